@@ -1,6 +1,5 @@
 local engine = require("engine")
 local assets_manager = engine.get_assets_manager()
-local generator = engine.get_generator()
 
 local map_icon = assets_manager:find_image("icon_asteroid_field")
 
@@ -28,6 +27,4 @@ function module.on_create_sector (heuristics, seed)
     return sector
 end
 
-generator:add_sector_type("asteroid_field", module.heuristics_callback, module.on_create_sector)
-
 return module
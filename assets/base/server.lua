@@ -16,5 +16,6 @@ require("base.events.event_player")
 -- Generator
 require("base.generator")
 
--- Sector types
-require("base.sectors.sector_asteroid_field")
+-- Sector types, loaded by every generator thread into a Lua state of its own
+local generator = engine.get_generator()
+generator:add_sector_module("asteroid_field", "base.sectors.sector_asteroid_field")
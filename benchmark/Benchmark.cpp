@@ -0,0 +1,218 @@
+#include "Benchmark.hpp"
+#include <Engine/Utils/Chrono.hpp>
+#include <Engine/Utils/Log.hpp>
+#include <iostream>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+static double percentile(std::vector<double> values, const double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const auto index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+double BenchmarkResult::getMedian() const {
+    return percentile(samples, 0.5);
+}
+
+Json BenchmarkResult::toJson() const {
+    auto mean = 0.0;
+    for (const auto sample : samples) {
+        mean += sample;
+    }
+    mean /= static_cast<double>(std::max<size_t>(samples.size(), 1));
+
+    auto variance = 0.0;
+    for (const auto sample : samples) {
+        variance += (sample - mean) * (sample - mean);
+    }
+    variance /= static_cast<double>(std::max<size_t>(samples.size(), 1));
+
+    const auto median = getMedian();
+
+    Json json{};
+    json["name"] = name;
+    json["samples"] = samples.size();
+    json["median_ns"] = median;
+    json["mean_ns"] = mean;
+    json["stddev_ns"] = std::sqrt(variance);
+    json["min_ns"] = percentile(samples, 0.0);
+    json["max_ns"] = percentile(samples, 1.0);
+    json["p90_ns"] = percentile(samples, 0.9);
+    json["items"] = items;
+    json["bytes"] = bytes;
+    if (median > 0.0) {
+        json["items_per_second"] = static_cast<double>(items) / (median / 1e9);
+        json["bytes_per_second"] = static_cast<double>(bytes) / (median / 1e9);
+    }
+    json["counters"] = counters;
+    return json;
+}
+
+static uint64_t hashName(const std::string& name) {
+    // FNV-1a, unlike std::hash it gives the same seeds with every standard library
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+BenchmarkContext::BenchmarkContext(const BenchmarkOptions& options, BenchmarkResult& result) :
+    options{options}, result{result}, rng{options.seed ^ hashName(result.name)} {
+}
+
+void BenchmarkContext::measure(const std::function<void()>& setup, const std::function<void()>& body) {
+    for (size_t i = 0; i < options.warmup + options.repetitions; i++) {
+        if (setup) {
+            setup();
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        body();
+        const auto t1 = std::chrono::steady_clock::now();
+
+        if (i >= options.warmup) {
+            result.samples.push_back(
+                static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        }
+    }
+}
+
+void BenchmarkContext::measure(const std::function<void()>& body) {
+    measure(nullptr, body);
+}
+
+void BenchmarkContext::setItems(const uint64_t value) {
+    result.items = value;
+}
+
+void BenchmarkContext::setBytes(const uint64_t value) {
+    result.bytes = value;
+}
+
+void BenchmarkContext::setCounter(const std::string& name, const double value) {
+    result.counters[name] = value;
+}
+
+Config BenchmarkContext::createConfig() const {
+    Config config{};
+    config.assetsPath = options.assetsPath;
+    return config;
+}
+
+BenchmarkRegistry::Registration::Registration(std::string name, Workload fn) {
+    BenchmarkRegistry::getInstance().add(std::move(name), std::move(fn));
+}
+
+BenchmarkRegistry& BenchmarkRegistry::getInstance() {
+    static BenchmarkRegistry registry;
+    return registry;
+}
+
+void BenchmarkRegistry::add(std::string name, Workload fn) {
+    workloads.emplace_back(std::move(name), std::move(fn));
+}
+
+std::vector<std::string> BenchmarkRegistry::getNames() const {
+    std::vector<std::string> names;
+    for (const auto& [name, fn] : workloads) {
+        names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::vector<BenchmarkResult> BenchmarkRegistry::run(const BenchmarkOptions& options) {
+    // The registration order depends on the link order, the results should not
+    std::sort(workloads.begin(), workloads.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& [name, fn] : workloads) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+
+        logger.info("Running benchmark workload: '{}'", name);
+
+        BenchmarkResult result{};
+        result.name = name;
+        BenchmarkContext context{options, result};
+
+        try {
+            fn(context);
+        } catch (...) {
+            EXCEPTION_NESTED("Benchmark workload: '{}' failed", name);
+        }
+
+        std::cout << fmt::format("{:<40} median: {:>12.3f} us samples: {}",
+                                 name,
+                                 result.getMedian() / 1000.0,
+                                 result.samples.size())
+                  << std::endl;
+
+        results.push_back(std::move(result));
+    }
+
+    return results;
+}
+
+Json Engine::benchmarkResultsToJson(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results) {
+    Json json{};
+    json["version"] = GAME_VERSION;
+    json["timestamp"] = std::chrono::system_clock::now();
+    json["seed"] = options.seed;
+    json["warmup"] = options.warmup;
+    json["repetitions"] = options.repetitions;
+    json["results"] = Json::array();
+    for (const auto& result : results) {
+        json["results"].push_back(result.toJson());
+    }
+    return json;
+}
+
+bool Engine::compareBenchmarkResults(const Json& baseline, const Json& current, const double threshold) {
+    std::unordered_map<std::string, double> baselineMedians;
+    for (const auto& result : baseline.at("results")) {
+        baselineMedians.emplace(result.at("name").get<std::string>(), result.at("median_ns").get<double>());
+    }
+
+    if (baseline.value("seed", 0ULL) != current.value("seed", 0ULL)) {
+        std::cout << "Warning: the results were produced with different seeds" << std::endl;
+    }
+
+    auto passed = true;
+    std::cout << fmt::format("{:<40} {:>14} {:>14} {:>9}", "workload", "baseline us", "current us", "change")
+              << std::endl;
+
+    for (const auto& result : current.at("results")) {
+        const auto name = result.at("name").get<std::string>();
+        const auto median = result.at("median_ns").get<double>();
+
+        const auto it = baselineMedians.find(name);
+        if (it == baselineMedians.end() || it->second <= 0.0) {
+            std::cout << fmt::format("{:<40} {:>14} {:>14.3f} {:>9}", name, "-", median / 1000.0, "new") << std::endl;
+            continue;
+        }
+
+        const auto change = (median / it->second - 1.0) * 100.0;
+        const auto regressed = change > threshold;
+        passed = passed && !regressed;
+
+        std::cout << fmt::format("{:<40} {:>14.3f} {:>14.3f} {:>+8.1f}%{}",
+                                 name,
+                                 it->second / 1000.0,
+                                 median / 1000.0,
+                                 change,
+                                 regressed ? " REGRESSION" : "")
+                  << std::endl;
+    }
+
+    return passed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Engine/Config.hpp>
+#include <Engine/Utils/Json.hpp>
+#include <Engine/Utils/Random.hpp>
+#include <chrono>
+#include <functional>
+#include <map>
+
+namespace Engine {
+struct BenchmarkOptions {
+    uint64_t seed{123456789ULL};
+    size_t warmup{1};
+    size_t repetitions{10};
+    std::string filter;
+    Path assetsPath;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::vector<double> samples;
+    uint64_t items{0};
+    uint64_t bytes{0};
+    std::map<std::string, double> counters;
+
+    [[nodiscard]] double getMedian() const;
+    [[nodiscard]] Json toJson() const;
+};
+
+// Handed to a workload, the workload prepares its data and then calls measure() with the timed part
+class BenchmarkContext {
+public:
+    explicit BenchmarkContext(const BenchmarkOptions& options, BenchmarkResult& result);
+
+    // Runs the body warmup + repetitions times, the setup runs before every run and is not timed
+    void measure(const std::function<void()>& setup, const std::function<void()>& body);
+    void measure(const std::function<void()>& body);
+
+    // Number of items and bytes processed by a single run of the body, reported as throughput
+    void setItems(uint64_t value);
+    void setBytes(uint64_t value);
+    void setCounter(const std::string& name, double value);
+
+    [[nodiscard]] const BenchmarkOptions& getOptions() const {
+        return options;
+    }
+
+    // Seeded from the options and the workload name, every run of the same workload gets the same sequence
+    Rng& getRng() {
+        return rng;
+    }
+
+    [[nodiscard]] Config createConfig() const;
+
+private:
+    const BenchmarkOptions& options;
+    BenchmarkResult& result;
+    Rng rng;
+};
+
+class BenchmarkRegistry {
+public:
+    using Workload = std::function<void(BenchmarkContext&)>;
+
+    struct Registration {
+        Registration(std::string name, Workload fn);
+    };
+
+    static BenchmarkRegistry& getInstance();
+
+    void add(std::string name, Workload fn);
+    std::vector<BenchmarkResult> run(const BenchmarkOptions& options);
+    std::vector<std::string> getNames() const;
+
+private:
+    std::vector<std::pair<std::string, Workload>> workloads;
+};
+
+// Prints the relative change of the median of every workload present in both files,
+// returns false when any of them is slower by more than the threshold (in percent)
+bool compareBenchmarkResults(const Json& baseline, const Json& current, double threshold);
+
+Json benchmarkResultsToJson(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results);
+
+#define BENCHMARK_WORKLOAD_CONCAT_IMPL(x, y) x##y
+#define BENCHMARK_WORKLOAD_CONCAT(x, y) BENCHMARK_WORKLOAD_CONCAT_IMPL(x, y)
+#define BENCHMARK_WORKLOAD(NAME, FUNC)                                                                                 \
+    static BenchmarkRegistry::Registration BENCHMARK_WORKLOAD_CONCAT(benchmarkWorkload, __COUNTER__) {                 \
+        NAME, FUNC                                                                                                     \
+    }
+} // namespace Engine
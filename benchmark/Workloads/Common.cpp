@@ -0,0 +1,87 @@
+#include "Common.hpp"
+#include <Engine/Stream/MsgpackReader.hpp>
+#include <random>
+
+using namespace Engine;
+
+AssetsManager& Engine::getBenchmarkAssets(const BenchmarkOptions& options) {
+    // The assets manager keeps a reference to the config
+    static Config config{};
+    static std::unique_ptr<AssetsManager> assetsManager;
+
+    if (!assetsManager) {
+        config.assetsPath = options.assetsPath;
+        assetsManager = std::make_unique<AssetsManager>(config);
+        for (auto& loadFn : assetsManager->getLoadQueue()) {
+            loadFn(nullptr, nullptr);
+        }
+    }
+
+    return *assetsManager;
+}
+
+BenchmarkTmpDir::BenchmarkTmpDir() {
+    const auto tmpPath = std::filesystem::temp_directory_path();
+    std::random_device dev;
+    std::mt19937_64 rng{dev()};
+    std::uniform_int_distribution<uint64_t> dist;
+
+    while (true) {
+        auto test = tmpPath / fmt::format("benchmark-{}", dist(rng));
+        if (std::filesystem::create_directory(test)) {
+            path = test;
+            break;
+        }
+    }
+}
+
+BenchmarkTmpDir::~BenchmarkTmpDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(path, ec);
+}
+
+BenchmarkNullStream::BenchmarkNullStream() : packet{std::make_shared<PacketBytes>()} {
+    onSharedSecret(std::vector<uint8_t>(32, 0x42));
+}
+
+PacketBytesPtr BenchmarkNullStream::allocatePacket() {
+    // The packet is consumed right away, the same buffer is used for all of them
+    packet->length = 0;
+    return packet;
+}
+
+void BenchmarkNullStream::enqueuePacket(const PacketBytesPtr& value) {
+    ++packets;
+    bytes += value->size();
+}
+
+void BenchmarkCaptureStream::enqueuePacket(const PacketBytesPtr& value) {
+    BenchmarkNullStream::enqueuePacket(value);
+
+    std::array<uint8_t, maxPacketSize> plaintext{};
+    bool verify{false};
+    const auto length =
+        decrypt(value->data() + sizeof(PacketHeader), plaintext.data(), value->size() - sizeof(PacketHeader), verify);
+    if (!verify) {
+        EXCEPTION("Captured packet has a bad signature");
+    }
+
+    captured.insert(captured.end(), plaintext.data(), plaintext.data() + length);
+}
+
+std::vector<RawMessagePtr> BenchmarkCaptureStream::takeMessages() {
+    std::vector<RawMessagePtr> messages;
+
+    size_t offset{0};
+    while (offset < captured.size()) {
+        const auto size = MsgpackReader::getObjectSize(captured.data() + offset, captured.size() - offset);
+        if (size == 0) {
+            EXCEPTION("Captured data ends with an incomplete message");
+        }
+        messages.push_back(std::make_shared<RawMessage>(captured.data() + offset, size));
+        offset += size;
+    }
+
+    captured.clear();
+    return messages;
+}
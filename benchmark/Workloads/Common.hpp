@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../Benchmark.hpp"
+#include <Engine/Assets/AssetsManager.hpp>
+#include <Engine/Network/NetworkStream.hpp>
+
+namespace Engine {
+// All assets loaded without a renderer, shared by the workloads of one run
+AssetsManager& getBenchmarkAssets(const BenchmarkOptions& options);
+
+// Removed together with its content once the workload is done
+class BenchmarkTmpDir {
+public:
+    BenchmarkTmpDir();
+    ~BenchmarkTmpDir();
+    NON_COPYABLE(BenchmarkTmpDir);
+    NON_MOVEABLE(BenchmarkTmpDir);
+
+    [[nodiscard]] const Path& value() const {
+        return path;
+    }
+
+private:
+    Path path;
+};
+
+// Encrypts and signs the packets like a real peer but only counts them instead of sending
+class BenchmarkNullStream : public NetworkStream {
+public:
+    BenchmarkNullStream();
+
+    bool isConnected() const override {
+        return true;
+    }
+    const std::string& getAddress() const override {
+        return address;
+    }
+    void close() override {
+    }
+
+    [[nodiscard]] uint64_t getPackets() const {
+        return packets;
+    }
+    [[nodiscard]] uint64_t getBytes() const {
+        return bytes;
+    }
+    void reset() {
+        packets = 0;
+        bytes = 0;
+    }
+
+protected:
+    PacketBytesPtr allocatePacket() override;
+    void enqueuePacket(const PacketBytesPtr& packet) override;
+
+private:
+    std::string address{"null"};
+    PacketBytesPtr packet;
+    uint64_t packets{0};
+    uint64_t bytes{0};
+};
+
+// Decrypts the sent packets back and splits them into the messages a peer would receive
+class BenchmarkCaptureStream : public BenchmarkNullStream {
+public:
+    [[nodiscard]] std::vector<RawMessagePtr> takeMessages();
+
+protected:
+    void enqueuePacket(const PacketBytesPtr& value) override;
+
+private:
+    std::vector<char> captured;
+};
+} // namespace Engine
@@ -0,0 +1,110 @@
+#include "Common.hpp"
+#include <Engine/Database/DatabaseRocksdb.hpp>
+#include <Engine/Server/Schemas.hpp>
+
+using namespace Engine;
+
+static constexpr size_t systemsCount = 1000;
+static constexpr size_t sectorsPerSystem = 10;
+static constexpr size_t operations = 20000;
+static constexpr auto galaxyId = "galaxy";
+
+static std::string systemId(const size_t s) {
+    return fmt::format("system-{:06}", s);
+}
+
+static std::string sectorId(const size_t s, const size_t c) {
+    return fmt::format("sector-{:06}-{:02}", s, c);
+}
+
+// Same key layout as the generated galaxy
+static void populateDatabase(BenchmarkContext& ctx, Database& db) {
+    auto& rng = ctx.getRng();
+    std::uniform_real_distribution<float> distPos{-250.0f, 250.0f};
+
+    auto batch = db.startBulkLoad();
+    for (size_t s = 0; s < systemsCount; s++) {
+        SystemData system{};
+        system.id = systemId(s);
+        system.galaxyId = galaxyId;
+        system.regionId = fmt::format("region-{}", s % 20);
+        system.name = fmt::format("System {}", s);
+        system.pos = {distPos(rng), distPos(rng)};
+        system.seed = rng();
+        for (size_t c = 0; c < 4; c++) {
+            system.connections.push_back(systemId((s + c * 7 + 1) % systemsCount));
+        }
+        batch->put(fmt::format("{}/{}", galaxyId, system.id), system);
+
+        for (size_t c = 0; c < sectorsPerSystem; c++) {
+            SectorData sector{};
+            sector.id = sectorId(s, c);
+            sector.galaxyId = galaxyId;
+            sector.systemId = system.id;
+            sector.name = fmt::format("Sector {} {}", s, c);
+            sector.pos = {distPos(rng), distPos(rng)};
+            sector.seed = rng();
+            sector.entity = "entity_sector_asteroid_field";
+            batch->put(fmt::format("{}/{}/{}", galaxyId, system.id, sector.id), sector);
+        }
+    }
+    batch->commit();
+}
+
+static void databaseWorkload(BenchmarkContext& ctx, const std::function<size_t(Database&, Rng&)>& op) {
+    // The schemas reference assets
+    getBenchmarkAssets(ctx.getOptions());
+
+    BenchmarkTmpDir tmpDir{};
+    DatabaseRocksDB::Options options{};
+    DatabaseRocksDB db{tmpDir.value(), options};
+    populateDatabase(ctx, db);
+
+    // Every run performs the same sequence of operations
+    const auto seed = ctx.getRng()();
+    size_t rows{0};
+    ctx.measure([&]() {
+        Rng rng{seed};
+        rows = 0;
+        for (size_t i = 0; i < operations; i++) {
+            rows += op(db, rng);
+        }
+    });
+
+    ctx.setItems(operations);
+    ctx.setCounter("rows", static_cast<double>(rows));
+}
+
+static size_t pointLookup(Database& db, Rng& rng) {
+    std::uniform_int_distribution<size_t> dist{0, systemsCount - 1};
+    return db.find<SystemData>(fmt::format("{}/{}", galaxyId, systemId(dist(rng)))) ? 1 : 0;
+}
+
+static size_t sectorScan(Database& db, Rng& rng) {
+    std::uniform_int_distribution<size_t> dist{0, systemsCount - 1};
+    return db.seekAll<SectorData>(fmt::format("{}/{}/", galaxyId, systemId(dist(rng)))).size();
+}
+
+static size_t indexLookup(Database& db, Rng& rng) {
+    std::uniform_int_distribution<size_t> distSystem{0, systemsCount - 1};
+    std::uniform_int_distribution<size_t> distSector{0, sectorsPerSystem - 1};
+    return db.getByIndex<&SectorData::id>(sectorId(distSystem(rng), distSector(rng))).size();
+}
+
+static size_t update(Database& db, Rng& rng) {
+    std::uniform_int_distribution<size_t> dist{0, systemsCount - 1};
+    const auto key = fmt::format("{}/{}", galaxyId, systemId(dist(rng)));
+    db.update<SystemData>(key, [&](std::optional<SystemData> value) {
+        if (!value) {
+            EXCEPTION("System: '{}' not found", key);
+        }
+        value->seed = rng();
+        return *value;
+    });
+    return 1;
+}
+
+BENCHMARK_WORKLOAD("database_point_lookup", [](BenchmarkContext& ctx) { databaseWorkload(ctx, &pointLookup); });
+BENCHMARK_WORKLOAD("database_sector_scan", [](BenchmarkContext& ctx) { databaseWorkload(ctx, &sectorScan); });
+BENCHMARK_WORKLOAD("database_index_lookup", [](BenchmarkContext& ctx) { databaseWorkload(ctx, &indexLookup); });
+BENCHMARK_WORKLOAD("database_update", [](BenchmarkContext& ctx) { databaseWorkload(ctx, &update); });
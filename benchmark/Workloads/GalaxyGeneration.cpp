@@ -0,0 +1,112 @@
+#include "Common.hpp"
+#include <Engine/Database/DatabaseRocksdb.hpp>
+#include <Engine/Server/Generator.hpp>
+
+using namespace Engine;
+
+// The factions the base assets put into a new save before the generator starts
+static void seedFactions(Database& db) {
+    static const std::vector<std::tuple<std::string, std::string, float>> factions = {
+        {"gallin_federation", "The Gallin Federation", 0.5f},
+        {"jetton_kingdom", "The Jetton Kingdom", 0.4f},
+        {"kaler_state", "The Kaler State", 0.25f},
+        {"quelis_republic", "The Quelis Republic", 0.8f},
+        {"syndicate", "The Syndicate", 0.0f},
+        {"terran_empire", "The Terran Empire", 0.15f},
+        {"valas_corporation", "The Valas Corporation", 0.6f},
+    };
+
+    for (const auto& [id, name, color] : factions) {
+        FactionData faction{};
+        faction.id = id;
+        faction.name = name;
+        faction.color = color;
+        db.put(id, faction);
+    }
+}
+
+// Same as the asteroid field sector type and the starting locations of the base assets, without Lua
+static void addSectorTypes(Generator& generator, AssetsManager& assetsManager, Database& db) {
+    const auto mapIcon = assetsManager.getImages().find("icon_asteroid_field");
+
+    generator.addSectorType(
+        "asteroid_field",
+        [](SystemHeuristics& heuristics) { return heuristics.getSectors().size() > 5 ? 0.0f : 1.0f; },
+        [mapIcon](SystemHeuristics& heuristics, const uint64_t seed) {
+            Rng rng{seed};
+
+            SectorData sector{};
+            sector.id = uuid();
+            sector.name = fmt::format("{} - Asteroids", heuristics.getSystem().name);
+            sector.pos = heuristics.findEmptyPosition(rng);
+            sector.galaxyId = heuristics.getGalaxy().id;
+            sector.systemId = heuristics.getSystem().id;
+            sector.seed = randomSeed(rng);
+            sector.icon = mapIcon;
+            sector.entity = "entity_sector_asteroid_field";
+            return sector;
+        },
+        true);
+
+    generator.addOnSectorCreated([&db](const GalaxyData& galaxy,
+                                       const SystemData& system,
+                                       const std::optional<FactionData>& faction,
+                                       const SectorData& sector) {
+        (void)faction;
+
+        StartingLocationData location{};
+        location.galaxyId = galaxy.id;
+        location.systemId = system.id;
+        location.sectorId = sector.id;
+        db.put(sector.id, location);
+    });
+}
+
+// The whole universe written into an empty database, same as when a new save is created
+static void galaxyGeneration(BenchmarkContext& ctx, const int systems, const size_t threads = 0) {
+    auto& assetsManager = getBenchmarkAssets(ctx.getOptions());
+
+    // The galaxy grows with the number of systems past the default size, otherwise they would not fit in
+    Generator::Options generatorOptions{};
+    generatorOptions.galaxySystemsMax = systems;
+    generatorOptions.galaxyWidthMax *= std::max(1.0f, std::sqrt(static_cast<float>(systems) / 2000.0f));
+    generatorOptions.threads = threads;
+
+    std::unique_ptr<BenchmarkTmpDir> tmpDir;
+    std::unique_ptr<DatabaseRocksDB> db;
+    std::unique_ptr<Generator> generator;
+
+    const auto setup = [&]() {
+        generator.reset();
+        db.reset();
+        tmpDir = std::make_unique<BenchmarkTmpDir>();
+        db = std::make_unique<DatabaseRocksDB>(tmpDir->value(), DatabaseRocksDB::Options{});
+        seedFactions(*db);
+        generator = std::make_unique<Generator>(generatorOptions, assetsManager, *db);
+        addSectorTypes(*generator, assetsManager, *db);
+    };
+
+    const auto seed = ctx.getOptions().seed;
+    ctx.measure(setup, [&]() { generator->generate(seed); });
+
+    const auto sectors = db->seekAll<SectorData>("").size();
+    if (sectors == 0) {
+        EXCEPTION("Galaxy generation created no sectors");
+    }
+
+    ctx.setItems(static_cast<uint64_t>(systems));
+    ctx.setCounter("sectors", static_cast<double>(sectors));
+    ctx.setCounter("systems", static_cast<double>(db->seekAll<SystemData>("").size()));
+
+    generator.reset();
+    db.reset();
+}
+
+BENCHMARK_WORKLOAD("galaxy_generation_500", [](BenchmarkContext& ctx) { galaxyGeneration(ctx, 500); });
+BENCHMARK_WORKLOAD("galaxy_generation_2000", [](BenchmarkContext& ctx) { galaxyGeneration(ctx, 2000); });
+
+// Thread scaling of the per system phases, the same galaxy with a fixed number of threads
+BENCHMARK_WORKLOAD("galaxy_generation_10000_threads_1", [](BenchmarkContext& ctx) { galaxyGeneration(ctx, 10000, 1); });
+BENCHMARK_WORKLOAD("galaxy_generation_10000_threads_2", [](BenchmarkContext& ctx) { galaxyGeneration(ctx, 10000, 2); });
+BENCHMARK_WORKLOAD("galaxy_generation_10000_threads_4", [](BenchmarkContext& ctx) { galaxyGeneration(ctx, 10000, 4); });
+BENCHMARK_WORKLOAD("galaxy_generation_10000_threads_8", [](BenchmarkContext& ctx) { galaxyGeneration(ctx, 10000, 8); });
@@ -0,0 +1,64 @@
+#include "Common.hpp"
+#include <Engine/Assets/VoxelShapeCache.hpp>
+#include <Engine/Scene/Grid.hpp>
+
+using namespace Engine;
+
+// A hull of the given width filled with random blocks, rotations and shapes
+static size_t populateGrid(BenchmarkContext& ctx, Grid& grid, const int width) {
+    auto blocks = getBenchmarkAssets(ctx.getOptions()).getBlocks().findAll();
+    std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b) { return a->getName() < b->getName(); });
+    if (blocks.empty()) {
+        EXCEPTION("No blocks found in: '{}'", ctx.getOptions().assetsPath);
+    }
+
+    auto& rng = ctx.getRng();
+    std::uniform_int_distribution<size_t> distBlock{0, blocks.size() - 1};
+    std::uniform_int_distribution<int> distRotation{0, 23};
+    std::uniform_int_distribution<int> distColor{0, 63};
+    std::uniform_int_distribution<int> distShape{0, 9};
+    std::uniform_int_distribution<int> distFill{0, 3};
+
+    size_t count{0};
+    for (auto z = 0; z < width; z++) {
+        for (auto y = 0; y < width; y++) {
+            for (auto x = 0; x < width; x++) {
+                const auto edge = x == 0 || y == 0 || z == 0 || x == width - 1 || y == width - 1 || z == width - 1;
+                // The inside is sparse so the neighbour masks vary
+                if (!edge && distFill(rng) != 0) {
+                    continue;
+                }
+
+                // Mostly cubes with a few of the other shapes
+                const auto shape = distShape(rng);
+                grid.insert(Vector3i{x, y, z} - Vector3i{width / 2},
+                            blocks.at(distBlock(rng)),
+                            static_cast<uint8_t>(distRotation(rng)),
+                            static_cast<uint8_t>(distColor(rng)),
+                            static_cast<uint8_t>(shape < 4 ? shape : 0));
+                ++count;
+            }
+        }
+    }
+
+    grid.updateBounds();
+    return count;
+}
+
+static void gridMeshing(BenchmarkContext& ctx, const int width) {
+    const auto config = ctx.createConfig();
+    const VoxelShapeCache voxelShapeCache{config};
+
+    Grid grid{};
+    const auto voxels = populateGrid(ctx, grid, width);
+
+    Grid::BlocksData data{};
+    ctx.measure([&]() { data = Grid::BlocksData{}; }, [&]() { grid.generateMesh(voxelShapeCache, data); });
+
+    ctx.setItems(voxels);
+    ctx.setCounter("vertices", static_cast<double>(data.vertices.size()));
+    ctx.setCounter("indices", static_cast<double>(data.indices.size()));
+}
+
+BENCHMARK_WORKLOAD("grid_meshing_16", [](BenchmarkContext& ctx) { gridMeshing(ctx, 16); });
+BENCHMARK_WORKLOAD("grid_meshing_64", [](BenchmarkContext& ctx) { gridMeshing(ctx, 64); });
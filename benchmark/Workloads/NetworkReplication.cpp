@@ -0,0 +1,127 @@
+#include "Common.hpp"
+#include <Engine/Scene/Controllers/ControllerNetwork.hpp>
+#include <Engine/Scene/Scene.hpp>
+
+using namespace Engine;
+
+static void populateScene(BenchmarkContext& ctx, Scene& scene, const size_t count) {
+    auto& rng = ctx.getRng();
+    std::uniform_real_distribution<float> distPos{-5000.0f, 5000.0f};
+
+    const auto shape = CollisionShape::createSphere(10.0f);
+
+    for (size_t i = 0; i < count; i++) {
+        auto entity = scene.createEntity();
+        auto& transform = entity.addComponent<ComponentTransform>();
+        transform.move({distPos(rng), distPos(rng), distPos(rng)});
+
+        auto& rigidBody = entity.addComponent<ComponentRigidBody>();
+        rigidBody.setMass(1.0f);
+        rigidBody.setShape(transform, shape);
+
+        entity.addComponent<ComponentLabel>(fmt::format("Ship {}", i));
+    }
+}
+
+// Every entity moved since the last tick, the usual state of a busy sector
+static void replicationUpdate(BenchmarkContext& ctx, const size_t count) {
+    const auto config = ctx.createConfig();
+    Scene scene{config};
+    populateScene(ctx, scene, count);
+
+    auto& controller = scene.getController<ControllerNetwork>();
+    BenchmarkNullStream stream{};
+
+    auto& rng = ctx.getRng();
+    std::uniform_real_distribution<float> distMove{-10.0f, 10.0f};
+
+    const auto setup = [&]() {
+        controller.resetUpdates();
+        stream.reset();
+        for (auto&& [entity, transform] : scene.getView<ComponentTransform>().each()) {
+            transform.move({distMove(rng), distMove(rng), distMove(rng)});
+            scene.setDirty(transform);
+        }
+    };
+
+    ctx.measure(setup, [&]() { controller.sendUpdate(stream); });
+
+    ctx.setItems(count);
+    ctx.setBytes(stream.getBytes());
+    ctx.setCounter("packets", static_cast<double>(stream.getPackets()));
+}
+
+// What a player receives when entering a sector
+static void replicationSnapshot(BenchmarkContext& ctx, const size_t count) {
+    const auto config = ctx.createConfig();
+    Scene scene{config};
+    populateScene(ctx, scene, count);
+
+    auto& controller = scene.getController<ControllerNetwork>();
+    BenchmarkNullStream stream{};
+
+    ctx.measure([&]() { stream.reset(); }, [&]() { controller.sendFullSnapshot(stream); });
+
+    ctx.setItems(count);
+    ctx.setBytes(stream.getBytes());
+    ctx.setCounter("packets", static_cast<double>(stream.getPackets()));
+}
+
+// Client side of the two above, the received messages are decoded into a scene
+static void replicationDecode(BenchmarkContext& ctx, const size_t count, const bool snapshot) {
+    const auto config = ctx.createConfig();
+    Scene server{config};
+    populateScene(ctx, server, count);
+
+    auto& controller = server.getController<ControllerNetwork>();
+    BenchmarkCaptureStream stream{};
+
+    controller.sendFullSnapshot(stream);
+    const auto snapshotMessages = stream.takeMessages();
+
+    for (auto&& [entity, transform] : server.getView<ComponentTransform>().each()) {
+        transform.move({1.0f, 0.0f, 0.0f});
+        server.setDirty(transform);
+    }
+    controller.sendUpdate(stream);
+    const auto updateMessages = stream.takeMessages();
+
+    const auto decode = [](Scene& scene, const std::vector<RawMessagePtr>& messages) {
+        auto& network = scene.getController<ControllerNetwork>();
+        for (const auto& message : messages) {
+            network.receiveUpdate(message->getBody());
+        }
+    };
+
+    std::unique_ptr<Scene> client;
+    const auto& messages = snapshot ? snapshotMessages : updateMessages;
+    const auto setup = [&]() {
+        // The patches only apply to the entities created by the snapshot
+        if (snapshot || !client) {
+            client.reset();
+            client = std::make_unique<Scene>(config);
+            if (!snapshot) {
+                decode(*client, snapshotMessages);
+            }
+        }
+    };
+
+    ctx.measure(setup, [&]() { decode(*client, messages); });
+
+    size_t bytes{0};
+    for (const auto& message : messages) {
+        bytes += message->getBody().size();
+    }
+
+    ctx.setItems(count);
+    ctx.setBytes(bytes);
+    ctx.setCounter("messages", static_cast<double>(messages.size()));
+}
+
+BENCHMARK_WORKLOAD("replication_update_1000", [](BenchmarkContext& ctx) { replicationUpdate(ctx, 1000); });
+BENCHMARK_WORKLOAD("replication_update_10000", [](BenchmarkContext& ctx) { replicationUpdate(ctx, 10000); });
+BENCHMARK_WORKLOAD("replication_snapshot_10000", [](BenchmarkContext& ctx) { replicationSnapshot(ctx, 10000); });
+BENCHMARK_WORKLOAD("replication_decode_update_10000",
+                   [](BenchmarkContext& ctx) { replicationDecode(ctx, 10000, false); });
+BENCHMARK_WORKLOAD("replication_decode_snapshot_10000",
+                   [](BenchmarkContext& ctx) { replicationDecode(ctx, 10000, true); });
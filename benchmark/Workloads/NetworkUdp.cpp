@@ -0,0 +1,130 @@
+#include "Common.hpp"
+#include <Engine/Network/NetworkUdpClient.hpp>
+#include <Engine/Network/NetworkUdpServer.hpp>
+#include <Engine/Utils/Worker.hpp>
+
+using namespace Engine;
+
+struct BenchmarkUdpMessage {
+    std::string payload;
+
+    MSGPACK_DEFINE(payload);
+};
+
+MESSAGE_DEFINE_RELIABLE(BenchmarkUdpMessage);
+
+class BenchmarkUdpServer : public BackgroundWorker, public NetworkDispatcher2 {
+public:
+    explicit BenchmarkUdpServer(const Config& config) : BackgroundWorker{4} {
+        server = std::make_shared<NetworkUdpServer>(config, getService(), *this);
+
+        auto& dispatcher = static_cast<NetworkDispatcher2&>(*this);
+        HANDLE_REQUEST2(BenchmarkUdpMessage);
+
+        server->start();
+    }
+
+    ~BenchmarkUdpServer() override {
+        server->stop();
+        BackgroundWorker::stop();
+        server.reset();
+    }
+
+    NetworkUdpServer* operator->() {
+        return server.get();
+    }
+
+    uint64_t getReceivedCount() const {
+        return receivedCount.load();
+    }
+
+    void onAcceptSuccess(const NetworkStreamPtr& peer) override {
+        (void)peer;
+    }
+
+    void onDisconnect(const NetworkStreamPtr& peer) override {
+        (void)peer;
+    }
+
+private:
+    void handle(Request2<BenchmarkUdpMessage> req) {
+        (void)req;
+        ++receivedCount;
+    }
+
+    std::shared_ptr<NetworkUdpServer> server;
+    std::atomic<uint64_t> receivedCount{0};
+};
+
+class BenchmarkUdpClient : public BackgroundWorker, public NetworkDispatcher2 {
+public:
+    explicit BenchmarkUdpClient(const Config& config) {
+        client = std::make_shared<NetworkUdpClient>(config, getService(), *this);
+        client->start();
+    }
+
+    ~BenchmarkUdpClient() override {
+        client->stop();
+        BackgroundWorker::stop();
+        client.reset();
+    }
+
+    NetworkUdpClient* operator->() {
+        return client.get();
+    }
+
+    void onAcceptSuccess(const NetworkStreamPtr& peer) override {
+        (void)peer;
+    }
+
+    void onDisconnect(const NetworkStreamPtr& peer) override {
+        (void)peer;
+    }
+
+private:
+    std::shared_ptr<NetworkUdpClient> client;
+};
+
+// Reliable messages from one client to the server over the loopback, until all of them are received
+static void udpLoopback(BenchmarkContext& ctx, const size_t count, const size_t size) {
+    auto config = ctx.createConfig();
+    config.network.clientBindAddress = "::1";
+    config.network.serverBindAddress = "::1";
+
+    BenchmarkUdpServer server{config};
+    BenchmarkUdpClient client{config};
+    client->connect(server->getEndpoint().address().to_string(), server->getEndpoint().port());
+
+    auto& rng = ctx.getRng();
+    std::uniform_int_distribution<int> distChar{'a', 'z'};
+
+    std::vector<BenchmarkUdpMessage> messages{count};
+    for (auto& message : messages) {
+        message.payload.resize(size);
+        for (auto& c : message.payload) {
+            c = static_cast<char>(distChar(rng));
+        }
+    }
+
+    uint64_t expected{0};
+    ctx.measure([&]() {
+        for (const auto& message : messages) {
+            client->send(message);
+        }
+        expected += count;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{30};
+        while (server.getReceivedCount() < expected) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                EXCEPTION("Timed out waiting for: {} messages, received: {}", expected, server.getReceivedCount());
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    ctx.setItems(count);
+    ctx.setBytes(count * size);
+}
+
+BENCHMARK_WORKLOAD("udp_loopback_small_messages", [](BenchmarkContext& ctx) { udpLoopback(ctx, 10000, 64); });
+BENCHMARK_WORKLOAD("udp_loopback_large_messages", [](BenchmarkContext& ctx) { udpLoopback(ctx, 500, 16000); });
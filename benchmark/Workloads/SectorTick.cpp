@@ -0,0 +1,58 @@
+#include "Common.hpp"
+#include <Engine/Scene/Controllers/ControllerAgent.hpp>
+#include <Engine/Scene/Controllers/ControllerNetwork.hpp>
+#include <Engine/Scene/Scene.hpp>
+#include <Engine/Server/Lua.hpp>
+#include <sol/sol.hpp>
+
+using namespace Engine;
+
+static constexpr size_t ticksPerRun = 10;
+
+// The update of a sector with the given number of NPC ships flying around and one player watching,
+// the same steps as Sector::update without the database
+static void sectorTick(BenchmarkContext& ctx, const size_t ships) {
+    getBenchmarkAssets(ctx.getOptions());
+
+    const auto config = ctx.createConfig();
+    EventBus eventBus{};
+    Lua lua{config, eventBus};
+    Scene scene{config, nullptr, &lua};
+    lua.setScene(scene);
+    lua.require("base.sector");
+
+    auto& rng = ctx.getRng();
+    std::uniform_real_distribution<float> distPos{-20000.0f, 20000.0f};
+
+    for (size_t i = 0; i < ships; i++) {
+        const auto entity = scene.createEntityFrom("scout_ship");
+        auto& transform = scene.getComponent<ComponentTransform>(entity);
+        transform.move({distPos(rng), 0.0f, distPos(rng)});
+
+        auto& control = scene.getComponent<ComponentShipControl>(entity);
+        control.actionMoveTo({distPos(rng), 0.0f, distPos(rng)});
+    }
+
+    // The player keeps the closest ships at the full update rate
+    const auto player = scene.createEntityFrom("scout_ship");
+    scene.getController<ControllerAgent>().addObserver(player);
+
+    auto& networkController = scene.getController<ControllerNetwork>();
+    BenchmarkNullStream stream{};
+
+    const auto tickF = static_cast<float>(config.tickLengthUs.count()) / 1000000.0f;
+    ctx.measure([&]() {
+        for (size_t t = 0; t < ticksPerRun; t++) {
+            scene.update(tickF);
+            networkController.sendUpdate(stream);
+            networkController.resetUpdates();
+        }
+    });
+
+    ctx.setItems(ships * ticksPerRun);
+    ctx.setCounter("ticks", static_cast<double>(ticksPerRun));
+    ctx.setCounter("sent_bytes", static_cast<double>(stream.getBytes()));
+}
+
+BENCHMARK_WORKLOAD("sector_tick_100_ships", [](BenchmarkContext& ctx) { sectorTick(ctx, 100); });
+BENCHMARK_WORKLOAD("sector_tick_1000_ships", [](BenchmarkContext& ctx) { sectorTick(ctx, 1000); });
@@ -0,0 +1,83 @@
+#include "Benchmark.hpp"
+#include <CLI/CLI.hpp>
+#include <Engine/Utils/Exceptions.hpp>
+#include <Engine/Utils/Log.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+static Json readResults(const Path& path) {
+    std::ifstream file{path};
+    if (!file) {
+        EXCEPTION("Failed to open benchmark results: '{}'", path);
+    }
+    return Json::parse(file);
+}
+
+static int commandRun(const BenchmarkOptions& options, const Path& output) {
+    const auto results = BenchmarkRegistry::getInstance().run(options);
+    const auto json = benchmarkResultsToJson(options, results);
+
+    std::ofstream file{output};
+    if (!file) {
+        EXCEPTION("Failed to open benchmark output: '{}'", output);
+    }
+    file << json.dump(2) << std::endl;
+    logger.info("Benchmark results written to: '{}'", output);
+
+    return EXIT_SUCCESS;
+}
+
+static int commandCompare(const Path& baseline, const Path& current, const double threshold) {
+    const auto passed = compareBenchmarkResults(readResults(baseline), readResults(current), threshold);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options{};
+    CLI::App parser{"Temporary Escape benchmarks"};
+    parser.require_subcommand(1);
+
+    Path rootPath{ROOT_DIR};
+    Path output;
+    auto* run = parser.add_subcommand("run", "Run the workloads and write the results as JSON");
+    run->add_option("--root", rootPath, "Root directory with the assets")->check(CLI::ExistingDirectory);
+    // The summaries and the log share the standard output, the results always go into a file
+    run->add_option("--output", output, "Output file of the results")->required();
+    run->add_option("--filter", options.filter, "Run only the workloads containing this string");
+    run->add_option("--seed", options.seed, "Seed of all generated data");
+    run->add_option("--repetitions", options.repetitions, "Measured runs of every workload");
+    run->add_option("--warmup", options.warmup, "Discarded runs before the measured ones");
+
+    parser.add_subcommand("list", "List the workloads");
+
+    Path baseline;
+    Path current;
+    double threshold{5.0};
+    auto* compare = parser.add_subcommand("compare", "Compare two result files, fails on a regression");
+    compare->add_option("baseline", baseline, "Results of the baseline")->required()->check(CLI::ExistingFile);
+    compare->add_option("current", current, "Results to check")->required()->check(CLI::ExistingFile);
+    compare->add_option("--threshold", threshold, "Allowed slowdown of the median in percent");
+
+    CLI11_PARSE(parser, argc, argv)
+
+    try {
+        if (parser.got_subcommand("list")) {
+            for (const auto& name : BenchmarkRegistry::getInstance().getNames()) {
+                std::cout << name << std::endl;
+            }
+            return EXIT_SUCCESS;
+        } else if (parser.got_subcommand("compare")) {
+            return commandCompare(baseline, current, threshold);
+        } else {
+            options.assetsPath = std::filesystem::absolute(rootPath) / "assets";
+            return commandRun(options, output);
+        }
+    } catch (const std::exception& e) {
+        BACKTRACE(e, "fatal error");
+        return EXIT_FAILURE;
+    }
+}
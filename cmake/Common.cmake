@@ -12,6 +12,10 @@ target_compile_definitions(${PROJECT_NAME}Common
         _CRT_SECURE_NO_WARNINGS=1
         "SOURCE_ROOT=\"${CMAKE_CURRENT_SOURCE_DIR}\"")
 
+if (TEMPORARY_ESCAPE_PROFILER)
+    target_compile_definitions(${PROJECT_NAME}Common INTERFACE TEMPORARY_ESCAPE_PROFILER=1)
+endif ()
+
 if (UNIX)
     target_compile_options(${PROJECT_NAME}Common INTERFACE -ftemplate-backtrace-limit=0)
 elseif (MSVC)
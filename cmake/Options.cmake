@@ -3,7 +3,17 @@ set(TEMPORARY_ESCAPE_BUILD_TESTS
         CACHE BOOL
         "Build with tests")
 
+set(TEMPORARY_ESCAPE_BUILD_BENCHMARKS
+        OFF
+        CACHE BOOL
+        "Build the benchmark suite")
+
 set(TEMPORARY_ESCAPE_LLVM_SYMBOLIZER_PATH
         ""
         CACHE STRING
         "Path to the llvm-symbolizer to enable address sanitizer")
+
+set(TEMPORARY_ESCAPE_PROFILER
+        OFF
+        CACHE BOOL
+        "Build with the frame profiler scopes enabled")
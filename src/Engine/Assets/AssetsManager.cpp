@@ -20,6 +20,14 @@ static void compressTexture(const Path& file) {
     }
 }
 
+static void bakeModel(const Path& file) {
+    if (!Model::isBaked(file)) {
+        Model::bake(file);
+    } else {
+        logger.debug("Skipping model: {}, not modified", file);
+    }
+}
+
 void AssetsManager::compressAssets(const Config& config) {
     try {
         const std::vector<Path> paths = {config.assetsPath / "base"};
@@ -31,6 +39,7 @@ void AssetsManager::compressAssets(const Config& config) {
 
             iterateDir(path / "textures", {".png"}, [&](const Path& file) { compressTexture(file); });
             iterateDir(path / "models", {".png"}, [&](const Path& file) { compressTexture(file); });
+            iterateDir(path / "models", {".gltf"}, [&](const Path& file) { bakeModel(file); });
             iterateDir(path / "images", {".png"}, [&](const Path& file) { compressTexture(file); });
         }
     } catch (...) {
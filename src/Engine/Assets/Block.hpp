@@ -194,6 +194,14 @@ public:
         return definition.thrust;
     }
 
+    [[nodiscard]] const Path& getPath() const {
+        return path;
+    }
+
+    [[nodiscard]] const std::vector<Material>& getMaterials() const {
+        return materials;
+    }
+
     static std::shared_ptr<Block> from(const std::string& name);
 
 private:
@@ -1,5 +1,8 @@
 #include "Model.hpp"
+#include "../File/BakedModelFile.hpp"
 #include "../File/GltfFileReader.hpp"
+#include "../Graphics/MeshOptimizer.hpp"
+#include "../Scene/Components/ComponentModel.hpp"
 #include "../Utils/StringUtils.hpp"
 #include "AssetsManager.hpp"
 #include <btBulletDynamicsCommon.h>
@@ -20,6 +23,9 @@ static const std::vector<Vector3> boxVertices = {
     {1.0f, -1.0f, 1.0f},   // 7
 };
 
+// The settings every non-skinned primitive is baked with, part of the source stamp of the baked files
+static const MeshOptimizeOptions bakeOptions{};
+
 static bool isCollision(const std::string& name) {
     if (name.find("_CCX") == name.size() - 4) {
         return true;
@@ -53,6 +59,53 @@ findMany(const Container& container, const std::function<bool(const typename Con
     return res;
 }
 
+// Full precision vertex used during the optimization, quantized into ComponentModel::Vertex afterwards
+struct SourceVertex {
+    Vector3 position;
+    Vector3 normal;
+    Vector2 texCoords;
+    Vector4 tangent;
+};
+
+template <typename Vertex> static std::vector<Vertex> toVertices(const std::vector<float>& data) {
+    std::vector<Vertex> vertices;
+    vertices.resize(data.size() * sizeof(float) / sizeof(Vertex));
+    std::memcpy(vertices.data(), data.data(), vertices.size() * sizeof(Vertex));
+    return vertices;
+}
+
+static std::vector<uint32_t> readIndices(const GltfAccessor& accessor) {
+    const auto span = accessor.bufferView.getSpan();
+
+    std::vector<uint32_t> indices;
+    indices.resize(accessor.count);
+
+    switch (accessor.componentType) {
+    case GltfComponentType::R8:
+    case GltfComponentType::R8u: {
+        const auto* src = reinterpret_cast<const uint8_t*>(span.data());
+        std::copy(src, src + accessor.count, indices.begin());
+        break;
+    }
+    case GltfComponentType::R16:
+    case GltfComponentType::R16u: {
+        const auto* src = reinterpret_cast<const uint16_t*>(span.data());
+        std::copy(src, src + accessor.count, indices.begin());
+        break;
+    }
+    case GltfComponentType::R32u: {
+        const auto* src = reinterpret_cast<const uint32_t*>(span.data());
+        std::copy(src, src + accessor.count, indices.begin());
+        break;
+    }
+    default: {
+        EXCEPTION("Invalid index type");
+    }
+    }
+
+    return indices;
+}
+
 static Path fixFileNameExt(const Path& path) {
     const auto filename = fmt::format("{}.ktx2", path.stem().string());
     if (path.has_parent_path()) {
@@ -61,362 +114,506 @@ static Path fixFileNameExt(const Path& path) {
     return filename;
 }
 
-Model::Model(std::string name, Path path) : Asset{std::move(name)}, path{std::move(path)} {
+static std::string getTextureUri(const std::optional<GltfTexture>& texture) {
+    return texture ? texture->getUri() : std::string{};
 }
 
-Model::Model(Model&& other) noexcept = default;
+static void bakePrimitive(const GltfAccessor& indicesAccessor, const GltfAccessor& positions,
+                          const GltfAccessor& normals, const GltfAccessor& texCoords, const GltfAccessor& tangents,
+                          const GltfAccessor* joints, const GltfAccessor* weights, BakedModel::Primitive& primitive) {
+    auto indices = readIndices(indicesAccessor);
+    MeshOptimizeResult optimized;
+
+    if (joints && weights) {
+        auto vertices = toVertices<ComponentModel::SkinnedVertex>(
+            GltfUtils::combine(positions, normals, texCoords, tangents, *joints, *weights));
+
+        // The simplified levels would not follow the joints, only reorder the skinned meshes
+        auto options = bakeOptions;
+        options.lods = 1;
+        optimized = optimizeMesh(vertices, indices, options);
+
+        primitive.vertices.resize(vertices.size() * sizeof(ComponentModel::SkinnedVertex));
+        std::memcpy(primitive.vertices.data(), vertices.data(), primitive.vertices.size());
+    } else {
+        auto source = toVertices<SourceVertex>(GltfUtils::combine(positions, normals, texCoords, tangents));
+
+        optimized = optimizeMesh(source, indices, bakeOptions);
+
+        std::vector<ComponentModel::Vertex> vertices;
+        vertices.reserve(source.size());
+        for (const auto& v : source) {
+            vertices.push_back({
+                v.position,
+                quantizeSnorm(v.normal),
+                quantizeHalf(v.texCoords),
+                quantizeSnorm(v.tangent),
+            });
+        }
 
-Model& Model::operator=(Model&& other) noexcept = default;
+        primitive.vertices.resize(vertices.size() * sizeof(ComponentModel::Vertex));
+        std::memcpy(primitive.vertices.data(), vertices.data(), primitive.vertices.size());
+    }
 
-Model::~Model() = default;
+    VkIndexType indexType;
+    const auto packed = packIndices(indices, optimized.vertexCount, indexType);
+    primitive.indices.assign(packed.begin(), packed.end());
+    primitive.indices32 = indexType == VkIndexType::VK_INDEX_TYPE_UINT32;
+    primitive.radius = optimized.radius;
+    for (const auto& lod : optimized.lods) {
+        primitive.lods.push_back({lod.offset, lod.count, lod.error});
+    }
+}
 
-void Model::load(AssetsManager& assetsManager, VulkanRenderer* vulkan, AudioContext* audio) {
-    (void)audio;
+static BakedModel bakeGltf(const Path& path, const bool withRender) {
+    const GltfFileReader gltf{path};
 
-    const auto resolveTexture = [this, &assetsManager, vulkan, audio](const Path& filename) -> TexturePtr {
-        const auto baseName = filename.stem().string();
-        auto found = assetsManager.getTextures().findOrNull(baseName);
-        if (found) {
-            return found;
-        }
-        const auto file = path.parent_path() / fixFileNameExt(filename);
-        auto texture = assetsManager.addTexture(file);
-        texture->load(assetsManager, vulkan, audio);
-        return texture;
-    };
+    if (gltf.getMaterials().empty()) {
+        EXCEPTION("gltf file has no materials");
+    }
 
-    try {
-        const GltfFileReader gltf{path};
+    const auto& modelNodes = gltf.getNodes();
+    if (modelNodes.empty()) {
+        EXCEPTION("gltf file has no nodes");
+    }
 
-        if (gltf.getMaterials().empty()) {
-            EXCEPTION("gltf file has no materials");
-        }
+    const auto objects = findMany(
+        modelNodes, [](const GltfNode& node) -> bool { return !isCollision(node.name) && node.mesh.has_value(); });
+
+    const auto collisions = findOne(
+        modelNodes, [](const GltfNode& node) -> bool { return isCollision(node.name) && node.mesh.has_value(); });
+
+    if (objects.empty()) {
+        EXCEPTION("gltf file has no valid node that can be used as a model");
+    }
+
+    BakedModel baked{};
 
-        const auto& modelNodes = gltf.getNodes();
-        if (modelNodes.empty()) {
-            EXCEPTION("gltf file has no nodes");
+    for (const auto& object : objects) {
+        if (object.mesh.value().primitives.empty()) {
+            EXCEPTION("gltf node has an object but contains no primitives");
         }
 
-        const auto objects = findMany(
-            modelNodes, [](const GltfNode& node) -> bool { return !isCollision(node.name) && node.mesh.has_value(); });
+        const auto& skin = object.skin;
+
+        auto& node = baked.nodes.emplace_back();
+        node.name = object.name;
+
+        if (skin) {
+            if (skin->inverseBindMatrices.type != GltfType::Mat4) {
+                EXCEPTION("gltf object skin matrices must be a mat4 type");
+            }
+            if (skin->inverseBindMatrices.count > Model::maxJoints) {
+                EXCEPTION("gltf object skin can not have more than {} joints", Model::maxJoints);
+            }
+
+            const auto count = skin->inverseBindMatrices.count;
+            if (count != skin->joints.size()) {
+                EXCEPTION("gltf object skin joints count does not match nodes count");
+            }
+
+            auto buffer = skin->inverseBindMatrices.bufferView.getSpan();
+            if (count * sizeof(Matrix4) != buffer.size()) {
+                EXCEPTION("gltf object skin matrices buffer does not match the expected size");
+            }
+
+            node.inverseBindMat.resize(count);
+            std::memcpy(node.inverseBindMat.data(), buffer.data(), count * sizeof(Matrix4));
 
-        const auto collisions = findOne(
-            modelNodes, [](const GltfNode& node) -> bool { return isCollision(node.name) && node.mesh.has_value(); });
+            for (const auto& joint : skin->joints) {
+                auto& mat = node.jointsLocalMat.emplace_back();
 
-        if (objects.empty()) {
-            EXCEPTION("gltf file has no valid node that can be used as a model");
+                mat = Matrix4{1.0f};
+                mat = glm::translate(mat, joint.translation);
+                mat = mat * glm::mat4_cast(joint.rotation);
+            }
         }
 
-        for (const auto& object : objects) {
-            if (object.mesh.value().primitives.empty()) {
-                EXCEPTION("gltf node has an object but contains no primitives");
+        for (const auto& part : object.mesh.value().primitives) {
+            if (!part.indices.has_value()) {
+                EXCEPTION("gltf object primitive has no indices");
             }
 
-            const auto& skin = object.skin;
+            if (!part.material.has_value()) {
+                EXCEPTION("gltf object primitive has no material");
+            }
 
-            auto& node = nodes.emplace_back();
-            node.name = object.name;
+            const auto positions = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
+                return a.type == GltfAttributeType::Position;
+            });
+            const auto normals = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
+                return a.type == GltfAttributeType::Normal;
+            });
+            const auto texCoords = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
+                return a.type == GltfAttributeType::TexCoord;
+            });
+            const auto tangents = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
+                return a.type == GltfAttributeType::Tangent;
+            });
+            const auto joints = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
+                return a.type == GltfAttributeType::Joints;
+            });
+            const auto weights = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
+                return a.type == GltfAttributeType::Weights;
+            });
+
+            if (!positions.has_value()) {
+                EXCEPTION("gltf object primitive has no position attribute");
+            }
+            if (!normals.has_value()) {
+                EXCEPTION("gltf object primitive has no normals attribute");
+            }
+            if (!texCoords.has_value()) {
+                EXCEPTION("gltf object primitive has no tex coords attribute");
+            }
+            if (!tangents.has_value()) {
+                EXCEPTION("gltf object primitive has no tangents attribute");
+            }
+            if (skin && !joints.has_value()) {
+                EXCEPTION("gltf object primitive has no joints attribute");
+            }
+            if (skin && !weights.has_value()) {
+                EXCEPTION("gltf object primitive has no weights attribute");
+            }
 
-            if (skin) {
-                if (skin->inverseBindMatrices.type != GltfType::Mat4) {
-                    EXCEPTION("gltf object skin matrices must be a mat4 type");
-                }
-                if (skin->inverseBindMatrices.count > maxJoints) {
-                    EXCEPTION("gltf object skin can not have more than {} joints", maxJoints);
-                }
+            const auto& indices = part.indices;
 
-                node.skin.count = skin->inverseBindMatrices.count;
-                if (node.skin.count != skin->joints.size()) {
-                    EXCEPTION("gltf object skin joints count does not match nodes count");
-                }
+            if (indices->type != GltfType::Scalar) {
+                EXCEPTION("gltf object primitive indicess must be a scalar type");
+            }
+            if (positions->accessor.type != GltfType::Vec3) {
+                EXCEPTION("gltf object primitive positions must be a Vec3 type");
+            }
+            if (normals->accessor.type != GltfType::Vec3) {
+                EXCEPTION("gltf object primitive normals must be a Vec3 type");
+            }
+            if (texCoords->accessor.type != GltfType::Vec2) {
+                EXCEPTION("gltf object primitive tex coords must be a Vec2 type");
+            }
+            if (tangents->accessor.type != GltfType::Vec4) {
+                EXCEPTION("gltf object primitive tangents must be a Vec4 type");
+            }
+            if (skin && joints->accessor.type != GltfType::Vec4) {
+                EXCEPTION("gltf object primitive joints must be a Vec4 type");
+            }
+            if (skin && weights->accessor.type != GltfType::Vec4) {
+                EXCEPTION("gltf object primitive weights must be a Vec4 type");
+            }
 
-                auto buffer = skin->inverseBindMatrices.bufferView.getSpan();
-                if (node.skin.count * sizeof(Matrix4) != buffer.size()) {
-                    EXCEPTION("gltf object skin matrices buffer does not match the expected size");
-                }
+            if (positions->accessor.componentType != GltfComponentType::R32f) {
+                EXCEPTION("gltf object primitive positions must be component type of 32-bit float");
+            }
+            if (normals->accessor.componentType != GltfComponentType::R32f) {
+                EXCEPTION("gltf object primitive normals must be component type of 32-bit float");
+            }
+            if (texCoords->accessor.componentType != GltfComponentType::R32f) {
+                EXCEPTION("gltf object primitive tex coords must be component type of 32-bit float");
+            }
+            if (tangents->accessor.componentType != GltfComponentType::R32f) {
+                EXCEPTION("gltf object primitive tangents must be component type of 32-bit float");
+            }
+            if (skin && joints->accessor.componentType != GltfComponentType::R8u) {
+                EXCEPTION("gltf object primitive joints must be component type of 8-bit int");
+            }
+            if (skin && weights->accessor.componentType != GltfComponentType::R32f) {
+                EXCEPTION("gltf object primitive weights must be component type of 32-bit float");
+            }
+
+            const auto count = positions->accessor.count;
+            if (count != normals->accessor.count || count != texCoords->accessor.count ||
+                count != tangents->accessor.count) {
+                EXCEPTION("gltf object contains primitive which accessors has conflicting counts");
+            }
+            if (skin && (count != joints->accessor.count || count != weights->accessor.count)) {
+                EXCEPTION("gltf object contains primitive which accessors has conflicting counts");
+            }
 
-                std::memcpy(node.skin.inverseBindMat.data(), buffer.data(), node.skin.count * sizeof(Matrix4));
+            if (part.type != GltfPrimitiveType::Triangles) {
+                EXCEPTION("Invalid primitive type");
+            }
 
-                for (size_t i = 0; i < skin->joints.size(); i++) {
-                    const auto& joint = skin->joints[i];
-                    auto& mat = node.skin.jointsLocalMat[i];
+            // Update the bounding box
+            baked.collision.bbMin = Vector3(positions->accessor.min);
+            baked.collision.bbMax = Vector3(positions->accessor.max);
 
-                    mat = Matrix4{1.0f};
-                    mat = glm::translate(mat, joint.translation);
-                    mat = mat * glm::mat4_cast(joint.rotation);
-                }
+            // Update the bounding radius
+            const auto span = positions->accessor.bufferView.getSpan();
+            for (size_t i = 0; i < positions->accessor.count; i++) {
+                const auto* point = reinterpret_cast<const float*>(span.data()) + i * 3;
+                baked.collision.radius =
+                    std::max(baked.collision.radius, glm::length(Vector3{point[0], point[1], point[2]}));
             }
 
-            for (const auto& part : object.mesh.value().primitives) {
-                if (!part.indices.has_value()) {
-                    EXCEPTION("gltf object primitive has no indices");
-                }
+            // The vertex processing is only needed by the client
+            if (!withRender) {
+                continue;
+            }
 
-                if (!part.material.has_value()) {
-                    EXCEPTION("gltf object primitive has no material");
-                }
+            const auto& partMaterial = part.material.value();
+
+            auto& primitive = node.primitives.emplace_back();
+            auto& material = primitive.material;
+            material.baseColorFactor = partMaterial.baseColorFactor;
+            material.emissiveFactor = partMaterial.emissiveFactor;
+            material.metallicRoughnessFactor = partMaterial.metallicRoughnessFactor;
+            material.baseColorTexture = getTextureUri(partMaterial.baseColorTexture);
+            material.normalTexture = getTextureUri(partMaterial.normalTexture);
+            material.emissiveTexture = getTextureUri(partMaterial.emissiveTexture);
+            material.metallicRoughnessTexture = getTextureUri(partMaterial.metallicRoughnessTexture);
+            material.ambientOcclusionTexture = getTextureUri(partMaterial.ambientOcclusionTexture);
+
+            bakePrimitive(indices.value(),
+                          positions->accessor,
+                          normals->accessor,
+                          texCoords->accessor,
+                          tangents->accessor,
+                          skin ? &joints->accessor : nullptr,
+                          skin ? &weights->accessor : nullptr,
+                          primitive);
+        }
+    }
 
-                const auto positions = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
-                    return a.type == GltfAttributeType::Position;
-                });
-                const auto normals = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
-                    return a.type == GltfAttributeType::Normal;
-                });
-                const auto texCoords = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
-                    return a.type == GltfAttributeType::TexCoord;
-                });
-                const auto tangents = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
-                    return a.type == GltfAttributeType::Tangent;
-                });
-                const auto joints = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
-                    return a.type == GltfAttributeType::Joints;
-                });
-                const auto weights = findOne(part.attributes, [](const GltfAttribute& a) -> bool {
-                    return a.type == GltfAttributeType::Weights;
-                });
-
-                if (!positions.has_value()) {
-                    EXCEPTION("gltf object primitive has no position attribute");
-                }
-                if (!normals.has_value()) {
-                    EXCEPTION("gltf object primitive has no normals attribute");
-                }
-                if (!texCoords.has_value()) {
-                    EXCEPTION("gltf object primitive has no tex coords attribute");
-                }
-                if (!tangents.has_value()) {
-                    EXCEPTION("gltf object primitive has no tangents attribute");
-                }
-                if (skin && !joints.has_value()) {
-                    EXCEPTION("gltf object primitive has no joints attribute");
-                }
-                if (skin && !weights.has_value()) {
-                    EXCEPTION("gltf object primitive has no weights attribute");
-                }
+    if (collisions && endsWith(collisions->name, "_CCX")) {
+        if (!collisions->mesh) {
+            EXCEPTION("gltf has collision node '{}' with no mesh", collisions->name);
+        }
+        if (collisions->mesh->primitives.empty()) {
+            EXCEPTION("gltf has collision node '{}' with no mesh primitives", collisions->name);
+        }
+        const auto& part = collisions->mesh->primitives.front();
+        const auto positions = findOne(
+            part.attributes, [](const GltfAttribute& a) -> bool { return a.type == GltfAttributeType::Position; });
 
-                const auto& indices = part.indices;
+        if (!positions) {
+            EXCEPTION("gltf has collision node '{}' with no vertices", collisions->name);
+        }
 
-                if (indices->type != GltfType::Scalar) {
-                    EXCEPTION("gltf object primitive indicess must be a scalar type");
-                }
-                if (positions->accessor.type != GltfType::Vec3) {
-                    EXCEPTION("gltf object primitive positions must be a Vec3 type");
-                }
-                if (normals->accessor.type != GltfType::Vec3) {
-                    EXCEPTION("gltf object primitive normals must be a Vec3 type");
-                }
-                if (texCoords->accessor.type != GltfType::Vec2) {
-                    EXCEPTION("gltf object primitive tex coords must be a Vec2 type");
-                }
-                if (tangents->accessor.type != GltfType::Vec4) {
-                    EXCEPTION("gltf object primitive tangents must be a Vec4 type");
-                }
-                if (skin && joints->accessor.type != GltfType::Vec4) {
-                    EXCEPTION("gltf object primitive joints must be a Vec4 type");
-                }
-                if (skin && weights->accessor.type != GltfType::Vec4) {
-                    EXCEPTION("gltf object primitive weights must be a Vec4 type");
-                }
+        const auto span = positions->accessor.bufferView.getSpan();
+        const auto* points = reinterpret_cast<const float*>(span.data());
+        baked.collision.hull.assign(points, points + positions->accessor.count * 3);
 
-                if (positions->accessor.componentType != GltfComponentType::R32f) {
-                    EXCEPTION("gltf object primitive positions must be component type of 32-bit float");
-                }
-                if (normals->accessor.componentType != GltfComponentType::R32f) {
-                    EXCEPTION("gltf object primitive normals must be component type of 32-bit float");
-                }
-                if (texCoords->accessor.componentType != GltfComponentType::R32f) {
-                    EXCEPTION("gltf object primitive tex coords must be component type of 32-bit float");
-                }
-                if (tangents->accessor.componentType != GltfComponentType::R32f) {
-                    EXCEPTION("gltf object primitive tangents must be component type of 32-bit float");
-                }
-                if (skin && joints->accessor.componentType != GltfComponentType::R8u) {
-                    EXCEPTION("gltf object primitive joints must be component type of 8-bit int");
-                }
-                if (skin && weights->accessor.componentType != GltfComponentType::R32f) {
-                    EXCEPTION("gltf object primitive weights must be component type of 32-bit float");
-                }
+        // Update the bounding box
+        baked.collision.bbMin = Vector3(positions->accessor.min);
+        baked.collision.bbMax = Vector3(positions->accessor.max);
 
-                const auto count = positions->accessor.count;
-                if (count != normals->accessor.count || count != texCoords->accessor.count ||
-                    count != tangents->accessor.count) {
-                    EXCEPTION("gltf object contains primitive which accessors has conflicting counts");
-                }
-                if (skin && (count != joints->accessor.count || count != weights->accessor.count)) {
-                    EXCEPTION("gltf object contains primitive which accessors has conflicting counts");
-                }
+        // Update the bounding radius
+        baked.collision.radius = 0.0f;
+        for (size_t i = 0; i < positions->accessor.count; i++) {
+            const auto* point = points + i * 3;
+            baked.collision.radius =
+                std::max(baked.collision.radius, glm::length(Vector3{point[0], point[1], point[2]}));
+        }
+    }
 
-                // Update the bounding box
-                bbMin = Vector3(positions->accessor.min);
-                bbMax = Vector3(positions->accessor.max);
+    return baked;
+}
 
-                // Update the bounding radius
-                const auto span = positions->accessor.bufferView.getSpan();
-                for (size_t i = 0; i < positions->accessor.count; i++) {
-                    const auto* point = reinterpret_cast<const float*>(span.data()) + i * 3;
-                    bbRadius = std::max(bbRadius, glm::length(Vector3{point[0], point[1], point[2]}));
-                }
+Model::Model(std::string name, Path path) : Asset{std::move(name)}, path{std::move(path)} {
+}
 
-                const auto& partMaterial = part.material.value();
+Model::Model(Model&& other) noexcept = default;
 
-                auto& primitive = node.primitives.emplace_back();
-                auto& material = materials.emplace_back();
+Model& Model::operator=(Model&& other) noexcept = default;
 
-                primitive.material = &material;
-                material.uniform.baseColorFactor = partMaterial.baseColorFactor;
-                material.uniform.emissiveFactor = partMaterial.emissiveFactor;
-                material.uniform.metallicRoughnessFactor = partMaterial.metallicRoughnessFactor;
-                material.uniform.normalFactor = Vector4{1.0f};
-                material.uniform.ambientOcclusionFactor = Vector4{1.0f};
+Model::~Model() = default;
 
-                // Only initialize textures if the Vulkan is present (client mode)
-                if (vulkan) {
-                    if (partMaterial.baseColorTexture) {
-                        material.baseColorTexture = resolveTexture(partMaterial.baseColorTexture.value().getUri());
-                    } else {
-                        material.baseColorTexture = assetsManager.getDefaultTextures().baseColor;
-                    }
-
-                    if (partMaterial.normalTexture) {
-                        material.normalTexture = resolveTexture(partMaterial.normalTexture.value().getUri());
-                    } else {
-                        material.normalTexture = assetsManager.getDefaultTextures().normal;
-                    }
-
-                    if (partMaterial.emissiveTexture) {
-                        material.emissiveTexture = resolveTexture(partMaterial.emissiveTexture.value().getUri());
-                    } else {
-                        material.emissiveTexture = assetsManager.getDefaultTextures().emissive;
-                    }
-
-                    if (partMaterial.metallicRoughnessTexture) {
-                        material.metallicRoughnessTexture =
-                            resolveTexture(partMaterial.metallicRoughnessTexture.value().getUri());
-                    } else {
-                        material.metallicRoughnessTexture = assetsManager.getDefaultTextures().metallicRoughness;
-                    }
-
-                    if (partMaterial.ambientOcclusionTexture) {
-                        material.ambientOcclusionTexture =
-                            resolveTexture(partMaterial.ambientOcclusionTexture.value().getUri());
-                    } else {
-                        material.ambientOcclusionTexture = assetsManager.getDefaultTextures().ambient;
-                    }
-
-                    material.maskTexture = assetsManager.getDefaultTextures().mask;
-                }
+Path Model::getBakedPath(const Path& path) {
+    return replaceExtension(path, ".mdl");
+}
 
-                switch (part.indices.value().componentType) {
-                case GltfComponentType::R8: {
-                    primitive.mesh.indexType = VkIndexType::VK_INDEX_TYPE_UINT8_EXT;
-                    break;
-                }
-                case GltfComponentType::R8u: {
-                    primitive.mesh.indexType = VkIndexType::VK_INDEX_TYPE_UINT8_EXT;
-                    break;
-                }
-                case GltfComponentType::R16: {
-                    primitive.mesh.indexType = VkIndexType::VK_INDEX_TYPE_UINT16;
-                    break;
-                }
-                case GltfComponentType::R16u: {
-                    primitive.mesh.indexType = VkIndexType::VK_INDEX_TYPE_UINT16;
-                    break;
-                }
-                case GltfComponentType::R32u: {
-                    primitive.mesh.indexType = VkIndexType::VK_INDEX_TYPE_UINT32;
-                    break;
-                }
-                default: {
-                    EXCEPTION("Invalid index type");
-                }
-                }
+// FNV-1a, only used to tell whether the sources changed
+static void hashBytes(uint64_t& hash, const void* data, const size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+}
 
-                if (part.type != GltfPrimitiveType::Triangles) {
-                    EXCEPTION("Invalid primitive type");
-                }
+template <typename T> static void hashValue(uint64_t& hash, const T& value) {
+    static_assert(std::is_arithmetic_v<T>, "Only arithmetic values can be hashed");
+    hashBytes(hash, &value, sizeof(T));
+}
+
+static void hashFile(uint64_t& hash, const Path& path) {
+    const auto name = path.filename().string();
+    hashBytes(hash, name.data(), name.size());
+    hashValue(hash, static_cast<uint64_t>(Fs::file_size(path)));
+    hashValue(hash, static_cast<int64_t>(Fs::last_write_time(path).time_since_epoch().count()));
+}
+
+uint64_t Model::getSourceStamp(const Path& path) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hashValue(hash, BakedModelFile::version);
+    hashValue(hash, static_cast<uint64_t>(bakeOptions.lods));
+    hashValue(hash, bakeOptions.reduction);
+    hashValue(hash, bakeOptions.maxError);
+    hashValue(hash, bakeOptions.overdrawThreshold);
+    hashValue(hash, bakeOptions.sloppy);
+    hashValue(hash, bakeOptions.deduplicate);
+
+    // The vertices live in the .bin files next to the glTF, which are edited without touching the glTF itself
+    hashFile(hash, path);
+    for (const auto& buffer : GltfFileReader::getBufferPaths(path)) {
+        hashFile(hash, buffer);
+    }
+
+    return hash;
+}
+
+bool Model::isBaked(const Path& path) {
+    return BakedModelFile::isUpToDate(getBakedPath(path), getSourceStamp(path));
+}
+
+void Model::bake(const Path& path) {
+    try {
+        // Stamped before the baking, so sources modified in the meantime are baked again next time
+        const auto source = getSourceStamp(path);
+        BakedModelFile::write(getBakedPath(path), bakeGltf(path, true), source);
+    } catch (...) {
+        EXCEPTION_NESTED("Failed to bake model: '{}'", path);
+    }
+}
 
-                // Only initialize buffers if the Vulkan is present (client mode)
+void Model::load(AssetsManager& assetsManager, VulkanRenderer* vulkan, AudioContext* audio) {
+    (void)audio;
+
+    try {
+        std::optional<BakedModel> baked;
+
+        const auto bakedPath = getBakedPath(path);
+        if (isBaked(path)) {
+            try {
                 if (vulkan) {
-                    std::vector<float> vboData;
-                    if (skin) {
-                        vboData = GltfUtils::combine(positions->accessor,
-                                                     normals->accessor,
-                                                     texCoords->accessor,
-                                                     tangents->accessor,
-                                                     joints->accessor,
-                                                     weights->accessor);
-                    } else {
-                        vboData = GltfUtils::combine(
-                            positions->accessor, normals->accessor, texCoords->accessor, tangents->accessor);
-                    }
-
-                    const auto& iboData = part.indices->bufferView.getBuffer();
-
-                    VulkanBuffer::CreateInfo bufferInfo{};
-                    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-                    bufferInfo.size = vboData.size() * sizeof(float);
-                    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-                    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-                    bufferInfo.memoryUsage = VMA_MEMORY_USAGE_AUTO;
-                    bufferInfo.memoryFlags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-                    primitive.mesh.vbo = vulkan->createBuffer(bufferInfo);
-                    vulkan->copyDataToBuffer(primitive.mesh.vbo, vboData.data(), bufferInfo.size);
-
-                    bufferInfo.size = iboData.size() * sizeof(uint8_t);
-                    bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-                    primitive.mesh.ibo = vulkan->createBuffer(bufferInfo);
-                    vulkan->copyDataToBuffer(primitive.mesh.ibo, iboData.data(), bufferInfo.size);
-
-                    primitive.mesh.count = static_cast<uint32_t>(part.indices->count);
-
-                    bufferInfo.size = iboData.size() * sizeof(uint8_t);
-                    bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-                    material.ubo = vulkan->createBuffer(bufferInfo);
-                    vulkan->copyDataToBuffer(material.ubo, &material.uniform, sizeof(Material::Uniform));
-                }
+                    baked = BakedModelFile::read(bakedPath);
+                } else {
+                    // The server never renders, the meshes are not even read
+                    baked.emplace().collision = BakedModelFile::readCollision(bakedPath);
+                }
+            } catch (std::exception& e) {
+                BACKTRACE(e, "Failed to read baked model: '{}'", getName());
+                baked.reset();
             }
         }
 
-        if (collisions && endsWith(collisions->name, "_CCX")) {
-            if (!collisions->mesh) {
-                EXCEPTION("gltf has collision node '{}' with no mesh", collisions->name);
-            }
-            if (collisions->mesh->primitives.empty()) {
-                EXCEPTION("gltf has collision node '{}' with no mesh primitives", collisions->name);
-            }
-            const auto& part = collisions->mesh->primitives.front();
-            const auto positions = findOne(
-                part.attributes, [](const GltfAttribute& a) -> bool { return a.type == GltfAttributeType::Position; });
+        if (!baked) {
+            logger.warn("Model: '{}' is not baked, loading from gltf", getName());
+            baked = bakeGltf(path, vulkan != nullptr);
+        }
 
-            if (!positions) {
-                EXCEPTION("gltf has collision node '{}' with no vertices", collisions->name);
-            }
+        loadCollision(baked->collision);
 
-            const auto span = positions->accessor.bufferView.getSpan();
-            auto* points = reinterpret_cast<const float*>(span.data());
-            collisionShape = CollisionShape::createConvexHull(points, positions->accessor.count);
+        // Only initialize the nodes if the Vulkan is present (client mode)
+        if (vulkan) {
+            loadNodes(assetsManager, *vulkan, baked->nodes);
+        }
+    } catch (...) {
+        EXCEPTION_NESTED("Failed to load model: '{}'", getName());
+    }
+}
 
-            // Update the bounding box
-            bbMin = Vector3(positions->accessor.min);
-            bbMax = Vector3(positions->accessor.max);
+void Model::loadCollision(const BakedModel::Collision& collision) {
+    bbMin = collision.bbMin;
+    bbMax = collision.bbMax;
+    bbRadius = collision.radius;
 
-            // Update the bounding radius
-            bbRadius = 0.0f;
-            for (size_t i = 0; i < positions->accessor.count; i++) {
-                const auto* point = reinterpret_cast<const float*>(span.data()) + i * 3;
-                bbRadius = std::max(bbRadius, glm::length(Vector3{point[0], point[1], point[2]}));
+    if (!collision.hull.empty()) {
+        collisionShape = CollisionShape::createConvexHull(collision.hull.data(), collision.hull.size() / 3);
+    } else {
+        collisionShape = CollisionShape::createSphere(bbRadius);
+    }
+}
+
+void Model::loadNodes(AssetsManager& assetsManager, VulkanRenderer& vulkan, const std::vector<BakedModel::Node>& src) {
+    const auto resolveTexture = [this, &assetsManager, &vulkan](const std::string& filename,
+                                                                const TexturePtr& fallback) -> TexturePtr {
+        if (filename.empty()) {
+            return fallback;
+        }
+        const auto baseName = Path{filename}.stem().string();
+        auto found = assetsManager.getTextures().findOrNull(baseName);
+        if (found) {
+            return found;
+        }
+        const auto file = path.parent_path() / fixFileNameExt(filename);
+        auto texture = assetsManager.addTexture(file);
+        texture->load(assetsManager, &vulkan, nullptr);
+        return texture;
+    };
+
+    const auto& defaults = assetsManager.getDefaultTextures();
+
+    for (const auto& bakedNode : src) {
+        auto& node = nodes.emplace_back();
+        node.name = bakedNode.name;
+
+        if (!bakedNode.inverseBindMat.empty()) {
+            if (bakedNode.inverseBindMat.size() > maxJoints ||
+                bakedNode.jointsLocalMat.size() != bakedNode.inverseBindMat.size()) {
+                EXCEPTION("Model node: '{}' has invalid skin", bakedNode.name);
             }
+
+            node.skin.count = bakedNode.inverseBindMat.size();
+            std::copy(bakedNode.inverseBindMat.begin(), bakedNode.inverseBindMat.end(), node.skin.inverseBindMat.begin());
+            std::copy(bakedNode.jointsLocalMat.begin(), bakedNode.jointsLocalMat.end(), node.skin.jointsLocalMat.begin());
         }
 
-        if (!collisionShape) {
-            collisionShape = CollisionShape::createSphere(bbRadius);
+        for (const auto& bakedPrimitive : bakedNode.primitives) {
+            if (bakedPrimitive.lods.empty()) {
+                EXCEPTION("Model node: '{}' has primitive with no indices", bakedNode.name);
+            }
+
+            auto& primitive = node.primitives.emplace_back();
+            auto& material = materials.emplace_back();
+            const auto& bakedMaterial = bakedPrimitive.material;
+
+            primitive.material = &material;
+            material.uniform.baseColorFactor = bakedMaterial.baseColorFactor;
+            material.uniform.emissiveFactor = bakedMaterial.emissiveFactor;
+            material.uniform.metallicRoughnessFactor = bakedMaterial.metallicRoughnessFactor;
+            material.uniform.normalFactor = Vector4{1.0f};
+            material.uniform.ambientOcclusionFactor = Vector4{1.0f};
+
+            material.baseColorTexture = resolveTexture(bakedMaterial.baseColorTexture, defaults.baseColor);
+            material.normalTexture = resolveTexture(bakedMaterial.normalTexture, defaults.normal);
+            material.emissiveTexture = resolveTexture(bakedMaterial.emissiveTexture, defaults.emissive);
+            material.metallicRoughnessTexture =
+                resolveTexture(bakedMaterial.metallicRoughnessTexture, defaults.metallicRoughness);
+            material.ambientOcclusionTexture =
+                resolveTexture(bakedMaterial.ambientOcclusionTexture, defaults.ambient);
+            material.maskTexture = defaults.mask;
+
+            VulkanBuffer::CreateInfo bufferInfo{};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = bakedPrimitive.vertices.size() * sizeof(char);
+            bufferInfo.usage =
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            bufferInfo.memoryUsage = VMA_MEMORY_USAGE_AUTO;
+            bufferInfo.memoryFlags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+            primitive.mesh.vbo = vulkan.createBuffer(bufferInfo);
+            vulkan.copyDataToBuffer(primitive.mesh.vbo, bakedPrimitive.vertices.data(), bufferInfo.size);
+
+            bufferInfo.size = bakedPrimitive.indices.size() * sizeof(char);
+            bufferInfo.usage =
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            primitive.mesh.ibo = vulkan.createBuffer(bufferInfo);
+            vulkan.copyDataToBuffer(primitive.mesh.ibo, bakedPrimitive.indices.data(), bufferInfo.size);
+
+            primitive.mesh.indexType =
+                bakedPrimitive.indices32 ? VkIndexType::VK_INDEX_TYPE_UINT32 : VkIndexType::VK_INDEX_TYPE_UINT16;
+            primitive.mesh.count = bakedPrimitive.lods.front().count;
+            primitive.mesh.radius = bakedPrimitive.radius;
+            for (const auto& lod : bakedPrimitive.lods) {
+                primitive.mesh.lods.push_back({lod.offset, lod.count, lod.error});
+            }
+
+            bufferInfo.size = sizeof(Material::Uniform);
+            bufferInfo.usage =
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            material.ubo = vulkan.createBuffer(bufferInfo);
+            vulkan.copyDataToBuffer(material.ubo, &material.uniform, sizeof(Material::Uniform));
         }
-    } catch (...) {
-        EXCEPTION_NESTED("Failed to load model: '{}'", getName());
     }
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../File/BakedModelFile.hpp"
 #include "../Math/Matrix.hpp"
 #include "CollisionShape.hpp"
 #include "Primitive.hpp"
@@ -35,6 +36,14 @@ public:
 
     void load(AssetsManager& assetsManager, VulkanRenderer* vulkan, AudioContext* audio) override;
 
+    // Processes the glTF file into the baked file next to it, which is then loaded instead
+    static void bake(const Path& path);
+    static Path getBakedPath(const Path& path);
+    // Changes with the glTF file, its buffer files, and the baking settings
+    static uint64_t getSourceStamp(const Path& path);
+    // Whether the baked file exists and was made from the current sources
+    static bool isBaked(const Path& path);
+
     [[nodiscard]] const std::list<Node>& getNodes() const {
         return nodes;
     }
@@ -58,6 +67,9 @@ public:
     static std::shared_ptr<Model> from(const std::string& name);
 
 private:
+    void loadCollision(const BakedModel::Collision& collision);
+    void loadNodes(AssetsManager& assetsManager, VulkanRenderer& vulkan, const std::vector<BakedModel::Node>& src);
+
     Path path;
     Vector3 bbMin{0.0f};
     Vector3 bbMax{0.0f};
@@ -51,6 +51,10 @@ public:
     explicit PlanetType(std::string name, Path path);
     void load(AssetsManager& assetsManager, VulkanRenderer* vulkan, AudioContext* audio) override;
 
+    [[nodiscard]] const Path& getPath() const {
+        return path;
+    }
+
     [[nodiscard]] const TexturePtr& getBiomeTexture() const {
         return definition.biome;
     }
@@ -0,0 +1,105 @@
+#include "RenderCache.hpp"
+#include "../File/MsgpackFileReader.hpp"
+#include "../File/MsgpackFileWriter.hpp"
+#include "../Utils/Exceptions.hpp"
+#include "../Utils/Md5.hpp"
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+RenderCache::Key::Key(RenderCache& cache) : cache{cache} {
+    add(version);
+}
+
+RenderCache::Key& RenderCache::Key::add(const std::string& value) {
+    // Length prefixed, so the neighbouring values can not be mistaken for each other
+    data += std::to_string(value.size());
+    data += ':';
+    data += value;
+    return *this;
+}
+
+RenderCache::Key& RenderCache::Key::add(const int64_t value) {
+    return add(std::to_string(value));
+}
+
+RenderCache::Key& RenderCache::Key::addFile(const Path& path) {
+    // The built-in assets (the default textures) are not backed by any file
+    if (path.empty()) {
+        return add(std::string{});
+    }
+    return add(cache.hashFile(path));
+}
+
+std::string RenderCache::Key::get() const {
+    return md5sum(data.data(), data.size());
+}
+
+RenderCache::RenderCache(Path path) : path{std::move(path)} {
+    std::filesystem::create_directories(this->path);
+}
+
+RenderCache::Key RenderCache::createKey() {
+    return Key{*this};
+}
+
+const std::string& RenderCache::hashFile(const Path& file) {
+    const auto name = file.string();
+    const auto it = fileHashes.find(name);
+    if (it != fileHashes.end()) {
+        return it->second;
+    }
+
+    const auto data = readFileBinary(file);
+    return fileHashes.emplace(name, md5sum(data.data(), data.size())).first->second;
+}
+
+Path RenderCache::getEntryPath(const std::string& name) const {
+    return path / fmt::format("{}.bin", name);
+}
+
+std::optional<std::vector<RenderCache::Image>> RenderCache::load(const std::string& name, const std::string& key) {
+    const auto entryPath = getEntryPath(name);
+    if (!std::filesystem::exists(entryPath)) {
+        ++misses;
+        return std::nullopt;
+    }
+
+    try {
+        MsgpackFileReader file{entryPath};
+
+        std::string storedKey;
+        if (!file.unpack(storedKey) || storedKey != key) {
+            ++misses;
+            return std::nullopt;
+        }
+
+        std::vector<Image> images;
+        if (!file.unpack(images)) {
+            EXCEPTION("Cache entry has no images");
+        }
+
+        ++hits;
+        return images;
+    } catch (std::exception& e) {
+        // A damaged entry is not fatal, it is simply rendered again
+        BACKTRACE(e, "Failed to read render cache entry: '{}'", entryPath);
+        ++misses;
+        return std::nullopt;
+    }
+}
+
+void RenderCache::store(const std::string& name, const std::string& key, const std::vector<Image>& images) {
+    const auto entryPath = getEntryPath(name);
+
+    try {
+        MsgpackFileWriter file{entryPath};
+        file.pack(key);
+        file.pack(images);
+    } catch (std::exception& e) {
+        BACKTRACE(e, "Failed to write render cache entry: '{}'", entryPath);
+        std::error_code ec;
+        std::filesystem::remove(entryPath, ec);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../Math/Vector.hpp"
+#include "../Utils/Path.hpp"
+#include <msgpack.hpp>
+#include <optional>
+#include <unordered_map>
+
+namespace Engine {
+// Keeps the images rendered from the assets during the startup (thumbnails, low-res planet textures) on the disk.
+// Every entry is a single file stored together with the key it was rendered from, the key is a hash of everything
+// the output depends on. An entry whose key no longer matches is rendered again and overwritten.
+class ENGINE_API RenderCache {
+public:
+    // Bump whenever the renderers change in a way that changes their output
+    static constexpr int version = 1;
+
+    struct Image {
+        Vector2i size;
+        std::vector<char> pixels;
+
+        MSGPACK_DEFINE_ARRAY(size, pixels);
+    };
+
+    class Key {
+    public:
+        explicit Key(RenderCache& cache);
+
+        Key& add(const std::string& value);
+        Key& add(int64_t value);
+        Key& addFile(const Path& path);
+
+        [[nodiscard]] std::string get() const;
+
+    private:
+        RenderCache& cache;
+        std::string data;
+    };
+
+    explicit RenderCache(Path path);
+
+    Key createKey();
+    std::optional<std::vector<Image>> load(const std::string& name, const std::string& key);
+    void store(const std::string& name, const std::string& key, const std::vector<Image>& images);
+
+    [[nodiscard]] size_t getHits() const {
+        return hits;
+    }
+    [[nodiscard]] size_t getMisses() const {
+        return misses;
+    }
+
+private:
+    const std::string& hashFile(const Path& file);
+    Path getEntryPath(const std::string& name) const;
+
+    Path path;
+    // The textures are shared by many blocks, each file is only read once
+    std::unordered_map<std::string, std::string> fileHashes;
+    size_t hits{0};
+    size_t misses{0};
+};
+} // namespace Engine
@@ -32,8 +32,26 @@ struct ENGINE_API VoxelShape {
         };
     };
 
+    // What the grid mesh is uploaded as, the texture coordinates carry the layer and stay in full precision
+    struct VertexQuantized {
+        Vector3 position;
+        Vector4b normal;
+        Vector4 texCoords;
+        Vector4b tangent;
+
+        static VulkanVertexLayoutMap getLayout() {
+            return {
+                {0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexQuantized, position)},
+                {1, VK_FORMAT_R8G8B8A8_SNORM, offsetof(VertexQuantized, normal)},
+                {2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(VertexQuantized, texCoords)},
+                {3, VK_FORMAT_R8G8B8A8_SNORM, offsetof(VertexQuantized, tangent)},
+            };
+        };
+    };
+
     static_assert(sizeof(VertexCached) == sizeof(float) * 6, "struct Vertex must be tightly packed");
     static_assert(sizeof(VertexFinal) == sizeof(float) * 14, "struct VertexFinal must be tightly packed");
+    static_assert(sizeof(VertexQuantized) == sizeof(float) * 9, "struct VertexQuantized must be tightly packed");
 
     enum Face : size_t {
         Default = 0,
@@ -1,5 +1,6 @@
 #include "Application.hpp"
 #include "../Graphics/RendererBackground.hpp"
+#include "../Graphics/RendererPlanetSurface.hpp"
 #include "../Graphics/RendererScenePbr.hpp"
 #include "../Graphics/RendererThumbnail.hpp"
 #include "ViewBuild.hpp"
@@ -247,6 +248,8 @@ void Application::setLoadSaveName(const Path& path) {
 }
 
 void Application::render(const Vector2i& viewport, const float deltaTime) {
+    PROFILE_SCOPE("Application::render");
+
     auto& computeFence = computeQueueFences.at(getCurrentFrameNum());
     auto& computeSemaphore = computeQueueSemaphores.at(getCurrentFrameNum());
     computeFence.wait();
@@ -280,6 +283,7 @@ void Application::render(const Vector2i& viewport, const float deltaTime) {
     }
 
     if (client) {
+        PROFILE_SCOPE("Client::update");
         client->update(deltaTime);
     }
 
@@ -326,12 +330,16 @@ void Application::render(const Vector2i& viewport, const float deltaTime) {
     }*/
 
     if (views) {
+        PROFILE_SCOPE("ViewContext::render");
         views->update(deltaTime, viewport);
         views->render(vkb, vkbc, *renderer, viewport);
     }
 
     // GUI
-    guiManager.draw(viewport);
+    {
+        PROFILE_SCOPE("GuiManager::draw");
+        guiManager.draw(viewport);
+    }
 
     // HUD
     VulkanRenderPassBeginInfo renderPassInfo{};
@@ -361,6 +369,7 @@ void Application::render(const Vector2i& viewport, const float deltaTime) {
 
     renderVersion(viewport);
     renderFrameTime(viewport);
+    renderProfiler(viewport);
 
     if (views && views->getCurrent()) {
         views->renderCanvas(canvas, viewport);
@@ -387,6 +396,9 @@ void Application::render(const Vector2i& viewport, const float deltaTime) {
     vkbc.end();
     vkb.end();
 
+    // Glyphs rasterized while recording this frame must be in the atlas before the frame is submitted
+    font.flush();
+
     VulkanSubmitInfo submitInfo{};
     submitInfo.signal = &computeSemaphore;
     submitInfo.fence = &computeFence;
@@ -513,6 +525,54 @@ void Application::renderFrameTime(const Vector2i& viewport) {
     }
 }
 
+void Application::renderProfiler(const Vector2i& viewport) {
+    static const Color4 color{Colors::text * alpha(0.5f)};
+
+    const auto posX = static_cast<float>(viewport.x) - 450.0f - 170.0f;
+    const auto fontSize = static_cast<float>(config.guiFontSize);
+    auto posY = 5.0f + fontSize * 7.0f;
+
+    // GPU time of each scene render pass
+    if (renderer && views && views->getCurrent()) {
+        for (const auto& passTime : renderer->getPassTimes()) {
+            const auto timeMs = static_cast<float>(passTime.duration.count()) / 1000000.0f;
+            const auto text = fmt::format("{}: {:.2f}ms", passTime.name, timeMs);
+            canvas.drawText({posX, posY}, text, font, config.guiFontSize, color);
+            posY += fontSize;
+        }
+    }
+
+#ifdef TEMPORARY_ESCAPE_PROFILER
+    // Most expensive CPU zones averaged over the last second, refreshed once per second
+    const auto now = std::chrono::steady_clock::now();
+    if (now - perf.zonesTime > std::chrono::seconds{1}) {
+        perf.zonesTime = now;
+        perf.zones = Profiler::getInstance().getStats(std::chrono::seconds{1});
+        if (perf.zones.size() > 10) {
+            perf.zones.resize(10);
+        }
+    }
+
+    posY += fontSize;
+    for (const auto& stat : perf.zones) {
+        const auto avgMs = static_cast<float>(stat.total.count()) / static_cast<float>(stat.count) / 1000000.0f;
+        const auto maxMs = static_cast<float>(stat.max.count()) / 1000000.0f;
+        const auto text = fmt::format("{}: {:.2f}ms (max {:.2f}ms)", stat.name, avgMs, maxMs);
+        canvas.drawText({posX, posY}, text, font, config.guiFontSize, color);
+        posY += fontSize;
+    }
+#endif
+}
+
+void Application::exportProfilerTrace() {
+    const auto path = config.userdataPath / fmt::format("trace-{}.json", std::time(nullptr));
+    try {
+        Profiler::getInstance().exportChromeTrace(path);
+    } catch (std::exception& e) {
+        BACKTRACE(e, "Failed to export profiler trace");
+    }
+}
+
 void Application::renderBanner(const Vector2i& viewport) {
     auto adjustedViewport = viewport - Vector2i{0, 200.0f};
     const auto size = bannerTexture.get().getSize2D();
@@ -617,21 +677,95 @@ void Application::startServer() {
     });
 }
 
-void Application::createEmptyThumbnail(RendererThumbnail& thumbnailRenderer) {
+// An entry written with different settings is not used, it is rendered again
+static bool matchesImage(const RenderCache::Image& image, const Vector2i& size, const size_t bytesPerPixel) {
+    return image.size == size && image.pixels.size() == static_cast<size_t>(size.x * size.y) * bytesPerPixel;
+}
+
+ImagePtr Application::createThumbnail(const std::string& name, const std::string& key,
+                                      const ThumbnailRendererProvider& thumbnailRenderer,
+                                      const std::function<void(RendererThumbnail&)>& render) {
+    auto& atlas = assetsManager->getImageAtlas();
+    const Vector2i size{config.thumbnailSize, config.thumbnailSize};
+
+    const auto images = renderCache->load(name, key);
+    if (images && images->size() == 1 && matchesImage(images->front(), size, 4)) {
+        return assetsManager->addImage(name, atlas.add(size, images->front().pixels.data()));
+    }
+
+    auto& renderer = thumbnailRenderer();
+    render(renderer);
+    const auto alloc = atlas.add(renderer.getViewport(), renderer.getFinalBuffer());
+
+    // Read back from the atlas rather than the render target, it already holds the final 8-bit pixels
+    RenderCache::Image image{};
+    image.size = alloc.size;
+    image.pixels =
+        copyImageToData(*alloc.texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, alloc.pos, 0, alloc.size);
+    renderCache->store(name, key, {image});
+
+    return assetsManager->addImage(name, alloc);
+}
+
+void Application::createEmptyThumbnail(const ThumbnailRendererProvider& thumbnailRenderer) {
     logger.info("Creating empty thumbnail");
 
-    thumbnailRenderer.render(nullptr, VoxelShape::Cube);
-    const auto alloc =
-        assetsManager->getImageAtlas().add(thumbnailRenderer.getViewport(), thumbnailRenderer.getFinalBuffer());
-    assetsManager->addImage("block_empty_image", alloc);
+    const auto key = renderCache->createKey().add("block_empty").add(config.thumbnailSize).get();
+    const auto render = [](RendererThumbnail& renderer) { renderer.render(nullptr, VoxelShape::Cube); };
+    createThumbnail("block_empty_image", key, thumbnailRenderer, render);
 }
 
-void Application::createPlanetLowResTextures(RendererPlanetSurface& renderer) {
-    uint64_t seed = 1;
-    for (auto& planet : assetsManager->getPlanetTypes().findAll()) {
-        auto textures = renderer.renderPlanet(seed++ * 100, planet);
-        planet->setLowResTextures(std::move(textures));
+bool Application::loadPlanetLowResTextures(const PlanetTypePtr& planet,
+                                           const std::vector<RenderCache::Image>& images) {
+    const Vector2i size{config.graphics.planetLowResTextureSize, config.graphics.planetLowResTextureSize};
+
+    // Six sides of the color, metallic roughness, and normal cube maps
+    static constexpr std::array<size_t, 3> bytesPerPixel = {4, 2, 4};
+    if (images.size() != bytesPerPixel.size() * 6) {
+        return false;
+    }
+    for (size_t i = 0; i < images.size(); i++) {
+        if (!matchesImage(images[i], size, bytesPerPixel[i / 6])) {
+            return false;
+        }
+    }
+
+    auto textures = RendererPlanetSurface::createTextures(*this, size);
+    const std::array<VulkanTexture*, 3> targets = {
+        &textures.getColor(),
+        &textures.getMetallicRoughness(),
+        &textures.getNormal(),
+    };
+
+    for (size_t t = 0; t < targets.size(); t++) {
+        auto& texture = *targets[t];
+        transitionImageLayout(texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        for (size_t side = 0; side < 6; side++) {
+            const auto& image = images[t * 6 + side];
+            copyDataToImage(
+                texture, 0, {0, 0}, static_cast<int>(side), image.size, image.pixels.data(), image.pixels.size());
+        }
+        generateMipMaps(texture);
+    }
+
+    planet->setLowResTextures(std::move(textures));
+    return true;
+}
+
+std::vector<RenderCache::Image> Application::readPlanetLowResTextures(const PlanetTextures& textures) {
+    const Vector2i size{config.graphics.planetLowResTextureSize, config.graphics.planetLowResTextureSize};
+
+    std::vector<RenderCache::Image> images;
+    for (const auto* texture : {&textures.getColor(), &textures.getMetallicRoughness(), &textures.getNormal()}) {
+        for (auto side = 0; side < 6; side++) {
+            // Only the base level is kept, the mip maps are generated again when loaded
+            auto& image = images.emplace_back();
+            image.size = size;
+            image.pixels =
+                copyImageToData(*texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, {0, 0}, side, size);
+        }
     }
+    return images;
 }
 
 void Application::createPlanetLowResTextures() {
@@ -639,39 +773,85 @@ void Application::createPlanetLowResTextures() {
 
     gui.loadStatus->setStatus("Rendering planets...", 0.5f);
 
+    renderCache = std::make_unique<RenderCache>(config.userdataPath / "cache");
+    planetCacheKeys.clear();
+
     const Vector2i viewport{config.graphics.planetLowResTextureSize, config.graphics.planetLowResTextureSize};
-    auto rendererPlanetSurfaceLowRes =
-        std::make_unique<RendererPlanetSurface>(config, viewport, *this, *renderResources, *voxelShapeCache);
+    std::unique_ptr<RendererPlanetSurface> rendererPlanetSurfaceLowRes;
 
-    createPlanetLowResTextures(*rendererPlanetSurfaceLowRes);
+    uint64_t seed = 1;
+    for (auto& planet : assetsManager->getPlanetTypes().findAll()) {
+        const auto planetSeed = seed++ * 100;
+
+        const auto name = fmt::format("{}_low_res", planet->getName());
+        const auto key = renderCache->createKey()
+                             .add(name)
+                             .add(config.graphics.planetLowResTextureSize)
+                             .add(static_cast<int64_t>(planetSeed))
+                             .addFile(planet->getPath())
+                             .addFile(planet->getBiomeTexture()->getPath())
+                             .addFile(planet->getRoughnessTexture()->getPath())
+                             .get();
+        planetCacheKeys[planet->getName()] = key;
+
+        const auto images = renderCache->load(name, key);
+        if (images && loadPlanetLowResTextures(planet, *images)) {
+            continue;
+        }
+
+        if (!rendererPlanetSurfaceLowRes) {
+            rendererPlanetSurfaceLowRes =
+                std::make_unique<RendererPlanetSurface>(config, viewport, *this, *renderResources, *voxelShapeCache);
+        }
+
+        auto textures = rendererPlanetSurfaceLowRes->renderPlanet(planetSeed, planet);
+        renderCache->store(name, key, readPlanetLowResTextures(textures));
+        planet->setLowResTextures(std::move(textures));
+    }
 
     NEXT(createThumbnails());
 }
 
-void Application::createPlanetThumbnails(RendererThumbnail& thumbnailRenderer) {
+void Application::createPlanetThumbnails(const ThumbnailRendererProvider& thumbnailRenderer) {
     logger.info("Creating planet thumbnails");
 
     for (const auto& planet : assetsManager->getPlanetTypes().findAll()) {
-        thumbnailRenderer.render(planet);
-        const auto alloc =
-            assetsManager->getImageAtlas().add(thumbnailRenderer.getViewport(), thumbnailRenderer.getFinalBuffer());
-
         const auto name = fmt::format("{}_image", planet->getName());
-        planet->setThumbnail(assetsManager->addImage(name, alloc));
+        const auto key = renderCache->createKey()
+                             .add(name)
+                             .add(config.thumbnailSize)
+                             .add(planetCacheKeys.at(planet->getName()))
+                             .get();
+
+        const auto render = [&](RendererThumbnail& renderer) { renderer.render(planet); };
+        planet->setThumbnail(createThumbnail(name, key, thumbnailRenderer, render));
     }
 }
 
-void Application::createBlockThumbnails(RendererThumbnail& thumbnailRenderer) {
+void Application::createBlockThumbnails(const ThumbnailRendererProvider& thumbnailRenderer) {
     logger.info("Creating block thumbnails");
 
     for (const auto& block : assetsManager->getBlocks().findAll()) {
-        for (const auto shape : block->getShapes()) {
-            thumbnailRenderer.render(block, shape);
-            const auto alloc =
-                assetsManager->getImageAtlas().add(thumbnailRenderer.getViewport(), thumbnailRenderer.getFinalBuffer());
+        // The shapes share the same block definition and textures
+        auto blockKey = renderCache->createKey();
+        blockKey.add(config.thumbnailSize).addFile(block->getPath());
+        for (const auto& material : block->getMaterials()) {
+            for (const auto* texture : {&material.baseColorTexture,
+                                        &material.emissiveTexture,
+                                        &material.normalTexture,
+                                        &material.ambientOcclusionTexture,
+                                        &material.metallicRoughnessTexture,
+                                        &material.maskTexture}) {
+                blockKey.addFile(*texture ? (*texture)->getPath() : Path{});
+            }
+        }
 
+        for (const auto shape : block->getShapes()) {
             const auto name = fmt::format("{}_{}_image", block->getName(), VoxelShape::typeNames[shape]);
-            block->setThumbnail(shape, assetsManager->addImage(name, alloc));
+            const auto key = RenderCache::Key{blockKey}.add(name).get();
+
+            const auto render = [&](RendererThumbnail& renderer) { renderer.render(block, shape); };
+            block->setThumbnail(shape, createThumbnail(name, key, thumbnailRenderer, render));
         }
     }
 }
@@ -681,14 +861,24 @@ void Application::createThumbnails() {
 
     gui.loadStatus->setStatus("Creating thumbnails...", 0.6f);
 
-    auto rendererThumbnail = std::make_unique<RendererThumbnail>(config, *this, *renderResources, *voxelShapeCache);
+    std::unique_ptr<RendererThumbnail> rendererThumbnail;
+    const auto thumbnailRenderer = [&]() -> RendererThumbnail& {
+        if (!rendererThumbnail) {
+            rendererThumbnail = std::make_unique<RendererThumbnail>(config, *this, *renderResources, *voxelShapeCache);
+        }
+        return *rendererThumbnail;
+    };
 
-    createBlockThumbnails(*rendererThumbnail);
-    createEmptyThumbnail(*rendererThumbnail);
-    createPlanetThumbnails(*rendererThumbnail);
+    createBlockThumbnails(thumbnailRenderer);
+    createEmptyThumbnail(thumbnailRenderer);
+    createPlanetThumbnails(thumbnailRenderer);
 
     assetsManager->finalize(*this);
 
+    logger.info("Render cache hits: {} misses: {}", renderCache->getHits(), renderCache->getMisses());
+    renderCache.reset();
+    planetCacheKeys.clear();
+
     views = std::make_unique<ViewContext>(config, *this, *assetsManager, guiManager, *rendererBackground);
 
     if (!connectServerId.empty()) {
@@ -764,7 +954,11 @@ void Application::createSceneRenderer(const Vector2i& viewport) {
     renderOptions.ssao = config.graphics.ssao;
     renderOptions.bloom = config.graphics.bloom;
     renderOptions.fxaa = config.graphics.fxaa;
+    renderOptions.lodThreshold = config.graphics.lodThreshold;
     renderer = std::make_unique<RendererScenePbr>(renderOptions, *this, *renderResources);
+#ifdef TEMPORARY_ESCAPE_PROFILER
+    renderer->setGpuTimingEnabled(config.graphics.gpuTiming);
+#endif
 }
 
 void Application::createRenderers() {
@@ -940,6 +1134,13 @@ void Application::eventMouseScroll(const int xscroll, const int yscroll) {
 void Application::eventKeyPressed(const Key key, const Modifiers modifiers) {
     guiManager.eventKeyPressed(key, modifiers);
 
+#ifdef TEMPORARY_ESCAPE_PROFILER
+    if (modifiers & Modifier::Ctrl && key == Key::LetterP) {
+        exportProfilerTrace();
+        return;
+    }
+#endif
+
     if (modifiers == 0 && key == Key::LetterM && !view.editor && !isViewsInputSuspended()) {
         if (views->getCurrent() == view.galaxy) {
             views->setCurrent(view.space);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../Assets/RenderCache.hpp"
 #include "../Audio/AudioContext.hpp"
 #include "../Font/FontFamilyDefault.hpp"
 #include "../Graphics/RendererCanvas.hpp"
@@ -16,6 +17,7 @@
 #include "../Gui/Windows/GuiWindowSettings.hpp"
 #include "../Server/Server.hpp"
 #include "../Utils/PerformanceRecord.hpp"
+#include "../Utils/Profiler.hpp"
 #include "../Vulkan/VulkanRenderer.hpp"
 #include "BannerImage.hpp"
 #include "Client.hpp"
@@ -57,6 +59,9 @@ public:
     void setLoadSaveName(const Path& path);
 
 private:
+    // The thumbnail renderer is only created once the first thumbnail is missing in the render cache
+    using ThumbnailRendererProvider = std::function<RendererThumbnail&()>;
+
     void checkOnlineServices();
     void quitToMenu();
     void shutdownServerSide();
@@ -68,6 +73,8 @@ private:
     void loadProfile();
     void renderVersion(const Vector2i& viewport);
     void renderFrameTime(const Vector2i& viewport);
+    void renderProfiler(const Vector2i& viewport);
+    void exportProfilerTrace();
     void renderBanner(const Vector2i& viewport);
     void checkForClientScene();
     void loadAssets();
@@ -87,11 +94,15 @@ private:
     void startSinglePlayer();
     void startConnectServer(const std::string& serverId);
     void startEditor();
-    void createPlanetLowResTextures(RendererPlanetSurface& rendererPlanetSurface);
     void createPlanetLowResTextures();
-    void createBlockThumbnails(RendererThumbnail& thumbnailRenderer);
-    void createEmptyThumbnail(RendererThumbnail& thumbnailRenderer);
-    void createPlanetThumbnails(RendererThumbnail& thumbnailRenderer);
+    bool loadPlanetLowResTextures(const PlanetTypePtr& planet, const std::vector<RenderCache::Image>& images);
+    std::vector<RenderCache::Image> readPlanetLowResTextures(const PlanetTextures& textures);
+    void createBlockThumbnails(const ThumbnailRendererProvider& thumbnailRenderer);
+    void createEmptyThumbnail(const ThumbnailRendererProvider& thumbnailRenderer);
+    void createPlanetThumbnails(const ThumbnailRendererProvider& thumbnailRenderer);
+    ImagePtr createThumbnail(const std::string& name, const std::string& key,
+                             const ThumbnailRendererProvider& thumbnailRenderer,
+                             const std::function<void(RendererThumbnail&)>& render);
     bool isViewsInputSuspended() const;
     void showError(std::string message);
 
@@ -136,6 +147,9 @@ private:
     std::unique_ptr<RenderResources> renderResources;
     std::unique_ptr<RendererScenePbr> renderer;
     std::unique_ptr<VoxelShapeCache> voxelShapeCache;
+    std::unique_ptr<RenderCache> renderCache;
+    // Keys of the low-res textures, the planet thumbnails are rendered from them
+    std::unordered_map<std::string, std::string> planetCacheKeys;
     std::unique_ptr<Client> client;
     std::unique_ptr<ViewContext> views;
     PlayerLocalProfile playerLocalProfile;
@@ -150,6 +164,8 @@ private:
         PerformanceRecord frameTime;
         PerformanceRecord renderTime;
         PerformanceRecord computeTime;
+        std::vector<Profiler::Stat> zones;
+        std::chrono::steady_clock::time_point zonesTime;
     } perf;
 
     Server::Options serverOptions;
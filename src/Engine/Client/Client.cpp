@@ -1,4 +1,5 @@
 #include "Client.hpp"
+#include "../Scene/Controllers/ControllerBullets.hpp"
 #include "../Scene/Controllers/ControllerNetwork.hpp"
 #include "../Scene/Controllers/ControllerTurret.hpp"
 #include "../Server/MatchmakerClient.hpp"
@@ -26,10 +27,10 @@ Client::Client(const Config& config, AssetsManager& assetsManager, const PlayerL
     HANDLE_REQUEST2(MessageFetchRegionsResponse);
     HANDLE_REQUEST2(MessageFetchFactionsResponse);
     HANDLE_REQUEST2(MessageFetchSystemsResponse);
-    HANDLE_REQUEST2(MessageSceneUpdateEvent);
+    HANDLE_RAW_REQUEST2(MessageSceneUpdateEvent);
     HANDLE_REQUEST2(MessageFetchPlanetsResponse);
     HANDLE_REQUEST2(MessageFetchSectorsResponse);
-    // HANDLE_REQUEST(MessageSceneBulletsEvent);
+    HANDLE_REQUEST2(MessageSceneBulletsEvent);
     HANDLE_REQUEST2(MessagePlayerControlEvent);
     // addHandler(this, &Client::handleSceneSnapshot, "MessageComponentSnapshot");
 
@@ -451,20 +452,20 @@ void Client::handle(Request2<MessageFetchSectorsResponse> req) {
     });
 }
 
-void Client::handle(Request2<MessageSceneUpdateEvent> req) {
+void Client::handle(RawRequest2<MessageSceneUpdateEvent> req) {
     // logger.debug("MessageSceneUpdateEvent received");
     sync.postSafe([=, r = std::move(req)]() {
         // Update, create, or delete entities in a scene
-        scene->getController<ControllerNetwork>().receiveUpdate(r.object());
+        scene->getController<ControllerNetwork>().receiveUpdate(r.body());
     });
 }
 
-/*void Client::handle(Request<MessageSceneBulletsEvent> req) {
-    sync.postSafe([=]() {
-        // Update, create, or delete entities in a scene
-        scene->getController<ControllerTurret>().receiveBullets(req.object());
+void Client::handle(Request2<MessageSceneBulletsEvent> req) {
+    sync.postSafe([=, r = std::move(req)]() {
+        // Spawn the fired bullets and remove the ones that hit something
+        scene->getController<ControllerBullets>().receiveEvents(r.get());
     });
-}*/
+}
 
 void Client::handle(Request2<MessagePlayerControlEvent> req) {
     sync.postSafe([=]() {
@@ -77,8 +77,8 @@ public:
     void handle(Request2<MessageFetchRegionsResponse> req);
     void handle(Request2<MessageFetchPlanetsResponse> req);
     void handle(Request2<MessageFetchSectorsResponse> req);
-    void handle(Request2<MessageSceneUpdateEvent> req);
-    // void handle(Request<MessageSceneBulletsEvent> req);
+    void handle(RawRequest2<MessageSceneUpdateEvent> req);
+    void handle(Request2<MessageSceneBulletsEvent> req);
     void handle(Request2<MessagePlayerControlEvent> req);
 
     // Used by unit tests for synchronized assertions
@@ -68,9 +68,13 @@ struct Config {
         bool fxaa = true;
         bool bloom = true;
         bool debugDraw = false;
+        // Timestamp queries around the scene passes, only read when the profiler is compiled in
+        bool gpuTiming = false;
         int ssao = 32;
         int shadowsSize = 2048;
         int shadowsLevel = 1;
+        // Largest allowed error of the simplified meshes in pixels, zero always renders the full detail
+        float lodThreshold = 1.0f;
         Vector2i textureArraySize{1024, 1024};
 
         void convert(const Xml::Node& xml) {
@@ -86,7 +90,9 @@ struct Config {
             xml.convert("ssao", ssao);
             xml.convert("shadowsSize", shadowsSize);
             xml.convert("shadowsLevel", shadowsLevel);
+            xml.convert("lodThreshold", lodThreshold);
             xml.convert("debugDraw", debugDraw);
+            xml.convert("gpuTiming", gpuTiming);
         }
 
         void pack(Xml::Node& xml) const {
@@ -102,7 +108,9 @@ struct Config {
             xml.pack("ssao", ssao);
             xml.pack("shadowsSize", shadowsSize);
             xml.pack("shadowsLevel", shadowsLevel);
+            xml.pack("lodThreshold", lodThreshold);
             xml.pack("debugDraw", debugDraw);
+            xml.pack("gpuTiming", gpuTiming);
         }
     } graphics;
 
@@ -122,17 +130,82 @@ struct Config {
         uint64_t dbCacheSize{256};
         bool dbDebug{false};
         bool dbCompression{true};
+        // Export of the RocksDB internal statistics, costs a few percent of throughput
+        bool dbStatistics{true};
+        // Number of unpacked objects kept in memory in front of the database, zero disables it
+        uint64_t dbObjectCacheSize{50000};
+        // Prometheus metrics endpoint, zero disables it
+        uint16_t metricsPort{0};
+        std::string metricsBindAddress{"127.0.0.1"};
+        // Periodic dump of all metrics into the log, zero disables it
+        int metricsLogIntervalSec{300};
+        // How often the changed sector entities are persisted, zero disables the sector checkpoints
+        int sectorCheckpointIntervalSec{30};
+        // Threads running the NPC behaviour trees of a sector, zero uses all cores
+        uint64_t agentThreads{0};
+        // Initialized Lua states kept ready for starting sectors, zero creates them on demand
+        uint64_t luaPoolSize{2};
+        // Player actions waiting per session in a sector, the rest is dropped
+        uint64_t sectorInboxCapacity{64};
+        // Cost of the player actions a single session can run in a sector per tick
+        uint64_t sectorInboxBudget{16};
+        // Seconds a sector stays loaded after the last player left, zero keeps it loaded.
+        // Needs the sector checkpoints, the hibernated sector is loaded back from them.
+        int sectorHibernateAfterSec{60};
+        // Estimated memory of the loaded sectors above which the least recently used empty ones are hibernated
+        // before their time, zero disables it
+        uint64_t sectorMemoryBudgetMb{0};
+        // Sectors without players are updated once per this many ticks and without the physics step,
+        // one keeps them at the full rate
+        uint64_t sectorBackgroundTicks{10};
+        // Navigation volume of the sectors is 2^depth cells of the size per side
+        uint64_t pathfindingDepth{6};
+        uint64_t pathfindingCellSize{32};
+        // Recently found paths kept per sector, zero disables the cache
+        uint64_t pathfindingCacheSize{256};
 
         void convert(const Xml::Node& xml) {
             xml.convert("dbCacheSize", dbCacheSize);
             xml.convert("dbDebug", dbDebug);
             xml.convert("dbCompression", dbCompression);
+            xml.convert("dbStatistics", dbStatistics, false);
+            xml.convert("dbObjectCacheSize", dbObjectCacheSize, false);
+            xml.convert("metricsPort", metricsPort, false);
+            xml.convert("metricsBindAddress", metricsBindAddress, false);
+            xml.convert("metricsLogIntervalSec", metricsLogIntervalSec, false);
+            xml.convert("sectorCheckpointIntervalSec", sectorCheckpointIntervalSec, false);
+            xml.convert("agentThreads", agentThreads, false);
+            xml.convert("luaPoolSize", luaPoolSize, false);
+            xml.convert("sectorInboxCapacity", sectorInboxCapacity, false);
+            xml.convert("sectorInboxBudget", sectorInboxBudget, false);
+            xml.convert("sectorHibernateAfterSec", sectorHibernateAfterSec, false);
+            xml.convert("sectorMemoryBudgetMb", sectorMemoryBudgetMb, false);
+            xml.convert("sectorBackgroundTicks", sectorBackgroundTicks, false);
+            xml.convert("pathfindingDepth", pathfindingDepth, false);
+            xml.convert("pathfindingCellSize", pathfindingCellSize, false);
+            xml.convert("pathfindingCacheSize", pathfindingCacheSize, false);
         }
 
         void pack(Xml::Node& xml) const {
             xml.pack("dbCacheSize", dbCacheSize);
             xml.pack("dbDebug", dbDebug);
             xml.pack("dbCompression", dbCompression);
+            xml.pack("dbStatistics", dbStatistics);
+            xml.pack("dbObjectCacheSize", dbObjectCacheSize);
+            xml.pack("metricsPort", metricsPort);
+            xml.pack("metricsBindAddress", metricsBindAddress);
+            xml.pack("metricsLogIntervalSec", metricsLogIntervalSec);
+            xml.pack("sectorCheckpointIntervalSec", sectorCheckpointIntervalSec);
+            xml.pack("agentThreads", agentThreads);
+            xml.pack("luaPoolSize", luaPoolSize);
+            xml.pack("sectorInboxCapacity", sectorInboxCapacity);
+            xml.pack("sectorInboxBudget", sectorInboxBudget);
+            xml.pack("sectorHibernateAfterSec", sectorHibernateAfterSec);
+            xml.pack("sectorMemoryBudgetMb", sectorMemoryBudgetMb);
+            xml.pack("sectorBackgroundTicks", sectorBackgroundTicks);
+            xml.pack("pathfindingDepth", pathfindingDepth);
+            xml.pack("pathfindingCellSize", pathfindingCellSize);
+            xml.pack("pathfindingCacheSize", pathfindingCacheSize);
         }
     } server;
 
@@ -4,6 +4,7 @@
 #include "../Utils/Exceptions.hpp"
 #include "../Utils/Macros.hpp"
 #include "../Utils/MsgpackAdaptors.hpp"
+#include "DatabaseCache.hpp"
 #include <msgpack.hpp>
 
 namespace Engine {
@@ -33,6 +34,50 @@ template <typename T> struct SchemaIndexes {
         (void)key;
         (void)value;
     }
+    static void removeChangedIndexes(Database& db, const std::string_view& key, const T& previous, const T& value) {
+        (void)db;
+        (void)key;
+        (void)previous;
+        (void)value;
+    }
+};
+
+// Index entries start with a tag, the entries written before the tags were added hold the bare data key.
+// The 0x02 tag held the whole object, such entries resolve to nothing until the next put() rewrites them.
+enum class SchemaIndexTag : char {
+    DataKey = 0x01,
+    Projection = 0x03,
+};
+
+template <auto A, auto B> constexpr bool isSameMember() {
+    if constexpr (std::is_same_v<decltype(A), decltype(B)>) {
+        return A == B;
+    } else {
+        return false;
+    }
+}
+
+// Covering indexes store the projected fields next to the index key, so the lookup does not need to read the data key
+template <typename T> struct SchemaCoveringIndexes {
+    template <auto F> static constexpr bool isCovering() {
+        return false;
+    }
+};
+
+// The fields stored in the covering index entries, the other fields of the objects found through them are left default
+template <typename T> struct SchemaCoveringFields {
+    template <auto F> static constexpr bool isProjected() {
+        return false;
+    }
+    static void pack(msgpack::packer<msgpack::sbuffer>& packer, const T& value) {
+        (void)packer;
+        (void)value;
+    }
+    static void unpack(const msgpack::object& obj, T& value) {
+        (void)obj;
+        (void)value;
+        EXCEPTION("No covering fields defined for schema: '{}'", SchemaDefinition<T>::getName());
+    }
 };
 
 template <typename T> struct SchemaUnpacker {
@@ -102,6 +147,7 @@ template <typename T> void unpackSchema(const msgpack::object& obj, T& value);
 class ENGINE_API Database {
 public:
     class Transaction;
+    class Batch;
     class ObjectIterator;
     template <typename T> class Iterator;
 
@@ -111,17 +157,31 @@ public:
 
     // Low level operations
     virtual std::optional<msgpack::object_handle> getRaw(const std::string_view& key) = 0;
+    // Returns one handle per key, missing keys are returned as nil objects
     virtual std::vector<msgpack::object_handle> multiGetRaw(const std::vector<std::string>& keys) = 0;
     virtual void putRaw(const std::string_view& key, const void* data, size_t size) = 0;
     virtual std::unique_ptr<Transaction> startTransaction() = 0;
+    // Buffered writes applied together, reads made through the batch do not see its pending writes
+    virtual std::unique_ptr<Batch> startBatch() = 0;
+    // Like a batch but the writes are sorted in memory and ingested as a single table file on commit,
+    // meant for loading large amounts of new data at once
+    virtual std::unique_ptr<Batch> startBulkLoad() = 0;
     virtual void removeRaw(const std::string_view& key) = 0;
     virtual std::unique_ptr<ObjectIterator> seekRaw(const std::string_view& prefix,
                                                     const std::optional<std::string_view>& lowerBound) = 0;
 
+    // Cache of unpacked objects used by find() and multiGet(), transactions do not read through it
+    virtual DatabaseCache* getCache() {
+        return nullptr;
+    }
+
     inline bool transaction(const TransactionCallback& callback);
     template <typename T> std::optional<T> find(const std::string_view& key);
     template <typename T> T get(const std::string_view& key);
+    // The index entries of the previous value are left in place, they are filtered out by getByIndex() unless covering
     template <typename T> void put(const std::string_view& key, const T& value);
+    // Also removes the index entries of the fields that differ from the previous value already known to the caller
+    template <typename T> void put(const std::string_view& key, const T& value, const T& previous);
     template <typename T> std::vector<T> multiGet(const std::vector<std::string>& keys);
     template <typename T> void remove(const std::string_view& key);
     template <typename T> void removeByPrefix(const std::string_view& key);
@@ -141,9 +201,16 @@ public:
               typename R = typename Details::SchemaGetVarType<decltype(F)>::type>
     void putIndex(const std::string_view& key, const R& value);
 
+    template <auto F, typename T = typename Details::SchemaGetVarClass<decltype(F)>::type,
+              typename R = typename Details::SchemaGetVarType<decltype(F)>::type>
+    void putIndex(const std::string_view& key, const R& value, const T& item);
+
     template <auto F, typename T = typename Details::SchemaGetVarClass<decltype(F)>::type,
               typename R = typename Details::SchemaGetVarType<decltype(F)>::type>
     void removeIndex(const std::string_view& key, const R& value);
+
+private:
+    template <typename T, typename Filter> std::vector<T> resolveIndex(const std::string& prefix, const Filter& filter);
 };
 
 class Database::Transaction : public Database {
@@ -154,6 +221,14 @@ public:
     virtual void abort() = 0;
 };
 
+class Database::Batch : public Database {
+public:
+    virtual ~Batch() = default;
+
+    virtual void commit() = 0;
+    [[nodiscard]] virtual size_t size() const = 0;
+};
+
 class Database::ObjectIterator {
 public:
     virtual ~ObjectIterator() = default;
@@ -204,11 +279,23 @@ private:
 template <typename T> std::optional<T> Database::find(const std::string_view& key) {
     try {
         const auto fullKey = Details::keyToSchemaDataKey<T>(key);
+
+        auto* cache = getCache();
+        if (cache) {
+            if (const auto cached = cache->template find<T>(fullKey)) {
+                return *cached;
+            }
+        }
+
+        const auto epoch = cache ? cache->getEpoch(fullKey) : 0;
         const auto object = getRaw(fullKey);
 
         if (object) {
             T value{};
             Details::unpackSchema(object->get(), value);
+            if (cache) {
+                cache->insert(fullKey, epoch, value);
+            }
             return value;
         }
 
@@ -245,26 +332,66 @@ template <typename T> void Database::put(const std::string_view& key, const T& v
     }
 }
 
+template <typename T> void Database::put(const std::string_view& key, const T& value, const T& previous) {
+    try {
+        // The entries of the previous value would still point to this key, the covering ones with stale fields
+        Details::SchemaIndexes<T>::removeChangedIndexes(*this, key, previous, value);
+    } catch (std::exception& e) {
+        EXCEPTION("Failed to put database key: {} schema: {} error: {}",
+                  key,
+                  Details::SchemaDefinition<T>::getName(),
+                  e.what());
+    }
+
+    put<T>(key, value);
+}
+
 template <typename T> std::vector<T> Database::multiGet(const std::vector<std::string>& keys) {
     try {
-        std::vector<T> values;
+        auto* cache = getCache();
 
+        std::vector<std::optional<T>> found(keys.size());
         std::vector<std::string> keysInternal;
+        std::vector<size_t> indexes;
+        std::vector<uint64_t> epochs;
         keysInternal.reserve(keys.size());
-        values.reserve(keys.size());
-
-        for (const auto& key : keys) {
-            keysInternal.push_back(Details::keyToSchemaDataKey<T>(key));
+        indexes.reserve(keys.size());
+
+        // Only the keys missing in the cache are read from the database
+        for (size_t i = 0; i < keys.size(); i++) {
+            auto fullKey = Details::keyToSchemaDataKey<T>(keys[i]);
+            if (cache) {
+                if (const auto cached = cache->template find<T>(fullKey)) {
+                    found[i] = *cached;
+                    continue;
+                }
+                epochs.push_back(cache->getEpoch(fullKey));
+            }
+            keysInternal.push_back(std::move(fullKey));
+            indexes.push_back(i);
         }
 
-        const auto objects = multiGetRaw(keysInternal);
+        if (!keysInternal.empty()) {
+            const auto objects = multiGetRaw(keysInternal);
+
+            for (size_t i = 0; i < objects.size(); i++) {
+                if (objects[i]->type == msgpack::type::NIL) {
+                    continue;
+                }
+                auto& value = found[indexes[i]].emplace();
+                Details::unpackSchema(objects[i].get(), value);
+                if (cache) {
+                    cache->insert(keysInternal[i], epochs[i], value);
+                }
+            }
+        }
 
-        for (const auto& object : objects) {
-            if (object->type == msgpack::type::NIL) {
-                continue;
+        std::vector<T> values;
+        values.reserve(keys.size());
+        for (auto& value : found) {
+            if (value) {
+                values.push_back(std::move(value.value()));
             }
-            values.emplace_back();
-            Details::unpackSchema(object.get(), values.back());
         }
 
         return values;
@@ -366,9 +493,13 @@ template <typename T>
 T Database::update(const std::string_view& key, const std::function<T(std::optional<T>)>& callback) {
     std::optional<T> found;
     transaction([&](Database& txn) -> bool {
-        found = txn.template find<T>(key);
-        found = callback(std::move(found));
-        txn.template put<T>(key, found.value());
+        const auto previous = txn.template find<T>(key);
+        found = callback(previous);
+        if (previous) {
+            txn.template put<T>(key, found.value(), previous.value());
+        } else {
+            txn.template put<T>(key, found.value());
+        }
         return true;
     });
 
@@ -381,26 +512,58 @@ T Database::update(const std::string_view& key, const std::function<T(std::optio
     return found.value();
 }
 
-template <auto F, typename T, typename R> std::vector<T> Database::getByIndex(const R& value) {
-    try {
-        const auto fullIndexKey = Details::keyToSchemaIndexKey<F>(value);
-
-        std::vector<T> items;
-
-        auto it = seekRaw(fullIndexKey, std::nullopt);
-        while (it->next()) {
-            const auto key = it->valueString();
-            const auto item = getRaw(key);
-
-            if (item) {
-                items.emplace_back();
-                Details::unpackSchema(item->get(), items.back());
+template <typename T, typename Filter>
+std::vector<T> Database::resolveIndex(const std::string& prefix, const Filter& filter) {
+    std::vector<T> items;
+    std::vector<std::string> keys;
+
+    // Plain index entries hold the data key, covering index entries hold the projected fields
+    auto it = seekRaw(prefix, std::nullopt);
+    while (it->next()) {
+        auto entry = it->valueString();
+        const auto tag = entry.empty() ? '\0' : entry.front();
+
+        if (tag == static_cast<char>(Details::SchemaIndexTag::Projection)) {
+            const auto object = msgpack::unpack(entry.data() + 1, entry.size() - 1);
+            T item{};
+            Details::SchemaCoveringFields<T>::unpack(object.get(), item);
+            if (filter(item)) {
+                items.push_back(std::move(item));
             }
+        } else if (tag == static_cast<char>(Details::SchemaIndexTag::DataKey)) {
+            keys.push_back(entry.substr(1));
+        } else {
+            keys.push_back(std::move(entry));
         }
+    }
 
+    if (keys.empty()) {
         return items;
+    }
+
+    // All of the remaining rows are resolved in a single batched lookup
+    for (const auto& object : multiGetRaw(keys)) {
+        if (object->type == msgpack::type::NIL) {
+            continue;
+        }
+        T item{};
+        Details::unpackSchema(object.get(), item);
+        if (filter(item)) {
+            items.push_back(std::move(item));
+        }
+    }
+
+    return items;
+}
+
+template <auto F, typename T, typename R> std::vector<T> Database::getByIndex(const R& value) {
+    try {
+        const auto fullIndexKey = Details::keyToSchemaIndexKey<F>(value);
+
+        // An index entry may be left behind when the indexed field of an object changes
+        return resolveIndex<T>(fullIndexKey, [&](const T& item) { return item.*F == value; });
     } catch (std::exception& e) {
-        EXCEPTION("Failed to delete database values by index: {} value: {} schema: {} error: {}",
+        EXCEPTION("Failed to get database values by index: {} value: {} schema: {} error: {}",
                   Details::SchemaIndexes<T>::template getIndexName<F>(),
                   value,
                   Details::SchemaDefinition<T>::getName(),
@@ -411,24 +574,11 @@ template <auto F, typename T, typename R> std::vector<T> Database::getByIndex(co
 template <typename T, typename V>
 std::vector<T> Database::getByIndexName(const std::string_view& index, const V& value) {
     try {
-        const auto fullIndexKey = Details::keyToSchemaIndexNameKey<T, V>(value);
-
-        std::vector<T> items;
+        const auto fullIndexKey = Details::keyToSchemaIndexNameKey<T, V>(index, value);
 
-        auto it = seekRaw(fullIndexKey, std::nullopt);
-        while (it->next()) {
-            const auto key = it->valueString();
-            const auto item = getRaw(key);
-
-            if (item) {
-                items.emplace_back();
-                Details::unpackSchema(item->get(), items.back());
-            }
-        }
-
-        return items;
+        return resolveIndex<T>(fullIndexKey, [](const T&) { return true; });
     } catch (std::exception& e) {
-        EXCEPTION("Failed to delete database values by index: {} value: {} schema: {} error: {}",
+        EXCEPTION("Failed to get database values by index: {} value: {} schema: {} error: {}",
                   index,
                   value,
                   Details::SchemaDefinition<T>::getName(),
@@ -438,8 +588,27 @@ std::vector<T> Database::getByIndexName(const std::string_view& index, const V&
 
 template <auto F, typename T, typename R> void Database::putIndex(const std::string_view& key, const R& value) {
     const auto fullIndexKey = Details::keyToSchemaIndexKey<F>(value, key);
-    const auto fullKey = Details::keyToSchemaDataKey<T>(key);
-    putRaw(fullIndexKey, fullKey.data(), fullKey.size());
+    const auto entry = static_cast<char>(Details::SchemaIndexTag::DataKey) + Details::keyToSchemaDataKey<T>(key);
+    putRaw(fullIndexKey, entry.data(), entry.size());
+}
+
+template <auto F, typename T, typename R>
+void Database::putIndex(const std::string_view& key, const R& value, const T& item) {
+    if constexpr (Details::SchemaCoveringIndexes<T>::template isCovering<F>()) {
+        static_assert(Details::SchemaCoveringFields<T>::template isProjected<F>(),
+                      "The field of a covering index must be one of the covering fields");
+
+        const auto fullIndexKey = Details::keyToSchemaIndexKey<F>(value, key);
+        const auto tag = static_cast<char>(Details::SchemaIndexTag::Projection);
+        msgpack::sbuffer entry;
+        entry.write(&tag, 1);
+        msgpack::packer<msgpack::sbuffer> packer(entry);
+        Details::SchemaCoveringFields<T>::pack(packer, item);
+        putRaw(fullIndexKey, entry.data(), entry.size());
+    } else {
+        (void)item;
+        putIndex<F>(key, value);
+    }
 }
 
 template <auto F, typename T, typename R> void Database::removeIndex(const std::string_view& key, const R& value) {
@@ -501,7 +670,7 @@ inline bool Database::transaction(const Database::TransactionCallback& callback)
     }
 
 #define SCHEMA_IF_INDEX_NAME_FIELD(Field)                                                                              \
-    if (reinterpret_cast<int T::*>(F) == reinterpret_cast<int T::*>(&T::Field)) {                                      \
+    if constexpr (Details::isSameMember<F, &T::Field>()) {                                                             \
         return #Field;                                                                                                 \
     }
 
@@ -510,10 +679,15 @@ inline bool Database::transaction(const Database::TransactionCallback& callback)
         return true;                                                                                                   \
     }
 
-#define SCHEMA_INDEX_PUT_FIELD(Field) db.putIndex<&T::Field>(key, value.Field);
+#define SCHEMA_INDEX_PUT_FIELD(Field) db.putIndex<&T::Field>(key, value.Field, value);
 
 #define SCHEMA_INDEX_REMOVE_FIELD(Field) db.removeIndex<&T::Field>(key, value.Field);
 
+#define SCHEMA_INDEX_REMOVE_CHANGED_FIELD(Field)                                                                       \
+    if (!(previous.Field == value.Field)) {                                                                            \
+        db.removeIndex<&T::Field>(key, previous.Field);                                                                \
+    }
+
 #define SCHEMA_INDEXES(Name, ...)                                                                                      \
     template <> struct Details::SchemaIndexes<Name> {                                                                  \
         using T = Name;                                                                                                \
@@ -535,4 +709,51 @@ inline bool Database::transaction(const Database::TransactionCallback& callback)
         static void removeIndexes(Engine::Database& db, const std::string_view& key, const T& value) {                 \
             FOR_EACH(SCHEMA_INDEX_REMOVE_FIELD, __VA_ARGS__)                                                           \
         }                                                                                                              \
+        static void removeChangedIndexes(Engine::Database& db, const std::string_view& key, const T& previous,         \
+                                         const T& value) {                                                             \
+            FOR_EACH(SCHEMA_INDEX_REMOVE_CHANGED_FIELD, __VA_ARGS__)                                                   \
+        }                                                                                                              \
+    }
+
+#define SCHEMA_IF_COVERING_FIELD(Field)                                                                                \
+    if constexpr (Details::isSameMember<F, &T::Field>()) {                                                             \
+        return true;                                                                                                   \
+    }
+
+// Marks some of the fields listed in SCHEMA_INDEXES as covering indexes
+#define SCHEMA_COVERING_INDEXES(Name, ...)                                                                             \
+    template <> struct Details::SchemaCoveringIndexes<Name> {                                                          \
+        using T = Name;                                                                                                \
+        template <auto F> static constexpr bool isCovering() {                                                         \
+            FOR_EACH(SCHEMA_IF_COVERING_FIELD, __VA_ARGS__)                                                            \
+            return false;                                                                                              \
+        }                                                                                                              \
+    }
+
+#define SCHEMA_COVERING_COUNT_FIELD(Field) +1
+
+#define SCHEMA_COVERING_PACK_FIELD(Field) packer.pack(value.Field);
+
+#define SCHEMA_COVERING_UNPACK_FIELD(Field) obj.via.array.ptr[i++].convert(value.Field);
+
+// The fields stored in the entries of the covering indexes, must include the fields of the indexes themselves
+#define SCHEMA_COVERING_FIELDS(Name, ...)                                                                              \
+    template <> struct Details::SchemaCoveringFields<Name> {                                                           \
+        using T = Name;                                                                                                \
+        static constexpr uint32_t count = 0 FOR_EACH(SCHEMA_COVERING_COUNT_FIELD, __VA_ARGS__);                        \
+        template <auto F> static constexpr bool isProjected() {                                                        \
+            FOR_EACH(SCHEMA_IF_COVERING_FIELD, __VA_ARGS__)                                                            \
+            return false;                                                                                              \
+        }                                                                                                              \
+        static void pack(msgpack::packer<msgpack::sbuffer>& packer, const T& value) {                                  \
+            packer.pack_array(count);                                                                                  \
+            FOR_EACH(SCHEMA_COVERING_PACK_FIELD, __VA_ARGS__)                                                          \
+        }                                                                                                              \
+        static void unpack(const msgpack::object& obj, T& value) {                                                     \
+            if (obj.type != msgpack::type::ARRAY || obj.via.array.size != count) {                                     \
+                EXCEPTION("Covering index entry is not an array of {} items", count);                                  \
+            }                                                                                                          \
+            size_t i = 0;                                                                                              \
+            FOR_EACH(SCHEMA_COVERING_UNPACK_FIELD, __VA_ARGS__)                                                        \
+        }                                                                                                              \
     }
@@ -0,0 +1,121 @@
+#include "DatabaseCache.hpp"
+#include "../Utils/Metrics.hpp"
+#include <algorithm>
+
+using namespace Engine;
+
+static MetricCounter& metricHits() {
+    static auto& counter = Metrics::getInstance().counter("database_cache_hits_total", "Object cache hits");
+    return counter;
+}
+
+static MetricCounter& metricMisses() {
+    static auto& counter = Metrics::getInstance().counter("database_cache_misses_total", "Object cache misses");
+    return counter;
+}
+
+static MetricCounter& metricEvictions() {
+    static auto& counter =
+        Metrics::getInstance().counter("database_cache_evictions_total", "Object cache LRU evictions");
+    return counter;
+}
+
+static MetricGauge& metricEntries() {
+    static auto& gauge = Metrics::getInstance().gauge("database_cache_entries", "Object cache entries");
+    return gauge;
+}
+
+DatabaseCache::DatabaseCache(const size_t capacity) :
+    shardCapacity{std::max<size_t>(1, (capacity + shardCount - 1) / shardCount)} {
+}
+
+DatabaseCache::Shard& DatabaseCache::getShard(const std::string& key) {
+    return shards[std::hash<std::string>{}(key) % shardCount];
+}
+
+const DatabaseCache::Shard& DatabaseCache::getShard(const std::string& key) const {
+    return shards[std::hash<std::string>{}(key) % shardCount];
+}
+
+std::shared_ptr<const void> DatabaseCache::findRaw(const std::string& key, const std::type_index type) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    const auto it = shard.map.find(key);
+    if (it == shard.map.end() || it->second.type != type) {
+        metricMisses().add();
+        return nullptr;
+    }
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+    metricHits().add();
+    return it->second.value;
+}
+
+uint64_t DatabaseCache::getEpoch(const std::string& key) const {
+    const auto& shard = getShard(key);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    return shard.epoch;
+}
+
+void DatabaseCache::insertRaw(const std::string& key, const uint64_t epoch, const std::type_index type,
+                              std::shared_ptr<const void> value) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    // Something in this shard was written since the value was read, it may be stale
+    if (shard.epoch != epoch) {
+        return;
+    }
+
+    auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        it->second.type = type;
+        it->second.value = std::move(value);
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+        return;
+    }
+
+    shard.lru.push_front(key);
+    shard.map.emplace(key, Entry{type, std::move(value), shard.lru.begin()});
+    metricEntries().add(1);
+
+    while (shard.map.size() > shardCapacity) {
+        shard.map.erase(shard.lru.back());
+        shard.lru.pop_back();
+        metricEvictions().add();
+        metricEntries().add(-1);
+    }
+}
+
+void DatabaseCache::invalidate(const std::string& key) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+
+    ++shard.epoch;
+    const auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        shard.lru.erase(it->second.lru);
+        shard.map.erase(it);
+        metricEntries().add(-1);
+    }
+}
+
+void DatabaseCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        ++shard.epoch;
+        metricEntries().add(-static_cast<int64_t>(shard.map.size()));
+        shard.map.clear();
+        shard.lru.clear();
+    }
+}
+
+size_t DatabaseCache::size() const {
+    size_t total{0};
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        total += shard.map.size();
+    }
+    return total;
+}
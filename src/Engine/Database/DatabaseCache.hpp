@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../Library.hpp"
+#include "../Utils/MoveableCopyable.hpp"
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+namespace Engine {
+// Sharded LRU of already unpacked objects keyed by the full data key (schema + key).
+// Any raw write to a key invalidates it, the epoch protects against a slow reader
+// inserting a value it has read before a concurrent write was made.
+class ENGINE_API DatabaseCache {
+public:
+    static constexpr size_t shardCount = 16;
+
+    explicit DatabaseCache(size_t capacity);
+    NON_COPYABLE(DatabaseCache);
+    NON_MOVEABLE(DatabaseCache);
+
+    template <typename T> std::shared_ptr<const T> find(const std::string& key) {
+        return std::static_pointer_cast<const T>(findRaw(key, typeid(T)));
+    }
+
+    // Must be read before the value is fetched from the database and passed to insert()
+    uint64_t getEpoch(const std::string& key) const;
+
+    template <typename T> void insert(const std::string& key, const uint64_t epoch, const T& value) {
+        insertRaw(key, epoch, typeid(T), std::make_shared<const T>(value));
+    }
+
+    void invalidate(const std::string& key);
+    void clear();
+    [[nodiscard]] size_t size() const;
+
+private:
+    struct Entry {
+        std::type_index type;
+        std::shared_ptr<const void> value;
+        std::list<std::string>::iterator lru;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> map;
+        std::list<std::string> lru;
+        uint64_t epoch{0};
+    };
+
+    Shard& getShard(const std::string& key);
+    const Shard& getShard(const std::string& key) const;
+    std::shared_ptr<const void> findRaw(const std::string& key, std::type_index type);
+    void insertRaw(const std::string& key, uint64_t epoch, std::type_index type, std::shared_ptr<const void> value);
+
+    const size_t shardCapacity;
+    std::array<Shard, shardCount> shards;
+};
+} // namespace Engine
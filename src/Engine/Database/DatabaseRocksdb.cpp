@@ -1,10 +1,16 @@
 #include "DatabaseRocksdb.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Random.hpp"
+#include <rocksdb/cache.h>
 #include <rocksdb/db.h>
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/slice_transform.h>
+#include <rocksdb/sst_file_writer.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
 #include <rocksdb/utilities/optimistic_transaction_db.h>
 #include <rocksdb/utilities/transaction.h>
+#include <rocksdb/write_batch.h>
 
 #include <memory>
 
@@ -12,6 +18,19 @@ using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
+static MetricHistogram& getLatencyMetric(const std::string& op) {
+    return Metrics::getInstance().histogram(
+        "database_operation_duration_seconds", "RocksDB operation latency", {{"op", op}}, 1e-9);
+}
+
+static auto& metricGet = getLatencyMetric("get");
+static auto& metricMultiGet = getLatencyMetric("multi_get");
+static auto& metricPut = getLatencyMetric("put");
+static auto& metricRemove = getLatencyMetric("remove");
+static auto& metricCommit = getLatencyMetric("commit");
+static auto& metricBatch = getLatencyMetric("batch");
+static auto& metricIngest = getLatencyMetric("ingest");
+
 class DefaultLogger : public rocksdb::Logger {
 public:
     explicit DefaultLogger(rocksdb::InfoLogLevel filterLogLevel) : filterLogLevel{filterLogLevel} {
@@ -69,40 +88,135 @@ private:
     }*/
 };
 
-DatabaseRocksDB::DatabaseRocksDB(const Path& path, const Options& options) {
-    rocksdb::Options opts;
-    opts.create_if_missing = true;
-    const auto logLevel = options.debugLogging ? rocksdb::InfoLogLevel::DEBUG_LEVEL : rocksdb::InfoLogLevel::WARN_LEVEL;
-    opts.info_log = std::make_shared<DefaultLogger>(logLevel);
+// See DatabaseRocksDB::getSeekPrefix(), the iterators use the prefix bloom only when their bounds match a prefix
+class SchemaPrefixTransform : public rocksdb::SliceTransform {
+public:
+    const char* Name() const override {
+        return "TemporaryEscape.SchemaPrefix.2";
+    }
 
-    opts.compression = options.compression ? rocksdb::kLZ4Compression : rocksdb::kNoCompression;
-    opts.max_open_files = -1;
-    opts.write_buffer_size = options.writeBufferSizeMb * 1024 * 1024; // 64MB
-    opts.max_background_compactions = 2;
+    rocksdb::Slice Transform(const rocksdb::Slice& key) const override {
+        return rocksdb::Slice{key.data(), DatabaseRocksDB::getSeekPrefix({key.data(), key.size()}).size()};
+    }
 
-    // options.table_factory.reset(rocksdb::NewTotalOrderPlainTableFactory());
-    /*options.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(16));
+    bool InDomain(const rocksdb::Slice& key) const override {
+        return !DatabaseRocksDB::getSeekPrefix({key.data(), key.size()}).empty();
+    }
+};
 
-    rocksdb::BlockBasedTableOptions tableOptions{};
-    tableOptions.block_cache = rocksdb::NewLRUCache(128 * 1024 * 1024);
-    tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(16, false));
-    tableOptions.index_type = rocksdb::BlockBasedTableOptions::kHashSearch;
-    tableOptions.block_size = 4 * 1024;
-    options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));*/
+struct DatabaseRocksDB::IteratorBounds {
+    std::string lower;
+    std::string upper;
+    rocksdb::Slice lowerSlice;
+    rocksdb::Slice upperSlice;
+};
+
+static std::unique_ptr<DatabaseRocksDB::IteratorBounds>
+createIteratorBounds(rocksdb::ReadOptions& options, const std::string_view& prefix,
+                     const std::optional<std::string_view>& lowerBound) {
+    auto bounds = std::make_unique<DatabaseRocksDB::IteratorBounds>();
+
+    if (lowerBound.has_value()) {
+        bounds->lower = std::string{lowerBound.value()};
+        bounds->lowerSlice = rocksdb::Slice{bounds->lower};
+        options.iterate_lower_bound = &bounds->lowerSlice;
+    }
+
+    // The first key past the prefix, so the iterator stops at the end of the prefix instead of the end of the table.
+    // The prefix bloom filters are used only when the bounds cover a single extracted prefix.
+    bounds->upper = std::string{prefix};
+    while (!bounds->upper.empty() && static_cast<unsigned char>(bounds->upper.back()) == 0xFF) {
+        bounds->upper.pop_back();
+    }
+    if (!bounds->upper.empty()) {
+        bounds->upper.back() = static_cast<char>(static_cast<unsigned char>(bounds->upper.back()) + 1);
+        bounds->upperSlice = rocksdb::Slice{bounds->upper};
+        options.iterate_upper_bound = &bounds->upperSlice;
+        options.auto_prefix_mode = true;
+    }
+
+    return bounds;
+}
 
-    opts.OptimizeForPointLookup(options.cacheSizeMb);
-    opts.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(16));
+DatabaseRocksDB::DatabaseRocksDB(const Path& path, const Options& options) : path{path} {
+    static constexpr size_t mb = 1024 * 1024;
+
+    rocksdb::DBOptions dbOpts;
+    dbOpts.create_if_missing = true;
+    dbOpts.create_missing_column_families = true;
+    const auto logLevel = options.debugLogging ? rocksdb::InfoLogLevel::DEBUG_LEVEL : rocksdb::InfoLogLevel::WARN_LEVEL;
+    dbOpts.info_log = std::make_shared<DefaultLogger>(logLevel);
+    dbOpts.max_open_files = -1;
+    dbOpts.max_background_jobs = 4;
+    dbOpts.db_write_buffer_size = options.writeBufferSizeMb * mb * 2;
+    if (options.statistics) {
+        statistics = rocksdb::CreateDBStatistics();
+        statistics->set_stats_level(rocksdb::StatsLevel::kExceptDetailedTimers);
+        dbOpts.statistics = statistics;
+    }
+
+    // One block cache for all schemas, the index and filter blocks are partitioned and cached with high priority,
+    // so only the top level index stays pinned and the rest competes with the data blocks
+    blockCache = rocksdb::NewLRUCache(options.cacheSizeMb * mb, -1, false, 0.5);
+
+    rocksdb::BlockBasedTableOptions tableOptions{};
+    tableOptions.block_cache = blockCache;
+    tableOptions.block_size = options.blockSizeKb * 1024;
+    tableOptions.format_version = 5;
+    tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(options.bloomBitsPerKey, false));
+    tableOptions.whole_key_filtering = true;
+    tableOptions.index_type = rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+    tableOptions.partition_filters = true;
+    tableOptions.metadata_block_size = 4096;
+    tableOptions.cache_index_and_filter_blocks = true;
+    tableOptions.cache_index_and_filter_blocks_with_high_priority = true;
+    tableOptions.pin_top_level_index_and_filter = true;
+    tableOptions.pin_l0_filter_and_index_blocks_in_cache = true;
+
+    rocksdb::ColumnFamilyOptions defaultOpts;
+    defaultOpts.compression = options.compression ? rocksdb::kLZ4Compression : rocksdb::kNoCompression;
+    defaultOpts.write_buffer_size = options.writeBufferSizeMb * mb;
+    defaultOpts.level_compaction_dynamic_level_bytes = true;
+    defaultOpts.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+
+    // Point lookups use the whole key filter, scans are bound to a namespace of a single schema
+    familyOptions = std::make_unique<rocksdb::ColumnFamilyOptions>(defaultOpts);
+    familyOptions->prefix_extractor = std::make_shared<SchemaPrefixTransform>();
+    familyOptions->memtable_prefix_bloom_size_ratio = 0.05;
+    familyOptions->memtable_whole_key_filtering = true;
+
+    std::vector<std::string> names;
+    if (!rocksdb::DB::ListColumnFamilies(dbOpts, path.string(), &names).ok()) {
+        names = {rocksdb::kDefaultColumnFamilyName};
+    }
 
-    // logger.info("Opening database: {}", path.string());
+    std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+    descriptors.reserve(names.size());
+    for (const auto& name : names) {
+        descriptors.emplace_back(name, name == rocksdb::kDefaultColumnFamilyName ? defaultOpts : *familyOptions);
+    }
 
     rocksdb::OptimisticTransactionDB* txnPtr;
-    const auto s = rocksdb::OptimisticTransactionDB::Open(opts, path.string(), &txnPtr);
+    std::vector<rocksdb::ColumnFamilyHandle*> handles;
+    const auto s = rocksdb::OptimisticTransactionDB::Open(dbOpts, path.string(), descriptors, &handles, &txnPtr);
     if (!s.ok()) {
         EXCEPTION("Failed to open database error: {}", s.ToString());
     }
 
     txn = std::unique_ptr<rocksdb::OptimisticTransactionDB, decltype(&deleterDb)>{txnPtr, &deleterDb};
     db = txn->GetBaseDB();
+
+    for (auto* handle : handles) {
+        families.emplace(handle->GetName(), handle);
+    }
+
+    migrateDefaultFamily();
+
+    if (options.objectCacheSize > 0) {
+        cache = std::make_unique<DatabaseCache>(options.objectCacheSize);
+    }
+
+    startMetrics();
 }
 
 void DatabaseRocksDB::deleterDb(rocksdb::OptimisticTransactionDB* value) {
@@ -110,12 +224,244 @@ void DatabaseRocksDB::deleterDb(rocksdb::OptimisticTransactionDB* value) {
     delete value;
 }
 
-DatabaseRocksDB::~DatabaseRocksDB() = default;
+DatabaseRocksDB::~DatabaseRocksDB() {
+    for (const auto id : metricsCollectors) {
+        Metrics::getInstance().removeCollector(id);
+    }
+
+    // The handles must be released before the database is closed
+    for (const auto& [_, handle] : families) {
+        db->DestroyColumnFamilyHandle(handle);
+    }
+    families.clear();
+}
+
+std::string_view DatabaseRocksDB::getFamilyName(const std::string_view& key) {
+    const auto pos = key.find(':');
+    if (pos == std::string_view::npos || pos == 0) {
+        return rocksdb::kDefaultColumnFamilyName;
+    }
+    return key.substr(0, pos);
+}
+
+std::string_view DatabaseRocksDB::getSeekPrefix(const std::string_view& key) {
+    static constexpr std::string_view data{":data:"};
+    static constexpr std::string_view index{":index:"};
+
+    const auto pos = key.find(':');
+    if (pos == std::string_view::npos || pos == 0) {
+        return {};
+    }
+
+    // Up to the first path separator of the data key, the keys of a galaxy or a sector share it
+    if (key.substr(pos, data.size()) == data) {
+        const auto end = key.find('/', pos + data.size());
+        return end == std::string_view::npos ? std::string_view{} : key.substr(0, end + 1);
+    }
+
+    // The name and the value of the index, the object keys follow
+    if (key.substr(pos, index.size()) == index) {
+        const auto name = key.find(':', pos + index.size());
+        const auto end = name == std::string_view::npos ? name : key.find(':', name + 1);
+        return end == std::string_view::npos ? std::string_view{} : key.substr(0, end + 1);
+    }
+
+    return {};
+}
+
+rocksdb::ColumnFamilyHandle* DatabaseRocksDB::getFamily(const std::string_view& key, const bool create) {
+    const auto name = getFamilyName(key);
+
+    {
+        std::shared_lock<std::shared_mutex> lock{familiesMutex};
+        const auto it = families.find(name);
+        if (it != families.end()) {
+            return it->second;
+        }
+        if (!create) {
+            return families.find(rocksdb::kDefaultColumnFamilyName)->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock{familiesMutex};
+    const auto it = families.find(name);
+    if (it != families.end()) {
+        return it->second;
+    }
+
+    rocksdb::ColumnFamilyHandle* handle{nullptr};
+    const auto s = db->CreateColumnFamily(*familyOptions, std::string{name}, &handle);
+    if (!s.ok()) {
+        throw std::runtime_error(fmt::format("Failed to create column family: {} error: {}", name, s.ToString()));
+    }
+
+    logger.info("Created database column family: {}", name);
+    return families.emplace(name, handle).first->second;
+}
+
+void DatabaseRocksDB::migrateDefaultFamily() {
+    // Databases created before the schemas had their own column families keep everything in the default one,
+    // the marker is written once they are moved so the default family is not scanned on every open
+    static constexpr std::string_view marker{"database_families_migrated"};
+
+    auto* defaultFamily = families.find(rocksdb::kDefaultColumnFamilyName)->second;
+
+    std::string value;
+    const rocksdb::Slice markerKey{marker.data(), marker.size()};
+    const auto found = db->Get(rocksdb::ReadOptions{}, defaultFamily, markerKey, &value);
+    if (found.ok()) {
+        return;
+    }
+    if (!found.IsNotFound()) {
+        EXCEPTION("Failed to read database migration marker error: {}", found.ToString());
+    }
+
+    std::unique_ptr<rocksdb::Iterator> iter{db->NewIterator(rocksdb::ReadOptions{}, defaultFamily)};
+
+    rocksdb::WriteBatch batch{};
+    size_t total{0};
+
+    const auto flush = [&]() {
+        const auto s = db->Write(rocksdb::WriteOptions{}, &batch);
+        if (!s.ok()) {
+            EXCEPTION("Failed to migrate database keys error: {}", s.ToString());
+        }
+        batch.Clear();
+    };
+
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        const std::string_view key{iter->key().data(), iter->key().size()};
+        if (getFamilyName(key) == rocksdb::kDefaultColumnFamilyName) {
+            continue;
+        }
+
+        batch.Put(getFamily(key, true), iter->key(), iter->value());
+        batch.Delete(defaultFamily, iter->key());
+        ++total;
+
+        if (batch.GetDataSize() >= BatchRocksDB::maxBatchBytes) {
+            flush();
+        }
+    }
+
+    if (!iter->status().ok()) {
+        EXCEPTION("Failed to migrate database keys error: {}", iter->status().ToString());
+    }
+
+    batch.Put(defaultFamily, markerKey, rocksdb::Slice{});
+    flush();
+
+    if (total > 0) {
+        logger.info("Migrated {} database keys into schema column families", total);
+    }
+}
+
+void DatabaseRocksDB::startMetrics() {
+    auto& metrics = Metrics::getInstance();
+
+    metricsCollectors.push_back(metrics.addCollector(
+        "database_rocksdb_block_cache_bytes",
+        Metrics::Type::Gauge,
+        "Size of the shared RocksDB block cache",
+        [this](std::vector<Metrics::Sample>& samples) {
+            samples.push_back({{{"kind", "usage"}}, static_cast<double>(blockCache->GetUsage())});
+            samples.push_back({{{"kind", "pinned"}}, static_cast<double>(blockCache->GetPinnedUsage())});
+            samples.push_back({{{"kind", "capacity"}}, static_cast<double>(blockCache->GetCapacity())});
+        }));
+
+    const auto addFamilyProperty = [&](const std::string& name, const std::string& help, const std::string& property) {
+        metricsCollectors.push_back(metrics.addCollector(
+            name, Metrics::Type::Gauge, help, [this, property](std::vector<Metrics::Sample>& samples) {
+                std::shared_lock<std::shared_mutex> lock{familiesMutex};
+                for (const auto& [family, handle] : families) {
+                    uint64_t value{0};
+                    if (db->GetIntProperty(handle, property, &value)) {
+                        samples.push_back({{{"family", family}}, static_cast<double>(value)});
+                    }
+                }
+            }));
+    };
+
+    addFamilyProperty("database_rocksdb_estimated_keys",
+                      "Estimated number of keys per column family",
+                      rocksdb::DB::Properties::kEstimateNumKeys);
+    addFamilyProperty("database_rocksdb_live_data_bytes",
+                      "Estimated size of the live data per column family",
+                      rocksdb::DB::Properties::kEstimateLiveDataSize);
+    addFamilyProperty("database_rocksdb_pending_compaction_bytes",
+                      "Estimated bytes to be rewritten by compaction per column family",
+                      rocksdb::DB::Properties::kEstimatePendingCompactionBytes);
+    addFamilyProperty("database_rocksdb_running_compactions",
+                      "Number of running compactions",
+                      rocksdb::DB::Properties::kNumRunningCompactions);
+
+    if (!statistics) {
+        return;
+    }
+
+    static const std::vector<std::pair<rocksdb::Tickers, std::string>> tickers = {
+        {rocksdb::BLOCK_CACHE_HIT, "block_cache_hit"},
+        {rocksdb::BLOCK_CACHE_MISS, "block_cache_miss"},
+        {rocksdb::BLOCK_CACHE_DATA_HIT, "block_cache_data_hit"},
+        {rocksdb::BLOCK_CACHE_DATA_MISS, "block_cache_data_miss"},
+        {rocksdb::BLOCK_CACHE_INDEX_HIT, "block_cache_index_hit"},
+        {rocksdb::BLOCK_CACHE_INDEX_MISS, "block_cache_index_miss"},
+        {rocksdb::BLOCK_CACHE_FILTER_HIT, "block_cache_filter_hit"},
+        {rocksdb::BLOCK_CACHE_FILTER_MISS, "block_cache_filter_miss"},
+        {rocksdb::BLOOM_FILTER_USEFUL, "bloom_filter_useful"},
+        {rocksdb::BLOOM_FILTER_PREFIX_CHECKED, "bloom_filter_prefix_checked"},
+        {rocksdb::BLOOM_FILTER_PREFIX_USEFUL, "bloom_filter_prefix_useful"},
+        {rocksdb::MEMTABLE_HIT, "memtable_hit"},
+        {rocksdb::MEMTABLE_MISS, "memtable_miss"},
+        {rocksdb::BYTES_READ, "bytes_read"},
+        {rocksdb::BYTES_WRITTEN, "bytes_written"},
+        {rocksdb::FLUSH_WRITE_BYTES, "flush_write_bytes"},
+        {rocksdb::COMPACT_READ_BYTES, "compact_read_bytes"},
+        {rocksdb::COMPACT_WRITE_BYTES, "compact_write_bytes"},
+        {rocksdb::STALL_MICROS, "stall_micros"},
+        {rocksdb::NUMBER_DB_SEEK, "db_seek"},
+        {rocksdb::NUMBER_DB_NEXT, "db_next"},
+    };
+
+    metricsCollectors.push_back(metrics.addCollector(
+        "database_rocksdb_tickers_total",
+        Metrics::Type::Counter,
+        "RocksDB statistics tickers",
+        [this](std::vector<Metrics::Sample>& samples) {
+            for (const auto& [ticker, name] : tickers) {
+                samples.push_back({{{"ticker", name}}, static_cast<double>(statistics->getTickerCount(ticker))});
+            }
+        }));
+
+    static const std::vector<std::pair<rocksdb::Histograms, std::string>> histograms = {
+        {rocksdb::DB_GET, "get"},
+        {rocksdb::DB_MULTIGET, "multi_get"},
+        {rocksdb::DB_WRITE, "write"},
+        {rocksdb::DB_SEEK, "seek"},
+        {rocksdb::COMPACTION_TIME, "compaction"},
+        {rocksdb::FLUSH_TIME, "flush"},
+    };
+
+    metricsCollectors.push_back(metrics.addCollector(
+        "database_rocksdb_latency_microseconds",
+        Metrics::Type::Gauge,
+        "RocksDB internal operation latency percentiles",
+        [this](std::vector<Metrics::Sample>& samples) {
+            for (const auto& [histogram, name] : histograms) {
+                rocksdb::HistogramData data{};
+                statistics->histogramData(histogram, &data);
+                samples.push_back({{{"op", name}, {"quantile", "0.5"}}, data.median});
+                samples.push_back({{{"op", name}, {"quantile", "0.99"}}, data.percentile99});
+                samples.push_back({{{"op", name}, {"quantile", "1"}}, data.max});
+            }
+        }));
+}
 
 std::optional<msgpack::object_handle> DatabaseRocksDB::getRaw(const std::string_view& key) {
+    const MetricHistogram::Timer timer{metricGet};
     rocksdb::ReadOptions options{};
     rocksdb::PinnableSlice slice;
-    const auto s = db->Get(options, db->DefaultColumnFamily(), key, &slice);
+    const auto s = db->Get(options, getFamily(key, false), key, &slice);
     if (!s.ok()) {
         if (s.code() == rocksdb::Status::Code::kNotFound) {
             return {};
@@ -129,12 +475,16 @@ std::optional<msgpack::object_handle> DatabaseRocksDB::getRaw(const std::string_
 }
 
 std::vector<msgpack::object_handle> DatabaseRocksDB::multiGetRaw(const std::vector<std::string>& keys) {
+    const MetricHistogram::Timer timer{metricMultiGet};
     rocksdb::ReadOptions options{};
     std::vector<rocksdb::Slice> keysSlice;
+    std::vector<rocksdb::ColumnFamilyHandle*> keysFamily;
     keysSlice.reserve(keys.size());
+    keysFamily.reserve(keys.size());
 
     for (const auto& key : keys) {
         keysSlice.emplace_back(key.data(), key.size());
+        keysFamily.push_back(getFamily(key, false));
     }
 
     std::vector<rocksdb::PinnableSlice> slices;
@@ -142,11 +492,13 @@ std::vector<msgpack::object_handle> DatabaseRocksDB::multiGetRaw(const std::vect
     slices.resize(keys.size());
     statuses.resize(keys.size());
 
-    db->MultiGet(options, db->DefaultColumnFamily(), keys.size(), keysSlice.data(), slices.data(), statuses.data());
+    db->MultiGet(options, keys.size(), keysFamily.data(), keysSlice.data(), slices.data(), statuses.data());
 
     std::vector<msgpack::object_handle> handles;
+    handles.reserve(keys.size());
     for (size_t i = 0; i < keys.size(); i++) {
         if (statuses[i].code() == rocksdb::Status::Code::kNotFound) {
+            handles.emplace_back();
             continue;
         }
 
@@ -162,48 +514,58 @@ std::vector<msgpack::object_handle> DatabaseRocksDB::multiGetRaw(const std::vect
 }
 
 void DatabaseRocksDB::putRaw(const std::string_view& key, const void* data, size_t size) {
+    const MetricHistogram::Timer timer{metricPut};
     rocksdb::WriteOptions options{};
     rocksdb::Slice slice(reinterpret_cast<const char*>(data), size);
-    const auto s = db->Put(options, db->DefaultColumnFamily(), key, slice);
+    const auto s = db->Put(options, getFamily(key, true), key, slice);
     if (!s.ok()) {
         throw std::runtime_error(fmt::format("database Put() error: {}", s.ToString()));
     }
+    if (cache) {
+        cache->invalidate(std::string{key});
+    }
 }
 
 std::unique_ptr<Database::Transaction> DatabaseRocksDB::startTransaction() {
     rocksdb::WriteOptions writeOptions{};
     std::unique_ptr<rocksdb::Transaction> tx(txn->BeginTransaction(writeOptions));
-    return std::make_unique<TransactionRocksDB>(std::move(tx), *db);
+    return std::make_unique<TransactionRocksDB>(std::move(tx), *this);
+}
+
+std::unique_ptr<Database::Batch> DatabaseRocksDB::startBatch() {
+    return std::make_unique<BatchRocksDB>(*this);
+}
+
+std::unique_ptr<Database::Batch> DatabaseRocksDB::startBulkLoad() {
+    return std::make_unique<BulkLoadRocksDB>(*this);
 }
 
 void DatabaseRocksDB::removeRaw(const std::string_view& key) {
+    const MetricHistogram::Timer timer{metricRemove};
     rocksdb::WriteOptions options{};
-    const auto s = db->Delete(options, db->DefaultColumnFamily(), key);
+    const auto s = db->Delete(options, getFamily(key, false), key);
     if (!s.ok()) {
         throw std::runtime_error(fmt::format("database Delete() error: {}", s.ToString()));
     }
+    if (cache) {
+        cache->invalidate(std::string{key});
+    }
 }
 
 std::unique_ptr<Database::ObjectIterator> DatabaseRocksDB::seekRaw(const std::string_view& prefix,
                                                                    const std::optional<std::string_view>& lowerBound) {
     rocksdb::ReadOptions options{};
-    options.prefix_same_as_start = true;
+    auto bounds = createIteratorBounds(options, prefix, lowerBound);
 
-    std::unique_ptr<rocksdb::Slice> lowerBoundSlice;
-    if (lowerBound.has_value()) {
-        lowerBoundSlice = std::make_unique<rocksdb::Slice>(lowerBound.value());
-        options.iterate_lower_bound = lowerBoundSlice.get();
-    }
+    std::unique_ptr<rocksdb::Iterator> iter(db->NewIterator(options, getFamily(prefix, false)));
 
-    std::unique_ptr<rocksdb::Iterator> iter(db->NewIterator(options));
-
-    return std::make_unique<ObjectIteratorRocksDB>(std::move(iter), std::string{prefix}, std::move(lowerBoundSlice));
+    return std::make_unique<ObjectIteratorRocksDB>(std::move(iter), std::string{prefix}, std::move(bounds));
 }
 
 DatabaseRocksDB::ObjectIteratorRocksDB::ObjectIteratorRocksDB(std::unique_ptr<rocksdb::Iterator> iter,
                                                               std::string prefix,
-                                                              std::unique_ptr<rocksdb::Slice> lowerBound) :
-    iter{std::move(iter)}, prefix{std::move(prefix)}, lowerBound{std::move(lowerBound)} {
+                                                              std::unique_ptr<IteratorBounds> bounds) :
+    iter{std::move(iter)}, prefix{std::move(prefix)}, bounds{std::move(bounds)} {
     this->iter->Seek(this->prefix);
 }
 
@@ -263,13 +625,15 @@ std::string DatabaseRocksDB::ObjectIteratorRocksDB::valueString() const {
     return iter->value().ToString();
 }
 
-DatabaseRocksDB::TransactionRocksDB::TransactionRocksDB(std::unique_ptr<rocksdb::Transaction> txn, rocksdb::DB& db) :
-    txn{std::move(txn)}, db{db} {
+DatabaseRocksDB::TransactionRocksDB::TransactionRocksDB(std::unique_ptr<rocksdb::Transaction> txn,
+                                                        DatabaseRocksDB& parent) :
+    txn{std::move(txn)}, parent{parent} {
 }
 
 DatabaseRocksDB::TransactionRocksDB::~TransactionRocksDB() = default;
 
 bool DatabaseRocksDB::TransactionRocksDB::commit() {
+    const MetricHistogram::Timer timer{metricCommit};
     const auto s = txn->Commit();
     if (s.code() == rocksdb::Status::Code::kBusy) {
         return false;
@@ -279,6 +643,14 @@ bool DatabaseRocksDB::TransactionRocksDB::commit() {
         throw std::runtime_error(fmt::format("database transaction commit error: {}", s.ToString()));
     }
 
+    // A reader may have cached the old value between the write and the commit
+    if (parent.cache) {
+        for (const auto& key : written) {
+            parent.cache->invalidate(key);
+        }
+    }
+    written.clear();
+
     return true;
 }
 
@@ -290,9 +662,10 @@ void DatabaseRocksDB::TransactionRocksDB::abort() {
 }
 
 std::optional<msgpack::object_handle> DatabaseRocksDB::TransactionRocksDB::getRaw(const std::string_view& key) {
+    const MetricHistogram::Timer timer{metricGet};
     rocksdb::ReadOptions options{};
     rocksdb::PinnableSlice slice;
-    const auto s = txn->GetForUpdate(options, db.DefaultColumnFamily(), key, &slice);
+    const auto s = txn->GetForUpdate(options, parent.getFamily(key, false), key, &slice);
     if (!s.ok()) {
         if (s.code() == rocksdb::Status::Code::kNotFound) {
             return {};
@@ -307,6 +680,7 @@ std::optional<msgpack::object_handle> DatabaseRocksDB::TransactionRocksDB::getRa
 
 std::vector<msgpack::object_handle>
 DatabaseRocksDB::TransactionRocksDB::multiGetRaw(const std::vector<std::string>& keys) {
+    const MetricHistogram::Timer timer{metricMultiGet};
     rocksdb::ReadOptions options{};
     std::vector<rocksdb::Slice> keysSlice;
     keysSlice.reserve(keys.size());
@@ -317,11 +691,24 @@ DatabaseRocksDB::TransactionRocksDB::multiGetRaw(const std::vector<std::string>&
     std::vector<rocksdb::Status> statuses;
     slices.resize(keys.size());
     statuses.resize(keys.size());
-    txn->MultiGet(options, db.DefaultColumnFamily(), keys.size(), keysSlice.data(), slices.data(), statuses.data());
+
+    // A transaction can only fetch from a single column family at once, the keys of one schema are usually adjacent
+    for (size_t start = 0; start < keys.size();) {
+        auto* family = parent.getFamily(keys[start], false);
+        auto end = start + 1;
+        while (end < keys.size() && parent.getFamily(keys[end], false) == family) {
+            ++end;
+        }
+        txn->MultiGet(
+            options, family, end - start, keysSlice.data() + start, slices.data() + start, statuses.data() + start);
+        start = end;
+    }
 
     std::vector<msgpack::object_handle> handles;
+    handles.reserve(keys.size());
     for (size_t i = 0; i < keys.size(); i++) {
         if (statuses[i].code() == rocksdb::Status::Code::kNotFound) {
+            handles.emplace_back();
             continue;
         }
 
@@ -338,37 +725,257 @@ DatabaseRocksDB::TransactionRocksDB::multiGetRaw(const std::vector<std::string>&
 }
 
 void DatabaseRocksDB::TransactionRocksDB::putRaw(const std::string_view& key, const void* data, size_t size) {
+    const MetricHistogram::Timer timer{metricPut};
     rocksdb::Slice slice(reinterpret_cast<const char*>(data), size);
-    const auto s = txn->Put(db.DefaultColumnFamily(), key, slice);
+    const auto s = txn->Put(parent.getFamily(key, true), key, slice);
     if (!s.ok()) {
         throw std::runtime_error(fmt::format("Failed to put database key: {} error: {}", key, s.ToString()));
     }
+    if (parent.cache) {
+        parent.cache->invalidate(written.emplace_back(key));
+    }
 }
 
 std::unique_ptr<Database::Transaction> DatabaseRocksDB::TransactionRocksDB::startTransaction() {
     throw std::runtime_error("Can not create nested transaction");
 }
 
+std::unique_ptr<Database::Batch> DatabaseRocksDB::TransactionRocksDB::startBatch() {
+    throw std::runtime_error("Can not create a batch inside of a transaction");
+}
+
+std::unique_ptr<Database::Batch> DatabaseRocksDB::TransactionRocksDB::startBulkLoad() {
+    throw std::runtime_error("Can not create a bulk load inside of a transaction");
+}
+
 void DatabaseRocksDB::TransactionRocksDB::removeRaw(const std::string_view& key) {
-    const auto s = txn->Delete(db.DefaultColumnFamily(), key);
+    const MetricHistogram::Timer timer{metricRemove};
+    const auto s = txn->Delete(parent.getFamily(key, false), key);
     if (!s.ok()) {
         throw std::runtime_error(fmt::format("Failed to delete database key: {} error: {}", key, s.ToString()));
     }
+    if (parent.cache) {
+        parent.cache->invalidate(written.emplace_back(key));
+    }
 }
 
 std::unique_ptr<Database::ObjectIterator>
 DatabaseRocksDB::TransactionRocksDB::seekRaw(const std::string_view& prefix,
                                              const std::optional<std::string_view>& lowerBound) {
     rocksdb::ReadOptions options{};
-    options.prefix_same_as_start = true;
+    auto bounds = createIteratorBounds(options, prefix, lowerBound);
 
-    std::unique_ptr<rocksdb::Slice> lowerBoundSlice;
-    if (lowerBound.has_value()) {
-        lowerBoundSlice = std::make_unique<rocksdb::Slice>(lowerBound.value());
-        options.iterate_lower_bound = lowerBoundSlice.get();
+    std::unique_ptr<rocksdb::Iterator> iter(txn->GetIterator(options, parent.getFamily(prefix, false)));
+
+    return std::make_unique<ObjectIteratorRocksDB>(std::move(iter), std::string{prefix}, std::move(bounds));
+}
+
+DatabaseRocksDB::BatchRocksDB::BatchRocksDB(DatabaseRocksDB& parent) :
+    parent{parent}, batch{std::make_unique<rocksdb::WriteBatch>()} {
+}
+
+DatabaseRocksDB::BatchRocksDB::~BatchRocksDB() = default;
+
+void DatabaseRocksDB::BatchRocksDB::flush() {
+    if (batch->Count() == 0) {
+        return;
+    }
+
+    const MetricHistogram::Timer timer{metricBatch};
+    rocksdb::WriteOptions options{};
+    const auto s = parent.db->Write(options, batch.get());
+    if (!s.ok()) {
+        throw std::runtime_error(fmt::format("database Write() error: {}", s.ToString()));
+    }
+
+    if (parent.cache) {
+        for (const auto& key : written) {
+            parent.cache->invalidate(key);
+        }
+    }
+
+    batch->Clear();
+    written.clear();
+}
+
+void DatabaseRocksDB::BatchRocksDB::commit() {
+    flush();
+}
+
+size_t DatabaseRocksDB::BatchRocksDB::size() const {
+    return total;
+}
+
+std::optional<msgpack::object_handle> DatabaseRocksDB::BatchRocksDB::getRaw(const std::string_view& key) {
+    return parent.getRaw(key);
+}
+
+std::vector<msgpack::object_handle> DatabaseRocksDB::BatchRocksDB::multiGetRaw(const std::vector<std::string>& keys) {
+    return parent.multiGetRaw(keys);
+}
+
+void DatabaseRocksDB::BatchRocksDB::putRaw(const std::string_view& key, const void* data, const size_t size) {
+    rocksdb::Slice slice(reinterpret_cast<const char*>(data), size);
+    const auto s = batch->Put(parent.getFamily(key, true), key, slice);
+    if (!s.ok()) {
+        throw std::runtime_error(fmt::format("Failed to put database key: {} error: {}", key, s.ToString()));
+    }
+
+    written.emplace_back(key);
+    ++total;
+
+    if (batch->GetDataSize() >= maxBatchBytes) {
+        flush();
     }
+}
+
+std::unique_ptr<Database::Transaction> DatabaseRocksDB::BatchRocksDB::startTransaction() {
+    throw std::runtime_error("Can not create a transaction inside of a batch");
+}
 
-    std::unique_ptr<rocksdb::Iterator> iter(txn->GetIterator(options));
+std::unique_ptr<Database::Batch> DatabaseRocksDB::BatchRocksDB::startBatch() {
+    throw std::runtime_error("Can not create nested batch");
+}
 
-    return std::make_unique<ObjectIteratorRocksDB>(std::move(iter), std::string{prefix}, std::move(lowerBoundSlice));
+std::unique_ptr<Database::Batch> DatabaseRocksDB::BatchRocksDB::startBulkLoad() {
+    throw std::runtime_error("Can not create nested batch");
+}
+
+void DatabaseRocksDB::BatchRocksDB::removeRaw(const std::string_view& key) {
+    const auto s = batch->Delete(parent.getFamily(key, false), key);
+    if (!s.ok()) {
+        throw std::runtime_error(fmt::format("Failed to delete database key: {} error: {}", key, s.ToString()));
+    }
+
+    written.emplace_back(key);
+    ++total;
+}
+
+std::unique_ptr<Database::ObjectIterator>
+DatabaseRocksDB::BatchRocksDB::seekRaw(const std::string_view& prefix,
+                                       const std::optional<std::string_view>& lowerBound) {
+    return parent.seekRaw(prefix, lowerBound);
+}
+
+DatabaseRocksDB::BulkLoadRocksDB::BulkLoadRocksDB(DatabaseRocksDB& parent) : parent{parent} {
+}
+
+DatabaseRocksDB::BulkLoadRocksDB::~BulkLoadRocksDB() = default;
+
+void DatabaseRocksDB::BulkLoadRocksDB::commit() {
+    if (entries.empty()) {
+        return;
+    }
+
+    const MetricHistogram::Timer timer{metricIngest};
+
+    // A table file belongs to a single column family. The keys of one schema share a prefix, so they are adjacent
+    // in the sorted map and every family gets exactly one file.
+    std::vector<rocksdb::IngestExternalFileArg> args;
+    std::vector<Path> files;
+
+    const auto removeFiles = [&]() {
+        for (const auto& file : files) {
+            std::error_code ec;
+            std::filesystem::remove(file, ec);
+        }
+    };
+
+    auto it = entries.begin();
+    while (it != entries.end()) {
+        const auto familyName = getFamilyName(it->first);
+        auto* family = parent.getFamily(it->first, true);
+
+        // Written next to the database so the ingestion can move the file instead of copying it
+        const auto& file = files.emplace_back(parent.path / fmt::format("bulk-{}.sst", uuid()));
+
+        const rocksdb::Options options{parent.db->GetDBOptions(), parent.db->GetOptions(family)};
+        rocksdb::SstFileWriter writer{rocksdb::EnvOptions{}, options, family};
+        auto s = writer.Open(file.string());
+
+        for (; s.ok() && it != entries.end() && getFamilyName(it->first) == familyName; ++it) {
+            s = it->second ? writer.Put(it->first, *it->second) : writer.Delete(it->first);
+        }
+
+        if (s.ok()) {
+            s = writer.Finish();
+        }
+
+        if (!s.ok()) {
+            removeFiles();
+            throw std::runtime_error(fmt::format("Failed to create bulk load file: {} error: {}", file, s.ToString()));
+        }
+
+        auto& arg = args.emplace_back();
+        arg.column_family = family;
+        arg.external_files.push_back(file.string());
+        arg.options.move_files = true;
+    }
+
+    // All families are ingested atomically
+    const auto s = parent.db->IngestExternalFiles(args);
+    if (!s.ok()) {
+        removeFiles();
+        throw std::runtime_error(fmt::format("Failed to ingest bulk load files error: {}", s.ToString()));
+    }
+
+    logger.info("Ingested {} keys into the database", entries.size());
+
+    if (parent.cache) {
+        for (const auto& [key, _] : entries) {
+            parent.cache->invalidate(key);
+        }
+    }
+
+    entries.clear();
+}
+
+size_t DatabaseRocksDB::BulkLoadRocksDB::size() const {
+    return entries.size();
+}
+
+std::optional<msgpack::object_handle> DatabaseRocksDB::BulkLoadRocksDB::getRaw(const std::string_view& key) {
+    return parent.getRaw(key);
+}
+
+std::vector<msgpack::object_handle>
+DatabaseRocksDB::BulkLoadRocksDB::multiGetRaw(const std::vector<std::string>& keys) {
+    return parent.multiGetRaw(keys);
+}
+
+void DatabaseRocksDB::BulkLoadRocksDB::putRaw(const std::string_view& key, const void* data, const size_t size) {
+    auto value = std::make_optional<std::string>(reinterpret_cast<const char*>(data), size);
+    const auto it = entries.find(key);
+    if (it != entries.end()) {
+        it->second = std::move(value);
+    } else {
+        entries.emplace(key, std::move(value));
+    }
+}
+
+std::unique_ptr<Database::Transaction> DatabaseRocksDB::BulkLoadRocksDB::startTransaction() {
+    throw std::runtime_error("Can not create a transaction inside of a bulk load");
+}
+
+std::unique_ptr<Database::Batch> DatabaseRocksDB::BulkLoadRocksDB::startBatch() {
+    throw std::runtime_error("Can not create nested batch");
+}
+
+std::unique_ptr<Database::Batch> DatabaseRocksDB::BulkLoadRocksDB::startBulkLoad() {
+    throw std::runtime_error("Can not create nested batch");
+}
+
+void DatabaseRocksDB::BulkLoadRocksDB::removeRaw(const std::string_view& key) {
+    const auto it = entries.find(key);
+    if (it != entries.end()) {
+        it->second.reset();
+    } else {
+        entries.emplace(key, std::nullopt);
+    }
+}
+
+std::unique_ptr<Database::ObjectIterator>
+DatabaseRocksDB::BulkLoadRocksDB::seekRaw(const std::string_view& prefix,
+                                          const std::optional<std::string_view>& lowerBound) {
+    return parent.seekRaw(prefix, lowerBound);
 }
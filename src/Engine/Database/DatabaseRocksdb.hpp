@@ -2,6 +2,8 @@
 
 #include "../Utils/Path.hpp"
 #include "Database.hpp"
+#include <map>
+#include <shared_mutex>
 
 namespace rocksdb {
 class DB;
@@ -9,22 +11,38 @@ class OptimisticTransactionDB;
 class Transaction;
 class Slice;
 class Iterator;
+class WriteBatch;
+class ColumnFamilyHandle;
+struct ColumnFamilyOptions;
+class Cache;
+class Statistics;
 } // namespace rocksdb
 
 namespace Engine {
 class ENGINE_API DatabaseRocksDB : public Database {
 public:
     struct Options {
+        // Memtable size of a single schema, all schemas together are capped at twice this size
         size_t writeBufferSizeMb{64};
+        // Block cache shared by all schemas, holds the data, index, and filter blocks
         size_t cacheSizeMb{256};
+        size_t blockSizeKb{16};
+        int bloomBitsPerKey{10};
         bool debugLogging{false};
         bool compression{false};
+        // Collects the RocksDB tickers and histograms and exports them to the metrics registry
+        bool statistics{true};
+        // Number of unpacked objects cached by find() and multiGet(), zero disables the cache
+        size_t objectCacheSize{0};
     };
 
+    // Keeps the iterate bounds alive for as long as the iterator lives
+    struct IteratorBounds;
+
     class ObjectIteratorRocksDB : public ObjectIterator {
     public:
         explicit ObjectIteratorRocksDB(std::unique_ptr<rocksdb::Iterator> iter, std::string prefix,
-                                       std::unique_ptr<rocksdb::Slice> lowerBound);
+                                       std::unique_ptr<IteratorBounds> bounds);
         ~ObjectIteratorRocksDB();
 
         bool next() override;
@@ -37,7 +55,7 @@ public:
     private:
         std::unique_ptr<rocksdb::Iterator> iter;
         std::string prefix;
-        std::unique_ptr<rocksdb::Slice> lowerBound;
+        std::unique_ptr<IteratorBounds> bounds;
         msgpack::object_handle oh;
         std::string iterKey;
         bool hasValue{false};
@@ -46,7 +64,7 @@ public:
 
     class TransactionRocksDB : public Transaction {
     public:
-        explicit TransactionRocksDB(std::unique_ptr<rocksdb::Transaction> txn, rocksdb::DB& db);
+        explicit TransactionRocksDB(std::unique_ptr<rocksdb::Transaction> txn, DatabaseRocksDB& parent);
         ~TransactionRocksDB();
 
         bool commit() override;
@@ -56,13 +74,70 @@ public:
         std::vector<msgpack::object_handle> multiGetRaw(const std::vector<std::string>& keys) override;
         void putRaw(const std::string_view& key, const void* data, size_t size) override;
         std::unique_ptr<Transaction> startTransaction() override;
+        std::unique_ptr<Batch> startBatch() override;
+        std::unique_ptr<Batch> startBulkLoad() override;
         void removeRaw(const std::string_view& key) override;
         std::unique_ptr<ObjectIterator> seekRaw(const std::string_view& prefix,
                                                 const std::optional<std::string_view>& lowerBound) override;
 
     private:
         std::unique_ptr<rocksdb::Transaction> txn;
-        rocksdb::DB& db;
+        DatabaseRocksDB& parent;
+        std::vector<std::string> written;
+    };
+
+    class BatchRocksDB : public Batch {
+    public:
+        // Pending writes are flushed once they reach this size, so large loads do not grow the memory unbounded
+        static constexpr size_t maxBatchBytes = 16 * 1024 * 1024;
+
+        explicit BatchRocksDB(DatabaseRocksDB& parent);
+        ~BatchRocksDB();
+
+        void commit() override;
+        [[nodiscard]] size_t size() const override;
+
+        std::optional<msgpack::object_handle> getRaw(const std::string_view& key) override;
+        std::vector<msgpack::object_handle> multiGetRaw(const std::vector<std::string>& keys) override;
+        void putRaw(const std::string_view& key, const void* data, size_t size) override;
+        std::unique_ptr<Transaction> startTransaction() override;
+        std::unique_ptr<Batch> startBatch() override;
+        std::unique_ptr<Batch> startBulkLoad() override;
+        void removeRaw(const std::string_view& key) override;
+        std::unique_ptr<ObjectIterator> seekRaw(const std::string_view& prefix,
+                                                const std::optional<std::string_view>& lowerBound) override;
+
+    private:
+        void flush();
+
+        DatabaseRocksDB& parent;
+        std::unique_ptr<rocksdb::WriteBatch> batch;
+        std::vector<std::string> written;
+        size_t total{0};
+    };
+
+    class BulkLoadRocksDB : public Batch {
+    public:
+        explicit BulkLoadRocksDB(DatabaseRocksDB& parent);
+        ~BulkLoadRocksDB();
+
+        void commit() override;
+        [[nodiscard]] size_t size() const override;
+
+        std::optional<msgpack::object_handle> getRaw(const std::string_view& key) override;
+        std::vector<msgpack::object_handle> multiGetRaw(const std::vector<std::string>& keys) override;
+        void putRaw(const std::string_view& key, const void* data, size_t size) override;
+        std::unique_ptr<Transaction> startTransaction() override;
+        std::unique_ptr<Batch> startBatch() override;
+        std::unique_ptr<Batch> startBulkLoad() override;
+        void removeRaw(const std::string_view& key) override;
+        std::unique_ptr<ObjectIterator> seekRaw(const std::string_view& prefix,
+                                                const std::optional<std::string_view>& lowerBound) override;
+
+    private:
+        DatabaseRocksDB& parent;
+        // Table files must be written in key order, an empty optional marks a deleted key
+        std::map<std::string, std::optional<std::string>, std::less<>> entries;
     };
 
     explicit DatabaseRocksDB(const Path& path, const Options& options);
@@ -72,14 +147,37 @@ public:
     std::vector<msgpack::object_handle> multiGetRaw(const std::vector<std::string>& keys) override;
     void putRaw(const std::string_view& key, const void* data, size_t size) override;
     std::unique_ptr<Transaction> startTransaction() override;
+    std::unique_ptr<Batch> startBatch() override;
+    std::unique_ptr<Batch> startBulkLoad() override;
     void removeRaw(const std::string_view& key) override;
     std::unique_ptr<ObjectIterator> seekRaw(const std::string_view& prefix,
                                             const std::optional<std::string_view>& lowerBound) override;
+    DatabaseCache* getCache() override {
+        return cache.get();
+    }
+
+    // Every schema lives in its own column family named after the schema, keys without a schema use the default one
+    static std::string_view getFamilyName(const std::string_view& key);
+    // The part of the key the prefix bloom filters are built from, empty if the key has none
+    static std::string_view getSeekPrefix(const std::string_view& key);
 
 private:
     static void deleterDb(rocksdb::OptimisticTransactionDB* value);
 
+    // Reads of a schema that was never written fall back to the default column family, writes create the family
+    rocksdb::ColumnFamilyHandle* getFamily(const std::string_view& key, bool create);
+    void migrateDefaultFamily();
+    void startMetrics();
+
+    Path path;
     rocksdb::DB* db{nullptr};
     std::unique_ptr<rocksdb::OptimisticTransactionDB, decltype(&deleterDb)> txn{nullptr, &deleterDb};
+    std::unique_ptr<rocksdb::ColumnFamilyOptions> familyOptions;
+    std::shared_ptr<rocksdb::Cache> blockCache;
+    std::shared_ptr<rocksdb::Statistics> statistics;
+    std::shared_mutex familiesMutex;
+    std::map<std::string, rocksdb::ColumnFamilyHandle*, std::less<>> families;
+    std::vector<uint64_t> metricsCollectors;
+    std::unique_ptr<DatabaseCache> cache;
 };
 } // namespace Engine
@@ -0,0 +1,138 @@
+#include "BakedModelFile.hpp"
+#include "../Utils/Exceptions.hpp"
+#include <cstring>
+#include <fstream>
+
+using namespace Engine;
+
+static constexpr std::array<char, 4> magic = {'T', 'E', 'M', 'D'};
+
+struct Header {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint64_t collisionOffset;
+    uint64_t collisionSize;
+    uint64_t renderOffset;
+    uint64_t renderSize;
+    uint64_t source;
+};
+
+static_assert(sizeof(Header) == 48, "struct Header must be tightly packed");
+
+static void validateHeader(const Header& header, const size_t fileSize) {
+    if (header.magic != magic) {
+        EXCEPTION("Not a baked model file");
+    }
+    if (header.version != BakedModelFile::version) {
+        EXCEPTION("Baked model file version: {} does not match: {}", header.version, BakedModelFile::version);
+    }
+    // Compared without the sum of the offset and the size, which a corrupted header could overflow
+    if (header.collisionOffset > fileSize || header.collisionSize > fileSize - header.collisionOffset ||
+        header.renderOffset > fileSize || header.renderSize > fileSize - header.renderOffset) {
+        EXCEPTION("Baked model file is truncated");
+    }
+}
+
+static Header readHeader(std::ifstream& file, const Path& path) {
+    Header header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header))) {
+        EXCEPTION("Baked model file is truncated");
+    }
+    validateHeader(header, Fs::file_size(path));
+    return header;
+}
+
+template <typename T> static void unpackSection(const char* data, const size_t size, T& value) {
+    const auto handle = msgpack::unpack(data, size);
+    handle.get().convert(value);
+}
+
+void BakedModelFile::write(const Path& path, const BakedModel& model, const uint64_t source) {
+    msgpack::sbuffer collision;
+    msgpack::pack(collision, model.collision);
+
+    msgpack::sbuffer render;
+    msgpack::pack(render, model.nodes);
+
+    Header header{};
+    header.magic = magic;
+    header.version = version;
+    header.collisionOffset = sizeof(Header);
+    header.collisionSize = collision.size();
+    header.renderOffset = header.collisionOffset + header.collisionSize;
+    header.renderSize = render.size();
+    header.source = source;
+
+    std::ofstream file{path, std::ios::out | std::ios::binary | std::ios::trunc};
+    if (!file) {
+        EXCEPTION("Failed to open file: '{}' for writing", path);
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.write(collision.data(), static_cast<std::streamsize>(collision.size()));
+    file.write(render.data(), static_cast<std::streamsize>(render.size()));
+
+    if (!file) {
+        EXCEPTION("Failed to write file: '{}'", path);
+    }
+}
+
+BakedModel BakedModelFile::read(const Path& path) {
+    try {
+        const auto data = readFileBinary(path);
+        if (data.size() < sizeof(Header)) {
+            EXCEPTION("Baked model file is truncated");
+        }
+
+        Header header{};
+        std::memcpy(&header, data.data(), sizeof(Header));
+        validateHeader(header, data.size());
+
+        BakedModel model{};
+        unpackSection(data.data() + header.collisionOffset, header.collisionSize, model.collision);
+        unpackSection(data.data() + header.renderOffset, header.renderSize, model.nodes);
+        return model;
+    } catch (...) {
+        EXCEPTION_NESTED("Failed to read baked model file: '{}'", path);
+    }
+}
+
+BakedModel::Collision BakedModelFile::readCollision(const Path& path) {
+    try {
+        std::ifstream file{path, std::ios::in | std::ios::binary};
+        if (!file) {
+            EXCEPTION("Failed to open file for reading");
+        }
+
+        const auto header = readHeader(file, path);
+
+        std::vector<char> data;
+        data.resize(header.collisionSize);
+        file.seekg(static_cast<std::streamoff>(header.collisionOffset));
+        if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+            EXCEPTION("Baked model file is truncated");
+        }
+
+        BakedModel::Collision collision{};
+        unpackSection(data.data(), data.size(), collision);
+        return collision;
+    } catch (...) {
+        EXCEPTION_NESTED("Failed to read baked model collision: '{}'", path);
+    }
+}
+
+bool BakedModelFile::isUpToDate(const Path& path, const uint64_t source) {
+    if (!Fs::exists(path)) {
+        return false;
+    }
+
+    try {
+        std::ifstream file{path, std::ios::in | std::ios::binary};
+        if (!file) {
+            return false;
+        }
+        return readHeader(file, path).source == source;
+    } catch (...) {
+        return false;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../Math/Matrix.hpp"
+#include "../Utils/Path.hpp"
+#include <msgpack.hpp>
+
+namespace Engine {
+// Everything the Model needs, already validated and processed, so the load does not touch the glTF files
+struct ENGINE_API BakedModel {
+    struct Collision {
+        Vector3 bbMin{0.0f};
+        Vector3 bbMax{0.0f};
+        float radius{0.0f};
+        // Points of the convex hull, empty when the model has no collision node and uses a sphere
+        std::vector<float> hull;
+
+        MSGPACK_DEFINE_ARRAY(bbMin, bbMax, radius, hull);
+    };
+
+    struct Material {
+        // Texture file names relative to the model, empty when the default texture is used
+        std::string baseColorTexture;
+        std::string normalTexture;
+        std::string emissiveTexture;
+        std::string metallicRoughnessTexture;
+        std::string ambientOcclusionTexture;
+        Vector4 baseColorFactor{1.0f};
+        Vector4 emissiveFactor{0.0f};
+        Vector4 metallicRoughnessFactor{1.0f};
+
+        MSGPACK_DEFINE_ARRAY(baseColorTexture, normalTexture, emissiveTexture, metallicRoughnessTexture,
+                             ambientOcclusionTexture, baseColorFactor, emissiveFactor, metallicRoughnessFactor);
+    };
+
+    struct Lod {
+        uint32_t offset{0};
+        uint32_t count{0};
+        float error{0.0f};
+
+        MSGPACK_DEFINE_ARRAY(offset, count, error);
+    };
+
+    struct Primitive {
+        Material material;
+        // Interleaved in the layout of the ComponentModel::Vertex or ComponentModel::SkinnedVertex
+        std::vector<char> vertices;
+        std::vector<char> indices;
+        bool indices32{false};
+        std::vector<Lod> lods;
+        float radius{0.0f};
+
+        MSGPACK_DEFINE_ARRAY(material, vertices, indices, indices32, lods, radius);
+    };
+
+    struct Node {
+        std::string name;
+        std::vector<Primitive> primitives;
+        std::vector<Matrix4> inverseBindMat;
+        std::vector<Matrix4> jointsLocalMat;
+
+        MSGPACK_DEFINE_ARRAY(name, primitives, inverseBindMat, jointsLocalMat);
+    };
+
+    Collision collision;
+    std::vector<Node> nodes;
+};
+
+// Uncompressed file made of a fixed header followed by the collision and the render sections. Each section is
+// a single msgpack object, the whole file is read at once by the client and only the collision by the server.
+// The header also keeps the stamp of the sources the file was baked from, see Model::getSourceStamp().
+class ENGINE_API BakedModelFile {
+public:
+    // Bump whenever the layout of the baked data or the vertex processing changes
+    static constexpr uint32_t version = 2;
+
+    static void write(const Path& path, const BakedModel& model, uint64_t source);
+    static BakedModel read(const Path& path);
+    static BakedModel::Collision readCollision(const Path& path);
+    // False when the file is missing, unreadable, of another version, or baked from different sources
+    static bool isUpToDate(const Path& path, uint64_t source);
+};
+} // namespace Engine
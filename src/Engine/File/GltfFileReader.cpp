@@ -310,6 +310,28 @@ GltfFileReader::GltfFileReader(const Span<uint8_t>& source) {
 
 GltfFileReader::~GltfFileReader() = default;
 
+std::vector<Path> GltfFileReader::getBufferPaths(const Path& path) {
+    cgltf_options options;
+    std::memset(&options, 0, sizeof(options));
+    cgltf_data* data = nullptr;
+    const auto pathStr = path.string();
+    const auto result = cgltf_parse_file(&options, pathStr.c_str(), &data);
+    if (result != cgltf_result_success) {
+        EXCEPTION("Failed to open gltf file: {} error: {}", path.string(), gltfErrorToString(result));
+    }
+
+    std::vector<Path> paths;
+    for (size_t i = 0; i < data->buffers_count; i++) {
+        const auto* uri = data->buffers[i].uri;
+        if (uri != nullptr && std::strncmp(uri, "data:", 5) != 0) {
+            paths.push_back(path.parent_path() / Path(uri));
+        }
+    }
+
+    cgltf_free(data);
+    return paths;
+}
+
 void GltfFileReader::process() {
     try {
         for (auto i = 0; i < static_cast<int>(this->data->materials_count); i++) {
@@ -196,6 +196,9 @@ public:
     explicit GltfFileReader(const Span<uint8_t>& source);
     virtual ~GltfFileReader();
 
+    // The external buffer files of the glTF file, only the JSON is parsed and the buffers are not loaded
+    static std::vector<Path> getBufferPaths(const Path& path);
+
     const std::vector<GltfMaterial>& getMaterials() const {
         return materials;
     }
@@ -1,90 +1,66 @@
 #include "FontFace.hpp"
 #include "../Utils/Exceptions.hpp"
-#include "../Utils/Packer.hpp"
-#include "FontLoader.hpp"
 #include <utf8.h>
 
 using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
+static_assert(GlyphAtlas::framesInFlight == MAX_FRAMES_IN_FLIGHT);
+
+static Vector2i getTextureSize(const VulkanTexture& texture) {
+    return {static_cast<int>(texture.getExtent().width), static_cast<int>(texture.getExtent().height)};
+}
+
+static VulkanTexture& clearRegion(VulkanRenderer& vulkan, VulkanTexture& texture, const Vector2i& offset) {
+    // Make sure the whole region is empty, pages are uploaded only once they are used
+    std::unique_ptr<char[]> pixels{new char[FontFace::atlasSize.x * FontFace::atlasSize.y]};
+    std::memset(pixels.get(), 0x00, FontFace::atlasSize.x * FontFace::atlasSize.y);
+    vulkan.copyDataToImage(texture, 0, offset, 0, FontFace::atlasSize, pixels.get());
+    return texture;
+}
+
 FontFace::FontFace(VulkanRenderer& vulkan, const Path& path, VulkanTexture& texture, const Vector2i& offset,
                    const int size) :
-    size{size} {
-
-    auto loader = FontLoader{path, size};
-
-    std::vector<std::tuple<int, FontLoader::Glyph>> raw;
-
-    static std::vector<std::tuple<int, int>> ranges = {
-        {0x0000, 0x0000}, // Unknown,
-        {0x0020, 0x00FF}, // Basic Latin + Latin-1 Supplement
-        {0x0100, 0x017F}, // Latin Extended-A
-        {0x0180, 0x024F}, // Latin Extended-B
-        {0x0250, 0x02AF}, // IPA Extensions
-        {0x0400, 0x04FF}, // Cyrillic
-        {0x0500, 0x052F}, // Cyrillic Supplementary
-        {0x2200, 0x22FF}, // Mathematical Operators
-    };
-
-    for (const auto [start, end] : ranges) {
-        for (int code = start; code <= end; code++) {
-            raw.emplace_back(code, loader.getGlyph(code));
-        }
-    }
-
-    std::unique_ptr<char[]> pixels{new char[atlasSize.x * atlasSize.y]};
-    auto dst = pixels.get();
-    std::memset(pixels.get(), 0x00, atlasSize.x * atlasSize.y);
+    size{size},
+    texture{clearRegion(vulkan, texture, offset)},
+    offset{offset},
+    loader{path, size},
+    atlas{*this, atlasSize, getTextureSize(texture), offset, size} {
+}
 
-    Packer packer{raw.size(), atlasSize};
-    for (auto& i : raw) {
-        const auto code = std::get<0>(i);
+FontFace::~FontFace() = default;
 
-        auto res = packer.add(std::get<1>(i).bitmapSize + padding * 2);
-        if (!res) {
-            EXCEPTION("Unable to fit glyph {} into the texture of size: {}", code, atlasSize);
-        }
+bool FontFace::hasGlyph(const uint32_t code) {
+    return loader.hasGlyph(code);
+}
 
-        const auto pos = *res + padding;
-        const auto& data = std::get<1>(i);
+FontLoader::Glyph FontFace::loadGlyph(const uint32_t code) {
+    return loader.getGlyph(static_cast<int>(code));
+}
 
-        const auto src = data.bitmap.get();
+bool FontFace::isDirty() const {
+    return atlas.isDirty();
+}
 
-        for (int row = 0; row < data.bitmapSize.y; row++) {
-            for (int col = 0; col < data.bitmapSize.x; col++) {
-                const auto x = pos.x + col;
-                const auto y = pos.y + row;
-                dst[y * atlasSize.x + x] = src[row * data.bitmapPitch + col];
-            }
+void FontFace::flush(VulkanRenderer& vulkan) {
+    const auto pageSize = atlas.getPageSize();
+    for (auto& page : atlas.getPages()) {
+        if (!page.dirty) {
+            continue;
         }
 
-        Glyph glyph{};
-        glyph.advance = static_cast<float>(data.advance >> 6);
-        glyph.uv = Vector2{
-            static_cast<float>(pos.x + offset.x) / static_cast<float>(texture.getExtent().width),
-            static_cast<float>(pos.y + offset.y) / static_cast<float>(texture.getExtent().height),
-        };
-        glyph.st = Vector2{
-            static_cast<float>(data.bitmapSize.x) / static_cast<float>(texture.getExtent().width),
-            static_cast<float>(data.bitmapSize.y) / static_cast<float>(texture.getExtent().height),
-        };
-        glyph.box = data.box;
-        glyph.size = data.bitmapSize;
-        glyph.ascend = data.ascend;
-
-        glyphs.insert(std::make_pair(code, glyph));
+        vulkan.copyDataToImage(texture, 0, offset + page.pos, 0, Vector2i{pageSize}, page.pixels.get());
+        page.dirty = false;
     }
-
-    vulkan.copyDataToImage(texture, 0, offset, 0, atlasSize, pixels.get());
-
-    unknown = &glyphs.at(0);
 }
 
-FontFace::~FontFace() = default;
+void FontFace::nextFrame() {
+    atlas.nextFrame();
+}
 
 float FontFace::getGlyphAdvance(const uint32_t code, const float height) const {
-    const auto& glyph = getGlyph(code);
+    const auto glyph = getGlyph(code);
     const auto scale = height / static_cast<float>(getSize());
     return glyph.advance * scale;
 }
@@ -100,7 +76,7 @@ Vector2 FontFace::getBounds(const std::string_view& text, const float height) co
 
     while (it < end) {
         const auto code = utf8::next(it, end);
-        const auto& glyph = getGlyph(code);
+        const auto glyph = getGlyph(code);
 
         max.y = std::max(max.y, pos.y + height);
         pos += Vector2{glyph.advance * scale, 0.0f};
@@ -2,7 +2,7 @@
 
 #include "../Utils/Path.hpp"
 #include "../Vulkan/VulkanRenderer.hpp"
-#include <unordered_map>
+#include "GlyphAtlas.hpp"
 
 namespace Engine {
 enum class TextAlign {
@@ -17,43 +17,50 @@ enum class TextAlign {
     RightBottom,
 };
 
-class ENGINE_API FontFace {
+class ENGINE_API FontFace : private GlyphAtlas::Source {
 public:
     static inline const Vector2i atlasSize{2048, 1024};
 
-    struct Glyph {
-        Vector2 uv;
-        Vector2 st;
-        Vector2 size;
-        Vector2 box;
-        float advance;
-        float ascend;
-    };
+    using Glyph = GlyphAtlas::Glyph;
 
     explicit FontFace(VulkanRenderer& vulkan, const Path& path, VulkanTexture& texture, const Vector2i& offset,
                       int size);
-    ~FontFace();
-
-    const Glyph& getGlyph(const uint32_t code) const {
-        const auto it = glyphs.find(code);
-        if (it == glyphs.end()) {
-            return *unknown;
-        }
-        return it->second;
+    ~FontFace() override;
+
+    // By value, rasterizing another glyph may evict the page the previous one lives in
+    Glyph getGlyph(const uint32_t code) const {
+        return atlas.getGlyph(code);
     }
 
     int getSize() const {
         return size;
     }
 
+    void touch(const int page) const {
+        atlas.touch(page);
+    }
+
+    // Incremented every time a page is evicted, any cached glyph UVs become invalid when this changes
+    uint64_t getGeneration() const {
+        return atlas.getGeneration();
+    }
+
     float getGlyphAdvance(uint32_t code, float height) const;
     Vector2 getBounds(const std::string_view& text, float height) const;
     Vector2 getPenOffset(const std::string_view& text, float height, const TextAlign textAlign) const;
 
+    bool isDirty() const;
+    void flush(VulkanRenderer& vulkan);
+    void nextFrame();
+
 private:
-    static inline const Vector2i padding{2, 2};
+    bool hasGlyph(uint32_t code) override;
+    FontLoader::Glyph loadGlyph(uint32_t code) override;
+
     const int size;
-    std::unordered_map<uint32_t, Glyph> glyphs;
-    const Glyph* unknown;
+    VulkanTexture& texture;
+    const Vector2i offset;
+    FontLoader loader;
+    mutable GlyphAtlas atlas;
 };
 } // namespace Engine
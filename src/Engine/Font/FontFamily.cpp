@@ -40,7 +40,7 @@ Vector2 Engine::textAlignToVector(TextAlign textAlign) {
     }
 }
 
-FontFamily::FontFamily(VulkanRenderer& vulkan, const Sources& sources, const int size) : size{size} {
+FontFamily::FontFamily(VulkanRenderer& vulkan, const Sources& sources, const int size) : vulkan{vulkan}, size{size}, runCache{*this} {
     VulkanTexture::CreateInfo textureInfo{};
     textureInfo.image.format = VK_FORMAT_R8_UNORM;
     textureInfo.image.imageType = VK_IMAGE_TYPE_2D;
@@ -98,6 +98,10 @@ FontFamily::FontFamily(VulkanRenderer& vulkan, const Sources& sources, const int
         }
     }
 
+    for (auto& face : faces) {
+        face->flush(vulkan);
+    }
+
     vulkan.generateMipMaps(texture);
 
     logger.info("Loaded font of size: {} with atlas size: {}", size, atlasSize);
@@ -108,15 +112,44 @@ float FontFamily::getGlyphAdvance(const uint32_t code, const float height) const
 }
 
 Vector2 FontFamily::getBounds(const std::string_view& text, const float height) const {
-    TextShaper shaper{*this, height};
-    shaper.write(text);
-    return shaper.getBounds();
+    return shape(text, height).bounds;
 }
 
 Vector2 FontFamily::getPenOffset(const std::string_view& text, const float height, const TextAlign textAlign) const {
     return getBounds(text, height) * textAlignToVector(textAlign);
 }
 
+uint64_t FontFamily::getGeneration() const {
+    uint64_t generation{0};
+    for (const auto& face : faces) {
+        generation += face->getGeneration();
+    }
+    return generation;
+}
+
+const TextRun& FontFamily::shape(const std::string_view& text, const float height, const bool markup) const {
+    return runCache.get(text, height, markup);
+}
+
+void FontFamily::flush() {
+    const auto dirty = std::any_of(faces.begin(), faces.end(), [](const auto& face) { return face->isDirty(); });
+
+    if (dirty) {
+        vulkan.transitionImageLayout(
+            texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+        for (auto& face : faces) {
+            face->flush(vulkan);
+        }
+
+        vulkan.generateMipMaps(texture);
+    }
+
+    for (auto& face : faces) {
+        face->nextFrame();
+    }
+}
+
 std::string FontFamily::wrapText(const std::string_view& text, const float height, const float width) const {
     TextWrapper wrapper{*this, height, width};
     wrapper.write(text);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "FontFace.hpp"
+#include "TextRunCache.hpp"
 
 namespace Engine {
 ENGINE_API Vector2 textAlignToVector(TextAlign textAlign);
@@ -40,6 +41,15 @@ public:
     [[nodiscard]] Vector2 getBounds(const std::string_view& text, float height) const;
     [[nodiscard]] Vector2 getPenOffset(const std::string_view& text, float height, TextAlign textAlign) const;
     [[nodiscard]] std::string wrapText(const std::string_view& text, float height, float width) const;
+    [[nodiscard]] uint64_t getGeneration() const;
+    [[nodiscard]] const TextRun& shape(const std::string_view& text, float height, bool markup = true) const;
+
+    [[nodiscard]] const TextRunCache& getRunCache() const {
+        return runCache;
+    }
+
+    // Uploads glyphs rasterized since the last call, must be called before the frame is submitted
+    void flush();
 
     [[nodiscard]] VulkanTexture& getTexture() {
         return texture;
@@ -51,8 +61,10 @@ public:
 
 private:
     static inline const Vector2i atlasSize{4096, 4096};
+    VulkanRenderer& vulkan;
     std::array<std::unique_ptr<FontFace>, total> faces;
     int size;
     VulkanTexture texture;
+    mutable TextRunCache runCache;
 };
 } // namespace Engine
@@ -62,3 +62,7 @@ FontLoader::Glyph FontLoader::getGlyph(int code) {
 
     return glyph;
 }
+
+bool FontLoader::hasGlyph(const uint32_t code) const {
+    return FT_Get_Char_Index(face.get(), code) != 0;
+}
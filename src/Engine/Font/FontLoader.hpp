@@ -21,6 +21,7 @@ public:
 
     explicit FontLoader(const Path& path, int size);
     Glyph getGlyph(int code);
+    bool hasGlyph(uint32_t code) const;
 
 private:
     std::shared_ptr<FT_FaceRec_> face;
@@ -0,0 +1,181 @@
+#include "GlyphAtlas.hpp"
+#include "../Utils/Exceptions.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+static int calculatePageSize(const int fontSize, const Vector2i& size) {
+    // Large enough to hold a decent number of glyphs, but small enough so that evicting a page is cheap
+    int pageSize = 256;
+    while (pageSize < fontSize * 4 && pageSize < size.y) {
+        pageSize *= 2;
+    }
+    return pageSize;
+}
+
+GlyphAtlas::GlyphAtlas(Source& source, const Vector2i& size, const Vector2i& textureSize, const Vector2i& offset,
+                       const int fontSize) :
+    source{source}, pageSize{calculatePageSize(fontSize, size)}, textureSize{textureSize}, offset{offset} {
+
+    direct.resize(directLookupSize);
+
+    for (auto y = 0; y + pageSize <= size.y; y += pageSize) {
+        for (auto x = 0; x + pageSize <= size.x; x += pageSize) {
+            auto& page = pages.emplace_back();
+            page.pos = {x, y};
+            clearPage(page);
+        }
+    }
+
+    // The unknown glyph always lives in the first page, which is never evicted
+    const auto glyph = rasterize(0);
+    if (glyph.page != 0) {
+        EXCEPTION("Unable to fit unknown glyph into the atlas of size: {}", size);
+    }
+    unknown = glyph;
+}
+
+GlyphAtlas::Glyph& GlyphAtlas::getSlot(const uint32_t code) {
+    return code < directLookupSize ? direct[code] : extended[code];
+}
+
+GlyphAtlas::Glyph GlyphAtlas::rasterize(const uint32_t code) {
+    // Code points missing in the font resolve to the unknown glyph, which is cached in their place
+    if (code != 0 && !source.hasGlyph(code)) {
+        return getSlot(code) = unknown;
+    }
+
+    const auto data = source.loadGlyph(code);
+
+    int index;
+    auto res = allocate(data.bitmapSize + padding * 2, index);
+    if (!res) {
+        if (code == 0) {
+            return unknown;
+        }
+
+        // Too large for a page is permanent, a full atlas is tried again on the next frame
+        const auto tooLarge = data.bitmapSize.x + padding.x * 2 > pageSize ||
+                              data.bitmapSize.y + padding.y * 2 > pageSize;
+        logger.warn("Unable to fit glyph {} into the atlas, too large: {}", code, tooLarge);
+        if (!tooLarge) {
+            deferred.push_back(code);
+        }
+        return getSlot(code) = unknown;
+    }
+
+    auto& page = pages[index];
+    const auto pos = *res + padding;
+    const auto src = data.bitmap.get();
+    auto* dst = page.pixels.get();
+
+    for (int row = 0; row < data.bitmapSize.y; row++) {
+        for (int col = 0; col < data.bitmapSize.x; col++) {
+            dst[(pos.y + row) * pageSize + pos.x + col] = src[row * data.bitmapPitch + col];
+        }
+    }
+
+    page.codes.push_back(code);
+    page.dirty = true;
+    page.lastUsed = frameNum;
+
+    const auto texel = page.pos + pos + offset;
+
+    auto& glyph = getSlot(code);
+    glyph.advance = static_cast<float>(data.advance >> 6);
+    glyph.uv = Vector2{
+        static_cast<float>(texel.x) / static_cast<float>(textureSize.x),
+        static_cast<float>(texel.y) / static_cast<float>(textureSize.y),
+    };
+    glyph.st = Vector2{
+        static_cast<float>(data.bitmapSize.x) / static_cast<float>(textureSize.x),
+        static_cast<float>(data.bitmapSize.y) / static_cast<float>(textureSize.y),
+    };
+    glyph.box = data.box;
+    glyph.size = data.bitmapSize;
+    glyph.ascend = data.ascend;
+    glyph.page = index;
+
+    return glyph;
+}
+
+std::optional<Vector2i> GlyphAtlas::allocate(const Vector2i& size, int& page) {
+    if (size.x > pageSize || size.y > pageSize) {
+        return std::nullopt;
+    }
+
+    for (page = 0; page < static_cast<int>(pages.size()); page++) {
+        auto res = pages[page].packer->add(size);
+        if (res) {
+            return res;
+        }
+    }
+
+    page = evict();
+    if (page < 0) {
+        return std::nullopt;
+    }
+
+    return pages[page].packer->add(size);
+}
+
+int GlyphAtlas::evict() {
+    // Find the least recently used page that is no longer referenced by any frame in flight
+    int found = -1;
+    for (int i = 1; i < static_cast<int>(pages.size()); i++) {
+        if (pages[i].lastUsed + framesInFlight >= frameNum) {
+            continue;
+        }
+        if (found < 0 || pages[i].lastUsed < pages[found].lastUsed) {
+            found = i;
+        }
+    }
+
+    if (found < 0) {
+        return -1;
+    }
+
+    auto& page = pages[found];
+    for (const auto code : page.codes) {
+        if (code < directLookupSize) {
+            direct[code].page = -1;
+        } else {
+            extended.erase(code);
+        }
+    }
+
+    clearPage(page);
+    page.dirty = true;
+    generation++;
+
+    return found;
+}
+
+void GlyphAtlas::clearPage(Page& page) const {
+    page.codes.clear();
+    page.packer = std::make_unique<Packer>(pageSize, Vector2i{pageSize, pageSize});
+    if (!page.pixels) {
+        page.pixels.reset(new char[pageSize * pageSize]);
+    }
+    std::memset(page.pixels.get(), 0x00, pageSize * pageSize);
+}
+
+bool GlyphAtlas::isDirty() const {
+    return std::any_of(pages.begin(), pages.end(), [](const Page& page) { return page.dirty; });
+}
+
+void GlyphAtlas::nextFrame() {
+    frameNum++;
+
+    for (const auto code : deferred) {
+        if (code < directLookupSize) {
+            direct[code].page = -1;
+        } else {
+            extended.erase(code);
+        }
+    }
+    deferred.clear();
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../Utils/Packer.hpp"
+#include "FontLoader.hpp"
+#include <unordered_map>
+
+namespace Engine {
+// The glyphs of a single face rasterized on demand into the pages of an atlas region.
+// The least recently used page is evicted when the region is full, the first page holds the unknown glyph
+// and is never evicted. The glyphs are handed out by value, as an eviction drops them from the tables.
+class ENGINE_API GlyphAtlas {
+public:
+    // Code points below this value are looked up through a flat table (Basic Latin up to Latin Extended-B)
+    static constexpr uint32_t directLookupSize = 0x0250;
+    // Frames that may still sample a page after its last use
+    static constexpr uint64_t framesInFlight = 2;
+
+    class Source {
+    public:
+        virtual ~Source() = default;
+
+        virtual bool hasGlyph(uint32_t code) = 0;
+        virtual FontLoader::Glyph loadGlyph(uint32_t code) = 0;
+    };
+
+    struct Glyph {
+        Vector2 uv;
+        Vector2 st;
+        Vector2 size;
+        Vector2 box;
+        float advance;
+        float ascend;
+        int page{-1};
+    };
+
+    struct Page {
+        Vector2i pos;
+        std::unique_ptr<Packer> packer;
+        std::unique_ptr<char[]> pixels;
+        std::vector<uint32_t> codes;
+        uint64_t lastUsed{0};
+        bool dirty{false};
+    };
+
+    // The size is the region of the atlas, the UVs are relative to the whole texture the region is placed into
+    explicit GlyphAtlas(Source& source, const Vector2i& size, const Vector2i& textureSize, const Vector2i& offset,
+                        int fontSize);
+
+    Glyph getGlyph(const uint32_t code) {
+        if (code < directLookupSize) {
+            const auto& glyph = direct[code];
+            if (glyph.page >= 0) {
+                touch(glyph.page);
+                return glyph;
+            }
+        } else {
+            const auto it = extended.find(code);
+            if (it != extended.end()) {
+                touch(it->second.page);
+                return it->second;
+            }
+        }
+        return rasterize(code);
+    }
+
+    // Incremented every time a page is evicted, any cached glyph UVs become invalid when this changes
+    [[nodiscard]] uint64_t getGeneration() const {
+        return generation;
+    }
+
+    [[nodiscard]] int getPageSize() const {
+        return pageSize;
+    }
+
+    [[nodiscard]] std::vector<Page>& getPages() {
+        return pages;
+    }
+
+    // Keeps the page from being evicted while the glyphs of retained geometry are still drawn from it
+    void touch(const int page) {
+        pages[page].lastUsed = frameNum;
+    }
+
+    [[nodiscard]] bool isDirty() const;
+    void nextFrame();
+
+private:
+    static inline const Vector2i padding{2, 2};
+
+    Glyph& getSlot(uint32_t code);
+    Glyph rasterize(uint32_t code);
+    std::optional<Vector2i> allocate(const Vector2i& size, int& page);
+    int evict();
+    void clearPage(Page& page) const;
+
+    Source& source;
+    const int pageSize;
+    const Vector2i textureSize;
+    const Vector2i offset;
+    std::vector<Glyph> direct;
+    std::unordered_map<uint32_t, Glyph> extended;
+    std::vector<Page> pages;
+    // Glyphs that did not fit while all pages were in use, they resolve to the unknown glyph until the next frame
+    std::vector<uint32_t> deferred;
+    uint64_t generation{0};
+    uint64_t frameNum{0};
+    Glyph unknown;
+};
+} // namespace Engine
@@ -0,0 +1,110 @@
+#include "TextRunCache.hpp"
+#include "FontFamily.hpp"
+#include "TextShaper.hpp"
+
+using namespace Engine;
+
+namespace Engine {
+class TextRunShaper : public TextShaper {
+public:
+    TextRunShaper(TextRun& run, const FontFamily& font, const float size, const bool markup) :
+        TextShaper{font, size, {0.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}, markup}, run{run} {
+    }
+
+private:
+    void onGlyph(const FontFace& fontFace, const FontFace::Glyph& glyph, const Vector2& pen, const Quad& quad,
+                 const Color4& color, const char* it, const uint32_t code) override {
+        (void)it;
+        (void)code;
+
+        TextRun::addPage(run.pages, {&fontFace, glyph.page});
+
+        auto& dst = run.glyphs.emplace_back();
+        dst.pen = pen;
+        dst.pos = quad.vertices[0].pos;
+        dst.size = quad.vertices[2].pos - quad.vertices[0].pos;
+        dst.uv = quad.vertices[0].uv;
+        dst.st = quad.vertices[2].uv - quad.vertices[0].uv;
+        dst.tint = color;
+
+        run.advance = pen.x + quad.advance;
+    }
+
+    TextRun& run;
+};
+} // namespace Engine
+
+static uint64_t hashRun(const std::string_view& text, const float size, const bool markup) {
+    const auto h0 = std::hash<std::string_view>{}(text);
+    const auto h1 = std::hash<float>{}(size) + (markup ? 1 : 0);
+    return h0 ^ (h1 + 0x9e3779b97f4a7c15ULL + (h0 << 6) + (h0 >> 2));
+}
+
+TextRunCache::TextRunCache(const FontFamily& font, const size_t capacity) : font{font}, capacity{capacity} {
+}
+
+TextRunCache::~TextRunCache() = default;
+
+const TextRun& TextRunCache::get(const std::string_view& text, const float size, const bool markup) {
+    // Glyphs were evicted from the atlas, the cached UVs are no longer valid
+    if (generation != font.getGeneration()) {
+        clear();
+        generation = font.getGeneration();
+    }
+
+    const auto hash = hashRun(text, size, markup);
+
+    const auto found = lookup.find(hash);
+    if (found != lookup.end()) {
+        auto it = found->second;
+        if (it->size == size && it->markup == markup && it->text == text) {
+            hits++;
+            entries.splice(entries.begin(), entries, it);
+            it->run.touch();
+            return it->run;
+        }
+
+        // Hash collision, the entry is replaced
+        entries.erase(it);
+        lookup.erase(found);
+    }
+
+    misses++;
+
+    if (entries.size() >= capacity) {
+        lookup.erase(entries.back().hash);
+        entries.pop_back();
+    }
+
+    auto& entry = entries.emplace_front();
+    entry.hash = hash;
+    entry.text = std::string{text};
+    entry.size = size;
+    entry.markup = markup;
+    shape(entry);
+
+    lookup.emplace(hash, entries.begin());
+
+    // Shaping may have rasterized new glyphs and evicted old pages
+    if (generation != font.getGeneration()) {
+        generation = font.getGeneration();
+        entries.erase(std::next(entries.begin()), entries.end());
+        lookup.clear();
+        lookup.emplace(hash, entries.begin());
+    }
+
+    return entry.run;
+}
+
+void TextRunCache::clear() {
+    entries.clear();
+    lookup.clear();
+}
+
+void TextRunCache::shape(Entry& entry) const {
+    entry.run.glyphs.reserve(entry.text.size());
+
+    TextRunShaper shaper{entry.run, font, entry.size, entry.markup};
+    shaper.write(entry.text);
+    entry.run.bounds = shaper.getBounds();
+}
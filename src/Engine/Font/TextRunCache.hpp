@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../Utils/MoveableCopyable.hpp"
+#include "FontFace.hpp"
+#include <algorithm>
+#include <list>
+
+namespace Engine {
+class ENGINE_API FontFamily;
+
+struct TextRun {
+    struct Glyph {
+        Vector2 pen;
+        Vector2 pos;
+        Vector2 size;
+        Vector2 uv;
+        Vector2 st;
+        Color4 tint;
+    };
+
+    // An atlas page the glyphs are sampled from
+    struct Page {
+        const FontFace* face;
+        int page;
+
+        bool operator==(const Page& other) const {
+            return face == other.face && page == other.page;
+        }
+    };
+
+    std::vector<Glyph> glyphs;
+    std::vector<Page> pages;
+    Vector2 bounds{0.0f};
+    float advance{0.0f};
+
+    // Must be called on every frame the glyphs are drawn, including from geometry built earlier
+    void touch() const {
+        touchPages(pages);
+    }
+
+    static void touchPages(const std::vector<Page>& pages) {
+        for (const auto& page : pages) {
+            page.face->touch(page.page);
+        }
+    }
+
+    static void addPage(std::vector<Page>& pages, const Page& page) {
+        if (std::find(pages.begin(), pages.end(), page) == pages.end()) {
+            pages.push_back(page);
+        }
+    }
+};
+
+class ENGINE_API TextRunCache {
+public:
+    static constexpr size_t defaultCapacity = 4096;
+
+    explicit TextRunCache(const FontFamily& font, size_t capacity = defaultCapacity);
+    ~TextRunCache();
+    NON_COPYABLE(TextRunCache);
+    NON_MOVEABLE(TextRunCache);
+
+    // The returned run is positioned at the origin and stays valid until the next call.
+    // Without the markup the tags and the line breaks are drawn as they are.
+    const TextRun& get(const std::string_view& text, float size, bool markup = true);
+    void clear();
+
+    [[nodiscard]] size_t getSize() const {
+        return entries.size();
+    }
+
+    [[nodiscard]] uint64_t getHits() const {
+        return hits;
+    }
+
+    [[nodiscard]] uint64_t getMisses() const {
+        return misses;
+    }
+
+private:
+    struct Entry {
+        uint64_t hash{0};
+        std::string text;
+        float size{0.0f};
+        bool markup{true};
+        TextRun run;
+    };
+
+    void shape(Entry& entry) const;
+
+    const FontFamily& font;
+    const size_t capacity;
+    uint64_t generation{0};
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> lookup;
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
+} // namespace Engine
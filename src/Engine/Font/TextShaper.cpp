@@ -74,14 +74,16 @@ static Color4 getFontColor(const Color4& mainColor, const uint32_t modifiers) {
     }
 }
 
-TextShaper::TextShaper(const FontFamily& font, const float size, const Vector2& pos, const Color4& color) :
+TextShaper::TextShaper(const FontFamily& font, const float size, const Vector2& pos, const Color4& color,
+                       const bool markup) :
     font{font},
     size{size},
     origin{pos},
     pos{pos},
     bounds{pos},
     scale{static_cast<float>(size) / static_cast<float>(font.getSize())},
-    mainColor{color} {
+    mainColor{color},
+    markup{markup} {
 }
 
 void TextShaper::write(const std::string_view& text) {
@@ -101,7 +103,7 @@ void TextShaper::write(const std::string_view& text) {
         const auto code = utf8::next(it, end);
 
         // Is it a beginning of a command?
-        if (code == '<' && previous != '\\') {
+        if (markup && code == '<' && previous != '\\') {
             cmdStart = it;
             continue;
         }
@@ -127,13 +129,13 @@ void TextShaper::write(const std::string_view& text) {
 
         previous = code;
 
-        if (code == '\n') {
+        if (markup && code == '\n') {
             pos.x = origin.x;
             pos.y += size * 1.25f;
             continue;
         }
 
-        const auto& glyph = face->getGlyph(code);
+        const auto glyph = face->getGlyph(code);
 
         const auto p = pos + Vector2{0.0f, glyph.ascend * scale};
 
@@ -19,7 +19,7 @@ public:
     };
 
     TextShaper(const FontFamily& font, float size, const Vector2& pos = {0.0f, 0.0f},
-               const Color4& color = {1.0f, 1.0f, 1.0f, 1.0f});
+               const Color4& color = {1.0f, 1.0f, 1.0f, 1.0f}, bool markup = true);
 
     virtual void write(const std::string_view& text);
 
@@ -42,6 +42,7 @@ private:
     Vector2 bounds;
     float scale;
     Color4 mainColor;
+    bool markup;
 };
 
 class TextWrapper : public TextShaper {
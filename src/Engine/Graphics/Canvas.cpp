@@ -1,6 +1,4 @@
 #include "Canvas.hpp"
-#include "../Font/TextShaper.hpp"
-#include <utf8cpp/utf8.h>
 
 using namespace Engine;
 
@@ -44,6 +42,7 @@ void Canvas::begin(const Vector2i& viewport) {
     currentViewport = viewport;
 
     batches.clear();
+    glyphPages.clear();
 
     for (auto& texture : textures) {
         texture = nullptr;
@@ -172,54 +171,46 @@ void Canvas::drawTexture(const Vector2& pos, const Vector2& size, const VulkanTe
     batches.back().length++;
 }
 
-class Canvas::CanvasTextShaper : public TextShaper {
-public:
-    CanvasTextShaper(Canvas& canvas, const Color4& color, const FontFamily& font, float size, const Vector2& pos) :
-        TextShaper{font, size, pos, color}, canvas{canvas} {
-        tex = static_cast<float>(canvas.addTexture(font.getTexture()));
+void Canvas::drawText(const Vector2& pos, const std::string_view& text, const FontFamily& font, const int size,
+                      const Color4& color) {
+    const auto& run = font.shape(text, static_cast<float>(size));
+    if (run.glyphs.empty()) {
+        return;
     }
 
-    void write(const std::string_view& text) override {
-        const auto total = utf8::distance(text.begin(), text.end());
-
-        v = canvas.reserve(canvas.vertices, 4 * total);
-        i = canvas.reserve(canvas.indices, 6 * total);
-        c = canvas.reserve(canvas.commands, 1);
-
-        c->firstIndex = canvas.getOffset(canvas.indices, i);
-        c->firstInstance = 0;
-        c->instanceCount = 1;
-        c->vertexOffset = 0;
-        c->indexCount = 0;
-
-        TextShaper::write(text);
+    auto* v = reserve(vertices, 4 * run.glyphs.size());
+    auto* i = reserve(indices, 6 * run.glyphs.size());
+    auto* c = reserve(commands, 1);
+    const auto tex = static_cast<float>(addTexture(font.getTexture()));
+    glyphPages.insert(glyphPages.end(), run.pages.begin(), run.pages.end());
 
-        canvas.batches.back().length++;
-    }
+    c->firstIndex = getOffset(indices, i);
+    c->firstInstance = 0;
+    c->instanceCount = 1;
+    c->vertexOffset = 0;
+    c->indexCount = 6 * run.glyphs.size();
 
-private:
-    void onGlyph(const FontFace& fontFace, const FontFace::Glyph& glyph, const Vector2& pen, const Quad& quad,
-                 const Color4& color, const char* it, const uint32_t code) override {
-        (void)it;
-        (void)code;
+    for (const auto& glyph : run.glyphs) {
+        const auto p = pos + glyph.pos;
+        const auto glyphColor = color * glyph.tint;
 
-        v[0].pos = quad.vertices[0].pos;
-        v[0].color = color;
-        v[0].uv = Vector4{quad.vertices[0].uv, 2.0f, tex};
+        v[0].pos = p;
+        v[0].color = glyphColor;
+        v[0].uv = Vector4{glyph.uv, 2.0f, tex};
 
-        v[1].pos = quad.vertices[1].pos;
-        v[1].color = color;
-        v[1].uv = Vector4{quad.vertices[1].uv, 2.0f, tex};
+        v[1].pos = p + Vector2{glyph.size.x, 0.0f};
+        v[1].color = glyphColor;
+        v[1].uv = Vector4{glyph.uv.x + glyph.st.x, glyph.uv.y, 2.0f, tex};
 
-        v[2].pos = quad.vertices[2].pos;
-        v[2].color = color;
-        v[2].uv = Vector4{quad.vertices[2].uv, 2.0f, tex};
+        v[2].pos = p + glyph.size;
+        v[2].color = glyphColor;
+        v[2].uv = Vector4{glyph.uv + glyph.st, 2.0f, tex};
 
-        v[3].pos = quad.vertices[3].pos;
-        v[3].color = color;
-        v[3].uv = Vector4{quad.vertices[3].uv, 2.0f, tex};
+        v[3].pos = p + Vector2{0.0f, glyph.size.y};
+        v[3].color = glyphColor;
+        v[3].uv = Vector4{glyph.uv.x, glyph.uv.y + glyph.st.y, 2.0f, tex};
 
-        const auto offset = canvas.getOffset(canvas.vertices, v);
+        const auto offset = getOffset(vertices, v);
         i[0] = offset;
         i[1] = offset + 1;
         i[2] = offset + 2;
@@ -229,21 +220,9 @@ private:
 
         v += 4;
         i += 6;
-
-        c->indexCount += 6;
     }
 
-    Canvas& canvas;
-    Canvas::Vertex* v{nullptr};
-    unsigned int* i{nullptr};
-    VkDrawIndexedIndirectCommand* c{nullptr};
-    float tex{0.0f};
-};
-
-void Canvas::drawText(const Vector2& pos, const std::string_view& text, const FontFamily& font, const int size,
-                      const Color4& color) {
-    CanvasTextShaper textShaper{*this, color, font, static_cast<float>(size), pos};
-    textShaper.write(text);
+    batches.back().length++;
 }
 
 void Canvas::drawImage(const Vector2& pos, const Vector2& size, const Image& image, const Color4& color) {
@@ -290,13 +269,103 @@ void Canvas::drawImage(const Vector2& pos, const Vector2& size, const Image& ima
     batches.back().length++;
 }
 
+Canvas::Mark Canvas::mark() const {
+    return {vertices.count, indices.count, commands.count, batches.size(), glyphPages.size()};
+}
+
+void Canvas::capture(const Mark& from, Segment& segment) const {
+    segment.vertices.assign(vertices.data.begin() + from.vertices, vertices.data.begin() + vertices.count);
+
+    segment.indices.resize(indices.count - from.indices);
+    for (size_t i = 0; i < segment.indices.size(); i++) {
+        segment.indices[i] = indices.data[from.indices + i] - from.vertices;
+    }
+
+    segment.commands.assign(commands.data.begin() + from.commands, commands.data.begin() + commands.count);
+    for (auto& command : segment.commands) {
+        command.firstIndex -= from.indices;
+    }
+
+    // Commands appended to the batch that was active when the mark was taken
+    if (batches.size() > from.batches) {
+        segment.leading = batches[from.batches].offset - from.commands;
+    } else {
+        segment.leading = commands.count - from.commands;
+    }
+
+    segment.batches.clear();
+    for (size_t i = from.batches; i < batches.size(); i++) {
+        auto& batch = segment.batches.emplace_back(batches[i]);
+        batch.offset -= from.commands;
+    }
+
+    segment.textures = textures;
+    segment.glyphPages.clear();
+    for (size_t i = from.glyphPages; i < glyphPages.size(); i++) {
+        TextRun::addPage(segment.glyphPages, glyphPages[i]);
+    }
+}
+
+void Canvas::replay(const Segment& segment) {
+    // The segment may have been recorded with a different texture slot assignment
+    std::array<float, std::tuple_size<SamplerArray>::value> remap{};
+    auto identity = true;
+    for (size_t i = 0; i < segment.textures.size(); i++) {
+        if (segment.textures[i]) {
+            remap[i] = static_cast<float>(addTexture(*segment.textures[i]));
+            identity &= remap[i] == static_cast<float>(i);
+        }
+    }
+
+    TextRun::touchPages(segment.glyphPages);
+    glyphPages.insert(glyphPages.end(), segment.glyphPages.begin(), segment.glyphPages.end());
+
+    const auto vertexOffset = static_cast<uint32_t>(vertices.count);
+    const auto indexOffset = static_cast<uint32_t>(indices.count);
+    const auto commandOffset = commands.count;
+
+    if (!segment.vertices.empty()) {
+        auto* v = reserve(vertices, segment.vertices.size());
+        std::memcpy(v, segment.vertices.data(), segment.vertices.size() * sizeof(Vertex));
+
+        if (!identity) {
+            for (size_t n = 0; n < segment.vertices.size(); n++) {
+                if (v[n].uv.z > 0.0f) {
+                    v[n].uv.w = remap[static_cast<size_t>(v[n].uv.w)];
+                }
+            }
+        }
+    }
+
+    if (!segment.indices.empty()) {
+        auto* i = reserve(indices, segment.indices.size());
+        for (size_t n = 0; n < segment.indices.size(); n++) {
+            i[n] = segment.indices[n] + vertexOffset;
+        }
+    }
+
+    if (!segment.commands.empty()) {
+        auto* c = reserve(commands, segment.commands.size());
+        for (size_t n = 0; n < segment.commands.size(); n++) {
+            c[n] = segment.commands[n];
+            c[n].firstIndex += indexOffset;
+        }
+    }
+
+    batches.back().length += segment.leading;
+    for (const auto& batch : segment.batches) {
+        batches.push_back(batch);
+        batches.back().offset += commandOffset;
+    }
+}
+
 template <typename T> size_t Canvas::getOffset(Buffer<T>& buffer, const T* ptr) const {
     return ptr - &buffer.data.front();
 }
 
 template <typename T> T* Canvas::reserve(Buffer<T>& buffer, const size_t count) {
     if (buffer.count + count > buffer.data.size()) {
-        buffer.data.resize(buffer.data.size() + 1024);
+        buffer.data.resize(std::max(buffer.data.size() + 1024, buffer.count + count));
     }
 
     auto* dst = &buffer.data.at(buffer.count);
@@ -336,12 +405,42 @@ template <typename T> void Canvas::flush(Buffer<T>& buffer, VulkanDoubleBuffer&
         if (expectedSize != 0) {
             target = vulkan.createDoubleBuffer(bufferInfo);
         }
+
+        for (auto& uploaded : buffer.uploaded) {
+            uploaded.clear();
+        }
     }
 
-    if (expectedSize != 0) {
-        auto* dst = target.getCurrentBuffer().getMappedPtr();
-        std::memcpy(dst, buffer.data.data(), expectedSize);
+    if (expectedSize == 0) {
+        return;
+    }
+
+    // Only the range that differs from what was written into this buffer the last time is uploaded
+    auto& uploaded = buffer.uploaded.at(vulkan.getCurrentFrameNum() % MAX_FRAMES_IN_FLIGHT);
+    const auto* src = reinterpret_cast<const uint8_t*>(buffer.data.data());
+    const auto total = sizeof(T) * buffer.count;
+    const auto common = std::min(total, uploaded.size());
+
+    const auto first = static_cast<size_t>(std::mismatch(src, src + common, uploaded.data()).first - src);
+    auto last = total;
+    if (total <= uploaded.size()) {
+        const auto found = std::mismatch(std::make_reverse_iterator(src + common),
+                                         std::make_reverse_iterator(src + first),
+                                         std::make_reverse_iterator(uploaded.data() + common));
+        last = static_cast<size_t>(found.first.base() - src);
+    }
+
+    if (first >= last) {
+        return;
+    }
+
+    auto* dst = static_cast<uint8_t*>(target.getCurrentBuffer().getMappedPtr());
+    std::memcpy(dst + first, src + first, last - first);
+
+    if (uploaded.size() < total) {
+        uploaded.resize(total);
     }
+    std::memcpy(uploaded.data() + first, src + first, last - first);
 }
 
 void Canvas::resetTextures() {
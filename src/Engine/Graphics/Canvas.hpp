@@ -26,6 +26,26 @@ public:
     using SamplerArray = std::array<const VulkanTexture*, 16>;
     using Batches = std::vector<Batch>;
 
+    struct Mark {
+        size_t vertices{0};
+        size_t indices{0};
+        size_t commands{0};
+        size_t batches{0};
+        size_t glyphPages{0};
+    };
+
+    // Geometry recorded between a mark and the current position, can be replayed in a later frame
+    struct Segment {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<VkDrawIndexedIndirectCommand> commands;
+        Batches batches;
+        size_t leading{0};
+        SamplerArray textures{};
+        // Touched on every replay, so the font atlas keeps the glyphs the segment samples
+        std::vector<TextRun::Page> glyphPages;
+    };
+
     explicit Canvas(VulkanRenderer& vulkan);
     virtual ~Canvas();
 
@@ -40,6 +60,10 @@ public:
                   const Color4& color);
     void drawImage(const Vector2& pos, const Vector2& size, const Image& image, const Color4& color);
 
+    [[nodiscard]] Mark mark() const;
+    void capture(const Mark& from, Segment& segment) const;
+    void replay(const Segment& segment);
+
     bool hasData() const {
         return vbo && ibo && cbo && commands.count > 0;
     }
@@ -60,11 +84,11 @@ public:
     }
 
 private:
-    class CanvasTextShaper;
-
     template <typename T> struct Buffer {
         std::vector<T> data;
         size_t count{0};
+        // What has been written into each of the double buffers, so only the changed range is uploaded
+        std::array<std::vector<uint8_t>, MAX_FRAMES_IN_FLIGHT> uploaded;
     };
 
     void doRect(Canvas::Vertex*& v, uint32_t*& i, const Vector2& pos, const Vector2& size, const Color4& color);
@@ -88,5 +112,6 @@ private:
     SamplerArray textures;
     Vector2i currentViewport;
     Batches batches;
+    std::vector<TextRun::Page> glyphPages;
 };
 } // namespace Engine
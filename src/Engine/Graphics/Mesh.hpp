@@ -3,17 +3,37 @@
 #include "../Vulkan/VulkanBuffer.hpp"
 
 namespace Engine {
+struct ENGINE_API MeshLod {
+    uint32_t offset{0};
+    uint32_t count{0};
+    // Largest deviation from the full detail mesh, in the units of the mesh
+    float error{0.0f};
+};
+
 struct ENGINE_API Mesh : public VulkanDisposable {
     VulkanBuffer vbo;
     VulkanBuffer ibo;
     VkIndexType indexType{VK_INDEX_TYPE_UINT16};
     uint32_t count{0};
     uint32_t instances{1};
+    // Ordered from the full detail, all of them share the vertices and are stored one after another in the ibo.
+    // Empty when the mesh was not processed by optimizeMesh.
+    std::vector<MeshLod> lods;
+    float radius{0.0f};
 
     operator bool() const {
         return vbo || ibo;
     }
 
+    // The coarsest level whose error projected to the screen stays within the threshold (in pixels)
+    [[nodiscard]] size_t selectLod(const float pixelsPerUnit, const float threshold) const {
+        size_t lod = 0;
+        while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= threshold) {
+            ++lod;
+        }
+        return lod;
+    }
+
     void destroy() override {
         vbo.destroy();
         ibo.destroy();
@@ -0,0 +1,154 @@
+#include "MeshOptimizer.hpp"
+#include "../Utils/Exceptions.hpp"
+#include <cstring>
+#include <meshoptimizer.h>
+
+using namespace Engine;
+
+MeshOptimizeResult Engine::optimizeMesh(void* vertices, const size_t vertexCount, const size_t vertexSize,
+                                        std::vector<uint32_t>& indices, const MeshOptimizeOptions& options) {
+    MeshOptimizeResult result{};
+    result.vertexCount = vertexCount;
+
+    if (indices.empty() || vertexCount == 0) {
+        return result;
+    }
+    if (indices.size() % 3 != 0) {
+        EXCEPTION("Mesh index count: {} is not a multiple of three", indices.size());
+    }
+
+    auto* data = static_cast<char*>(vertices);
+    const auto* positions = static_cast<const float*>(vertices);
+
+    if (options.deduplicate) {
+        std::vector<uint32_t> remap(vertexCount);
+        result.vertexCount =
+            meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), data, vertexCount, vertexSize);
+        meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+
+        std::vector<char> remapped(result.vertexCount * vertexSize);
+        meshopt_remapVertexBuffer(remapped.data(), data, vertexCount, vertexSize, remap.data());
+        std::memcpy(data, remapped.data(), remapped.size());
+    }
+
+    auto count = result.vertexCount;
+
+    meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), count);
+    meshopt_optimizeOverdraw(
+        indices.data(), indices.data(), indices.size(), positions, count, vertexSize, options.overdrawThreshold);
+
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<float> errors;
+    levels.push_back(indices);
+    errors.push_back(0.0f);
+
+    // The simplifier reports the error relative to the extents, the selection needs it in the units of the mesh
+    const auto scale = meshopt_simplifyScale(positions, count, vertexSize);
+
+    while (levels.size() < options.lods) {
+        const auto previous = levels.back().size();
+        const auto target = static_cast<size_t>(static_cast<float>(previous) * options.reduction) / 3 * 3;
+        if (target < 3) {
+            break;
+        }
+
+        // Always simplified from the full detail, so the errors do not accumulate
+        std::vector<uint32_t> lod(indices.size());
+        float error{0.0f};
+        size_t size;
+        if (options.sloppy) {
+            size = meshopt_simplifySloppy(lod.data(),
+                                          indices.data(),
+                                          indices.size(),
+                                          positions,
+                                          count,
+                                          vertexSize,
+                                          target,
+                                          options.maxError,
+                                          &error);
+        } else {
+            size = meshopt_simplify(lod.data(),
+                                    indices.data(),
+                                    indices.size(),
+                                    positions,
+                                    count,
+                                    vertexSize,
+                                    target,
+                                    options.maxError,
+                                    0,
+                                    &error);
+        }
+
+        // The error limit was reached, any further level would look the same
+        if (size == 0 || static_cast<float>(size) > static_cast<float>(previous) * 0.95f) {
+            break;
+        }
+
+        lod.resize(size);
+        meshopt_optimizeVertexCache(lod.data(), lod.data(), lod.size(), count);
+
+        levels.push_back(std::move(lod));
+        errors.push_back(error * scale);
+    }
+
+    indices.clear();
+    for (size_t i = 0; i < levels.size(); i++) {
+        result.lods.push_back({
+            static_cast<uint32_t>(indices.size()),
+            static_cast<uint32_t>(levels[i].size()),
+            errors[i],
+        });
+        indices.insert(indices.end(), levels[i].begin(), levels[i].end());
+    }
+
+    // Done over all of the levels at once, the coarse levels only reference a subset of the vertices
+    result.vertexCount =
+        meshopt_optimizeVertexFetch(data, indices.data(), indices.size(), data, count, vertexSize);
+
+    for (size_t i = 0; i < result.vertexCount; i++) {
+        const auto* position = reinterpret_cast<const float*>(data + i * vertexSize);
+        result.radius = std::max(result.radius, glm::length(Vector3{position[0], position[1], position[2]}));
+    }
+
+    return result;
+}
+
+Vector4b Engine::quantizeSnorm(const Vector4& value) {
+    return {
+        meshopt_quantizeSnorm(value.x, 8),
+        meshopt_quantizeSnorm(value.y, 8),
+        meshopt_quantizeSnorm(value.z, 8),
+        meshopt_quantizeSnorm(value.w, 8),
+    };
+}
+
+Vector4b Engine::quantizeSnorm(const Vector3& value) {
+    return quantizeSnorm(Vector4{value, 0.0f});
+}
+
+Vector2h Engine::quantizeHalf(const Vector2& value) {
+    return {
+        meshopt_quantizeHalf(value.x),
+        meshopt_quantizeHalf(value.y),
+    };
+}
+
+std::vector<uint8_t> Engine::packIndices(const std::vector<uint32_t>& indices, const size_t vertexCount,
+                                         VkIndexType& indexType) {
+    std::vector<uint8_t> bytes;
+
+    if (vertexCount <= std::numeric_limits<uint16_t>::max()) {
+        indexType = VK_INDEX_TYPE_UINT16;
+        bytes.resize(indices.size() * sizeof(uint16_t));
+        auto* dst = reinterpret_cast<uint16_t*>(bytes.data());
+        for (size_t i = 0; i < indices.size(); i++) {
+            dst[i] = static_cast<uint16_t>(indices[i]);
+        }
+    } else {
+        indexType = VK_INDEX_TYPE_UINT32;
+        bytes.resize(indices.size() * sizeof(uint32_t));
+        std::memcpy(bytes.data(), indices.data(), bytes.size());
+    }
+
+    return bytes;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../Math/Vector.hpp"
+#include "Mesh.hpp"
+#include <vector>
+
+namespace Engine {
+struct ENGINE_API MeshOptimizeOptions {
+    // Number of levels including the full detail one, one disables the simplification
+    size_t lods{4};
+    // Target index count of each level relative to the previous one
+    float reduction{0.5f};
+    // Largest error of any level, relative to the extents of the mesh
+    float maxError{0.1f};
+    // Allowed vertex cache degradation when reordering the triangles for less overdraw
+    float overdrawThreshold{1.05f};
+    // Simplify regardless of the topology, used for the grids that are made of disconnected faces
+    bool sloppy{false};
+    // Merge the vertices that are bitwise equal first
+    bool deduplicate{false};
+};
+
+struct ENGINE_API MeshOptimizeResult {
+    size_t vertexCount{0};
+    std::vector<MeshLod> lods;
+    float radius{0.0f};
+};
+
+// Reorders the triangles for the post-transform vertex cache and overdraw, builds the simplified levels of detail,
+// and reorders the vertices for the fetch. The vertices are modified in place and may shrink, the position must be
+// the first member of the vertex stored as three floats. The levels are appended one after another to the indices.
+ENGINE_API MeshOptimizeResult optimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize,
+                                           std::vector<uint32_t>& indices, const MeshOptimizeOptions& options);
+
+template <typename Vertex>
+MeshOptimizeResult optimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                const MeshOptimizeOptions& options) {
+    static_assert(offsetof(Vertex, position) == 0, "Vertex position must be the first member");
+    auto result = optimizeMesh(vertices.data(), vertices.size(), sizeof(Vertex), indices, options);
+    vertices.resize(result.vertexCount);
+    return result;
+}
+
+ENGINE_API Vector4b quantizeSnorm(const Vector4& value);
+ENGINE_API Vector4b quantizeSnorm(const Vector3& value);
+ENGINE_API Vector2h quantizeHalf(const Vector2& value);
+
+// 16-bit indices when the vertices fit, returns the raw bytes for the index buffer
+ENGINE_API std::vector<uint8_t> packIndices(const std::vector<uint32_t>& indices, size_t vertexCount,
+                                            VkIndexType& indexType);
+} // namespace Engine
@@ -39,6 +39,7 @@ static void validateMaterial(const Material& material) {
 RenderPassOpaque::RenderPassOpaque(const RenderOptions& options, VulkanRenderer& vulkan, RenderBufferPbr& buffer,
                                    RenderResources& resources) :
     RenderPass{vulkan, buffer, "RenderPassOpaque"},
+    options{options},
     buffer{buffer},
     resources{resources},
     pipelineGrid{vulkan},
@@ -177,7 +178,7 @@ void RenderPassOpaque::renderGrids(VulkanCommandBuffer& vkb, Scene& scene) {
         pipelineGrid.setEntityColor(entityColor(transform));
         pipelineGrid.flushConstants(vkb);
 
-        pipelineGrid.renderMesh(vkb, mesh);
+        pipelineGrid.renderMesh(vkb, mesh, selectLod(camera, mesh, modelMatrix, options.lodThreshold));
     }
 }
 
@@ -215,7 +216,8 @@ void RenderPassOpaque::renderModels(VulkanCommandBuffer& vkb, Scene& scene) {
                 validateMaterial(*primitive.material);
 
                 pipelineModel.setDesriptorSet(vkb, 1, primitive.material->descriptorSet);
-                pipelineModel.renderMesh(vkb, primitive.mesh);
+                pipelineModel.renderMesh(
+                    vkb, primitive.mesh, selectLod(camera, primitive.mesh, modelMatrix, options.lodThreshold));
             }
         }
     }
@@ -30,6 +30,7 @@ private:
     void renderModelsSkinned(VulkanCommandBuffer& vkb, Scene& scene);
     void renderModelsInstanced(VulkanCommandBuffer& vkb, Scene& scene);
 
+    const RenderOptions& options;
     RenderBufferPbr& buffer;
     RenderResources& resources;
     RenderPipelineGrid pipelineGrid;
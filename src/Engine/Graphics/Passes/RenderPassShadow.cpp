@@ -69,6 +69,9 @@ void RenderPassShadow::renderGrids(VulkanCommandBuffer& vkb, Scene& scene) {
     };
     pipelineGrid.setDesriptorSet(vkb, 0, controllerLights.getDescriptorSetShadowCamera(), offsets);
 
+    // The shadows follow the detail of what is visible from the primary camera
+    const auto& camera = *scene.getPrimaryCamera();
+
     for (auto&& [entity, transform, grid] : systemGrids.each()) {
         const auto& mesh = grid.getMesh();
         if (!mesh) {
@@ -83,7 +86,7 @@ void RenderPassShadow::renderGrids(VulkanCommandBuffer& vkb, Scene& scene) {
         pipelineGrid.setEntityColor(entityColor(entity));
         pipelineGrid.flushConstants(vkb);
 
-        pipelineGrid.renderMesh(vkb, mesh);
+        pipelineGrid.renderMesh(vkb, mesh, selectLod(camera, mesh, modelMatrix, options.lodThreshold));
     }
 }
 
@@ -97,6 +100,8 @@ void RenderPassShadow::renderModels(VulkanCommandBuffer& vkb, Scene& scene) {
     };
     pipelineModel.setDesriptorSet(vkb, 0, controllerLights.getDescriptorSetShadowCamera(), offsets);
 
+    const auto& camera = *scene.getPrimaryCamera();
+
     for (auto&& [entity, transform, model] : systemModels.each()) {
         if (transform.isStatic()) {
             continue;
@@ -121,7 +126,8 @@ void RenderPassShadow::renderModels(VulkanCommandBuffer& vkb, Scene& scene) {
                     EXCEPTION("Primitive has no material");
                 }
 
-                pipelineModel.renderMesh(vkb, primitive.mesh);
+                pipelineModel.renderMesh(
+                    vkb, primitive.mesh, selectLod(camera, primitive.mesh, modelMatrix, options.lodThreshold));
             }
         }
     }
@@ -1,6 +1,6 @@
 #include "RenderPipelinePlanet.hpp"
 #include "../../Assets/AssetsManager.hpp"
-#include "../../Scene/Components/ComponentModel.hpp"
+#include "../MeshUtils.hpp"
 #include <component_planet_frag.spirv.h>
 #include <component_planet_vert.spirv.h>
 
@@ -9,7 +9,7 @@ using namespace Engine;
 RenderPipelinePlanet::RenderPipelinePlanet(VulkanRenderer& vulkan) : RenderPipeline{vulkan, "RenderPipelinePlanet"} {
     addShader(Embed::component_planet_vert_spirv, VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT);
     addShader(Embed::component_planet_frag_spirv, VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT);
-    addVertexInput(RenderPipeline::VertexInput::of<ComponentModel::Vertex>(0));
+    addVertexInput(RenderPipeline::VertexInput::of<PlanetVertex>(0));
     setTopology(VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
     setDepthMode(DepthMode::ReadWrite);
     setPolygonMode(VkPolygonMode::VK_POLYGON_MODE_FILL);
@@ -11,7 +11,7 @@ RenderPipelineShadowsGrid::RenderPipelineShadowsGrid(VulkanRenderer& vulkan) :
 
     addShader(Embed::component_grid_vert_spirv, VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT);
     addShader(Embed::component_shadow_frag_spirv, VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT);
-    addVertexInput(RenderPipeline::VertexInput::of<VoxelShape::VertexFinal>(0));
+    addVertexInput(RenderPipeline::VertexInput::of<VoxelShape::VertexQuantized>(0));
     setTopology(VkPrimitiveTopology::VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
     setDepthMode(DepthMode::ReadWrite);
     setPolygonMode(VkPolygonMode::VK_POLYGON_MODE_FILL);
@@ -11,5 +11,6 @@ struct ENGINE_API RenderOptions {
     bool fxaa{true};
     bool bloom{false};
     bool enableSrc{false};
+    float lodThreshold{1.0f};
 };
 } // namespace Engine
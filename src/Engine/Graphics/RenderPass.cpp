@@ -1,4 +1,5 @@
 #include "RenderPass.hpp"
+#include "../Scene/Camera.hpp"
 #include "../Utils/Exceptions.hpp"
 #include "RenderPipeline.hpp"
 
@@ -60,6 +61,24 @@ void RenderPass::end(VulkanCommandBuffer& vkb) {
     afterRender(vkb);
 }
 
+size_t RenderPass::selectLod(const Camera& camera, const Mesh& mesh, const Matrix4& modelMatrix,
+                             const float threshold) {
+    if (mesh.lods.size() <= 1) {
+        return 0;
+    }
+
+    const auto scale = glm::length(Vector3{modelMatrix[0]});
+    auto pixelsPerUnit = camera.getProjectionMatrix()[1][1] * static_cast<float>(camera.getViewport().y) * 0.5f * scale;
+
+    if (!camera.isOrthographic()) {
+        // Measured to the nearest point of the bounding sphere, so the large meshes do not degrade up close
+        const auto distance = glm::distance(camera.getEyesPos(), Vector3{modelMatrix[3]}) - mesh.radius * scale;
+        pixelsPerUnit /= std::max(distance, camera.getZNear());
+    }
+
+    return mesh.selectLod(std::abs(pixelsPerUnit), threshold);
+}
+
 void RenderPass::addPipeline(RenderPipeline& pipeline, const uint32_t subpass) {
     pipelines.emplace_back(&pipeline, subpass);
 }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "../Vulkan/VulkanRenderer.hpp"
+#include "Mesh.hpp"
 #include "RenderBuffer.hpp"
 #include "RenderResources.hpp"
 
 namespace Engine {
+class ENGINE_API Camera;
 class ENGINE_API RenderPipeline;
 class ENGINE_API Scene;
 
@@ -65,6 +67,8 @@ protected:
     void addAttachment(uint32_t attachment, const AttachmentInfo& info);
     void addSubpass(const std::vector<uint32_t>& attachments, const std::vector<uint32_t>& inputs);
     void addSubpassDependency(const DependencyInfo& dependency);
+    // Picks the level of detail of the mesh by its error projected onto the screen of the camera
+    static size_t selectLod(const Camera& camera, const Mesh& mesh, const Matrix4& modelMatrix, float threshold);
 
 private:
     struct SubpassDescriptionData {
@@ -586,7 +586,7 @@ void RenderPipeline::bind(VulkanCommandBuffer& vkb) {
     vkb.bindPipeline(pipeline);
 }
 
-void RenderPipeline::renderMesh(VulkanCommandBuffer& vkb, const Mesh& mesh) const {
+void RenderPipeline::renderMesh(VulkanCommandBuffer& vkb, const Mesh& mesh, const size_t lod) const {
     std::array<VulkanVertexBufferBindRef, 1> vboBindings{};
 
     if (mesh.vbo) {
@@ -596,7 +596,11 @@ void RenderPipeline::renderMesh(VulkanCommandBuffer& vkb, const Mesh& mesh) cons
 
     if (mesh.ibo) {
         vkb.bindIndexBuffer(mesh.ibo, 0, mesh.indexType);
-        vkb.drawIndexed(mesh.count, mesh.instances, 0, 0, 0);
+        if (lod < mesh.lods.size()) {
+            vkb.drawIndexed(mesh.lods[lod].count, mesh.instances, mesh.lods[lod].offset, 0, 0);
+        } else {
+            vkb.drawIndexed(mesh.count, mesh.instances, 0, 0, 0);
+        }
     } else {
         vkb.draw(mesh.count, mesh.instances, 0, 0);
     }
@@ -109,7 +109,7 @@ public:
     }
     void setDesriptorSet(VulkanCommandBuffer& vkb, uint32_t setNum, const VulkanDescriptorSet& descriptorSet,
                          const Span<uint32_t>& offsets = VulkanCommandBuffer::noOffsets);
-    void renderMesh(VulkanCommandBuffer& vkb, const Mesh& mesh) const;
+    void renderMesh(VulkanCommandBuffer& vkb, const Mesh& mesh, size_t lod = 0) const;
     void renderMeshInstanced(VulkanCommandBuffer& vkb, const Mesh& mesh, const VulkanBuffer& vbo, uint32_t count) const;
 
 protected:
@@ -1,6 +1,7 @@
 #include "Renderer.hpp"
 #include "../Scene/Scene.hpp"
 #include "../Utils/Exceptions.hpp"
+#include "../Utils/Profiler.hpp"
 
 using namespace Engine;
 
@@ -8,24 +9,137 @@ Renderer::Renderer(VulkanRenderer& vulkan) : vulkan{vulkan} {
 }
 
 void Renderer::render(VulkanCommandBuffer& vkb, VulkanCommandBuffer& vkbc, Scene& scene) {
+    PROFILE_SCOPE("Renderer::render");
+
     scene.recalculate(vulkan);
 
-    for (auto& pass : passes) {
+    FrameQueries* queries{nullptr};
+    if (gpuTiming) {
+        readPassTimes();
+
+        queries = &frameQueries.at(vulkan.getCurrentFrameNum());
+        queries->time = std::chrono::steady_clock::now();
+        queries->graphics.clear();
+        queries->compute.clear();
+
+        const auto count = static_cast<uint32_t>(passes.size() * 2);
+        if (vulkan.getGraphicsQueueFamilyProperties().timestampValidBits) {
+            vkb.resetQueryPool(graphicsQueries, 0, count);
+        }
+        if (vulkan.getComputeQueueFamilyProperties().timestampValidBits) {
+            vkbc.resetQueryPool(computeQueries, 0, count);
+        }
+    }
+
+    for (size_t i = 0; i < passes.size(); i++) {
+        auto& pass = passes[i];
         if (pass->isExcluded()) {
             continue;
         }
 
         try {
             auto& cmd = pass->isCompute() ? vkbc : vkb;
+
+            // Each timed pass takes two consecutive queries, the start and the end
+            VulkanQueryPool* pool{nullptr};
+            uint32_t query{0};
+            if (queries) {
+                const auto validBits = pass->isCompute() ? vulkan.getComputeQueueFamilyProperties().timestampValidBits
+                                                         : vulkan.getGraphicsQueueFamilyProperties().timestampValidBits;
+                if (validBits) {
+                    auto& indices = pass->isCompute() ? queries->compute : queries->graphics;
+                    pool = pass->isCompute() ? &computeQueries : &graphicsQueries;
+                    query = static_cast<uint32_t>(indices.size() * 2);
+                    indices.push_back(i);
+                }
+            }
+
+            if (pool) {
+                cmd.writeTimestamp(*pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query);
+            }
+
             pass->begin(cmd);
             pass->render(cmd, scene);
             pass->end(cmd);
+
+            if (pool) {
+                cmd.writeTimestamp(*pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query + 1);
+            }
         } catch (...) {
             EXCEPTION_NESTED("Failed to render scene pass: {}", pass->getName());
         }
     }
 }
 
+void Renderer::setGpuTimingEnabled(const bool value) {
+    if (value && !gpuTimingCreated) {
+        VkQueryPoolCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        createInfo.queryCount = static_cast<uint32_t>(passes.size() * 2);
+        graphicsQueries = vulkan.createQueryPool(createInfo);
+        computeQueries = vulkan.createQueryPool(createInfo);
+        gpuTimingCreated = true;
+    }
+
+    gpuTiming = value;
+    passTimes.clear();
+    for (auto& queries : frameQueries) {
+        queries.graphics.clear();
+        queries.compute.clear();
+    }
+}
+
+void Renderer::readPassTimes() {
+    // The slot of the current frame has been waited on, so these are the timestamps from MAX_FRAMES_IN_FLIGHT ago
+    const auto& queries = frameQueries.at(vulkan.getCurrentFrameNum());
+    if (queries.graphics.empty() && queries.compute.empty()) {
+        return;
+    }
+
+    passTimes.clear();
+    readPassTimes(graphicsQueries, queries.graphics, queries.time);
+    readPassTimes(computeQueries, queries.compute, queries.time);
+}
+
+void Renderer::readPassTimes(VulkanQueryPool& pool, const std::vector<size_t>& indices,
+                             const std::chrono::steady_clock::time_point time) {
+    if (indices.empty()) {
+        return;
+    }
+
+    const auto results = pool.getResult<uint64_t>(0, static_cast<uint32_t>(indices.size() * 2), VK_QUERY_RESULT_64_BIT);
+    if (results.empty()) {
+        return;
+    }
+
+    const auto period = static_cast<double>(vulkan.getPhysicalDeviceProperties().limits.timestampPeriod);
+    const auto toNanos = [&](const uint64_t ticks) {
+        return std::chrono::nanoseconds{static_cast<uint64_t>(static_cast<double>(ticks) * period)};
+    };
+
+#ifndef TEMPORARY_ESCAPE_PROFILER
+    (void)time;
+#endif
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        auto& pass = passes.at(indices[i]);
+        const auto start = results[i * 2];
+        const auto end = results[i * 2 + 1];
+
+        PassTime passTime{};
+        passTime.name = pass->getName().c_str();
+        passTime.duration = toNanos(end - start);
+        passTimes.push_back(passTime);
+
+#ifdef TEMPORARY_ESCAPE_PROFILER
+        // GPU clock is not related to the CPU clock, the zones are placed relative to when the frame was recorded
+        auto& profiler = Profiler::getInstance();
+        profiler.addGpuZone(profiler.intern(pass->getName()), time + toNanos(start - results[0]), passTime.duration);
+#endif
+    }
+}
+
 void Renderer::addRenderPass(std::unique_ptr<RenderPass> pass) {
     passes.push_back(std::move(pass));
 }
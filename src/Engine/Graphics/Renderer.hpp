@@ -15,8 +15,20 @@ public:
     NON_MOVEABLE(Renderer);
     NON_COPYABLE(Renderer);
 
+    struct PassTime {
+        const char* name{nullptr};
+        std::chrono::nanoseconds duration{0};
+    };
+
     virtual void render(VulkanCommandBuffer& vkb, VulkanCommandBuffer& vkbc, Scene& scene);
 
+    // Records GPU timestamps around each render pass, only meant for renderers submitted once per frame
+    void setGpuTimingEnabled(bool value);
+    // GPU time of each pass from the last frame whose timestamps are available
+    const std::vector<PassTime>& getPassTimes() const {
+        return passTimes;
+    }
+
 protected:
     void addRenderPass(std::unique_ptr<RenderPass> pass);
     template <typename T> T& getRenderPass() {
@@ -31,7 +43,23 @@ protected:
     void create();
 
 private:
+    struct FrameQueries {
+        std::chrono::steady_clock::time_point time;
+        std::vector<size_t> graphics;
+        std::vector<size_t> compute;
+    };
+
+    void readPassTimes();
+    void readPassTimes(VulkanQueryPool& pool, const std::vector<size_t>& indices,
+                       std::chrono::steady_clock::time_point time);
+
     VulkanRenderer& vulkan;
     std::vector<std::unique_ptr<RenderPass>> passes;
+    bool gpuTiming{false};
+    bool gpuTimingCreated{false};
+    VulkanQueryPool graphicsQueries;
+    VulkanQueryPool computeQueries;
+    std::array<FrameQueries, MAX_FRAMES_IN_FLIGHT> frameQueries;
+    std::vector<PassTime> passTimes;
 };
 } // namespace Engine
@@ -180,10 +180,18 @@ void RendererPlanetSurface::prepareTexture(VulkanCommandBuffer& vkb, const Vulka
 
 void RendererPlanetSurface::prepareCubemap(VulkanCommandBuffer& vkb) {
     planetTextures.dispose(vulkan);
-    planetTextures = PlanetTextures{};
 
     const auto extent = renderBufferPlanet.getAttachmentTexture(RenderBufferPlanet::Attachment::Color).getExtent();
     const Vector2i textureSize{extent.width, extent.height};
+    planetTextures = createTextures(vulkan, textureSize);
+
+    prepareTexture(vkb, planetTextures.getColor());
+    prepareTexture(vkb, planetTextures.getMetallicRoughness());
+    prepareTexture(vkb, planetTextures.getNormal());
+}
+
+PlanetTextures RendererPlanetSurface::createTextures(VulkanRenderer& vulkan, const Vector2i& textureSize) {
+    PlanetTextures textures{};
 
     VulkanTexture::CreateInfo textureInfo{};
     textureInfo.image.format = VK_FORMAT_R8G8B8A8_UNORM;
@@ -224,19 +232,17 @@ void RendererPlanetSurface::prepareCubemap(VulkanCommandBuffer& vkb) {
     textureInfo.sampler.minLod = 0.0f;
     textureInfo.sampler.maxLod = static_cast<float>(textureInfo.image.mipLevels);
 
-    planetTextures.getColor() = vulkan.createTexture(textureInfo);
+    textures.getColor() = vulkan.createTexture(textureInfo);
 
     textureInfo.image.format = VK_FORMAT_R8G8_UNORM;
     textureInfo.view.format = VK_FORMAT_R8G8_UNORM;
 
-    planetTextures.getMetallicRoughness() = vulkan.createTexture(textureInfo);
+    textures.getMetallicRoughness() = vulkan.createTexture(textureInfo);
 
     textureInfo.image.format = VK_FORMAT_R8G8B8A8_UNORM;
     textureInfo.view.format = VK_FORMAT_R8G8B8A8_UNORM;
 
-    planetTextures.getNormal() = vulkan.createTexture(textureInfo);
+    textures.getNormal() = vulkan.createTexture(textureInfo);
 
-    prepareTexture(vkb, planetTextures.getColor());
-    prepareTexture(vkb, planetTextures.getMetallicRoughness());
-    prepareTexture(vkb, planetTextures.getNormal());
+    return textures;
 }
@@ -15,6 +15,8 @@ public:
 
     void update(Scene& scene);
     PlanetTextures renderPlanet(uint64_t seed, const PlanetTypePtr& planetType);
+    // Empty cube maps in the formats the planet surface is rendered into
+    static PlanetTextures createTextures(VulkanRenderer& vulkan, const Vector2i& textureSize);
 
 protected:
     void beforeRender(VulkanCommandBuffer& vkb, Scene& scene, size_t job) override;
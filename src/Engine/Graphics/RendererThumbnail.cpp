@@ -14,6 +14,7 @@ static RenderOptions getOptionsThumbnails(const Config& config) {
     options.shadowsLevel = 0;
     options.viewport = {config.thumbnailSize, config.thumbnailSize};
     options.enableSrc = true;
+    options.lodThreshold = 0.0f;
     return options;
 }
 
@@ -1,47 +1,26 @@
 #include "WorldSpaceText.hpp"
 #include "../Font/FontFamily.hpp"
-#include <utf8/checked.h>
 
 using namespace Engine;
 
-WorldSpaceText::TextVertexShaper::TextVertexShaper(Vertices& vertices, const FontFamily& font, const float size,
-                                                   const Vector3& pos) :
-    TextShaper{font, size}, vertices{vertices}, pos{pos} {
-}
-
-void WorldSpaceText::TextVertexShaper::onGlyph(const FontFace& fontFace, const FontFace::Glyph& glyph,
-                                               const Vector2& pen, const Quad& quad, const Color4& color,
-                                               const char* it, const uint32_t code) {
-    (void)color;
-    (void)it;
-    (void)code;
-
-    vertices.emplace_back();
-    auto& dst = vertices.back();
-
-    const auto height = static_cast<float>(fontFace.getSize());
-
-    dst.position = pos;
-    dst.offset = pen + Vector2{0.0f, glyph.ascend * getScale() + (height - glyph.size.y * getScale())};
-    dst.offset.y -= (height * getScale());
-    dst.size = glyph.size * getScale();
-    dst.uv = glyph.uv;
-    dst.st = glyph.st;
-}
-
 WorldSpaceText::WorldSpaceText(const FontFamily& font) : font{font} {
 }
 
 void WorldSpaceText::add(const Vector3& pos, const std::string_view& text, const float size) {
-    const auto start = vertices.size();
-    vertices.reserve(vertices.size() + utf8::distance(text.begin(), text.end()));
-
-    TextVertexShaper shaper{vertices, font, size, pos};
-    shaper.write(text);
-
-    const auto bounds = shaper.getBounds() * textAlignToVector(textAlign);
-    for (size_t i = start; i < vertices.size(); i++) {
-        vertices[i].offset -= bounds;
+    const auto& run = font.shape(text, size);
+    vertices.reserve(vertices.size() + run.glyphs.size());
+
+    const auto height = static_cast<float>(font.getSize());
+    const auto scale = size / height;
+    const auto bounds = run.bounds * textAlignToVector(textAlign);
+
+    for (const auto& glyph : run.glyphs) {
+        auto& dst = vertices.emplace_back();
+        dst.position = pos;
+        dst.offset = glyph.pos + Vector2{0.0f, height - height * scale} - bounds;
+        dst.size = glyph.size;
+        dst.uv = glyph.uv;
+        dst.st = glyph.st;
     }
 }
 
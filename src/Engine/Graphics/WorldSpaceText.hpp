@@ -26,18 +26,6 @@ public:
 
     using Vertices = std::vector<Vertex>;
 
-    class TextVertexShaper : public TextShaper {
-    public:
-        TextVertexShaper(Vertices& vertices, const FontFamily& font, float size, const Vector3& pos);
-
-    private:
-        void onGlyph(const FontFace& fontFace, const FontFace::Glyph& glyph, const Vector2& pen, const Quad& quad,
-                     const Color4& color, const char* it, uint32_t code) override;
-
-        Vertices& vertices;
-        Vector3 pos;
-    };
-
     explicit WorldSpaceText(const FontFamily& font);
 
     void add(const Vector3& pos, const std::string_view& text, float size);
@@ -215,107 +215,235 @@ const FontFamily& Engine::GuiContext::getFont() const {
 void GuiContext::update() {
 }
 
+static size_t getCommandSize(const struct nk_command* cmd) {
+    switch (cmd->type) {
+    case NK_COMMAND_SCISSOR: {
+        return sizeof(struct nk_command_scissor);
+    }
+    case NK_COMMAND_TEXT: {
+        const auto c = reinterpret_cast<const struct nk_command_text*>(cmd);
+        return offsetof(struct nk_command_text, string) + c->length;
+    }
+    case NK_COMMAND_RECT: {
+        return sizeof(struct nk_command_rect);
+    }
+    case NK_COMMAND_RECT_FILLED: {
+        return sizeof(struct nk_command_rect_filled);
+    }
+    case NK_COMMAND_IMAGE: {
+        return sizeof(struct nk_command_image);
+    }
+    default: {
+        // Not rendered by the canvas, does not affect the geometry
+        return 0;
+    }
+    }
+}
+
+static uint64_t hashBytes(uint64_t hash, const void* data, const size_t size) {
+    // FNV-1a
+    const auto* ptr = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t hashCommand(uint64_t hash, const struct nk_command* cmd) {
+    const auto size = getCommandSize(cmd);
+    if (size == 0) {
+        return hash;
+    }
+
+    // The header holds the offset of the next command and is skipped
+    hash = hashBytes(hash, &cmd->type, sizeof(cmd->type));
+    hash = hashBytes(hash, reinterpret_cast<const uint8_t*>(cmd) + sizeof(struct nk_command),
+                     size - sizeof(struct nk_command));
+
+    // Images can be moved within the atlas while keeping the same pointer
+    if (cmd->type == NK_COMMAND_IMAGE) {
+        const auto c = reinterpret_cast<const struct nk_command_image*>(cmd);
+        const auto image = reinterpret_cast<const Image*>(c->img.handle.ptr);
+        if (image) {
+            const auto& alc = image->getAllocation();
+            hash = hashBytes(hash, &alc.texture, sizeof(alc.texture));
+            hash = hashBytes(hash, &alc.uv, sizeof(alc.uv));
+            hash = hashBytes(hash, &alc.st, sizeof(alc.st));
+        }
+    }
+
+    return hash;
+}
+
 void GuiContext::render(Canvas& canvas, const Vector2& viewport) {
     groupStates.clear();
 
+    // Cached geometry holds absolute positions, scissors and glyph UVs
+    const auto& fontFamily = getFont();
+    if (cacheViewport != viewport || cacheFontGeneration != fontFamily.getGeneration()) {
+        windowCache.clear();
+        cacheViewport = viewport;
+        cacheFontGeneration = fontFamily.getGeneration();
+    }
+
+    // Find where the commands of each window start
+    std::unordered_map<nk_size, nk_hash> windowStarts;
+    for (auto* win = nk->begin; win; win = win->next) {
+        if (win->buffer.begin != win->buffer.end) {
+            windowStarts.emplace(win->buffer.begin, win->name);
+        }
+    }
+
+    // Split the command list into per window segments and hash them
+    windowSegments.clear();
+    const auto* base = static_cast<const nk_byte*>(nk->memory.memory.ptr);
     const struct nk_command* cmd;
     nk_foreach(cmd, nk.get()) {
-        switch (cmd->type) {
-        case NK_COMMAND_SCISSOR: {
-            const auto c = reinterpret_cast<const struct nk_command_scissor*>(cmd);
-            const auto scale = Vector2{1.0f / config.gui.scale};
-            if (c->x >= 0 && c->y >= 0) {
-                canvas.setScissor(Vector2{static_cast<float>(c->x), static_cast<float>(c->y)} * scale,
-                                  Vector2{static_cast<float>(c->w), static_cast<float>(c->h)} * scale);
-            } else {
-                canvas.setScissor({0.0f, 0.0f}, viewport * scale);
-            }
-            break;
+        const auto offset = static_cast<nk_size>(reinterpret_cast<const nk_byte*>(cmd) - base);
+        const auto found = windowStarts.find(offset);
+        if (found != windowStarts.end() || windowSegments.empty()) {
+            auto& segment = windowSegments.emplace_back();
+            segment.name = found != windowStarts.end() ? found->second : 0;
+            segment.hash = 0xcbf29ce484222325ULL;
+            segment.begin = cmd;
         }
-        case NK_COMMAND_LINE: {
-            const auto c = reinterpret_cast<const struct nk_command_line*>(cmd);
-            /*if (c->color.a == 0) {
-                break;
-            }
-
-            canvas.beginPath();
-            canvas.moveTo(Vector2(c->begin.x, c->begin.y));
-            canvas.strokeColor(asColor(c->color));
-            canvas.strokeWidth(c->line_thickness);
-            canvas.lineTo(Vector2(c->end.x, c->end.y));
-            canvas.stroke();
-            canvas.closePath();*/
-            break;
-        }
-        case NK_COMMAND_TEXT: {
-            const auto c = reinterpret_cast<const struct nk_command_text*>(cmd);
-            const auto& font = *static_cast<const FontFamily*>(c->font->userdata.ptr);
-            std::string_view text{&c->string[0], std::strlen(&c->string[0])};
-            const auto pos = Vector2{c->x, static_cast<float>(c->y) + c->height / 1.25f};
-            canvas.drawText(pos, text, font, c->font->height, asColor(c->foreground));
-            break;
+        windowSegments.back().hash = hashCommand(windowSegments.back().hash, cmd);
+    }
+
+    for (auto& [_, cache] : windowCache) {
+        cache.used = false;
+    }
+
+    for (size_t i = 0; i < windowSegments.size(); i++) {
+        const auto& segment = windowSegments[i];
+        const auto* end = i + 1 < windowSegments.size() ? windowSegments[i + 1].begin : nullptr;
+
+        auto& cache = windowCache[segment.name];
+        cache.used = true;
+
+        // Nothing has changed in this window since the last frame
+        if (cache.hash == segment.hash) {
+            canvas.replay(cache.segment);
+            continue;
         }
-        case NK_COMMAND_RECT: {
-            const auto c = reinterpret_cast<const struct nk_command_rect*>(cmd);
-            const auto p = Vector2{c->x, c->y};
-            const auto s = Vector2{c->w, c->h};
-            canvas.drawRectOutline(p, s, c->line_thickness, asColor(c->color));
-            break;
+
+        const auto mark = canvas.mark();
+        for (cmd = segment.begin; cmd && cmd != end; cmd = nk__next(nk.get(), cmd)) {
+            renderCommand(canvas, viewport, cmd);
         }
-        case NK_COMMAND_RECT_FILLED: {
-            const auto c = reinterpret_cast<const struct nk_command_rect_filled*>(cmd);
-            canvas.drawRect(Vector2(c->x, c->y), Vector2(c->w, c->h), asColor(c->color));
-            break;
+
+        cache.hash = segment.hash;
+        canvas.capture(mark, cache.segment);
+    }
+
+    // Forget windows that are no longer visible
+    for (auto it = windowCache.begin(); it != windowCache.end();) {
+        if (!it->second.used) {
+            it = windowCache.erase(it);
+        } else {
+            ++it;
         }
-        case NK_COMMAND_TRIANGLE: {
-            const auto c = reinterpret_cast<const struct nk_command_triangle*>(cmd);
-            /*if (c->color.a == 0) {
-                break;
-            }
-
-            canvas.beginPath();
-            canvas.strokeColor(asColor(c->color));
-            canvas.strokeWidth(c->line_thickness);
-            canvas.moveTo(asVec(c->a));
-            canvas.lineTo(asVec(c->b));
-            canvas.lineTo(asVec(c->c));
-            canvas.lineTo(asVec(c->a));
-            canvas.stroke();*/
-            break;
+    }
+
+    nk_clear(nk.get());
+}
+
+void GuiContext::renderCommand(Canvas& canvas, const Vector2& viewport, const struct nk_command* cmd) {
+    switch (cmd->type) {
+    case NK_COMMAND_SCISSOR: {
+        const auto c = reinterpret_cast<const struct nk_command_scissor*>(cmd);
+        const auto scale = Vector2{1.0f / config.gui.scale};
+        if (c->x >= 0 && c->y >= 0) {
+            canvas.setScissor(Vector2{static_cast<float>(c->x), static_cast<float>(c->y)} * scale,
+                              Vector2{static_cast<float>(c->w), static_cast<float>(c->h)} * scale);
+        } else {
+            canvas.setScissor({0.0f, 0.0f}, viewport * scale);
         }
-        case NK_COMMAND_TRIANGLE_FILLED: {
-            const auto c = reinterpret_cast<const struct nk_command_triangle_filled*>(cmd);
-            /*if (c->color.a == 0) {
-                break;
-            }
-
-            canvas.beginPath();
-            canvas.fillColor(asColor(c->color));
-            canvas.moveTo(asVec(c->a));
-            canvas.lineTo(asVec(c->b));
-            canvas.lineTo(asVec(c->c));
-            canvas.lineTo(asVec(c->a));
-            canvas.fill();*/
+        break;
+    }
+    case NK_COMMAND_LINE: {
+        const auto c = reinterpret_cast<const struct nk_command_line*>(cmd);
+        /*if (c->color.a == 0) {
             break;
         }
-        case NK_COMMAND_IMAGE: {
-            const auto c = reinterpret_cast<const struct nk_command_image*>(cmd);
-            const auto& color = asColor(c->col);
-            const auto image = reinterpret_cast<Image*>(c->img.handle.ptr);
-            if (image) {
-                canvas.drawImage({static_cast<float>(c->x), static_cast<float>(c->y)},
-                                 {static_cast<float>(c->w), static_cast<float>(c->h)},
-                                 *image,
-                                 color);
-            }
+
+        canvas.beginPath();
+        canvas.moveTo(Vector2(c->begin.x, c->begin.y));
+        canvas.strokeColor(asColor(c->color));
+        canvas.strokeWidth(c->line_thickness);
+        canvas.lineTo(Vector2(c->end.x, c->end.y));
+        canvas.stroke();
+        canvas.closePath();*/
+        break;
+    }
+    case NK_COMMAND_TEXT: {
+        const auto c = reinterpret_cast<const struct nk_command_text*>(cmd);
+        const auto& font = *static_cast<const FontFamily*>(c->font->userdata.ptr);
+        std::string_view text{&c->string[0], std::strlen(&c->string[0])};
+        const auto pos = Vector2{c->x, static_cast<float>(c->y) + c->height / 1.25f};
+        canvas.drawText(pos, text, font, c->font->height, asColor(c->foreground));
+        break;
+    }
+    case NK_COMMAND_RECT: {
+        const auto c = reinterpret_cast<const struct nk_command_rect*>(cmd);
+        const auto p = Vector2{c->x, c->y};
+        const auto s = Vector2{c->w, c->h};
+        canvas.drawRectOutline(p, s, c->line_thickness, asColor(c->color));
+        break;
+    }
+    case NK_COMMAND_RECT_FILLED: {
+        const auto c = reinterpret_cast<const struct nk_command_rect_filled*>(cmd);
+        canvas.drawRect(Vector2(c->x, c->y), Vector2(c->w, c->h), asColor(c->color));
+        break;
+    }
+    case NK_COMMAND_TRIANGLE: {
+        const auto c = reinterpret_cast<const struct nk_command_triangle*>(cmd);
+        /*if (c->color.a == 0) {
             break;
         }
-        default: {
+
+        canvas.beginPath();
+        canvas.strokeColor(asColor(c->color));
+        canvas.strokeWidth(c->line_thickness);
+        canvas.moveTo(asVec(c->a));
+        canvas.lineTo(asVec(c->b));
+        canvas.lineTo(asVec(c->c));
+        canvas.lineTo(asVec(c->a));
+        canvas.stroke();*/
+        break;
+    }
+    case NK_COMMAND_TRIANGLE_FILLED: {
+        const auto c = reinterpret_cast<const struct nk_command_triangle_filled*>(cmd);
+        /*if (c->color.a == 0) {
             break;
         }
+
+        canvas.beginPath();
+        canvas.fillColor(asColor(c->color));
+        canvas.moveTo(asVec(c->a));
+        canvas.lineTo(asVec(c->b));
+        canvas.lineTo(asVec(c->c));
+        canvas.lineTo(asVec(c->a));
+        canvas.fill();*/
+        break;
+    }
+    case NK_COMMAND_IMAGE: {
+        const auto c = reinterpret_cast<const struct nk_command_image*>(cmd);
+        const auto& color = asColor(c->col);
+        const auto image = reinterpret_cast<Image*>(c->img.handle.ptr);
+        if (image) {
+            canvas.drawImage({static_cast<float>(c->x), static_cast<float>(c->y)},
+                             {static_cast<float>(c->w), static_cast<float>(c->h)},
+                             *image,
+                             color);
         }
+        break;
+    }
+    default: {
+        break;
+    }
     }
-    nk_clear(nk.get());
 }
 
 bool GuiContext::windowBegin(const GuiStyleWindow& style, const std::string& id, const std::string& title,
@@ -6,6 +6,7 @@
 
 struct nk_context;
 struct nk_user_font;
+struct nk_command;
 
 namespace Engine {
 enum class GuiTextAlign : uint32_t {
@@ -121,11 +122,25 @@ private:
 
     struct CustomStyle;
 
+    // Geometry of a single window, replayed as long as the window produces the same draw commands
+    struct WindowCache {
+        uint64_t hash{0};
+        Canvas::Segment segment;
+        bool used{false};
+    };
+
+    struct WindowSegment {
+        uint32_t name{0};
+        uint64_t hash{0};
+        const struct nk_command* begin{nullptr};
+    };
+
     static inline const auto padding = 4.0f;
 
     void applyTheme();
     void pushGroupState();
     void popGroupState();
+    void renderCommand(Canvas& canvas, const Vector2& viewport, const struct nk_command* cmd);
 
     const Config& config;
     const int fontSize;
@@ -138,6 +153,10 @@ private:
     bool inputEnabled{true};
 
     std::list<GroupState> groupStates;
+    std::vector<WindowSegment> windowSegments;
+    std::unordered_map<uint32_t, WindowCache> windowCache;
+    Vector2 cacheViewport{0.0f};
+    uint64_t cacheFontGeneration{0};
 };
 
 inline GuiContext::Flags operator|(const GuiContext::WindowFlag a, const GuiContext::WindowFlag b) {
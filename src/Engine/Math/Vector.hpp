@@ -3,6 +3,7 @@
 #include "../Library.hpp"
 #include <fmt/format.h>
 #include <glm/geometric.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/vec2.hpp>
@@ -21,6 +22,9 @@ using Vector3i = glm::i32vec3;
 using Vector4 = glm::f32vec4;
 using Vector4d = glm::f64vec4;
 using Vector4i = glm::i32vec4;
+// Quantized vertex attributes
+using Vector2h = glm::u16vec2;
+using Vector4b = glm::i8vec4;
 using Color4 = glm::f32vec4;
 
 inline Color4 alpha(float a) {
@@ -22,3 +22,17 @@ void NetworkDispatcher2::onObjectReceived(NetworkStreamPtr peer, ObjectHandlePtr
         BACKTRACE(e, "Failed to handle message: {}", it->second.name);
     }
 }
+
+void NetworkDispatcher2::onRawReceived(NetworkStreamPtr peer, RawMessagePtr raw) {
+    auto it = rawHandlers.find(raw->getHash());
+    if (it == rawHandlers.end()) {
+        logger.error("No such raw handler for message id: {}", raw->getHash());
+        return;
+    }
+
+    try {
+        it->second.fn(std::move(peer), std::move(raw));
+    } catch (std::exception& e) {
+        BACKTRACE(e, "Failed to handle message: {}", it->second.name);
+    }
+}
@@ -9,6 +9,7 @@ class ENGINE_API NetworkDispatcher2 {
 public:
     using ObjectHandlePtr = std::shared_ptr<msgpack::object_handle>;
     using Handler = std::function<void(NetworkStreamPtr, ObjectHandlePtr)>;
+    using RawHandler = std::function<void(NetworkStreamPtr, RawMessagePtr)>;
 
     virtual ~NetworkDispatcher2() = default;
 
@@ -16,17 +17,33 @@ public:
         using Req = typename Traits<decltype(&Fn::operator())>::Arg;
         using T = Req;
 
-        HandlerData data;
-        data.fn = [fn](NetworkStreamPtr peer, ObjectHandlePtr oh) {
-            // Construct a request and call a handler function
-            fn(Request2<T>{std::move(peer), std::move(oh)});
-        };
-        data.name = Detail::MessageHelper<T>::name;
+        if constexpr (Traits<decltype(&Fn::operator())>::raw) {
+            RawHandlerData data;
+            data.fn = [fn](NetworkStreamPtr peer, RawMessagePtr raw) {
+                fn(RawRequest2<T>{std::move(peer), std::move(raw)});
+            };
+            data.name = Detail::MessageHelper<T>::name;
 
-        handlers.emplace(Detail::MessageHelper<T>::hash, std::move(data));
+            rawHandlers.emplace(Detail::MessageHelper<T>::hash, std::move(data));
+        } else {
+            HandlerData data;
+            data.fn = [fn](NetworkStreamPtr peer, ObjectHandlePtr oh) {
+                // Construct a request and call a handler function
+                fn(Request2<T>{std::move(peer), std::move(oh)});
+            };
+            data.name = Detail::MessageHelper<T>::name;
+
+            handlers.emplace(Detail::MessageHelper<T>::hash, std::move(data));
+        }
     }
 
     void onObjectReceived(NetworkStreamPtr peer, ObjectHandlePtr oh);
+    void onRawReceived(NetworkStreamPtr peer, RawMessagePtr raw);
+
+    // The handlers are added before any connection is made, so this is safe to call from the network threads
+    [[nodiscard]] bool hasRawHandler(const uint64_t hash) const {
+        return rawHandlers.find(hash) != rawHandlers.end();
+    }
 
     virtual void onAcceptSuccess(const NetworkStreamPtr& peer) {
         (void)peer;
@@ -41,14 +58,27 @@ private:
         const char* name;
     };
 
+    struct RawHandlerData {
+        RawHandler fn;
+        const char* name;
+    };
+
     template <typename F> struct Traits;
 
     template <typename C, typename R, typename T> struct Traits<R (C::*)(Request2<T>) const> {
         using Ret = R;
         using Arg = T;
+        static constexpr bool raw = false;
+    };
+
+    template <typename C, typename R, typename T> struct Traits<R (C::*)(RawRequest2<T>) const> {
+        using Ret = R;
+        using Arg = T;
+        static constexpr bool raw = true;
     };
 
     std::unordered_map<uint64_t, HandlerData> handlers;
+    std::unordered_map<uint64_t, RawHandlerData> rawHandlers;
 };
 } // namespace Engine
 
@@ -58,3 +88,11 @@ private:
         using Handler = void (Self::*)(Request2<Type>);                                                                \
         (this->*static_cast<Handler>(&Self::handle))(std::move(req));                                                  \
     })
+
+// The handler receives the message undecoded, see RawRequest2
+#define HANDLE_RAW_REQUEST2(Type)                                                                                      \
+    dispatcher.addHandler([this](RawRequest2<Type> req) {                                                              \
+        using Self = std::remove_pointer<decltype(this)>::type;                                                        \
+        using Handler = void (Self::*)(RawRequest2<Type>);                                                             \
+        (this->*static_cast<Handler>(&Self::handle))(std::move(req));                                                  \
+    })
@@ -2,6 +2,8 @@
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 
 #include "NetworkMessage.hpp"
+#include "../Stream/MsgpackReader.hpp"
+#include "../Utils/Exceptions.hpp"
 #include <openssl/sha.h>
 
 using namespace Engine;
@@ -22,3 +24,31 @@ uint64_t Detail::getMessageHash(const std::string_view& name) {
 bool Detail::validateMessageObject(const msgpack::object_handle& oh) {
     return oh.zone() && oh->type == msgpack::type::ARRAY && oh->via.array.size == 3;
 }
+
+RawMessage::RawMessage(const char* data, const size_t size) : data{data, data + size} {
+    MsgpackReader reader{this->data.data(), this->data.size()};
+    if (reader.readArray() != 3) {
+        EXCEPTION("Raw message is not an array of three elements");
+    }
+    hash = reader.readUint();
+    xid = reader.readUint();
+    bodyOffset = reader.getOffset();
+}
+
+bool RawMessage::peekHash(const char* data, const size_t size, uint64_t& hash) {
+    // Every message starts with a fixarray of three elements followed by the unsigned id
+    if (size < 2 || static_cast<uint8_t>(data[0]) != 0x93) {
+        return false;
+    }
+    const auto type = static_cast<uint8_t>(data[1]);
+    if (type > 0x7f && (type < 0xcc || type > 0xcf)) {
+        return false;
+    }
+    if (MsgpackReader::getObjectSize(data + 1, size - 1) == 0) {
+        return false;
+    }
+
+    MsgpackReader reader{data + 1, size - 1};
+    hash = reader.readUint();
+    return true;
+}
@@ -102,6 +102,53 @@ public:
     MOVEABLE(Request2);
 };
 
+// The packed bytes of a whole message, kept for the handlers that decode the body straight from the bytes
+class ENGINE_API RawMessage {
+public:
+    RawMessage(const char* data, size_t size);
+
+    [[nodiscard]] uint64_t getHash() const {
+        return hash;
+    }
+    [[nodiscard]] uint64_t getXid() const {
+        return xid;
+    }
+    [[nodiscard]] std::string_view getBody() const {
+        return {data.data() + bodyOffset, data.size() - bodyOffset};
+    }
+
+    // Reads only the message id, returns false when the bytes do not start like a message
+    static bool peekHash(const char* data, size_t size, uint64_t& hash);
+
+private:
+    std::vector<char> data;
+    uint64_t hash{0};
+    uint64_t xid{0};
+    size_t bodyOffset{0};
+};
+
+using RawMessagePtr = std::shared_ptr<const RawMessage>;
+
+template <typename T> class RawRequest2 {
+public:
+    using Type = T;
+
+    explicit RawRequest2(NetworkStreamPtr peer, RawMessagePtr raw) : peer{std::move(peer)}, raw{std::move(raw)} {
+    }
+
+    [[nodiscard]] std::string_view body() const {
+        return raw->getBody();
+    }
+
+    COPYABLE(RawRequest2);
+    MOVEABLE(RawRequest2);
+
+    NetworkStreamPtr peer;
+
+private:
+    RawMessagePtr raw;
+};
+
 template <> struct Detail::MessageHelper<std::string> {
     static inline const bool reliable = true;
 };
@@ -0,0 +1,82 @@
+#include "NetworkMetricsServer.hpp"
+#include "../Utils/Metrics.hpp"
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+NetworkMetricsServer::NetworkMetricsServer(asio::io_service& service, const std::string& address,
+                                           const uint16_t port) :
+    service{service},
+    acceptor{service, asio::ip::tcp::endpoint{asio::ip::address::from_string(address), port}},
+    localEndpoint{acceptor.local_endpoint()} {
+}
+
+NetworkMetricsServer::~NetworkMetricsServer() {
+    logger.info("Metrics server destroyed");
+}
+
+void NetworkMetricsServer::start() {
+    accept();
+    logger.info("Metrics server started on address: {}", localEndpoint);
+}
+
+void NetworkMetricsServer::stop() {
+    asio::error_code ec;
+    (void)acceptor.close(ec);
+}
+
+void NetworkMetricsServer::accept() {
+    auto connection = std::make_shared<Connection>(service);
+    acceptor.async_accept(connection->socket, [self = shared_from_this(), connection](const asio::error_code ec) {
+        if (ec) {
+            if (ec != asio::error::operation_aborted) {
+                logger.error("Metrics server accept error: {}", ec.message());
+            }
+            return;
+        }
+
+        self->read(connection);
+        self->accept();
+    });
+}
+
+void NetworkMetricsServer::read(const std::shared_ptr<Connection>& connection) {
+    asio::async_read_until(
+        connection->socket,
+        connection->request,
+        "\r\n\r\n",
+        [self = shared_from_this(), connection](const asio::error_code ec, const size_t length) {
+            if (ec) {
+                return;
+            }
+
+            std::string line;
+            std::istream stream{&connection->request};
+            std::getline(stream, line);
+
+            if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET / ", 0) == 0) {
+                const auto body = Metrics::getInstance().toPrometheus();
+                connection->response = fmt::format("HTTP/1.0 200 OK\r\n"
+                                                   "Content-Type: text/plain; version=0.0.4\r\n"
+                                                   "Content-Length: {}\r\n"
+                                                   "Connection: close\r\n\r\n{}",
+                                                   body.size(),
+                                                   body);
+            } else {
+                connection->response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            }
+
+            self->write(connection);
+        });
+}
+
+void NetworkMetricsServer::write(const std::shared_ptr<Connection>& connection) {
+    asio::async_write(connection->socket,
+                      asio::buffer(connection->response),
+                      [connection](const asio::error_code ec, const size_t length) {
+                          asio::error_code ignored;
+                          (void)connection->socket.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+                          (void)connection->socket.close(ignored);
+                      });
+}
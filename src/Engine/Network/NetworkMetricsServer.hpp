@@ -0,0 +1,40 @@
+#pragma once
+
+#include "NetworkUtils.hpp"
+
+namespace Engine {
+// Minimal HTTP/1.0 endpoint that serves the metrics registry in the Prometheus text format on GET /metrics
+class ENGINE_API NetworkMetricsServer : public std::enable_shared_from_this<NetworkMetricsServer> {
+public:
+    explicit NetworkMetricsServer(asio::io_service& service, const std::string& address, uint16_t port);
+    ~NetworkMetricsServer();
+
+    void start();
+    void stop();
+
+    [[nodiscard]] uint16_t getPort() const {
+        return localEndpoint.port();
+    }
+
+private:
+    // Anything bigger than this is not a scrape request
+    static constexpr size_t maxRequestSize = 8 * 1024;
+
+    struct Connection {
+        explicit Connection(asio::io_service& service) : socket{service} {
+        }
+
+        asio::ip::tcp::socket socket;
+        asio::streambuf request{maxRequestSize};
+        std::string response;
+    };
+
+    void accept();
+    void read(const std::shared_ptr<Connection>& connection);
+    void write(const std::shared_ptr<Connection>& connection);
+
+    asio::io_service& service;
+    asio::ip::tcp::acceptor acceptor;
+    asio::ip::tcp::endpoint localEndpoint;
+};
+} // namespace Engine
@@ -27,6 +27,8 @@ struct ENGINE_API PacketBytes {
 using PacketBytesPtr = std::shared_ptr<PacketBytes>;
 
 static constexpr size_t maxPacketDataSize = maxPacketSize - AES::ivecLength - sizeof(PacketHeader) - HMAC::resultSize;
+// Largest message split across the reliable packets, the peer sending a longer one is disconnected
+static constexpr size_t maxMessageSize = 16 * 1024 * 1024;
 
 class ENGINE_API NetworkStream {
 public:
@@ -188,3 +188,16 @@ void NetworkUdpClient::onObjectReceived(msgpack::object_handle oh) {
     auto self = shared_from_this();
     strand.post([self, o]() { self->dispatcher.onObjectReceived(self, o); });
 }
+
+bool NetworkUdpClient::acceptsRawMessage(const uint64_t hash) const {
+    return dispatcher.hasRawHandler(hash);
+}
+
+void NetworkUdpClient::onRawMessageReceived(RawMessagePtr raw) {
+    if (!isEstablished()) {
+        return;
+    }
+
+    auto self = shared_from_this();
+    strand.post([self, r = std::move(raw)]() { self->dispatcher.onRawReceived(self, r); });
+}
@@ -30,6 +30,8 @@ private:
     void onDisconnected() override;
     std::shared_ptr<NetworkUdpStream> makeShared() override;
     void onObjectReceived(msgpack::object_handle oh) override;
+    bool acceptsRawMessage(uint64_t hash) const override;
+    void onRawMessageReceived(RawMessagePtr raw) override;
 
     void receive();
 
@@ -88,3 +88,16 @@ void NetworkUdpPeer::onObjectReceived(msgpack::object_handle oh) {
     auto self = shared_from_this();
     strand.post([self, o]() { self->dispatcher.onObjectReceived(self, o); });
 }
+
+bool NetworkUdpPeer::acceptsRawMessage(const uint64_t hash) const {
+    return dispatcher.hasRawHandler(hash);
+}
+
+void NetworkUdpPeer::onRawMessageReceived(RawMessagePtr raw) {
+    if (!isEstablished()) {
+        return;
+    }
+
+    auto self = shared_from_this();
+    strand.post([self, r = std::move(raw)]() { self->dispatcher.onRawReceived(self, r); });
+}
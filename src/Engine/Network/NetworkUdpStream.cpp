@@ -1,5 +1,6 @@
 #include "NetworkUdpStream.hpp"
 #include "../Utils/Log.hpp"
+#include "../Utils/Metrics.hpp"
 #include "../Utils/StringUtils.hpp"
 
 using namespace Engine;
@@ -11,6 +12,15 @@ static auto ackTimerDeadline = 10;
 static auto pingTimerInterval = std::chrono::milliseconds{1000};
 static auto pingTimeoutMs = std::chrono::milliseconds{3000};
 
+// Totals across all of the streams in this process, per stream totals are kept in the stream itself
+static auto& metricPacketsSent = Metrics::getInstance().counter("network_packets_sent_total", "Data packets queued");
+static auto& metricPacketsReceived =
+    Metrics::getInstance().counter("network_packets_received_total", "Data packets received");
+static auto& metricBytesSent = Metrics::getInstance().counter("network_bytes_sent_total", "Data bytes queued");
+static auto& metricBytesReceived = Metrics::getInstance().counter("network_bytes_received_total", "Bytes received");
+static auto& metricPacketsResent =
+    Metrics::getInstance().counter("network_packets_resent_total", "Reliable packets resent after a missing ack");
+
 static uint64_t getTimeNowMs() {
     const auto now = std::chrono::steady_clock::now().time_since_epoch();
     return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
@@ -118,6 +128,9 @@ static bool isPacketDataSizeValid(const PacketBytesPtr& packet) {
 }
 
 void NetworkUdpStream::onReceive(const PacketBytesPtr& packet) {
+    totalBytesReceived += packet->size();
+    metricBytesReceived.add(packet->size());
+
     // Is it public key?
     if (ECDH::isPublicKey({reinterpret_cast<const char*>(packet->data()), packet->size()})) {
         if (sharedSecret.empty()) {
@@ -170,6 +183,7 @@ void NetworkUdpStream::onReceive(const PacketBytesPtr& packet) {
 
 void NetworkUdpStream::receivePacketUnreliable(const PacketBytesPtr& packet) {
     ++totalReceived;
+    metricPacketsReceived.add();
 
     bool verify{false};
     const auto length =
@@ -182,8 +196,7 @@ void NetworkUdpStream::receivePacketUnreliable(const PacketBytesPtr& packet) {
         return;
     }
 
-    auto oh = msgpack::unpack(reinterpret_cast<const char*>(plaintext.data()), length);
-    receiveObject(std::move(oh));
+    receiveMessage(reinterpret_cast<const char*>(plaintext.data()), length);
 }
 
 void NetworkUdpStream::receivePacketReliable(const PacketBytesPtr& packet) {
@@ -226,7 +239,10 @@ void NetworkUdpStream::receivePacketReliable(const PacketBytesPtr& packet) {
         auto& p = receiveQueue.at(index);
         if (p.length) {
             ++totalReceived;
-            consumePacket(p);
+            metricPacketsReceived.add();
+            if (!consumePacket(p)) {
+                return;
+            }
         } else {
             break;
         }
@@ -240,19 +256,71 @@ void NetworkUdpStream::receivePacketReliable(const PacketBytesPtr& packet) {
     }*/
 }
 
-void NetworkUdpStream::consumePacket(const ReceiveQueueItem& packet) {
+bool NetworkUdpStream::consumePacket(const ReceiveQueueItem& packet) {
     // logger.debug("Consume packet size: {}", packet.length);
 
-    unp.reserve_buffer(packet.length);
-    std::memcpy(unp.buffer(), packet.buffer.data(), packet.length);
-    unp.buffer_consumed(packet.length);
+    const auto* data = reinterpret_cast<const char*>(packet.buffer.data());
 
-    msgpack::object_handle oh{};
-    while (unp.next(oh)) {
-        // logger.info("Got msgpack object!");
-        receiveObject(std::move(oh));
-        oh = msgpack::object_handle{};
+    // Only a message split across packets is assembled in a separate buffer, the rest is read from the packet
+    auto start = static_cast<size_t>(0);
+    if (!pending.empty()) {
+        pending.insert(pending.end(), data, data + packet.length);
+
+        // Continues from the end of the previous packet, the bytes received before are not walked again
+        const auto size = pendingParser.parse(pending.data(), pending.size());
+        if (size != 0) {
+            receiveMessage(pending.data(), size);
+
+            // The message ends in this packet, whatever follows it is read from the packet
+            start = packet.length - (pending.size() - size);
+            pending.clear();
+        }
+    }
+
+    if (pending.empty()) {
+        const auto consumed = consumeMessages(data + start, packet.length - start);
+        pending.assign(data + start + consumed, data + packet.length);
+    }
+
+    // Whatever is left is the start of a single message, a declared length of the strings or arrays
+    // must not let the peer grow the buffer without a limit
+    if (pending.size() > maxMessageSize || pendingParser.getRequired() > maxMessageSize) {
+        logger.warn("UDP connection received message larger than: {} bytes", maxMessageSize);
+        pending.clear();
+        pending.shrink_to_fit();
+        pendingParser.reset();
+        sendClosePacket();
+        forceClosed();
+        return false;
     }
+
+    return true;
+}
+
+size_t NetworkUdpStream::consumeMessages(const char* data, const size_t length) {
+    // The parser keeps the state of an incomplete message at the end, it becomes the pending one
+    size_t offset{0};
+    while (offset < length) {
+        const auto size = pendingParser.parse(data + offset, length - offset);
+        if (size == 0) {
+            break;
+        }
+
+        receiveMessage(data + offset, size);
+        offset += size;
+    }
+    return offset;
+}
+
+void NetworkUdpStream::receiveMessage(const char* data, const size_t length) {
+    // Messages with a raw handler skip the object tree, the handler decodes the bytes by itself
+    uint64_t hash{0};
+    if (RawMessage::peekHash(data, length, hash) && acceptsRawMessage(hash)) {
+        onRawMessageReceived(std::make_shared<RawMessage>(data, length));
+        return;
+    }
+
+    receiveObject(msgpack::unpack(data, length));
 }
 
 void NetworkUdpStream::receiveObject(msgpack::object_handle oh) {
@@ -379,6 +447,9 @@ void NetworkUdpStream::enqueuePacket(const PacketBytesPtr& packet) {
 
     ++sendQueueSize;
     ++totalSent;
+    totalBytesSent += packet->size();
+    metricPacketsSent.add();
+    metricBytesSent.add(packet->size());
 
     auto self = makeShared();
     strand.post([self, packet]() {
@@ -486,6 +557,8 @@ void NetworkUdpStream::processQueue() {
         } else if (packet.time % ackTimerResentInterval == (ackTimerResentInterval - 1)) {
             // Resend!
             logger.warn("Resending packet: {}", i);
+            ++totalResent;
+            metricPacketsResent.add();
             sendPacket(packet.buffer);
         }
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Crypto/ECDH.hpp"
+#include "../Stream/MsgpackReader.hpp"
 #include "../Utils/MemoryPool.hpp"
 #include "NetworkMessage.hpp"
 #include "NetworkPacket.hpp"
@@ -38,6 +39,18 @@ public:
         return totalReceived.load();
     }
 
+    uint64_t getTotalBytesSent() const {
+        return totalBytesSent.load();
+    }
+
+    uint64_t getTotalBytesReceived() const {
+        return totalBytesReceived.load();
+    }
+
+    uint64_t getTotalResent() const {
+        return totalResent.load();
+    }
+
     bool isConnected() const override {
         return isEstablished();
     }
@@ -84,7 +97,9 @@ private:
     void sendPong(const PacketBytesPtr& packet);
     void receivePacketReliable(const PacketBytesPtr& packet);
     void receivePacketUnreliable(const PacketBytesPtr& packet);
-    void consumePacket(const ReceiveQueueItem& packet);
+    bool consumePacket(const ReceiveQueueItem& packet);
+    size_t consumeMessages(const char* data, size_t length);
+    void receiveMessage(const char* data, size_t length);
     void startSendQueue();
     void processQueue();
     void receiveObject(msgpack::object_handle oh);
@@ -94,6 +109,8 @@ private:
     virtual void onDisconnected() = 0;
     virtual std::shared_ptr<NetworkUdpStream> makeShared() = 0;
     virtual void onObjectReceived(msgpack::object_handle oh) = 0;
+    virtual bool acceptsRawMessage(uint64_t hash) const = 0;
+    virtual void onRawMessageReceived(RawMessagePtr raw) = 0;
 
     ECDH ecdh{};
     std::string publicKey;
@@ -107,6 +124,9 @@ private:
     std::atomic<uint64_t> sendQueueSize{0};
     std::atomic<uint64_t> totalSent{0};
     std::atomic<uint64_t> totalReceived{0};
+    std::atomic<uint64_t> totalBytesSent{0};
+    std::atomic<uint64_t> totalBytesReceived{0};
+    std::atomic<uint64_t> totalResent{0};
 
     uint32_t sequenceNum{0};
     uint32_t ackNum{0};
@@ -121,6 +141,9 @@ private:
     uint32_t receiveNum{0};
     asio::steady_timer ackTimer;
     asio::steady_timer pingTimer;
-    msgpack::unpacker unp;
+    // The start of a message that continues in the next packets
+    std::vector<char> pending;
+    // Where the walk of the pending message stopped, the next packet continues from there
+    MsgpackSizeParser pendingParser;
 };
 } // namespace Engine
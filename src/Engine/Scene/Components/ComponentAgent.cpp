@@ -1,14 +1,69 @@
 #include "ComponentAgent.hpp"
+#include "../Controllers/ControllerPathfinding.hpp"
 #include "../Scene.hpp"
 
 using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
+AgentSpatialIndex::AgentSpatialIndex(const float cellSize) : cellSize{cellSize} {
+}
+
+void AgentSpatialIndex::clear() {
+    entities.clear();
+    ranges.clear();
+}
+
+void AgentSpatialIndex::add(const EntityId entity, const Vector3& position) {
+    entities.push_back({entity, position});
+}
+
+Vector3i AgentSpatialIndex::getCell(const Vector3& position) const {
+    return Vector3i{glm::floor(position / cellSize)};
+}
+
+uint64_t AgentSpatialIndex::getCellKey(const Vector3i& cell) {
+    // 21 bits per axis, enough for +-1M cells
+    static constexpr uint64_t mask = (1ULL << 21) - 1;
+    return ((static_cast<uint64_t>(cell.x) & mask) << 42) | ((static_cast<uint64_t>(cell.y) & mask) << 21) |
+           (static_cast<uint64_t>(cell.z) & mask);
+}
+
+void AgentSpatialIndex::build() {
+    // Sorted by the cell, so the entities of a single cell are next to each other
+    std::vector<std::pair<uint64_t, uint32_t>> order;
+    order.reserve(entities.size());
+    for (size_t i = 0; i < entities.size(); i++) {
+        order.emplace_back(getCellKey(getCell(entities[i].position)), static_cast<uint32_t>(i));
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<AgentObservable> sorted;
+    sorted.reserve(entities.size());
+    ranges.clear();
+    for (const auto& [key, index] : order) {
+        if (ranges.empty() || ranges.back().key != key) {
+            ranges.push_back({key, static_cast<uint32_t>(sorted.size()), static_cast<uint32_t>(sorted.size())});
+        }
+        sorted.push_back(entities[index]);
+        ranges.back().end = static_cast<uint32_t>(sorted.size());
+    }
+    entities = std::move(sorted);
+}
+
+const AgentSpatialIndex::CellRange* AgentSpatialIndex::findCell(const uint64_t key) const {
+    const auto it = std::lower_bound(
+        ranges.begin(), ranges.end(), key, [](const CellRange& range, const uint64_t k) { return range.key < k; });
+    if (it == ranges.end() || it->key != key) {
+        return nullptr;
+    }
+    return &*it;
+}
+
 BehaviorTree::Composite::~Composite() = default;
 
 void BehaviorTree::Selector::start() {
-    logger.warn("Selector start");
+    logger.debug("Selector start");
 }
 
 void BehaviorTree::Selector::update(const float delta, AgentState& state) {
@@ -28,17 +83,17 @@ void BehaviorTree::Selector::update(const float delta, AgentState& state) {
         }
         case Status::Success: {
             // Child has completed, return immediately
-            logger.warn("Selector success");
+            logger.debug("Selector success");
             status = Status::Success;
             selected = 0;
             return;
         }
         default: { // Idle or failure
             // Child has failed, we need to try the next child
-            logger.warn("Selector child failure status: {}", int(child->getStatus()));
+            logger.debug("Selector child failure status: {}", int(child->getStatus()));
             selected += 1;
             if (selected >= children.size()) {
-                logger.warn("Selector failure");
+                logger.debug("Selector failure");
                 selected = 0;
                 status = Status::Failure;
             }
@@ -48,7 +103,7 @@ void BehaviorTree::Selector::update(const float delta, AgentState& state) {
     }
 
     status = Status::Running;
-    logger.warn("Selector choose next: {}", selected);
+    logger.debug("Selector choose next: {}", selected);
 
     // Selector will try each child in a sequence and will return immediately
     // when ANY of the children succeed.
@@ -62,7 +117,7 @@ void BehaviorTree::Selector::update(const float delta, AgentState& state) {
         // On success return immediately
         if (child->getStatus() == Status::Success) {
             status = Status::Success;
-            logger.warn("Selector success");
+            logger.debug("Selector success");
             selected = 0;
             break;
         }
@@ -84,7 +139,7 @@ void BehaviorTree::Selector::update(const float delta, AgentState& state) {
 }
 
 void BehaviorTree::Sequence::start() {
-    logger.warn("Sequence start");
+    logger.debug("Sequence start");
 }
 
 void BehaviorTree::Sequence::update(const float delta, AgentState& state) {
@@ -113,13 +168,13 @@ void BehaviorTree::Sequence::update(const float delta, AgentState& state) {
             status = Status::Success;
             selected = 0;
         }
-        logger.warn("Sequence success selected: {}", selected);
+        logger.debug("Sequence success selected: {}", selected);
         return;
     }
     default: { // Idle or failure
         // Child has failed, return immediately
         status = Status::Failure;
-        logger.warn("Sequence failure child status: {}", int(child->getStatus()));
+        logger.debug("Sequence failure child status: {}", int(child->getStatus()));
         return;
     }
     }
@@ -127,7 +182,7 @@ void BehaviorTree::Sequence::update(const float delta, AgentState& state) {
 
 void BehaviorTree::update(const float delta, AgentState& state) {
     if (root.getStatus() == Status::Idle) {
-        logger.warn("BehaviorTree root is idle");
+        logger.debug("BehaviorTree root is idle");
         root.start();
     }
     root.update(delta, state);
@@ -138,82 +193,108 @@ public:
     virtual ~ActionPatrol() = default;
 
     void start() override {
-        logger.warn("ActionPatrol start");
+        logger.debug("ActionPatrol start");
     }
     void update(const float delta, AgentState& state) override {
         if (!state.shipControl) {
-            logger.warn("ActionPatrol ship control is none");
+            logger.debug("ActionPatrol ship control is none");
             status = BehaviorTree::Status::Failure;
             return;
         }
 
-        // Choose random entity to visit
+        // Choose random entity to visit, around the obstacles if the sector is navigable
         if (status != BehaviorTree::Status::Running) {
-            // const auto right = Vector3{state.transform.getAbsoluteTransform() * Vector4{1.0f, 0.0f, 0.0f, 0.0f}};
-            // const auto top = Vector3{state.transform.getAbsoluteTransform() * Vector4{0.0f, 1.0f, 0.0f, 0.0f}};
-            // const auto forward = glm::cross(right, top);
-
-            /*Vector3 direction{0.0f, 0.0f, 1.0f};
-
-            std::uniform_real_distribution<float> distDistance{1000.0f, 5000.0f};
-            std::uniform_real_distribution<float> distAxis{-10000.0f, 10000.0f};
-            std::uniform_real_distribution<float> distAngle{0.0f, glm::radians(60.0f)};
-
-            const auto half = glm::radians(30.0f);
-
-            direction = glm::rotate(direction, distAngle(state.world.rng) - half, Vector3{1.0f, 0.0f, 0.0f});
-            direction = glm::rotate(direction, distAngle(state.world.rng) - half, Vector3{0.0f, 1.0f, 0.0f});
-
-            const auto distance = distDistance(state.world.rng);
-
-            direction *= distance;
-
-            auto position = state.position + direction;
-
-            // If the position is too far from the center then choose random position near the center
-            if (glm::length(position) > 10000.0f) {
-                position = Vector3{
-                    distAxis(state.world.rng),
-                    distAxis(state.world.rng),
-                    distAxis(state.world.rng),
-                };
-            }*/
-
-            std::uniform_real_distribution<float> distAxis{-10000.0f, 10000.0f};
-            const auto position = Vector3{
-                distAxis(state.world.rng),
-                distAxis(state.world.rng),
-                distAxis(state.world.rng),
-            };
+            const auto position = choosePosition(state);
+            logger.debug("ActionPatrol chosen pos: {}", position);
+            waypoints.clear();
+            next = 0;
+            goal = position;
+
+            auto* pathfinding = state.world.pathfinding;
+            if (pathfinding && pathfinding->getOctree().isBuilt()) {
+                ticket = pathfinding->requestPath(state.position, position);
+                status = BehaviorTree::Status::Running;
+                return;
+            }
 
-            logger.warn("ActionPatrol chosen pos: {}", position);
+            ticket = 0;
             state.shipControl->actionMoveTo(position);
-
-            /*auto chosen = state.world.entities.end();
-            auto maxToCheck = std::min<size_t>(state.world.entities.size(), 64);
-            for (auto test = state.world.entities.begin(); test != state.world.entities.end(); test++) {
-                // Discard if the entity is us
-                if (test->entity == state.entity) {
-                    continue;
-                }
-
-                // Discard if the distance is too short
-                if (glm::distance(test->position, state.position) < 500.0f) {
-                    continue;
-                }
-
-                const auto dir = glm::dot(forward, test.position - state.position);
-            }*/
         }
 
         status = BehaviorTree::Status::Running;
+        if (ticket != 0 && !receivePath(state)) {
+            return;
+        }
+
         if (state.shipControl->getAction() != ShipAutopilotAction::MoveTo) {
-            logger.warn("ActionPatrol move done");
+            if (++next < waypoints.size()) {
+                state.shipControl->actionMoveTo(waypoints[next]);
+                return;
+            }
+            logger.debug("ActionPatrol move done");
             status = BehaviorTree::Status::Success;
         }
     }
 
 private:
+    static constexpr float visitRadius = 5000.0f;
+    static constexpr float visitMinDistance = 500.0f;
+
+    // Returns false while the path is not there yet
+    bool receivePath(AgentState& state) {
+        const auto* result = state.world.pathfinding->getResult(ticket);
+        if (!result) {
+            if (!state.world.pathfinding->isPending(ticket)) {
+                logger.debug("ActionPatrol path expired");
+                status = BehaviorTree::Status::Failure;
+            }
+            return false;
+        }
+
+        ticket = 0;
+        if (result->path) {
+            // The first waypoint is where the agent was at the time of the request
+            waypoints.assign(std::next(result->path->begin()), result->path->end());
+        } else {
+            // Either end may be inside of the occupied cells, such as next to a station
+            logger.debug("ActionPatrol no path found, flying straight");
+            waypoints.assign(1, goal);
+        }
+        state.shipControl->actionMoveTo(waypoints.front());
+        return false;
+    }
+
+    Vector3 choosePosition(AgentState& state) {
+        // Visit one of the entities around us, the snapshot is ordered by cells so the choice is deterministic
+        candidates.clear();
+        state.world.spatial.forEachInRadius(state.position, visitRadius, [&](const AgentObservable& observable) {
+            if (observable.entity != state.entity &&
+                glm::distance2(observable.position, state.position) >= visitMinDistance * visitMinDistance) {
+                candidates.push_back(observable.position);
+            }
+        });
+
+        if (!candidates.empty()) {
+            std::uniform_int_distribution<size_t> distIndex{0, candidates.size() - 1};
+            std::uniform_real_distribution<float> distOffset{-visitMinDistance / 2.0f, visitMinDistance / 2.0f};
+            const auto& chosen = candidates[distIndex(state.rng)];
+            return chosen + Vector3{distOffset(state.rng), distOffset(state.rng), distOffset(state.rng)};
+        }
+
+        // Nothing nearby, fly somewhere around the center of the sector
+        std::uniform_real_distribution<float> distAxis{-10000.0f, 10000.0f};
+        return Vector3{
+            distAxis(state.rng),
+            distAxis(state.rng),
+            distAxis(state.rng),
+        };
+    }
+
+    std::vector<Vector3> candidates;
+    ControllerPathfinding::Ticket ticket{0};
+    Vector3 goal{0.0f};
+    std::vector<Vector3> waypoints;
+    size_t next{0};
 };
 
 class ActionKeepIdle : public BehaviorTree::Node {
@@ -221,12 +302,12 @@ public:
     virtual ~ActionKeepIdle() = default;
 
     void start() override {
-        logger.warn("ActionKeepIdle start");
+        logger.debug("ActionKeepIdle start");
     }
     void update(const float delta, AgentState& state) override {
         if (status != BehaviorTree::Status::Running) {
             std::uniform_real_distribution<float> dist{5.0f, 30.0f};
-            time = dist(state.world.rng);
+            time = dist(state.rng);
         }
 
         status = BehaviorTree::Status::Running;
@@ -244,7 +325,10 @@ BehaviorTree::BehaviorTree() = default;
 
 BehaviorTree::~BehaviorTree() = default;
 
-ComponentAgent::ComponentAgent(EntityId entity) : Component{entity}, bt{std::make_unique<BehaviorTree>()} {
+ComponentAgent::ComponentAgent(EntityId entity) :
+    Component{entity},
+    bt{std::make_unique<BehaviorTree>()},
+    rng{static_cast<uint64_t>(entity) * 0x9E3779B97F4A7C15ULL + 1} {
     auto& root = bt->getRoot();
 
     { // Behavior: patrol
@@ -254,15 +338,18 @@ ComponentAgent::ComponentAgent(EntityId entity) : Component{entity}, bt{std::mak
     }
 }
 
-void ComponentAgent::update(const float delta, Scene& scene, AgentWorldState& worldState,
-                            ComponentTransform& transform) {
+void ComponentAgent::update(Scene& scene, const AgentWorldState& worldState, ComponentTransform& transform) {
     auto* shipControl = scene.tryGetComponent<ComponentShipControl>(getEntity());
     AgentState state{
         getEntity(),
         transform.getAbsolutePosition(),
         worldState,
+        rng,
         transform,
         shipControl,
     };
+
+    const auto delta = pending;
+    pending = 0.0f;
     bt->update(delta, state);
 }
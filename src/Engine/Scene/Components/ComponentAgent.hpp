@@ -6,21 +6,97 @@
 namespace Engine {
 class ENGINE_API ComponentShipControl;
 class ENGINE_API ComponentTransform;
+class ENGINE_API ControllerPathfinding;
 
 struct ENGINE_API AgentObservable {
     EntityId entity;
     Vector3 position;
 };
 
-struct ENGINE_API AgentWorldState {
-    std::mt19937_64& rng;
+// Snapshot of the root entities taken once per tick, bucketed into a uniform grid so the perception of an agent
+// only looks at its neighbourhood. It is read only while the agents run, so they can share it between threads.
+class ENGINE_API AgentSpatialIndex {
+public:
+    explicit AgentSpatialIndex(float cellSize = 1000.0f);
+
+    void clear();
+    void add(EntityId entity, const Vector3& position);
+    // Must be called after all entities are added and before any query
+    void build();
+
+    template <typename Fn> void forEachInRadius(const Vector3& center, const float radius, Fn&& fn) const {
+        const auto radius2 = radius * radius;
+        const auto min = getCell(center - Vector3{radius});
+        const auto max = getCell(center + Vector3{radius});
+
+        // Too many cells to look at, a linear pass is cheaper
+        const auto cells = static_cast<int64_t>(max.x - min.x + 1) * (max.y - min.y + 1) * (max.z - min.z + 1);
+        if (cells > static_cast<int64_t>(ranges.size())) {
+            for (const auto& entity : entities) {
+                if (glm::distance2(entity.position, center) <= radius2) {
+                    fn(entity);
+                }
+            }
+            return;
+        }
+
+        for (auto x = min.x; x <= max.x; x++) {
+            for (auto y = min.y; y <= max.y; y++) {
+                for (auto z = min.z; z <= max.z; z++) {
+                    const auto* range = findCell(getCellKey({x, y, z}));
+                    if (!range) {
+                        continue;
+                    }
+                    for (auto i = range->begin; i < range->end; i++) {
+                        if (glm::distance2(entities[i].position, center) <= radius2) {
+                            fn(entities[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] const std::vector<AgentObservable>& getEntities() const {
+        return entities;
+    }
+
+private:
+    struct CellRange {
+        uint64_t key{0};
+        uint32_t begin{0};
+        uint32_t end{0};
+    };
+
+    [[nodiscard]] Vector3i getCell(const Vector3& position) const;
+    [[nodiscard]] static uint64_t getCellKey(const Vector3i& cell);
+    [[nodiscard]] const CellRange* findCell(uint64_t key) const;
+
+    float cellSize;
     std::vector<AgentObservable> entities;
+    std::vector<CellRange> ranges;
+};
+
+// Moves the agent into a closer or further distance tier of the scheduler
+enum class AgentPriority {
+    Low = 0,
+    Normal,
+    High,
 };
 
+struct ENGINE_API AgentWorldState {
+    const AgentSpatialIndex& spatial;
+    // None in the scenes without navigation
+    ControllerPathfinding* pathfinding;
+};
+
+// Behaviour nodes may run on any thread in parallel with other agents, they must only modify the components of
+// their own agent and must not create or destroy entities.
 struct ENGINE_API AgentState {
     EntityId entity;
     Vector3 position;
-    AgentWorldState& world;
+    const AgentWorldState& world;
+    std::mt19937_64& rng;
     ComponentTransform& transform;
     ComponentShipControl* shipControl;
 };
@@ -108,9 +184,26 @@ public:
     explicit ComponentAgent(EntityId entity);
     COMPONENT_DEFAULTS(ComponentAgent);
 
-    void update(float delta, Scene& scene, AgentWorldState& worldState, ComponentTransform& transform);
+    // Agents are not updated on every tick, the time of the skipped ticks is accumulated and given to the next update
+    void addPendingTime(const float delta) {
+        pending += delta;
+    }
+
+    void update(Scene& scene, const AgentWorldState& worldState, ComponentTransform& transform);
+
+    void setPriority(const AgentPriority value) {
+        priority = value;
+    }
+
+    [[nodiscard]] AgentPriority getPriority() const {
+        return priority;
+    }
 
 private:
     std::unique_ptr<BehaviorTree> bt;
+    // Seeded from the entity, so the decisions do not depend on the order in which the agents run
+    std::mt19937_64 rng;
+    float pending{0.0f};
+    AgentPriority priority{AgentPriority::Normal};
 };
 } // namespace Engine
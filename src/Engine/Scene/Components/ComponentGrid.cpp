@@ -1,6 +1,7 @@
 #include "ComponentGrid.hpp"
 #include "../../File/MsgpackFileReader.hpp"
 #include "../../File/TebFileHeader.hpp"
+#include "../../Graphics/MeshOptimizer.hpp"
 #include <btBulletDynamicsCommon.h>
 
 using namespace Engine;
@@ -129,9 +130,29 @@ void ComponentGrid::recalculate(VulkanRenderer& vulkan, const VoxelShapeCache& v
         return;
     }
 
+    // The faces of the neighbouring voxels do not share the edges, only the sloppy simplification can reduce them
+    MeshOptimizeOptions options{};
+    options.lods = 3;
+    options.sloppy = true;
+    options.deduplicate = true;
+    auto optimized = optimizeMesh(data.vertices, data.indices, options);
+
+    std::vector<VoxelShape::VertexQuantized> vertices;
+    vertices.reserve(data.vertices.size());
+    for (const auto& v : data.vertices) {
+        vertices.push_back({
+            v.position,
+            quantizeSnorm(v.normal),
+            v.texCoords,
+            quantizeSnorm(v.tangent),
+        });
+    }
+
+    const auto indices = packIndices(data.indices, vertices.size(), mesh.indexType);
+
     VulkanBuffer::CreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = data.vertices.size() * sizeof(VoxelShape::VertexFinal);
+    bufferInfo.size = vertices.size() * sizeof(VoxelShape::VertexQuantized);
     bufferInfo.usage =
         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -139,15 +160,16 @@ void ComponentGrid::recalculate(VulkanRenderer& vulkan, const VoxelShapeCache& v
     bufferInfo.memoryFlags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
 
     mesh.vbo = vulkan.createBuffer(bufferInfo);
-    vulkan.copyDataToBuffer(mesh.vbo, data.vertices.data(), bufferInfo.size);
+    vulkan.copyDataToBuffer(mesh.vbo, vertices.data(), bufferInfo.size);
 
-    bufferInfo.size = data.indices.size() * sizeof(uint32_t);
+    bufferInfo.size = indices.size() * sizeof(uint8_t);
     bufferInfo.usage =
         VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
     mesh.ibo = vulkan.createBuffer(bufferInfo);
-    vulkan.copyDataToBuffer(mesh.ibo, data.indices.data(), bufferInfo.size);
+    vulkan.copyDataToBuffer(mesh.ibo, indices.data(), bufferInfo.size);
 
-    mesh.count = data.indices.size();
-    mesh.indexType = VkIndexType::VK_INDEX_TYPE_UINT32;
+    mesh.count = optimized.lods.front().count;
+    mesh.lods = std::move(optimized.lods);
+    mesh.radius = optimized.radius;
 }
@@ -6,18 +6,19 @@
 namespace Engine {
 class ENGINE_API ComponentModel : public Component {
 public:
+    // Quantized by the Model::load, the position stays in full precision
     struct Vertex {
         Vector3 position;
-        Vector3 normal;
-        Vector2 texCoords;
-        Vector4 tangent;
+        Vector4b normal;
+        Vector2h texCoords;
+        Vector4b tangent;
 
         static VulkanVertexLayoutMap getLayout() {
             return {
                 {0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)},
-                {1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
-                {2, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoords)},
-                {3, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, tangent)},
+                {1, VK_FORMAT_R8G8B8A8_SNORM, offsetof(Vertex, normal)},
+                {2, VK_FORMAT_R16G16_SFLOAT, offsetof(Vertex, texCoords)},
+                {3, VK_FORMAT_R8G8B8A8_SNORM, offsetof(Vertex, tangent)},
             };
         };
     };
@@ -10,6 +10,7 @@ ComponentTransform::ComponentTransform(EntityId entity) : Component{entity} {
 
 void ComponentTransform::setParent(const ComponentTransform* value) {
     parent = value;
+    worldDirty = true;
     if (parent) {
         parentId = static_cast<uint64_t>(parent->getEntity());
     } else {
@@ -51,8 +52,20 @@ void ComponentTransform::scale(const Vector3& value) {
     setTransform(glm::scale(transform, value));
 }
 
+bool ComponentTransform::isWorldCached() const {
+    for (const auto* t = this; t; t = t->getParent()) {
+        if (t->worldDirty || !t->worldCached) {
+            return false;
+        }
+    }
+    return true;
+}
+
 Matrix4 ComponentTransform::getAbsoluteTransform() const {
     if (const auto p = getParent()) {
+        if (isWorldCached()) {
+            return absolute;
+        }
         return p->getAbsoluteTransform() * getTransform();
     }
     return getTransform();
@@ -60,6 +73,9 @@ Matrix4 ComponentTransform::getAbsoluteTransform() const {
 
 Matrix4 ComponentTransform::getAbsoluteInterpolatedTransform() const {
     if (const auto p = getParent()) {
+        if (isWorldCached()) {
+            return absoluteInterpolated;
+        }
         return p->getAbsoluteInterpolatedTransform() * getInterpolatedTransform();
     }
     return getInterpolatedTransform();
@@ -71,6 +87,7 @@ void ComponentTransform::setTransform(const Matrix4& value) {
         setWorldTransform(rigidBody->getRigidBody()->getWorldTransform());
     } else {
         transform = value;
+        worldDirty = true;
     }
 }
 
@@ -116,20 +133,10 @@ bool ComponentTransform::isKinematic() const {
     return flags & static_cast<uint64_t>(TransformFlags::Kinematic);
 }
 
-void ComponentTransform::interpolate() {
-    if (glm::distance2(transformInterpolated[3], transform[3]) > 50 * 50) {
-        transformInterpolated = transform;
-    } else {
-        const auto previousPos = transformInterpolated[3];
-        const auto previousRot = glm::quat_cast(transformInterpolated);
-
-        const auto rotDiff = glm::slerp(previousRot, glm::quat_cast(transform), 0.5f);
-
-        transformInterpolated = glm::toMat4(rotDiff);
-        transformInterpolated[3] = glm::mix(previousPos, transform[3], 0.5f);
-        transformInterpolated[3].w = 1.0f;
-    }
+void ComponentTransform::setInterpolatedTransform(const Matrix4& value) {
+    transformInterpolated = value;
     interpolated = true;
+    worldDirty = true;
 }
 
 void ComponentTransform::setScene(Scene& value) {
@@ -154,6 +161,7 @@ void ComponentTransform::setWorldTransform(const btTransform& worldTrans) {
     worldTrans.getOpenGLMatrix(&mat[0][0]);
     mat = glm::scale(mat, Vector3{rigidBody->getScale()});
     transform = mat;
+    worldDirty = true;
     scene->setDirty(*this);
     scene->setDirty(*rigidBody);
 }
@@ -7,6 +7,7 @@ class btRigidBody;
 
 namespace Engine {
 class ENGINE_API ComponentRigidBody;
+class ENGINE_API ControllerTransform;
 
 enum class TransformFlags : uint64_t {
     Static = 1ULL << 0,
@@ -43,7 +44,9 @@ public:
 
     void scale(const Vector3& value);
 
+    // The caller may modify the matrix, so the cached absolute matrices of this subtree are no longer trusted
     [[nodiscard]] Matrix4& getTransform() {
+        worldDirty = true;
         return transform;
     }
 
@@ -83,7 +86,8 @@ public:
     void setKinematic(bool value);
     bool isKinematic() const;
 
-    void interpolate();
+    // The matrix rendered in place of the replicated one, see SnapshotBuffer
+    void setInterpolatedTransform(const Matrix4& value);
 
     void setScene(Scene& value);
     void setRigidBody(ComponentRigidBody& value);
@@ -91,6 +95,11 @@ public:
     MSGPACK_DEFINE_ARRAY(transform, flags, parentId);
 
 private:
+    friend class ControllerTransform;
+
+    // The absolute matrices computed by ControllerTransform are only valid if nothing up the chain changed since
+    [[nodiscard]] bool isWorldCached() const;
+
     void getWorldTransform(btTransform& worldTrans) const override;
     void setWorldTransform(const btTransform& worldTrans) override;
 
@@ -101,6 +110,10 @@ private:
     uint64_t parentId{NullParentId};
     uint64_t flags{0};
     bool interpolated{false};
+    Matrix4 absolute{1.0f};
+    Matrix4 absoluteInterpolated{1.0f};
+    bool worldDirty{true};
+    bool worldCached{false};
 
     Scene* scene{nullptr};
     ComponentRigidBody* rigidBody{nullptr};
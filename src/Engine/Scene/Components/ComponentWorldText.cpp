@@ -1,5 +1,4 @@
 #include "ComponentWorldText.hpp"
-#include <utf8cpp/utf8.h>
 
 using namespace Engine;
 
@@ -11,6 +10,19 @@ ComponentWorldText::ComponentWorldText(EntityId entity, const FontFamily& font,
 }
 
 void ComponentWorldText::recalculate(VulkanRenderer& vulkan) {
+    // Glyphs were evicted from the font atlas, the UVs need to be rebuilt
+    if (font && generation != font->getGeneration()) {
+        vertices.clear();
+        glyphPages.clear();
+        for (const auto& label : labels) {
+            addVertices(label);
+        }
+        dirty = true;
+    }
+
+    // The retained vertices sample the atlas on every frame
+    TextRun::touchPages(glyphPages);
+
     if (!dirty) {
         return;
     }
@@ -37,35 +49,41 @@ void ComponentWorldText::recalculate(VulkanRenderer& vulkan) {
 
 void ComponentWorldText::reset() {
     vertices.clear();
+    glyphPages.clear();
+    labels.clear();
     dirty = true;
 }
 
 void ComponentWorldText::add(const Vector3& pos, const std::string& text) {
-    auto it = text.c_str();
-    const auto end = it + text.size();
-
-    const auto& fontFace = font->get(FontType::Regular);
+    labels.push_back({pos, text});
+    addVertices(labels.back());
+    dirty = true;
+}
 
-    auto pen = -fontFace.getPenOffset(text, font->getSize(), textAlign);
-    pen += offset;
+void ComponentWorldText::addVertices(const Label& label) {
+    // Labels are names, the markup of the GUI does not apply to them
+    const auto& run = font->shape(label.text, height * 2.0f, false);
 
     const auto scale = (static_cast<float>(height) / static_cast<float>(font->getSize())) * 2.0f;
+    const auto bounds = Vector2{run.advance / scale, static_cast<float>(font->getSize())};
+
+    auto pen = -bounds * textAlignToVector(textAlign);
+    pen += offset;
 
-    while (it < end) {
-        const auto code = utf8::next(it, end);
-        const auto& glyph = fontFace.getGlyph(code);
+    vertices.reserve(vertices.size() + run.glyphs.size());
+    for (const auto& page : run.pages) {
+        TextRun::addPage(glyphPages, page);
+    }
 
-        vertices.emplace_back();
-        auto& dst = vertices.back();
+    for (const auto& glyph : run.glyphs) {
+        auto& dst = vertices.emplace_back();
 
-        dst.position = pos;
-        dst.offset = pen + Vector2{0.0f, glyph.ascend * scale + (height - glyph.size.y * scale)};
-        dst.size = glyph.size * scale;
+        dst.position = label.pos;
+        dst.offset = pen + glyph.pos + Vector2{0.0f, height};
+        dst.size = glyph.size;
         dst.uv = glyph.uv;
         dst.st = glyph.st;
-
-        pen += Vector2{glyph.advance * scale, 0.0f};
     }
 
-    dirty = true;
+    generation = font->getGeneration();
 }
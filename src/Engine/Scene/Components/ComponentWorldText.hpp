@@ -44,12 +44,22 @@ public:
     }
 
 private:
+    struct Label {
+        Vector3 pos;
+        std::string text;
+    };
+
+    void addVertices(const Label& label);
+
     bool dirty{false};
+    uint64_t generation{0};
     const FontFamily* font{nullptr};
     Color4 color;
     float height;
     Mesh mesh;
     std::vector<Vertex> vertices;
+    std::vector<TextRun::Page> glyphPages;
+    std::vector<Label> labels;
     Vector2 offset;
     TextAlign textAlign{TextAlign::Center};
 };
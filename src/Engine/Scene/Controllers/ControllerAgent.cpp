@@ -1,33 +1,176 @@
 #include "ControllerAgent.hpp"
+#include "../../Utils/Worker.hpp"
+#include "../Scene.hpp"
+#include "ControllerPathfinding.hpp"
+#include <atomic>
 
 using namespace Engine;
 
-ControllerAgent::ControllerAgent(Scene& scene, entt::registry& reg) :
-    scene{scene}, reg{reg}, rng{std::random_device()()} {
+static auto logger = createLogger(LOG_FILENAME);
+
+// Ordered from the closest, the distances are squared when compared
+static const std::array<ControllerAgent::Tier, 3> tiers = {
+    ControllerAgent::Tier{5000.0f, 1},
+    ControllerAgent::Tier{20000.0f, 4},
+    ControllerAgent::Tier{50000.0f, 8},
+};
+
+// Agents are handed to the threads in chunks, so the atomic counter is not touched for every agent
+static constexpr size_t chunkSize = 64;
+
+// Shared by all scenes, the sectors are updated one after another
+static BackgroundWorker& getAgentWorkers() {
+    static BackgroundWorker workers{std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1};
+    return workers;
+}
+
+ControllerAgent::ControllerAgent(Scene& scene, entt::registry& reg, const size_t threads) :
+    scene{scene},
+    reg{reg},
+    threads{threads == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : threads} {
 }
 
 ControllerAgent::~ControllerAgent() = default;
 
-void ControllerAgent::update(const float delta) {
-    std::vector<AgentObservable> others;
+void ControllerAgent::addObserver(const EntityId entity) {
+    if (std::find(observers.begin(), observers.end(), entity) == observers.end()) {
+        observers.push_back(entity);
+    }
+}
+
+void ControllerAgent::removeObserver(const EntityId entity) {
+    observers.erase(std::remove(observers.begin(), observers.end(), entity), observers.end());
+}
+
+void ControllerAgent::updateSpatial() {
+    spatial.clear();
     auto&& everyone = reg.view<ComponentTransform>(entt::exclude<TagDisabled>).each();
     for (auto&& [entity, transform] : everyone) {
         if (transform.getParent()) {
             continue;
         }
+        spatial.add(entity, transform.getPosition());
+    }
+    spatial.build();
 
-        auto& other = others.emplace_back();
-        other.entity = entity;
-        other.position = transform.getPosition();
+    observerPositions.clear();
+    observers.erase(std::remove_if(observers.begin(),
+                                   observers.end(),
+                                   [this](const EntityId entity) { return !reg.valid(entity); }),
+                    observers.end());
+    for (const auto entity : observers) {
+        if (const auto* transform = reg.try_get<ComponentTransform>(entity); transform) {
+            observerPositions.push_back(transform->getAbsolutePosition());
+        }
     }
+}
 
-    AgentWorldState worldState{
-        rng,
-    };
+static uint32_t getTierInterval(const float distance2) {
+    for (const auto& tier : tiers) {
+        if (distance2 <= tier.distance * tier.distance) {
+            return tier.interval;
+        }
+    }
+    return ControllerAgent::idleInterval;
+}
+
+uint32_t ControllerAgent::getInterval(const Vector3& position, const AgentPriority priority) const {
+    auto closest = std::numeric_limits<float>::max();
+    for (const auto& observer : observerPositions) {
+        closest = std::min(closest, glm::distance2(observer, position));
+    }
+
+    // The intervals stay powers of two, so the staggering by the entity index still covers every tick
+    const auto interval = getTierInterval(closest);
+    switch (priority) {
+    case AgentPriority::High: {
+        return std::max<uint32_t>(interval / 4, 1);
+    }
+    case AgentPriority::Low: {
+        return interval * 2;
+    }
+    default: {
+        return interval;
+    }
+    }
+}
+
+void ControllerAgent::update(const float delta) {
+    updateSpatial();
+
+    scheduled.clear();
 
     auto&& entities = reg.view<ComponentTransform, ComponentAgent>(entt::exclude<TagDisabled>).each();
     for (auto&& [entity, transform, agent] : entities) {
-        agent.update(delta, scene, worldState, transform);
+        agent.addPendingTime(delta);
+
+        // The entity index staggers the agents of the same tier across the ticks
+        const auto interval = getInterval(transform.getAbsolutePosition(), agent.getPriority());
+        if ((tick + entt::to_entity(entity)) % interval == 0) {
+            scheduled.push_back({&agent, &transform});
+        }
+    }
+
+    runScheduled();
+    ++tick;
+}
+
+void ControllerAgent::runScheduled() {
+    auto* pathfinding =
+        scene.hasController<ControllerPathfinding>() ? &scene.getController<ControllerPathfinding>() : nullptr;
+    const AgentWorldState worldState{spatial, pathfinding};
+
+    const auto chunks = (scheduled.size() + chunkSize - 1) / chunkSize;
+    const auto helpers = std::min(threads, chunks) - (chunks > 0 ? 1 : 0);
+
+    if (helpers == 0) {
+        for (const auto& item : scheduled) {
+            item.agent->update(scene, worldState, *item.transform);
+        }
+        return;
+    }
+
+    // The helpers may start after all chunks are done, so the state they touch must outlive this call
+    struct Shared {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::exception_ptr error;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    const auto work = [this, chunks, &worldState](Shared& s) {
+        for (auto chunk = s.next++; chunk < chunks; chunk = s.next++) {
+            try {
+                const auto end = std::min((chunk + 1) * chunkSize, scheduled.size());
+                for (auto i = chunk * chunkSize; i < end; i++) {
+                    scheduled[i].agent->update(scene, worldState, *scheduled[i].transform);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock{s.mutex};
+                if (!s.error) {
+                    s.error = std::current_exception();
+                }
+            }
+
+            if (++s.done == chunks) {
+                std::lock_guard<std::mutex> lock{s.mutex};
+                s.cv.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 0; i < helpers; i++) {
+        getAgentWorkers().post([shared, work]() { work(*shared); });
+    }
+    work(*shared);
+
+    std::unique_lock<std::mutex> lock{shared->mutex};
+    shared->cv.wait(lock, [&]() { return shared->done.load() == chunks; });
+
+    if (shared->error) {
+        std::rethrow_exception(shared->error);
     }
 }
 
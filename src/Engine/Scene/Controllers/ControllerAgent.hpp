@@ -4,9 +4,21 @@
 #include "../Entity.hpp"
 
 namespace Engine {
+// Runs the behaviour trees of the agents. Agents close to an observer (a player) are updated on every tick,
+// the ones further away only on every few ticks, spread evenly across the ticks. The priority of an agent
+// shortens or stretches the interval of its distance tier. The scheduled agents run
+// in parallel against a spatial snapshot of the scene taken at the start of the tick.
 class ENGINE_API ControllerAgent : public Controller {
 public:
-    explicit ControllerAgent(Scene& scene, entt::registry& reg);
+    struct Tier {
+        float distance;
+        uint32_t interval;
+    };
+
+    // Agents further than the last tier, or all agents when nobody observes the scene, use this interval
+    static constexpr uint32_t idleInterval = 16;
+
+    explicit ControllerAgent(Scene& scene, entt::registry& reg, size_t threads = 1);
     ~ControllerAgent() override;
     NON_COPYABLE(ControllerAgent);
     NON_MOVEABLE(ControllerAgent);
@@ -14,9 +26,30 @@ public:
     void update(float delta) override;
     void recalculate(VulkanRenderer& vulkan) override;
 
+    void addObserver(EntityId entity);
+    void removeObserver(EntityId entity);
+
+    [[nodiscard]] size_t getScheduledCount() const {
+        return scheduled.size();
+    }
+
 private:
+    struct Scheduled {
+        ComponentAgent* agent;
+        ComponentTransform* transform;
+    };
+
+    void updateSpatial();
+    uint32_t getInterval(const Vector3& position, AgentPriority priority) const;
+    void runScheduled();
+
     Scene& scene;
     entt::registry& reg;
-    std::mt19937_64 rng;
+    size_t threads;
+    uint64_t tick{0};
+    std::vector<EntityId> observers;
+    std::vector<Vector3> observerPositions;
+    AgentSpatialIndex spatial;
+    std::vector<Scheduled> scheduled;
 };
 } // namespace Engine
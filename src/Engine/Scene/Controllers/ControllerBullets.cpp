@@ -4,37 +4,52 @@ using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
-ControllerBullets::ControllerBullets(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld) :
-    scene{scene}, reg{reg}, dynamicsWorld{dynamicsWorld} {
+ControllerBullets::ControllerBullets(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld,
+                                     const Config& config, const bool authoritative) :
+    scene{scene},
+    reg{reg},
+    dynamicsWorld{dynamicsWorld},
+    tickLength{static_cast<float>(config.tickLengthUs.count()) / 1000000.0f},
+    authoritative{authoritative} {
 }
 
 ControllerBullets::~ControllerBullets() {
 }
 
 void ControllerBullets::update(const float delta) {
-    for (auto& bullet : bullets) {
-        if (bullet.lifetime <= 0.0f) {
-            continue;
-        }
+    ++tick;
+    events.tick = tick;
+
+    for (size_t i = 0; i < bullets.size(); i++) {
+        advance(bullets[i], ids[i], delta);
+    }
+}
+
+void ControllerBullets::advance(ComponentTurret::BulletInstance& bullet, const uint32_t id, const float delta) {
+    if (bullet.lifetime <= 0.0f) {
+        return;
+    }
 
-        bullet.lifetime -= delta;
+    bullet.lifetime -= delta;
 
-        const auto advance = bullet.direction * bullet.speed * delta;
+    const auto advance = bullet.direction * bullet.speed * delta;
 
+    if (authoritative) {
         DynamicsWorld::RayCastResult rayCastResult;
         dynamicsWorld.rayCast(bullet.origin, bullet.origin + advance, rayCastResult);
 
         if (rayCastResult) {
             bullet.lifetime = 0.0f;
             bullet.size = 0.0f;
-            continue;
+            events.hits.push_back({id, rayCastResult.hitPos});
+            return;
         }
+    }
 
-        bullet.origin += advance;
+    bullet.origin += advance;
 
-        if (bullet.lifetime < 0.0f) {
-            bullet.size = 0.0f;
-        }
+    if (bullet.lifetime < 0.0f) {
+        bullet.size = 0.0f;
     }
 }
 
@@ -59,11 +74,80 @@ void ControllerBullets::recalculate(VulkanRenderer& vulkan) {
     }
 }
 
-ComponentTurret::BulletInstance& ControllerBullets::allocateBullet() {
-    for (auto& bullet : bullets) {
-        if (bullet.lifetime <= 0.0f) {
-            return bullet;
+size_t ControllerBullets::allocate(const uint32_t id) {
+    size_t index = 0;
+    while (index < bullets.size() && bullets[index].lifetime > 0.0f) {
+        ++index;
+    }
+
+    if (index == bullets.size()) {
+        bullets.emplace_back();
+        ids.push_back(0);
+    } else {
+        indexes.erase(ids[index]);
+    }
+
+    ids[index] = id;
+    indexes[id] = index;
+    return index;
+}
+
+uint32_t ControllerBullets::fire(const EntityId turret, const Vector3& origin, const Vector3& direction,
+                                 const float speed, const float lifetime, const float size) {
+    const auto id = nextId++;
+
+    auto& bullet = bullets[allocate(id)];
+    bullet.origin = origin;
+    bullet.direction = direction;
+    bullet.speed = speed;
+    bullet.lifetime = lifetime;
+    bullet.size = size;
+
+    events.fired.push_back({id, turret, origin, direction, speed, lifetime, size});
+    return id;
+}
+
+const ComponentTurret::BulletInstance* ControllerBullets::findBullet(const uint32_t id) const {
+    const auto it = indexes.find(id);
+    if (it == indexes.end() || bullets[it->second].lifetime <= 0.0f) {
+        return nullptr;
+    }
+    return &bullets[it->second];
+}
+
+void ControllerBullets::resetEvents() {
+    events.fired.clear();
+    events.hits.clear();
+}
+
+void ControllerBullets::receiveEvents(const Events& value) {
+    // A late batch is caught up to the newest one, so the bullets do not lag behind the scene
+    const auto behind = lastReceivedTick > value.tick ? lastReceivedTick - value.tick : 0;
+    lastReceivedTick = std::max(lastReceivedTick, value.tick);
+
+    for (const auto& fire : value.fired) {
+        const auto index = allocate(fire.id);
+        auto& bullet = bullets[index];
+        bullet.origin = fire.origin;
+        bullet.direction = fire.direction;
+        bullet.speed = fire.speed;
+        bullet.lifetime = fire.lifetime;
+        bullet.size = fire.size;
+
+        for (uint64_t t = 0; t < behind; t++) {
+            advance(bullet, fire.id, tickLength);
         }
     }
-    return bullets.emplace_back();
+
+    for (const auto& hit : value.hits) {
+        const auto it = indexes.find(hit.id);
+        if (it == indexes.end()) {
+            continue;
+        }
+
+        auto& bullet = bullets[it->second];
+        bullet.origin = hit.position;
+        bullet.lifetime = 0.0f;
+        bullet.size = 0.0f;
+    }
 }
@@ -1,12 +1,18 @@
 #pragma once
 
+#include "../../Server/Messages.hpp"
 #include "../Controller.hpp"
 #include "../DynamicsWorld.hpp"
 
 namespace Engine {
+// Bullets are not entities, they are simulated on both sides from the fire events. Only the authoritative
+// side (the server) tests them for hits, the clients remove them once the hit event arrives.
 class ENGINE_API ControllerBullets : public Controller {
 public:
-    explicit ControllerBullets(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld);
+    using Events = MessageSceneBulletsEvent;
+
+    explicit ControllerBullets(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld, const Config& config,
+                               bool authoritative);
     ~ControllerBullets() override;
     NON_COPYABLE(ControllerBullets);
     NON_MOVEABLE(ControllerBullets);
@@ -22,14 +28,46 @@ public:
         return bullets.size();
     }
 
-    ComponentTurret::BulletInstance& allocateBullet();
+    // Spawns a new bullet and queues its fire event, the server side only
+    uint32_t fire(EntityId turret, const Vector3& origin, const Vector3& direction, float speed, float lifetime,
+                  float size);
+    // Returns the bullet if it is still flying
+    const ComponentTurret::BulletInstance* findBullet(uint32_t id) const;
+
+    bool isAuthoritative() const {
+        return authoritative;
+    }
+
+    // The events of the current tick, sent to every player of the sector and then reset
+    bool hasEvents() const {
+        return !events.fired.empty() || !events.hits.empty();
+    }
+    const Events& getEvents() const {
+        return events;
+    }
+    void resetEvents();
+
+    // Replays the events of the server on the client
+    void receiveEvents(const Events& value);
 
 private:
+    size_t allocate(uint32_t id);
+    void advance(ComponentTurret::BulletInstance& bullet, uint32_t id, float delta);
+
     Scene& scene;
     entt::registry& reg;
     DynamicsWorld& dynamicsWorld;
+    float tickLength;
+    bool authoritative;
 
     std::vector<ComponentTurret::BulletInstance> bullets;
+    // Id of the bullet in the same slot, the instances are uploaded as they are to the GPU
+    std::vector<uint32_t> ids;
+    std::unordered_map<uint32_t, size_t> indexes;
+    uint32_t nextId{1};
+    uint64_t tick{0};
+    uint64_t lastReceivedTick{0};
+    Events events;
     VulkanDoubleBuffer vbo;
 };
 } // namespace Engine
@@ -0,0 +1,272 @@
+#include "ControllerCheckpoint.hpp"
+#include "../Scene.hpp"
+#include <btBulletDynamicsCommon.h>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+template <typename... Ts> static uint32_t countComponents(const entt::registry& reg, const entt::entity handle) {
+    return (static_cast<uint32_t>(reg.all_of<Ts>(handle)) + ...);
+}
+
+// A body packed before it had a shape holds no transform
+static bool isRigidBodyPacked(const msgpack::object& obj) {
+    return obj.type == msgpack::type::ARRAY && obj.via.array.size == 6 &&
+           obj.via.array.ptr[2].type != msgpack::type::NIL;
+}
+
+ControllerCheckpoint::ControllerCheckpoint(Scene& scene, entt::registry& reg) : scene{scene}, reg{reg} {
+    registerComponent<ComponentTransform>();
+    registerComponent<ComponentRigidBody>();
+    registerComponent<ComponentModel>();
+    registerComponent<ComponentModelSkinned>();
+    registerComponent<ComponentIcon>();
+    registerComponent<ComponentLabel>();
+    registerComponent<ComponentGrid>();
+    registerComponent<ComponentTurret>();
+    registerComponent<ComponentShipControl>();
+    reg.on_destroy<entt::entity>().connect<&ControllerCheckpoint::onDestroyEntity>(this);
+}
+
+ControllerCheckpoint::~ControllerCheckpoint() {
+    unregisterComponent<ComponentTransform>();
+    unregisterComponent<ComponentRigidBody>();
+    unregisterComponent<ComponentModel>();
+    unregisterComponent<ComponentModelSkinned>();
+    unregisterComponent<ComponentIcon>();
+    unregisterComponent<ComponentLabel>();
+    unregisterComponent<ComponentGrid>();
+    unregisterComponent<ComponentTurret>();
+    unregisterComponent<ComponentShipControl>();
+    reg.on_destroy<entt::entity>().disconnect<&ControllerCheckpoint::onDestroyEntity>(this);
+}
+
+void ControllerCheckpoint::update(const float delta) {
+    (void)delta;
+}
+
+void ControllerCheckpoint::recalculate(VulkanRenderer& vulkan) {
+    (void)vulkan;
+}
+
+template <typename T> void ControllerCheckpoint::registerComponent() {
+    reg.on_construct<T>().template connect<&ControllerCheckpoint::onChange>(this);
+    reg.on_update<T>().template connect<&ControllerCheckpoint::onChange>(this);
+}
+
+template <typename T> void ControllerCheckpoint::unregisterComponent() {
+    reg.on_construct<T>().template disconnect<&ControllerCheckpoint::onChange>(this);
+    reg.on_update<T>().template disconnect<&ControllerCheckpoint::onChange>(this);
+}
+
+void ControllerCheckpoint::onChange(entt::registry& r, const entt::entity handle) {
+    (void)r;
+    if (!restoring) {
+        changed.insert(handle);
+    }
+}
+
+void ControllerCheckpoint::onDestroyEntity(entt::registry& r, const entt::entity handle) {
+    (void)r;
+    changed.erase(handle);
+    if (!restoring && !isTransient(handle)) {
+        removed.insert(handle);
+    }
+    transient.erase(handle);
+}
+
+bool ControllerCheckpoint::isTransient(const entt::entity handle) const {
+    if (transient.find(handle) != transient.end()) {
+        return true;
+    }
+
+    // Children such as turrets belong to whoever owns the root of the transform hierarchy
+    const auto* transform = reg.try_get<ComponentTransform>(handle);
+    while (transform && transform->getParent()) {
+        transform = transform->getParent();
+        if (transient.find(transform->getEntity()) != transient.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ControllerCheckpoint::setTransient(const EntityId handle) {
+    transient.insert(handle);
+    changed.erase(handle);
+}
+
+void ControllerCheckpoint::reset() {
+    changed.clear();
+    removed.clear();
+}
+
+template <typename T>
+void ControllerCheckpoint::packComponent(msgpack::packer<msgpack::sbuffer>& packer, const entt::entity handle) {
+    if (const auto* component = reg.try_get<T>(handle); component) {
+        packer.pack_array(2);
+        packer.pack(EntityComponentIds::value<T>);
+        packer.pack(*component);
+    }
+}
+
+ControllerCheckpoint::Snapshot ControllerCheckpoint::takeSnapshot() {
+    Snapshot snapshot{};
+    snapshot.entities.reserve(changed.size());
+    snapshot.removed.assign(removed.begin(), removed.end());
+
+    for (const auto handle : changed) {
+        if (!reg.valid(handle) || isTransient(handle)) {
+            continue;
+        }
+
+        auto& entity = snapshot.entities.emplace_back();
+        entity.handle = handle;
+        entity.count = countComponents<ComponentTransform,
+                                       ComponentRigidBody,
+                                       ComponentModel,
+                                       ComponentModelSkinned,
+                                       ComponentIcon,
+                                       ComponentLabel,
+                                       ComponentTurret,
+                                       ComponentShipControl>(reg, handle);
+
+        msgpack::packer<msgpack::sbuffer> packer{entity.components};
+        packComponent<ComponentTransform>(packer, handle);
+        packComponent<ComponentRigidBody>(packer, handle);
+        packComponent<ComponentModel>(packer, handle);
+        packComponent<ComponentModelSkinned>(packer, handle);
+        packComponent<ComponentIcon>(packer, handle);
+        packComponent<ComponentLabel>(packer, handle);
+        packComponent<ComponentTurret>(packer, handle);
+        packComponent<ComponentShipControl>(packer, handle);
+
+        if (const auto* grid = reg.try_get<ComponentGrid>(handle); grid) {
+            entity.grid.emplace(static_cast<const Grid&>(*grid));
+        }
+    }
+
+    reset();
+    return snapshot;
+}
+
+msgpack::sbuffer ControllerCheckpoint::Snapshot::Entity::pack() const {
+    msgpack::sbuffer sbuf;
+    msgpack::packer<msgpack::sbuffer> packer{sbuf};
+    packer.pack_array(count + (grid ? 1 : 0));
+    sbuf.write(components.data(), components.size());
+
+    // Same layout as ComponentGrid, an array holding the grid
+    if (grid) {
+        packer.pack_array(2);
+        packer.pack(EntityComponentIds::value<ComponentGrid>);
+        packer.pack_array(1);
+        packer.pack(*grid);
+    }
+
+    return sbuf;
+}
+
+template <typename T>
+void ControllerCheckpoint::unpackComponent(const entt::entity handle, const msgpack::object& obj) {
+    auto* component = reg.try_get<T>(handle);
+    if (!component) {
+        component = &reg.emplace<T>(handle);
+        component->postUnpack(handle);
+    }
+    obj.convert(*component);
+    scene.setDirty(*component);
+}
+
+void ControllerCheckpoint::restore(const EntityId handle, const msgpack::object& obj) {
+    static const std::unordered_map<uint32_t, UnpackerFunction> unpackers = {
+        {EntityComponentIds::value<ComponentTransform>, &ControllerCheckpoint::unpackComponent<ComponentTransform>},
+        {EntityComponentIds::value<ComponentRigidBody>, &ControllerCheckpoint::unpackComponent<ComponentRigidBody>},
+        {EntityComponentIds::value<ComponentModel>, &ControllerCheckpoint::unpackComponent<ComponentModel>},
+        {EntityComponentIds::value<ComponentModelSkinned>,
+         &ControllerCheckpoint::unpackComponent<ComponentModelSkinned>},
+        {EntityComponentIds::value<ComponentIcon>, &ControllerCheckpoint::unpackComponent<ComponentIcon>},
+        {EntityComponentIds::value<ComponentLabel>, &ControllerCheckpoint::unpackComponent<ComponentLabel>},
+        {EntityComponentIds::value<ComponentGrid>, &ControllerCheckpoint::unpackComponent<ComponentGrid>},
+        {EntityComponentIds::value<ComponentTurret>, &ControllerCheckpoint::unpackComponent<ComponentTurret>},
+        {EntityComponentIds::value<ComponentShipControl>,
+         &ControllerCheckpoint::unpackComponent<ComponentShipControl>},
+    };
+
+    if (obj.type != msgpack::type::ARRAY) {
+        EXCEPTION("Checkpoint of entity: {} is not an array", handle);
+    }
+
+    restoring = true;
+
+    // The entities created by the sector template keep their ids, anything else is created with its old id
+    auto entity = handle;
+    if (!reg.valid(handle)) {
+        entity = reg.create(handle);
+        if (entity != handle) {
+            logger.warn("Checkpoint entity: {} was restored with a different id: {}", handle, entity);
+        }
+    }
+
+    try {
+        const msgpack::object* rigidBodyState{nullptr};
+
+        for (size_t i = 0; i < obj.via.array.size; i++) {
+            const auto& pair = obj.via.array.ptr[i];
+            if (pair.type != msgpack::type::ARRAY || pair.via.array.size != 2) {
+                EXCEPTION("Checkpoint of entity: {} has a bad component at: {}", handle, i);
+            }
+
+            const auto id = pair.via.array.ptr[0].as<uint32_t>();
+            const auto found = unpackers.find(id);
+            if (found != unpackers.end()) {
+                (this->*(found->second))(entity, pair.via.array.ptr[1]);
+            } else {
+                logger.warn("Unmatched checkpoint component id: {} entity id: {}", id, handle);
+            }
+
+            if (id == EntityComponentIds::value<ComponentRigidBody>) {
+                rigidBodyState = &pair.via.array.ptr[1];
+            }
+        }
+
+        // The body of an entity that is not in the template is created only once its model or grid is unpacked,
+        // the velocity and the transform are applied again now that it exists
+        auto* rigidBody = reg.try_get<ComponentRigidBody>(entity);
+        if (rigidBodyState && rigidBody && rigidBody->getRigidBody() && isRigidBodyPacked(*rigidBodyState)) {
+            rigidBodyState->convert(*rigidBody);
+        }
+    } catch (...) {
+        restoring = false;
+        throw;
+    }
+
+    restoring = false;
+}
+
+bool ControllerCheckpoint::restoreRemoved(const EntityId handle) {
+    if (!reg.valid(handle)) {
+        return false;
+    }
+
+    restoring = true;
+    reg.destroy(handle);
+    restoring = false;
+    return true;
+}
+
+void ControllerCheckpoint::restoreFinish() {
+    for (auto&& [entity, transform] : reg.view<ComponentTransform>().each()) {
+        if (transform.getParentId() == ComponentTransform::NullParentId) {
+            continue;
+        }
+
+        const auto parent = static_cast<EntityId>(transform.getParentId());
+        if (const auto* other = reg.try_get<ComponentTransform>(parent); other) {
+            transform.setParent(other);
+        } else {
+            logger.warn("Failed to find parent transform id: {} for child: {}", transform.getParentId(), entity);
+        }
+    }
+}
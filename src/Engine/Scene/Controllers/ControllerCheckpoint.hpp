@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../Controller.hpp"
+#include "../Entity.hpp"
+#include "../Grid.hpp"
+#include <unordered_set>
+
+namespace Engine {
+// Tracks which entities had any of their replicated components changed, so a checkpoint only contains
+// the entities that changed since the previous one. Every entity is packed as an array of [id, component] pairs.
+class ENGINE_API ControllerCheckpoint : public Controller {
+public:
+    struct Snapshot {
+        struct Entity {
+            EntityId handle{NullEntity};
+            // The small components are packed right away as [id, component] pairs
+            uint32_t count{0};
+            msgpack::sbuffer components;
+            // Copying the nodes of a grid is much cheaper than packing them, the grid is packed by pack()
+            std::optional<Grid> grid;
+
+            // Packs the whole entity, safe to call from any thread
+            [[nodiscard]] msgpack::sbuffer pack() const;
+        };
+
+        std::vector<Entity> entities;
+        std::vector<EntityId> removed;
+    };
+
+    explicit ControllerCheckpoint(Scene& scene, entt::registry& reg);
+    ~ControllerCheckpoint() override;
+    NON_COPYABLE(ControllerCheckpoint);
+    NON_MOVEABLE(ControllerCheckpoint);
+
+    void update(float delta) override;
+    void recalculate(VulkanRenderer& vulkan) override;
+
+    // Copies the changed entities and starts tracking from scratch, must be called between two ticks
+    Snapshot takeSnapshot();
+    // Forgets the changes made so far, the entities created by the sector template are recreated on every load
+    void reset();
+    void restore(EntityId handle, const msgpack::object& obj);
+    // Returns false if the entity does not exist, its tombstone is no longer needed
+    bool restoreRemoved(EntityId handle);
+    // Resolves the transform parents once all entities are restored
+    void restoreFinish();
+    // Transient entities (and the entities parented to them) are never checkpointed, ie. player ships
+    void setTransient(EntityId handle);
+
+    [[nodiscard]] size_t getChangedCount() const {
+        return changed.size() + removed.size();
+    }
+
+private:
+    using UnpackerFunction = void (ControllerCheckpoint::*)(entt::entity, const msgpack::object&);
+
+    template <typename T> void registerComponent();
+    template <typename T> void unregisterComponent();
+    template <typename T> void packComponent(msgpack::packer<msgpack::sbuffer>& packer, entt::entity handle);
+    template <typename T> void unpackComponent(entt::entity handle, const msgpack::object& obj);
+
+    void onChange(entt::registry& r, entt::entity handle);
+    void onDestroyEntity(entt::registry& r, entt::entity handle);
+    bool isTransient(entt::entity handle) const;
+
+    Scene& scene;
+    entt::registry& reg;
+    std::unordered_set<EntityId> changed;
+    std::unordered_set<EntityId> removed;
+    std::unordered_set<EntityId> transient;
+    bool restoring{false};
+};
+} // namespace Engine
@@ -1,6 +1,7 @@
 #include "ControllerNetwork.hpp"
 #include "../../Network/NetworkStream.hpp"
 #include "../../Server/Messages.hpp"
+#include "../../Stream/MsgpackReader.hpp"
 #include "../Scene.hpp"
 #include <bitset>
 #include <btBulletDynamicsCommon.h>
@@ -9,6 +10,13 @@ using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
+static bool referenceAll(msgpack::type::object_type type, size_t size, void* userData) {
+    (void)type;
+    (void)size;
+    (void)userData;
+    return true;
+}
+
 ControllerNetwork::ControllerNetwork(Scene& scene, entt::registry& reg) : scene{scene}, reg{reg} {
     registerComponent<ComponentTransform>();
     registerComponent<ComponentRigidBody>();
@@ -26,7 +34,7 @@ ControllerNetwork::~ControllerNetwork() {
 }
 
 void ControllerNetwork::update(const float delta) {
-    (void)delta;
+    time += delta;
 }
 
 void ControllerNetwork::recalculate(VulkanRenderer& vulkan) {
@@ -68,9 +76,9 @@ void ControllerNetwork::postEmplaceComponent(const uint64_t remoteId, const entt
 
     if (component.getParentId() != ComponentTransform::NullParentId) {
         logger.warn("Emplace component transform with parent");
-        auto local = remoteToLocal.find(static_cast<entt::entity>(component.getParentId()));
-        if (local != remoteToLocal.end()) {
-            const auto transform = reg.try_get<ComponentTransform>(local->second);
+        const auto local = remoteToLocal.find(static_cast<entt::entity>(component.getParentId()));
+        if (local != NullEntity) {
+            const auto transform = reg.try_get<ComponentTransform>(local);
             if (transform) {
                 component.setParent(transform);
             } else {
@@ -87,6 +95,7 @@ void ControllerNetwork::postEmplaceComponent(const uint64_t remoteId, const entt
         }
     }
 
+    snapshots.push(handle, receivedTime, std::as_const(component).getTransform());
     scene.setDirty(component);
 }
 
@@ -141,6 +150,14 @@ void ControllerNetwork::postPatchComponent(const uint64_t remoteId, const entt::
     scene.setDirty(component);
 }
 
+template <>
+void ControllerNetwork::postPatchComponent(const uint64_t remoteId, const entt::entity handle,
+                                           ComponentTransform& component) {
+    (void)remoteId;
+    snapshots.push(handle, receivedTime, std::as_const(component).getTransform());
+    scene.setDirty(component);
+}
+
 template <typename Packer, typename Type>
 void ControllerNetwork::packComponent(Packer& packer, entt::entity handle, const Type& component,
                                       const SyncOperation op) {
@@ -158,6 +175,8 @@ void ControllerNetwork::sendComponents(NetworkStream& peer, const ComponentRefer
 
     NetworkStream::Writer writer{peer, PacketType::DataReliable};
     writer.start<MessageSceneUpdateEvent>(0);
+    writer.pack_array(2);
+    writer.pack(time);
     writer.pack_array(count);
     for (size_t i = 0; i < count; i++) {
         packComponent(writer, std::get<0>(components.at(i)), *std::get<1>(components.at(i)), op);
@@ -188,8 +207,13 @@ void ControllerNetwork::packComponents(NetworkStream& peer, const View& view, co
 }
 
 template <typename T>
-void ControllerNetwork::unpackComponent(const uint64_t remoteId, const entt::entity handle, const msgpack::object& obj,
+void ControllerNetwork::unpackComponent(const uint64_t remoteId, const entt::entity handle, const std::string_view raw,
                                         const SyncOperation op) {
+    // Only the component itself is unpacked into an object, the strings and binaries point into the message
+    size_t offset{0};
+    bool referenced{false};
+    const auto obj = msgpack::unpack(zone, raw.data(), raw.size(), offset, referenced, &referenceAll);
+
     if (op == SyncOperation::Emplace) {
         auto& component = reg.emplace<T>(handle);
         component.postUnpack(handle);
@@ -206,23 +230,31 @@ void ControllerNetwork::unpackComponent(const uint64_t remoteId, const entt::ent
     }
 }
 
-void ControllerNetwork::unpackComponentId(const uint32_t id, const uint64_t remoteId, const entt::entity handle,
-                                          const msgpack::object& obj, const SyncOperation op) {
-    static std::unordered_map<uint32_t, UnpackerFunction> unpackers = {
-        {EntityComponentIds::value<ComponentTransform>, &ControllerNetwork::unpackComponent<ComponentTransform>},
-        {EntityComponentIds::value<ComponentRigidBody>, &ControllerNetwork::unpackComponent<ComponentRigidBody>},
-        {EntityComponentIds::value<ComponentModel>, &ControllerNetwork::unpackComponent<ComponentModel>},
-        {EntityComponentIds::value<ComponentModelSkinned>, &ControllerNetwork::unpackComponent<ComponentModelSkinned>},
-        {EntityComponentIds::value<ComponentIcon>, &ControllerNetwork::unpackComponent<ComponentIcon>},
-        {EntityComponentIds::value<ComponentLabel>, &ControllerNetwork::unpackComponent<ComponentLabel>},
-        {EntityComponentIds::value<ComponentGrid>, &ControllerNetwork::unpackComponent<ComponentGrid>},
-        {EntityComponentIds::value<ComponentTurret>, &ControllerNetwork::unpackComponent<ComponentTurret>},
-        {EntityComponentIds::value<ComponentShipControl>, &ControllerNetwork::unpackComponent<ComponentShipControl>},
-    };
+const ControllerNetwork::UnpackerTable& ControllerNetwork::getUnpackers() {
+    static const auto unpackers = []() {
+        UnpackerTable table{};
+        const auto add = [&](const uint32_t id, const UnpackerFunction fn) { table.at(id) = fn; };
+        add(EntityComponentIds::value<ComponentTransform>, &ControllerNetwork::unpackComponent<ComponentTransform>);
+        add(EntityComponentIds::value<ComponentRigidBody>, &ControllerNetwork::unpackComponent<ComponentRigidBody>);
+        add(EntityComponentIds::value<ComponentModel>, &ControllerNetwork::unpackComponent<ComponentModel>);
+        add(EntityComponentIds::value<ComponentModelSkinned>,
+            &ControllerNetwork::unpackComponent<ComponentModelSkinned>);
+        add(EntityComponentIds::value<ComponentIcon>, &ControllerNetwork::unpackComponent<ComponentIcon>);
+        add(EntityComponentIds::value<ComponentLabel>, &ControllerNetwork::unpackComponent<ComponentLabel>);
+        add(EntityComponentIds::value<ComponentGrid>, &ControllerNetwork::unpackComponent<ComponentGrid>);
+        add(EntityComponentIds::value<ComponentTurret>, &ControllerNetwork::unpackComponent<ComponentTurret>);
+        add(EntityComponentIds::value<ComponentShipControl>,
+            &ControllerNetwork::unpackComponent<ComponentShipControl>);
+        return table;
+    }();
+    return unpackers;
+}
 
-    const auto found = unpackers.find(id);
-    if (found != unpackers.end()) {
-        (this->*(found->second))(remoteId, handle, obj, op);
+void ControllerNetwork::unpackComponentId(const uint32_t id, const uint64_t remoteId, const entt::entity handle,
+                                          const std::string_view raw, const SyncOperation op) {
+    const auto& unpackers = getUnpackers();
+    if (id < unpackers.size() && unpackers[id]) {
+        (this->*unpackers[id])(remoteId, handle, raw, op);
     } else {
         logger.warn("Unmatched component id: {} entity id: {}", id, static_cast<uint32_t>(handle));
     }
@@ -254,6 +286,8 @@ void ControllerNetwork::sendUpdate(NetworkStream& peer) {
             arraySize = std::min<size_t>(total, 64);
             count = 0;
             writer.start<MessageSceneUpdateEvent>(0);
+            writer.pack_array(2);
+            writer.pack(time);
             writer.pack_array(arraySize);
         }
         ++count;
@@ -296,47 +330,71 @@ void ControllerNetwork::resetUpdates() {
     updatedComponentsCount = 0;
 }
 
-void ControllerNetwork::receiveUpdate(const msgpack::object& obj) {
-    if (obj.type != msgpack::type::ARRAY) {
-        EXCEPTION("Component snapshot is not an array");
+void ControllerNetwork::receiveUpdate(const std::string_view body) {
+    zone.clear();
+
+    MsgpackReader reader{body};
+    if (reader.readArray() != 2) {
+        EXCEPTION("Component snapshot is not an array of time and components");
     }
 
-    const auto& arr = obj.via.array;
-    // logger.debug("Received: {} components", arr.size);
+    receivedTime = reader.readDouble();
+    snapshots.receive(receivedTime, localTime);
 
-    for (size_t i = 0; i < arr.size; i++) {
-        if (arr.ptr[i].type != msgpack::type::ARRAY) {
-            EXCEPTION("Component snapshot children: {} is not an array", i);
-        }
-        const auto& child = arr.ptr[i].via.array;
-        if (child.ptr[0].type != msgpack::type::POSITIVE_INTEGER) {
-            EXCEPTION("Component snapshot children: {} has a bad id", i);
-        }
-        if (child.ptr[2].type != msgpack::type::POSITIVE_INTEGER) {
-            EXCEPTION("Component snapshot children: {} has a bad handle", i);
+    const auto count = reader.readArray();
+    // logger.debug("Received: {} components", count);
+
+    for (size_t i = 0; i < count; i++) {
+        if (reader.readArray() != 4) {
+            EXCEPTION("Component snapshot children: {} is not an array of four elements", i);
         }
-        const auto id = child.ptr[0].as<uint32_t>();
-        const auto op = child.ptr[1].as<SyncOperation>();
-        const auto handle = child.ptr[2].as<EntityId>();
+        const auto id = static_cast<uint32_t>(reader.readUint());
+        const auto op = static_cast<SyncOperation>(reader.readInt());
+        const auto handle = static_cast<EntityId>(reader.readUint());
+        const auto raw = reader.readRaw();
 
         // Map the remote entity ID to a local one
         auto local = remoteToLocal.find(handle);
-        if (local == remoteToLocal.end() && op == SyncOperation::Emplace) {
-            local = remoteToLocal.emplace(handle, reg.create()).first;
-            localToRemote.emplace(local->second, handle);
+        if (local == NullEntity && op == SyncOperation::Emplace) {
+            local = reg.create();
+            remoteToLocal.insert(handle, local);
+            localToRemote.insert(local, handle);
         }
 
-        if (local != remoteToLocal.end()) {
-            unpackComponentId(id, static_cast<uint64_t>(local->first), local->second, child.ptr[3], op);
+        if (local != NullEntity) {
+            unpackComponentId(id, static_cast<uint64_t>(handle), local, raw, op);
         } else {
             logger.warn("Unmatched entity update id: {}", static_cast<uint32_t>(handle));
         }
     }
 }
 
+void ControllerNetwork::interpolate(const float delta) {
+    localTime += delta;
+
+    const auto playoutTime = snapshots.getPlayoutTime(localTime);
+    snapshots.forEach([&](const EntityId entity) {
+        auto* transform = reg.try_get<ComponentTransform>(entity);
+        if (!transform) {
+            return;
+        }
+        if (const auto value = snapshots.sample(entity, playoutTime); value) {
+            transform->setInterpolatedTransform(*value);
+        }
+    });
+}
+
 void ControllerNetwork::onDestroyEntity(entt::registry& r, entt::entity handle) {
     (void)r;
 
+    snapshots.remove(handle);
+
+    const auto remote = localToRemote.find(handle);
+    if (remote != NullEntity) {
+        localToRemote.erase(handle);
+        remoteToLocal.erase(remote);
+    }
+
     const auto it = updatedComponentsMap.find(handle);
     if (it != updatedComponentsMap.end()) {
         updatedComponentsCount -= std::bitset<64>{it->second}.count();
@@ -345,25 +403,17 @@ void ControllerNetwork::onDestroyEntity(entt::registry& r, entt::entity handle)
 }
 
 std::optional<Entity> ControllerNetwork::getRemoteToLocalEntity(const EntityId entity) const {
-    auto local = remoteToLocal.find(entity);
-    if (local != remoteToLocal.end()) {
-        return Entity{reg, local->second};
+    const auto local = remoteToLocal.find(entity);
+    if (local != NullEntity) {
+        return Entity{reg, local};
     }
     return std::nullopt;
 }
 
 EntityId ControllerNetwork::getRemoteToLocal(const EntityId entity) const {
-    auto local = remoteToLocal.find(entity);
-    if (local != remoteToLocal.end()) {
-        return local->second;
-    }
-    return NullEntity;
+    return remoteToLocal.find(entity);
 }
 
 EntityId ControllerNetwork::getLocalToRemote(const EntityId entity) const {
-    auto remote = localToRemote.find(entity);
-    if (remote != localToRemote.end()) {
-        return remote->second;
-    }
-    return NullEntity;
+    return localToRemote.find(entity);
 }
@@ -2,6 +2,8 @@
 
 #include "../Controller.hpp"
 #include "../Entity.hpp"
+#include "../EntityIdMap.hpp"
+#include "../SnapshotBuffer.hpp"
 
 namespace Engine {
 class ENGINE_API NetworkStream;
@@ -26,29 +28,39 @@ public:
 
     void sendFullSnapshot(NetworkStream& peer);
     void sendUpdate(NetworkStream& peer);
-    void receiveUpdate(const msgpack::object& obj);
+    // Decodes the body of MessageSceneUpdateEvent straight from the received bytes
+    void receiveUpdate(std::string_view body);
     void resetUpdates();
+    // Client only, renders the replicated transforms from the snapshot buffer
+    void interpolate(float delta);
     std::optional<Entity> getRemoteToLocalEntity(EntityId entity) const;
     EntityId getRemoteToLocal(EntityId entity) const;
     EntityId getLocalToRemote(EntityId entity) const;
 
+    [[nodiscard]] const SnapshotBuffer& getSnapshotBuffer() const {
+        return snapshots;
+    }
+
 private:
     struct ChildParentValue {
         uint64_t parentId;
         entt::entity child;
     };
 
-    using UnpackerFunction = void (ControllerNetwork::*)(uint64_t, entt::entity, const msgpack::object&,
+    using UnpackerFunction = void (ControllerNetwork::*)(uint64_t, entt::entity, std::string_view,
                                                          const SyncOperation op);
+    // Indexed by the component id, the ids fit the 64 bit mask of the updated components
+    using UnpackerTable = std::array<UnpackerFunction, 64>;
     template <typename T> using ComponentReferences = std::array<std::tuple<entt::entity, const T*>, 64>;
 
     template <typename Type> void postEmplaceComponent(uint64_t remoteId, entt::entity handle, Type& component);
     template <typename Type> void postPatchComponent(uint64_t remoteId, entt::entity handle, Type& component);
 
     template <typename T>
-    void unpackComponent(uint64_t remoteId, entt::entity handle, const msgpack::object& obj, SyncOperation op);
-    void unpackComponentId(const uint32_t id, uint64_t remoteId, entt::entity handle, const msgpack::object& obj,
+    void unpackComponent(uint64_t remoteId, entt::entity handle, std::string_view raw, SyncOperation op);
+    void unpackComponentId(const uint32_t id, uint64_t remoteId, entt::entity handle, std::string_view raw,
                            SyncOperation op);
+    static const UnpackerTable& getUnpackers();
 
     template <typename Packer, typename Type>
     void packComponent(Packer& packer, entt::entity handle, const Type& component, const SyncOperation op);
@@ -86,11 +98,19 @@ private:
 
     Scene& scene;
     entt::registry& reg;
-    std::unordered_map<EntityId, EntityId> remoteToLocal;
-    std::unordered_map<EntityId, EntityId> localToRemote;
+    EntityIdMap remoteToLocal;
+    EntityIdMap localToRemote;
+    // Reused by every decoded component, the strings reference the message bytes instead of being copied
+    msgpack::zone zone;
     std::unordered_map<EntityId, uint64_t> updatedComponentsMap;
     size_t updatedComponentsCount{0};
     std::vector<ChildParentValue> transformChildParentMap;
+    // Simulation time on the server, sent with every update so the client can order and space the samples
+    double time{0.0};
+    // Client side clock advanced by the frames, and the server time of the update being unpacked
+    double localTime{0.0};
+    double receivedTime{0.0};
+    SnapshotBuffer snapshots;
 };
 } // namespace Engine
 
@@ -1,19 +1,82 @@
 #include "ControllerPathfinding.hpp"
 #include "../../Assets/AssetsManager.hpp"
+#include "../../Utils/Worker.hpp"
 #include "../Scene.hpp"
+#include <btBulletDynamicsCommon.h>
 
 using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
-ControllerPathfinding::ControllerPathfinding(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld) :
-    scene{scene}, reg{reg}, dynamicsWorld{dynamicsWorld}, octree{*this, 6, 32} {
+// Searches of a single batch running at the same time, each one owns a search state
+static size_t getBatchWorkerCount() {
+    return std::max<size_t>(std::thread::hardware_concurrency() / 2, 1);
 }
 
-ControllerPathfinding::~ControllerPathfinding() = default;
+// Shared by all scenes, a batch runs in the background across the updates of its scene
+static BackgroundWorker& getPathfindingWorkers() {
+    static BackgroundWorker workers{getBatchWorkerCount()};
+    return workers;
+}
+
+struct ControllerPathfinding::Batch {
+    std::vector<Request> requests;
+    std::vector<PathResult> results;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> running{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::exception_ptr error;
+};
+
+ControllerPathfinding::ControllerPathfinding(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld,
+                                             const Config& config) :
+    scene{scene},
+    reg{reg},
+    dynamicsWorld{dynamicsWorld},
+    octree{*this,
+           static_cast<int>(config.server.pathfindingDepth),
+           static_cast<int>(config.server.pathfindingCellSize),
+           config.server.pathfindingCacheSize} {
+
+    for (size_t i = 0; i < getBatchWorkerCount(); i++) {
+        states.push_back(std::make_unique<Pathfinding::SearchState>());
+    }
+
+    reg.on_construct<ComponentRigidBody>().connect<&ControllerPathfinding::onChange>(this);
+    reg.on_update<ComponentRigidBody>().connect<&ControllerPathfinding::onChange>(this);
+    reg.on_update<ComponentTransform>().connect<&ControllerPathfinding::onChange>(this);
+    reg.on_destroy<ComponentRigidBody>().connect<&ControllerPathfinding::onDestroy>(this);
+}
+
+ControllerPathfinding::~ControllerPathfinding() {
+    reg.on_construct<ComponentRigidBody>().disconnect<&ControllerPathfinding::onChange>(this);
+    reg.on_update<ComponentRigidBody>().disconnect<&ControllerPathfinding::onChange>(this);
+    reg.on_update<ComponentTransform>().disconnect<&ControllerPathfinding::onChange>(this);
+    reg.on_destroy<ComponentRigidBody>().disconnect<&ControllerPathfinding::onDestroy>(this);
+
+    // The searches still running read the octree
+    try {
+        waitBatch();
+    } catch (std::exception& e) {
+        BACKTRACE(e, "Pathfinding batch failed");
+    }
+}
 
 void ControllerPathfinding::update(const float delta) {
     (void)delta;
+
+    ++tick;
+    while (!results.empty() && results.front().tick + resultTicks <= tick) {
+        results.pop_front();
+    }
+
+    // Blocks when the searches take longer than the tick, a batch carried over would make the agents depend on timing
+    waitBatch();
+
+    // The octree is rebuilt only when no search reads it
+    applyChanges();
+    startBatch();
 }
 
 void ControllerPathfinding::recalculate(VulkanRenderer& vulkan) {
@@ -21,9 +84,183 @@ void ControllerPathfinding::recalculate(VulkanRenderer& vulkan) {
 }
 
 void ControllerPathfinding::buildTree() {
+    waitBatch();
+
+    tracked.clear();
+    changed.clear();
+    dirty.clear();
+    for (const auto handle : reg.view<ComponentTransform, ComponentRigidBody>()) {
+        if (const auto bounds = getBounds(handle); bounds) {
+            tracked.emplace(handle, *bounds);
+        }
+    }
+
     octree.build();
 }
 
+ControllerPathfinding::Ticket ControllerPathfinding::requestPath(const Vector3& from, const Vector3& to) {
+    std::lock_guard<std::mutex> lock{requestsMutex};
+    const auto ticket = nextTicket++;
+    requests.push_back({ticket, from, to});
+    return ticket;
+}
+
+const ControllerPathfinding::PathResult* ControllerPathfinding::getResult(const Ticket ticket) const {
+    // The tickets are increasing, the results are stored in the order of the requests
+    const auto it = std::lower_bound(results.begin(), results.end(), ticket, [](const PathResult& r, Ticket t) {
+        return r.ticket < t;
+    });
+    if (it == results.end() || it->ticket != ticket) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+bool ControllerPathfinding::isPending(const Ticket ticket) const {
+    return ticket > collected;
+}
+
+void ControllerPathfinding::startBatch() {
+    std::lock_guard<std::mutex> lock{requestsMutex};
+    if (requests.empty()) {
+        return;
+    }
+
+    batch = std::make_shared<Batch>();
+    batch->requests.swap(requests);
+    batch->results.resize(batch->requests.size());
+    for (size_t i = 0; i < batch->requests.size(); i++) {
+        batch->results[i].ticket = batch->requests[i].ticket;
+    }
+
+    const auto workers = std::min(states.size(), batch->requests.size());
+    batch->running = workers;
+
+    for (size_t w = 0; w < workers; w++) {
+        getPathfindingWorkers().post([this, b = batch, state = states[w].get()]() {
+            for (auto i = b->next++; i < b->requests.size(); i = b->next++) {
+                try {
+                    const auto& request = b->requests[i];
+                    b->results[i].path = octree.findPath(request.from, request.to, *state);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock{b->mutex};
+                    if (!b->error) {
+                        b->error = std::current_exception();
+                    }
+                }
+            }
+
+            if (--b->running == 0) {
+                std::lock_guard<std::mutex> lock{b->mutex};
+                b->cv.notify_all();
+            }
+        });
+    }
+}
+
+// Collects the batch once all of its searches are done
+void ControllerPathfinding::finishBatch() {
+    for (auto& result : batch->results) {
+        result.tick = tick;
+        results.push_back(std::move(result));
+    }
+    collected = batch->requests.back().ticket;
+    const auto error = batch->error;
+    batch.reset();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ControllerPathfinding::waitBatch() {
+    if (!batch) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock{batch->mutex};
+        batch->cv.wait(lock, [this]() { return batch->running.load() == 0; });
+    }
+
+    finishBatch();
+}
+
+// Runs between the batches, the octree is not read by anyone
+void ControllerPathfinding::applyChanges() {
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    for (const auto handle : changed) {
+        const auto bounds = reg.valid(handle) ? getBounds(handle) : std::nullopt;
+        const auto it = tracked.find(handle);
+
+        if (it != tracked.end() && bounds && it->second.min == bounds->min && it->second.max == bounds->max) {
+            continue;
+        }
+
+        if (it != tracked.end()) {
+            dirty.push_back(it->second);
+            tracked.erase(it);
+        }
+        if (bounds) {
+            dirty.push_back(*bounds);
+            tracked.emplace(handle, *bounds);
+        }
+    }
+    changed.clear();
+
+    if (dirty.empty() || !octree.isBuilt()) {
+        dirty.clear();
+        return;
+    }
+
+    for (const auto& bounds : dirty) {
+        octree.invalidate(bounds.min, bounds.max);
+    }
+    dirty.clear();
+
+    dynamicsWorld.updateAabbs();
+    octree.rebuild();
+}
+
+// Only the static bodies are obstacles, the same as in the contact test
+std::optional<ControllerPathfinding::Bounds> ControllerPathfinding::getBounds(const EntityId handle) const {
+    const auto* transform = reg.try_get<ComponentTransform>(handle);
+    const auto* rigidBody = reg.try_get<ComponentRigidBody>(handle);
+    if (!transform || !transform->isStatic() || !rigidBody) {
+        return std::nullopt;
+    }
+
+    const auto* body = rigidBody->getRigidBody();
+    if (!body || !body->getCollisionShape()) {
+        return std::nullopt;
+    }
+
+    btVector3 min;
+    btVector3 max;
+    body->getCollisionShape()->getAabb(body->getWorldTransform(), min, max);
+    return Bounds{{min.x(), min.y(), min.z()}, {max.x(), max.y(), max.z()}};
+}
+
+void ControllerPathfinding::onChange(entt::registry& r, const entt::entity handle) {
+    // The moving ships patch their transforms on every tick, only the static bodies are of interest
+    const auto* transform = r.try_get<ComponentTransform>(handle);
+    if (tracked.find(handle) != tracked.end() || (transform && transform->isStatic())) {
+        changed.push_back(handle);
+    }
+}
+
+void ControllerPathfinding::onDestroy(entt::registry& r, const entt::entity handle) {
+    (void)r;
+
+    const auto it = tracked.find(handle);
+    if (it != tracked.end()) {
+        dirty.push_back(it->second);
+        tracked.erase(it);
+    }
+}
+
 bool ControllerPathfinding::contactTestBox(const Vector3i& pos, const int width) {
     return dynamicsWorld.contactTestBox(pos, static_cast<float>(width), CollisionGroup::Static);
 }
@@ -4,13 +4,31 @@
 #include "../DynamicsWorld.hpp"
 #include "../Entity.hpp"
 #include "../Pathfinding.hpp"
+#include <deque>
 
 namespace Engine {
 class ENGINE_API Scene;
 
+// Navigation for the NPCs. The path requests are searched together in the background while the rest of the tick
+// runs, the next update waits for the batch, so a request made on a tick always has its result on the following
+// one regardless of the machine. The results are kept for a number of ticks after they are collected.
+// The static rigid bodies are tracked, the parts of the volume they leave or enter are rebuilt between the batches.
 class ENGINE_API ControllerPathfinding : public Controller, public Pathfinding::Tester {
 public:
-    explicit ControllerPathfinding(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld);
+    using Ticket = uint64_t;
+
+    // Longer than the longest update interval of the agents, so each one sees the result of its request
+    static constexpr uint64_t resultTicks = 64;
+
+    struct PathResult {
+        Ticket ticket;
+        std::optional<Pathfinding::Path> path;
+        // The tick it was collected in
+        uint64_t tick{0};
+    };
+
+    explicit ControllerPathfinding(Scene& scene, entt::registry& reg, DynamicsWorld& dynamicsWorld,
+                                   const Config& config);
     ~ControllerPathfinding() override;
     NON_COPYABLE(ControllerPathfinding);
     NON_MOVEABLE(ControllerPathfinding);
@@ -20,6 +38,12 @@ public:
     void buildTree();
     void debug(Scene& scene);
 
+    // Safe to call from the agents running in parallel
+    Ticket requestPath(const Vector3& from, const Vector3& to);
+    // Null while the request is pending, or when its result has expired. Only for the tickets handed out.
+    [[nodiscard]] const PathResult* getResult(Ticket ticket) const;
+    [[nodiscard]] bool isPending(Ticket ticket) const;
+
     Pathfinding& getOctree() {
         return octree;
     }
@@ -31,10 +55,44 @@ public:
     bool contactTestBox(const Vector3i& pos, int width) override;
 
 private:
+    struct Request {
+        Ticket ticket;
+        Vector3 from;
+        Vector3 to;
+    };
+
+    struct Bounds {
+        Vector3 min;
+        Vector3 max;
+    };
+
+    struct Batch;
+
+    void startBatch();
+    void finishBatch();
+    void waitBatch();
+    void applyChanges();
+    std::optional<Bounds> getBounds(EntityId handle) const;
+    void onChange(entt::registry& r, entt::entity handle);
+    void onDestroy(entt::registry& r, entt::entity handle);
+
     Scene& scene;
     entt::registry& reg;
     DynamicsWorld& dynamicsWorld;
     Pathfinding octree;
+    uint64_t tick{0};
+    std::mutex requestsMutex;
+    Ticket nextTicket{1};
+    std::vector<Request> requests;
+    // The last ticket of the collected batches
+    Ticket collected{0};
+    std::deque<PathResult> results;
+    std::shared_ptr<Batch> batch;
+    std::vector<std::unique_ptr<Pathfinding::SearchState>> states;
+    // Last known bounds of the static bodies, so the space they left is rebuilt too
+    std::unordered_map<EntityId, Bounds> tracked;
+    std::vector<EntityId> changed;
+    std::vector<Bounds> dirty;
 
     VulkanDoubleBuffer vbo;
 };
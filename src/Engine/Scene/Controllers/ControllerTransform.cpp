@@ -0,0 +1,130 @@
+#include "ControllerTransform.hpp"
+#include <btBulletDynamicsCommon.h>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+// Protects against a cycle in the hierarchy, nothing in the game nests this deep
+static constexpr size_t maxDepth = 64;
+
+ControllerTransform::ControllerTransform(Scene& scene, entt::registry& reg) : scene{scene}, reg{reg} {
+    reg.on_construct<ComponentTransform>().connect<&ControllerTransform::onConstruct>(this);
+    reg.on_update<ComponentTransform>().connect<&ControllerTransform::onUpdate>(this);
+    reg.on_destroy<ComponentTransform>().connect<&ControllerTransform::onDestroy>(this);
+}
+
+ControllerTransform::~ControllerTransform() {
+    reg.on_construct<ComponentTransform>().disconnect<&ControllerTransform::onConstruct>(this);
+    reg.on_update<ComponentTransform>().disconnect<&ControllerTransform::onUpdate>(this);
+    reg.on_destroy<ComponentTransform>().disconnect<&ControllerTransform::onDestroy>(this);
+}
+
+void ControllerTransform::update(const float delta) {
+    (void)delta;
+}
+
+void ControllerTransform::recalculate(VulkanRenderer& vulkan) {
+    (void)vulkan;
+}
+
+void ControllerTransform::rebuild() {
+    rebuildNeeded = false;
+
+    std::vector<std::pair<size_t, ComponentTransform*>> sorted;
+    sorted.reserve(reg.storage<ComponentTransform>().size());
+
+    for (auto&& [entity, transform] : reg.view<ComponentTransform>().each()) {
+        size_t depth = 0;
+        for (const auto* p = transform.getParent(); p && depth <= maxDepth; p = p->getParent()) {
+            ++depth;
+        }
+        sorted.emplace_back(depth, &transform);
+    }
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::unordered_map<const ComponentTransform*, uint32_t> indexes;
+    indexes.reserve(sorted.size());
+
+    nodes.clear();
+    nodes.reserve(sorted.size());
+
+    for (const auto& [depth, transform] : sorted) {
+        const auto* parent = transform->getParent();
+        auto parentIndex = noParent;
+        if (parent) {
+            const auto found = indexes.find(parent);
+            if (depth > maxDepth || found == indexes.end()) {
+                // Not reachable from a root, keeps using the uncached path
+                logger.debug("Transform of entity: {} has an invalid parent", transform->getEntity());
+                transform->worldCached = false;
+                continue;
+            }
+            parentIndex = found->second;
+        }
+
+        indexes.emplace(transform, static_cast<uint32_t>(nodes.size()));
+        nodes.push_back({transform, parent, parentIndex});
+    }
+
+    updated.assign(nodes.size(), 0);
+}
+
+void ControllerTransform::updateWorld() {
+    if (rebuildNeeded) {
+        rebuild();
+    }
+
+    updatedCount = 0;
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const auto& node = nodes[i];
+        auto& transform = *node.transform;
+
+        // Parent changed since the last rebuild, the order is no longer valid
+        if (transform.getParent() != node.parent) {
+            rebuild();
+            updateWorld();
+            return;
+        }
+
+        const auto hasParent = node.parentIndex != noParent;
+        if (transform.worldDirty || !transform.worldCached || (hasParent && updated[node.parentIndex])) {
+            if (hasParent) {
+                transform.absolute = node.parent->absolute * transform.transform;
+                transform.absoluteInterpolated =
+                    node.parent->absoluteInterpolated * transform.getInterpolatedTransform();
+            } else {
+                transform.absolute = transform.transform;
+                transform.absoluteInterpolated = transform.getInterpolatedTransform();
+            }
+
+            updated[i] = 1;
+            ++updatedCount;
+        } else {
+            updated[i] = 0;
+        }
+
+        transform.worldDirty = false;
+        transform.worldCached = true;
+    }
+}
+
+void ControllerTransform::onConstruct(entt::registry& r, const entt::entity handle) {
+    (void)r;
+    (void)handle;
+    rebuildNeeded = true;
+}
+
+void ControllerTransform::onUpdate(entt::registry& r, const entt::entity handle) {
+    (void)r;
+    // The component may have been unpacked from the network or a checkpoint, bypassing the setters
+    reg.get<ComponentTransform>(handle).worldDirty = true;
+}
+
+void ControllerTransform::onDestroy(entt::registry& r, const entt::entity handle) {
+    (void)r;
+    (void)handle;
+    rebuildNeeded = true;
+}
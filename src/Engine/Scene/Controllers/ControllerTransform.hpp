@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../Controller.hpp"
+#include "../Entity.hpp"
+
+namespace Engine {
+// Computes the absolute (world) matrix of every transform once per tick and once per frame.
+// The transforms are kept in a flat array ordered parents before children, so every matrix is a single
+// multiplication with the already computed parent matrix, and only the subtrees under a changed transform
+// are recomputed. The getters of ComponentTransform read the result as long as nothing in the chain changed.
+class ENGINE_API ControllerTransform : public Controller {
+public:
+    explicit ControllerTransform(Scene& scene, entt::registry& reg);
+    ~ControllerTransform() override;
+    NON_COPYABLE(ControllerTransform);
+    NON_MOVEABLE(ControllerTransform);
+
+    void update(float delta) override;
+    void recalculate(VulkanRenderer& vulkan) override;
+
+    // Called by the scene before the other controllers, so they see the cached matrices
+    void updateWorld();
+
+    [[nodiscard]] size_t getUpdatedCount() const {
+        return updatedCount;
+    }
+
+private:
+    struct Node {
+        ComponentTransform* transform{nullptr};
+        const ComponentTransform* parent{nullptr};
+        uint32_t parentIndex{0};
+    };
+
+    static constexpr uint32_t noParent = std::numeric_limits<uint32_t>::max();
+
+    void rebuild();
+
+    void onConstruct(entt::registry& r, entt::entity handle);
+    void onUpdate(entt::registry& r, entt::entity handle);
+    void onDestroy(entt::registry& r, entt::entity handle);
+
+    Scene& scene;
+    entt::registry& reg;
+    std::vector<Node> nodes;
+    std::vector<uint8_t> updated;
+    size_t updatedCount{0};
+    bool rebuildNeeded{true};
+};
+} // namespace Engine
@@ -23,12 +23,11 @@ void ControllerTurret::update(const float delta) {
 
             if (turret.shouldShoot()) {
                 turret.resetShoot();
-                auto& bullet = bullets.allocateBullet();
-                bullet.origin = transform.getAbsolutePosition();
-                bullet.lifetime = 10.0f;
-                bullet.direction = turret.getTargetDirection();
-                bullet.size = 10.0f;
-                bullet.speed = 500.0f;
+                // The clients spawn the bullets from the fire events of the server
+                if (bullets.isAuthoritative()) {
+                    bullets.fire(
+                        entity, transform.getAbsolutePosition(), turret.getTargetDirection(), 500.0f, 10.0f, 10.0f);
+                }
             }
         }
     }
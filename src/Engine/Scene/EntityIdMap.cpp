@@ -0,0 +1,84 @@
+#include "EntityIdMap.hpp"
+
+using namespace Engine;
+
+static constexpr size_t initialCapacity = 256;
+
+// Kept at most half full, the probe sequences stay short
+static constexpr size_t maxLoadDivisor = 2;
+
+static size_t hashEntity(const EntityId key, const size_t mask) {
+    // Fibonacci hashing, the ids are mostly sequential
+    return static_cast<size_t>((static_cast<uint64_t>(entt::to_integral(key)) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+size_t EntityIdMap::indexOf(const EntityId key) const {
+    const auto mask = slots.size() - 1;
+    for (auto i = hashEntity(key, mask);; i = (i + 1) & mask) {
+        if (slots[i].key == key || slots[i].key == NullEntity) {
+            return i;
+        }
+    }
+}
+
+EntityId EntityIdMap::find(const EntityId key) const {
+    if (slots.empty()) {
+        return NullEntity;
+    }
+    return slots[indexOf(key)].value;
+}
+
+void EntityIdMap::insert(const EntityId key, const EntityId value) {
+    if ((count + 1) * maxLoadDivisor > slots.size()) {
+        grow();
+    }
+
+    auto& slot = slots[indexOf(key)];
+    if (slot.key == NullEntity) {
+        slot.key = key;
+        ++count;
+    }
+    slot.value = value;
+}
+
+void EntityIdMap::erase(const EntityId key) {
+    if (slots.empty()) {
+        return;
+    }
+
+    const auto mask = slots.size() - 1;
+    auto hole = indexOf(key);
+    if (slots[hole].key == NullEntity) {
+        return;
+    }
+    --count;
+
+    // Shift the following entries of the probe sequence back, so no tombstones are needed
+    for (auto i = (hole + 1) & mask; slots[i].key != NullEntity; i = (i + 1) & mask) {
+        const auto home = hashEntity(slots[i].key, mask);
+        const auto distance = (i - home) & mask;
+        const auto distanceToHole = (i - hole) & mask;
+        if (distance >= distanceToHole) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole] = Slot{};
+}
+
+void EntityIdMap::clear() {
+    slots.clear();
+    count = 0;
+}
+
+void EntityIdMap::grow() {
+    auto old = std::move(slots);
+    slots.assign(old.empty() ? initialCapacity : old.size() * 2, Slot{});
+    count = 0;
+
+    for (const auto& slot : old) {
+        if (slot.key != NullEntity) {
+            insert(slot.key, slot.value);
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Component.hpp"
+#include <vector>
+
+namespace Engine {
+// Maps one entity id to another in a single flat array with linear probing. Used for the remote to local ids
+// on the client, where a lookup is done for every replicated component.
+class ENGINE_API EntityIdMap {
+public:
+    EntityIdMap() = default;
+
+    [[nodiscard]] EntityId find(EntityId key) const;
+    void insert(EntityId key, EntityId value);
+    void erase(EntityId key);
+    void clear();
+
+    [[nodiscard]] size_t size() const {
+        return count;
+    }
+
+private:
+    struct Slot {
+        EntityId key{NullEntity};
+        EntityId value{NullEntity};
+    };
+
+    [[nodiscard]] size_t indexOf(EntityId key) const;
+    void grow();
+
+    std::vector<Slot> slots;
+    size_t count{0};
+};
+} // namespace Engine
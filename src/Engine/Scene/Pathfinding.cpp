@@ -1,422 +1,549 @@
 #include "Pathfinding.hpp"
 #include "../Utils/Exceptions.hpp"
 #include "../Utils/Log.hpp"
-#include <queue>
+#include <algorithm>
+#include <chrono>
 
 using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
-template <typename V>
-static inline glm::vec<3, V> idxToOffset(const int idx, const glm::vec<3, V>& origin, const V size) {
-    using Vec = glm::vec<3, V>;
+// The grid of the clusters is 8x8x8 for the volumes deep enough
+static constexpr int maxClusterLevels = 3;
 
-    const auto off = size / 4.0f;
-
-    switch (idx) {
-    case 0: {
-        return origin + Vec{off, off, off};
-    }
-    case 1: {
-        return origin + Vec{-off, off, off};
-    }
-    case 2: {
-        return origin + Vec{-off, off, -off};
-    }
-    case 3: {
-        return origin + Vec{off, off, -off};
-    }
-    case 4: {
-        return origin + Vec{off, -off, off};
-    }
-    case 5: {
-        return origin + Vec{-off, -off, off};
-    }
-    case 6: {
-        return origin + Vec{-off, -off, -off};
-    }
-    case 7: {
-        return origin + Vec{off, -off, -off};
-    }
-    default: {
-        throw std::out_of_range("Invalid index");
-    }
-    }
+static inline Vector3i childOffset(const int idx) {
+    return Vector3i{idx & 1, (idx >> 1) & 1, (idx >> 2) & 1};
 }
 
-template <typename... Args> static inline constexpr uint8_t idxToMask(const Args... args) {
-    uint8_t result{0};
-    ((result |= 1 << args), ...);
-    return result;
+static inline bool isInside(const Vector3i& min, const int size, const Vector3i& pos) {
+    return pos.x >= min.x && pos.x < min.x + size && pos.y >= min.y && pos.y < min.y + size && pos.z >= min.z &&
+           pos.z < min.z + size;
 }
 
-static constexpr std::array<uint8_t, 6> sidesMask = {
-    // Positive X
-    idxToMask(0, 3, 4, 7),
-    // Negative X
-    idxToMask(1, 2, 5, 6),
-    // Positive Y
-    idxToMask(0, 1, 2, 3),
-    // Negative Y
-    idxToMask(4, 5, 6, 7),
-    // Positive Z
-    idxToMask(0, 1, 4, 5),
-    // Negative Z
-    idxToMask(2, 3, 6, 7),
-};
-
-static inline int getHashCodeLevel(const Pathfinding::HashCode code) {
-    int level = 0;
-    while (true) {
-        const auto test = 0x0FULL << (level * 4ULL);
-        if (!(test & code)) {
-            break;
-        }
-        ++level;
+void Pathfinding::SearchState::Scratch::reset(const size_t size) {
+    if (visited.size() != size) {
+        cost.resize(size);
+        parent.resize(size);
+        visited.assign(size, 0);
+        generation = 0;
     }
-    return level - 1;
-}
 
-static inline bool isInsideBox(const Vector3i& origin, const int width, const Vector3i& pos) {
-    const auto half = width / 2;
-
-    if (pos.x >= origin.x - half && pos.x < origin.x + half && pos.y >= origin.y - half && pos.y < origin.y + half &&
-        pos.z >= origin.z - half && pos.z < origin.z + half) {
-        return true;
+    // Nodes not stamped with the current generation are unvisited, so nothing is cleared between the searches
+    if (++generation == 0) {
+        std::fill(visited.begin(), visited.end(), 0);
+        generation = 1;
     }
 
-    return false;
-}
-
-static int64_t heuristic(const Vector3i& a, const Vector3i& b) {
-    return glm::abs(a.x - b.x) + glm::abs(a.y - b.y) + glm::abs(a.z - b.z);
+    open.clear();
 }
 
-Pathfinding::Pathfinding(Tester& tester, const int depth, const int scale) :
-    tester{tester}, depth{depth}, scale{scale}, levels{} {
+Pathfinding::Pathfinding(Tester& tester, const int depth, const int scale, const size_t cacheSize) :
+    tester{tester},
+    depth{depth},
+    scale{scale},
+    clusterLevels{std::min(depth, maxClusterLevels)},
+    clusterSize{1 << (depth - clusterLevels)},
+    cacheSize{cacheSize} {
 
-    // Create all layers
-    for (auto d = 0; d < depth; d++) {
-        temp.emplace_back();
+    if (depth < 1 || depth > 16) {
+        EXCEPTION("Pathfinding depth: {} out of bounds", depth);
+    }
+    if (scale < 2) {
+        EXCEPTION("Pathfinding scale: {} is too small", scale);
     }
 
-    // Create the root node
-    auto& root = temp[0].emplace_back();
-    root.offset = 0;
-    root.children = 0;
+    clusters.resize(static_cast<size_t>(1) << (clusterLevels * 3));
+    clusterGraph.resize(clusters.size());
+    for (Index i = 0; i < clusters.size(); i++) {
+        clusterGraph.positions[i] = getCenter(getClusterMin(i), clusterSize);
+    }
 }
 
 void Pathfinding::build() {
-    logger.info("Pathfinding building of size: {} units", std::pow(2, depth) * scale);
+    const auto width = static_cast<int64_t>(1 << depth) * scale;
+    logger.info("Pathfinding building of size: {} units", width);
     const auto t0 = std::chrono::high_resolution_clock::now();
-    build(0, {0, 0, 0}, 0);
-    optimize();
+
+    for (auto& cluster : clusters) {
+        cluster.dirty = true;
+    }
+    rebuild();
+    built = true;
+
     const auto t1 = std::chrono::high_resolution_clock::now();
     const auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-    logger.info("Pathfinding built in {}ms with {} nodes", diff.count(), nodes.size());
+    logger.info("Pathfinding built in {}ms with {} cells", diff.count(), getCellCount());
 }
 
-std::optional<Pathfinding::HashCode> Pathfinding::find(const Vector3& pos) {
-    return find(0, {0, 0, 0}, 0, HashCode{0}, pos);
-}
+void Pathfinding::invalidate(const Vector3& min, const Vector3& max) {
+    const auto last = (1 << clusterLevels) - 1;
+    const auto from = glm::clamp(toLeaf(min) / clusterSize, Vector3i{0}, Vector3i{last});
+    const auto to = glm::clamp(toLeaf(max) / clusterSize, Vector3i{0}, Vector3i{last});
 
-Pathfinding::NodeInfo Pathfinding::findNearest(const Vector3& pos, int maxLevel) {
-    return findNearest(0, {0, 0, 0}, 0, HashCode{0}, pos, maxLevel);
+    const auto side = 1 << clusterLevels;
+    for (auto z = from.z; z <= to.z; z++) {
+        for (auto y = from.y; y <= to.y; y++) {
+            for (auto x = from.x; x <= to.x; x++) {
+                clusters[(z * side + y) * side + x].dirty = true;
+            }
+        }
+    }
 }
 
-bool Pathfinding::findPath(const Vector3& from, const Vector3& to) {
-    const auto t0 = std::chrono::high_resolution_clock::now();
-
-    QueryData data;
-
-    data.start = findNearest(from);
-    if (!data.start) {
-        return false;
+bool Pathfinding::rebuild() {
+    std::vector<uint8_t> dirty(clusters.size(), 0);
+    std::vector<Index> rebuilt;
+    for (Index i = 0; i < clusters.size(); i++) {
+        if (clusters[i].dirty) {
+            dirty[i] = 1;
+            rebuilt.push_back(i);
+        }
     }
 
-    data.goal = findNearest(to);
-    if (!data.goal) {
+    if (rebuilt.empty()) {
         return false;
     }
 
-    logger.info("Start pos: {} level: {} code: {:x}", data.start.pos, data.start.level, data.start.code);
-    logger.info("Goal pos: {} level: {} code: {:x}", data.goal.pos, data.goal.level, data.goal.code);
+    // Before the cells of the dirty clusters are released, their indices may be handed out again
+    evictCachedRoutes(dirty);
 
-    /*if (infos.size() != nodes.size()) {
-        infos.resize(nodes.size());
+    for (const auto i : rebuilt) {
+        releaseCells(i);
+        buildCluster(i);
+        collectCells(i, 0, getClusterMin(i), clusterSize);
     }
-    std::memset(infos.data(), 0, infos.size() * sizeof(Info));*/
 
-    // getNeighbours(start);
-
-    std::vector<NodeInfoDistance> frontierVec;
-    frontierVec.reserve(1 * 1024);
-    data.frontier = std::priority_queue<NodeInfoDistance>(std::less<NodeInfoDistance>(), std::move(frontierVec));
-    data.frontier.emplace(NodeInfoDistance{data.start, 0});
-
-    data.costSoFar.reserve(1 * 1024);
-    data.costSoFar[data.start.code] = Info{0, 0};
-
-    size_t count{0};
+    // The new cells, and the cells of the clean neighbours touching the rebuilt clusters across the shared face
+    std::vector<Index> relink;
+    std::vector<Index> touched;
+    const auto side = 1 << clusterLevels;
+    for (const auto i : rebuilt) {
+        relink.insert(relink.end(), clusters[i].cells.begin(), clusters[i].cells.end());
+        touched.push_back(i);
+
+        const auto min = getClusterMin(i);
+        const auto c = min / clusterSize;
+        for (int axis = 0; axis < 3; axis++) {
+            for (const auto dir : {-1, 1}) {
+                auto n = c;
+                n[axis] += dir;
+                if (n[axis] < 0 || n[axis] >= side) {
+                    continue;
+                }
 
-    while (!data.frontier.empty()) {
-        data.current = data.frontier.top();
-        data.frontier.pop();
+                const auto neighbour = static_cast<Index>((n.z * side + n.y) * side + n.x);
+                if (dirty[neighbour]) {
+                    continue;
+                }
+                touched.push_back(neighbour);
 
-        if (data.current.info.code == data.goal.code) {
-            break;
+                for (const auto cell : clusters[neighbour].cells) {
+                    const auto& other = cells[cell];
+                    if (dir > 0 ? other.min[axis] == min[axis] + clusterSize
+                                : other.min[axis] + other.size == min[axis]) {
+                        relink.push_back(cell);
+                    }
+                }
+            }
         }
+    }
 
-        getNeighbours(data.current.info, data);
+    std::sort(relink.begin(), relink.end());
+    relink.erase(std::unique(relink.begin(), relink.end()), relink.end());
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    cellGraph.resize(cells.size());
+    std::vector<Index> neighbours;
+    for (const auto i : relink) {
+        linkCell(i, neighbours);
+    }
+    for (const auto i : touched) {
+        linkCluster(i, neighbours);
     }
 
-    const auto t1 = std::chrono::high_resolution_clock::now();
-    const auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-    logger.info("Pathfinding found in {}ms count: {}", diff.count(), count);
+    cellGraph.compact();
+    clusterGraph.compact();
 
+    logger.debug("Pathfinding rebuilt {} clusters and linked {} cells", rebuilt.size(), relink.size());
     return true;
 }
 
-void Pathfinding::optimize() {
-    for (int level = 0; level < depth; level++) {
-        // Allocate the level into the continuous array
-        const auto start = allocateNodes(temp[level].size());
-
-        logger.debug(
-            "Pathfinding optimize copying level: {} to offset: {} of size: {}", level, start, temp[level].size());
-
-        // Copy the nodes over
-        std::memcpy(&nodes[start], &temp[level][0], temp[level].size() * sizeof(Node));
+void Pathfinding::buildCluster(const Index index) {
+    auto& cluster = clusters[index];
+    cluster.nodes.clear();
+    cluster.nodes.emplace_back();
+    cluster.dirty = false;
+    buildNode(cluster, 0, getClusterMin(index), clusterSize);
+}
 
-        // Update the offsets in this layer
-        // The start of the next layer is exactly at the end of this layer
-        for (size_t i = start; i < start + temp[level].size(); i++) {
-            // if (nodes[i].offset) {
-            nodes[i].offset += start + temp[level].size();
-            //}
-        }
+void Pathfinding::buildNode(Cluster& cluster, const Index index, const Vector3i& min, const int size) {
+    const auto center = min * scale + Vector3i{size * scale / 2} - Vector3i{(1 << depth) * scale / 2};
+    if (!tester.contactTestBox(center, size * scale)) {
+        cluster.nodes[index].state = NodeState::Free;
+        return;
     }
 
-    // Free the temp nodes memory
-    temp.clear();
-    temp.shrink_to_fit();
-}
+    if (size == 1) {
+        cluster.nodes[index].state = NodeState::Blocked;
+        return;
+    }
 
-void Pathfinding::build(Index index, const Vector3i& origin, const int level) {
-    const auto nodeWidth = scale * static_cast<int>(std::pow(2.0f, static_cast<float>(depth - level)));
+    const auto first = static_cast<Index>(cluster.nodes.size());
+    cluster.nodes.resize(first + 8);
+    cluster.nodes[index].state = NodeState::Split;
+    cluster.nodes[index].children = first;
 
-    if (nodeWidth < 4) {
-        EXCEPTION("Pathfinding node width is too small at level: {}", level);
+    const auto half = size / 2;
+    for (int idx = 0; idx < 8; idx++) {
+        buildNode(cluster, first + idx, min + childOffset(idx) * half, half);
     }
+}
 
-    const auto childWidth = nodeWidth / 2;
+void Pathfinding::collectCells(const Index cluster, const Index index, const Vector3i& min, const int size) {
+    auto& node = clusters[cluster].nodes[index];
 
-    ChildrenMask children{0};
-    for (int idx = 0; idx < 8; idx++) {
-        const auto childOrigin = idxToOffset<int>(idx, origin, nodeWidth);
+    if (node.state == NodeState::Free) {
+        if (freeCells.empty()) {
+            node.cell = static_cast<Index>(cells.size());
+            cells.emplace_back();
+            cellClusters.emplace_back();
+        } else {
+            node.cell = freeCells.back();
+            freeCells.pop_back();
+        }
 
-        if (tester.contactTestBox(childOrigin, childWidth)) {
-            children |= 1 << idx;
+        cells[node.cell] = {min, size, cluster};
+        cellClusters[node.cell] = cluster;
+        clusters[cluster].cells.push_back(node.cell);
+    } else if (node.state == NodeState::Split) {
+        const auto half = size / 2;
+        for (int idx = 0; idx < 8; idx++) {
+            collectCells(cluster, node.children + idx, min + childOffset(idx) * half, half);
         }
     }
+}
 
-    auto& node = temp[level][index];
-    node.children = children;
-    node.offset = 0;
+void Pathfinding::releaseCells(const Index cluster) {
+    auto& released = clusters[cluster].cells;
+    for (const auto cell : released) {
+        cells[cell].size = 0;
+        cellGraph.link(cell, {});
+        freeCells.push_back(cell);
+    }
+    released.clear();
+}
 
-    if (children && level + 1 != depth) {
-        node.offset = allocateTempNodes(level + 1);
+// Probes every leaf across each face, skipping the ones covered by the neighbour found last
+void Pathfinding::linkCell(const Index index, std::vector<Index>& neighbours) {
+    const auto& cell = cells[index];
+    cellGraph.positions[index] = getCenter(cell.min, cell.size);
+
+    neighbours.clear();
+    for (int axis = 0; axis < 3; axis++) {
+        const auto u = (axis + 1) % 3;
+        const auto v = (axis + 2) % 3;
+
+        for (const auto outside : {cell.min[axis] - 1, cell.min[axis] + cell.size}) {
+            Index last = invalidIndex;
+            for (auto a = 0; a < cell.size; a++) {
+                for (auto b = 0; b < cell.size; b++) {
+                    Vector3i probe{};
+                    probe[axis] = outside;
+                    probe[u] = cell.min[u] + a;
+                    probe[v] = cell.min[v] + b;
+
+                    if (last != invalidIndex && isInside(cells[last].min, cells[last].size, probe)) {
+                        continue;
+                    }
 
-        for (int idx = 0; idx < 8; idx++) {
-            if (children & (1 << idx)) {
-                const auto childOrigin = idxToOffset<int>(idx, origin, nodeWidth);
-                build(node.offset + idx, childOrigin, level + 1);
-            } else {
-                auto& child = temp[level + 1][node.offset + idx];
-                child.offset = 0;
-                child.children = 0;
+                    const auto found = findCell(probe);
+                    if (found != invalidIndex) {
+                        neighbours.push_back(found);
+                        last = found;
+                    }
+                }
             }
         }
     }
+
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    cellGraph.link(index, neighbours);
 }
 
-Pathfinding::Index Pathfinding::allocateNodes(const size_t num) {
-    if (nodes.size() + num > nodes.capacity()) {
-        nodes.reserve(nodes.capacity() + nodeCapacityMultipler);
+// The clusters connected by at least a single pair of cells
+void Pathfinding::linkCluster(const Index index, std::vector<Index>& neighbours) {
+    neighbours.clear();
+    for (const auto cell : clusters[index].cells) {
+        for (auto e = cellGraph.begins[cell]; e < cellGraph.ends[cell]; e++) {
+            const auto other = cellClusters[cellGraph.edges[e]];
+            if (other != index) {
+                neighbours.push_back(other);
+            }
+        }
     }
 
-    const auto offset = nodes.size();
-    nodes.resize(offset + num);
-    return static_cast<Index>(offset);
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+    clusterGraph.link(index, neighbours);
+}
+
+void Pathfinding::Graph::resize(const size_t size) {
+    positions.resize(size);
+    begins.resize(size, 0);
+    ends.resize(size, 0);
 }
 
-Pathfinding::Index Pathfinding::allocateTempNodes(const int level) {
-    if (level <= 0 || level >= temp.size()) {
-        EXCEPTION("Failed to allocate nodes, error: level {} out of bounds", level);
+void Pathfinding::Graph::link(const Index node, const std::vector<Index>& targets) {
+    garbage += ends[node] - begins[node];
+    begins[node] = static_cast<Index>(edges.size());
+    edges.insert(edges.end(), targets.begin(), targets.end());
+    ends[node] = static_cast<Index>(edges.size());
+}
+
+void Pathfinding::Graph::compact() {
+    if (garbage * 2 < edges.size()) {
+        return;
     }
 
-    auto& layer = temp[level];
-    if (layer.size() + 8 > layer.capacity()) {
-        const auto expectedNodes = static_cast<size_t>(std::pow(2, level - 1));
-        layer.reserve(layer.size() + std::min<size_t>(nodeCapacityMultipler, expectedNodes));
+    std::vector<Index> packed;
+    packed.reserve(edges.size() - garbage);
+    for (size_t i = 0; i < begins.size(); i++) {
+        const auto begin = static_cast<Index>(packed.size());
+        packed.insert(packed.end(), edges.begin() + begins[i], edges.begin() + ends[i]);
+        begins[i] = begin;
+        ends[i] = static_cast<Index>(packed.size());
     }
 
-    const auto offset = layer.size();
-    layer.resize(layer.size() + 8);
-    return static_cast<Index>(offset);
+    edges.swap(packed);
+    garbage = 0;
 }
 
-void Pathfinding::getNeighbours(const NodeInfo& info, QueryData& data) {
-    const auto nodeWidth = scale * static_cast<int>(std::pow(2.0f, static_cast<float>(depth - info.level)));
+Vector3i Pathfinding::toLeaf(const Vector3& pos) const {
+    const auto half = static_cast<float>((1 << depth) * scale) / 2.0f;
+    const auto leaf = (pos + Vector3{half}) / static_cast<float>(scale);
+    return Vector3i{
+        static_cast<int>(std::floor(leaf.x)),
+        static_cast<int>(std::floor(leaf.y)),
+        static_cast<int>(std::floor(leaf.z)),
+    };
+}
 
-    std::array<NodeInfo, 6> neighbours = {findNearest(info.pos + Vector3i{nodeWidth, 0, 0}, info.level),
-                                          findNearest(info.pos + Vector3i{-nodeWidth, 0, 0}, info.level),
-                                          findNearest(info.pos + Vector3i{0, nodeWidth, 0}, info.level),
-                                          findNearest(info.pos + Vector3i{0, -nodeWidth, 0}, info.level),
-                                          findNearest(info.pos + Vector3i{0, 0, nodeWidth}, info.level),
-                                          findNearest(info.pos + Vector3i{0, 0, -nodeWidth}, info.level)};
+Vector3i Pathfinding::getClusterMin(const Index index) const {
+    const auto side = static_cast<Index>(1 << clusterLevels);
+    const auto x = static_cast<int>(index % side);
+    const auto y = static_cast<int>((index / side) % side);
+    const auto z = static_cast<int>(index / (side * side));
+    return Vector3i{x, y, z} * clusterSize;
+}
 
-    for (size_t i = 0; i < neighbours.size(); i++) {
-        if (!neighbours[i]) {
-            continue;
-        }
+Vector3 Pathfinding::getCenter(const Vector3i& min, const int size) const {
+    const auto half = static_cast<float>((1 << depth) * scale) / 2.0f;
+    return (Vector3{min} + Vector3{static_cast<float>(size) / 2.0f}) * static_cast<float>(scale) - Vector3{half};
+}
 
-        if (neighbours[i].level == depth) {
-            processNeighbour(neighbours[i], data);
-            continue;
-        }
+Pathfinding::Index Pathfinding::findCell(const Vector3i& leaf) const {
+    const auto width = 1 << depth;
+    if (leaf.x < 0 || leaf.y < 0 || leaf.z < 0 || leaf.x >= width || leaf.y >= width || leaf.z >= width) {
+        return invalidIndex;
+    }
 
-        auto side = static_cast<int>(i);
-        if (side % 2 == 0) {
-            ++side;
-        } else {
-            --side;
-        }
-        /*if (neighbour) {
-            logger.info("Found neighbour code: {:x} pos: {} level: {}", neighbour.code, neighbour.pos, neighbour.level);
-        }*/
-        const auto& n = neighbours[i];
-        getNeighboursSide(n.offset, n.pos, n.level, n.code, side, data);
+    const auto side = 1 << clusterLevels;
+    const auto c = leaf / clusterSize;
+    const auto& nodes = clusters[(c.z * side + c.y) * side + c.x].nodes;
+    if (nodes.empty()) {
+        return invalidIndex;
     }
 
-    // const auto& n = neighbours[0];
-    //  getNeighboursSide(n.offset, n.pos, n.level, n.code, 1, callback);
+    Index index{0};
+    auto min = c * clusterSize;
+    auto size = clusterSize;
+
+    while (true) {
+        const auto& node = nodes[index];
+        if (node.state == NodeState::Free) {
+            return node.cell;
+        }
+        if (node.state == NodeState::Blocked) {
+            return invalidIndex;
+        }
+
+        const auto half = size / 2;
+        const auto local = leaf - min;
+        const auto idx = (local.x >= half ? 1 : 0) | (local.y >= half ? 2 : 0) | (local.z >= half ? 4 : 0);
+        min += childOffset(idx) * half;
+        size = half;
+        index = node.children + idx;
+    }
 }
 
-void Pathfinding::processNeighbour(const NodeInfo& next, QueryData& data) {
-    const auto newCost = data.costSoFar[data.current.info.code].cost + heuristic(data.current.info.pos, next.pos);
-    if (data.costSoFar.find(next.code) == data.costSoFar.end() || newCost < data.costSoFar[next.code].cost) {
-        data.costSoFar[next] = Info{
-            data.current.info.code,
-            newCost,
-        };
-        const auto priority = newCost + heuristic(next.pos, data.goal.pos);
-        data.frontier.push(NodeInfoDistance{next, priority});
+std::optional<Pathfinding::Index> Pathfinding::find(const Vector3& pos) const {
+    const auto found = findCell(toLeaf(pos));
+    if (found == invalidIndex) {
+        return std::nullopt;
     }
+    return found;
 }
 
-void Pathfinding::getNeighboursSide(const Index index, const Vector3i& origin, const int level, const HashCode previous,
-                                    const uint8_t side, QueryData& data) {
-    const auto nodeWidth = scale * static_cast<int>(std::pow(2.0f, static_cast<float>(depth - level)));
-
-    if (level + 1 == depth || !nodes[index].children) {
-        processNeighbour(
-            NodeInfo{
-                origin,
-                index,
-                previous,
-                level,
-            },
-            data);
-        return;
+std::optional<Pathfinding::Path> Pathfinding::findPath(const Vector3& from, const Vector3& to,
+                                                       SearchState& state) const {
+    const auto start = findCell(toLeaf(from));
+    const auto goal = findCell(toLeaf(to));
+    if (start == invalidIndex || goal == invalidIndex) {
+        return std::nullopt;
     }
 
-    auto& node = nodes[index];
+    const auto key = (static_cast<uint64_t>(start) << 32) | goal;
+    if (findCachedRoute(key, state.route)) {
+        ++cacheHits;
+    } else {
+        ++cacheMisses;
+
+        // The corridor is made of the clusters on the coarse route and the ones around them
+        const auto startCluster = cellClusters[start];
+        const auto goalCluster = cellClusters[goal];
+        if (!search(clusterGraph, startCluster, goalCluster, state.clusters, Filter{}, state.route)) {
+            return std::nullopt;
+        }
 
-    for (int idx = 0; idx < 8; idx++) {
-        if (sidesMask[side] & (1 << idx)) {
-            const auto nextCode = previous | (((idx + 1) & 0x0F) << (level * 4));
-            const auto childOrigin = idxToOffset(idx, origin, nodeWidth);
-
-            if (node.children & (1 << idx) && level + 1 < depth) {
-                getNeighboursSide(node.offset + idx, childOrigin, level + 1, nextCode, side, data);
-            } else if (node.children & (1 << idx)) {
-                // Occupied space
-                continue;
-            } else {
-                // Empty space
-                processNeighbour(
-                    NodeInfo{
-                        childOrigin,
-                        level + 1 == depth ? 0 : static_cast<Index>(node.offset + idx),
-                        nextCode,
-                        level + 1,
-                    },
-                    data);
+        if (state.corridor.size() != clusters.size()) {
+            state.corridor.assign(clusters.size(), 0);
+            state.corridorGeneration = 0;
+        }
+        if (++state.corridorGeneration == 0) {
+            std::fill(state.corridor.begin(), state.corridor.end(), 0);
+            state.corridorGeneration = 1;
+        }
+
+        for (const auto cluster : state.route) {
+            state.corridor[cluster] = state.corridorGeneration;
+            for (auto e = clusterGraph.begins[cluster]; e < clusterGraph.ends[cluster]; e++) {
+                state.corridor[clusterGraph.edges[e]] = state.corridorGeneration;
             }
         }
+
+        const Filter corridor{&cellClusters, &state.corridor, state.corridorGeneration};
+        if (!search(cellGraph, start, goal, state.cells, corridor, state.route)) {
+            // The free space of a cluster does not have to be connected, the corridor may be a dead end
+            if (!search(cellGraph, start, goal, state.cells, Filter{}, state.route)) {
+                return std::nullopt;
+            }
+        }
+
+        storeCachedRoute(key, state.route);
     }
+
+    Path path;
+    path.reserve(state.route.size() + 1);
+    path.push_back(from);
+    for (size_t i = 1; i + 1 < state.route.size(); i++) {
+        path.push_back(cellGraph.positions[state.route[i]]);
+    }
+    path.push_back(to);
+    return path;
 }
 
-std::optional<Pathfinding::HashCode> Pathfinding::find(const Index index, const Vector3i& origin, const int level,
-                                                       const HashCode previous, const Vector3& pos) {
-    const auto nodeWidth = scale * static_cast<int>(std::pow(2.0f, static_cast<float>(depth - level)));
+// A* with the straight distance as the heuristic, the stale entries of the open list are skipped when popped
+bool Pathfinding::search(const Graph& graph, const Index from, const Index to, SearchState::Scratch& scratch,
+                         const Filter& filter, std::vector<Index>& route) const {
+    scratch.reset(graph.positions.size());
+    route.clear();
 
-    const auto childWidth = nodeWidth / 2;
+    const auto& goalPos = graph.positions[to];
+    const auto greater = std::greater<std::pair<float, Index>>{};
 
-    auto& node = nodes[index];
+    scratch.visited[from] = scratch.generation;
+    scratch.cost[from] = 0.0f;
+    scratch.parent[from] = invalidIndex;
+    scratch.open.emplace_back(glm::distance(graph.positions[from], goalPos), from);
 
-    for (int idx = 0; idx < 8; idx++) {
-        if (node.children & (1 << idx)) {
-            const auto nextCode = previous | (((idx + 1) & 0x0F) << (level * 4));
-            const auto childOrigin = idxToOffset(idx, origin, nodeWidth);
-
-            if (isInsideBox(childOrigin, childWidth, pos)) {
-                if (level + 1 == depth) {
-                    return nextCode;
-                } else {
-                    const auto test = find(node.offset + idx, childOrigin, level + 1, nextCode, pos);
-                    if (test) {
-                        return test;
-                    }
-                }
+    while (!scratch.open.empty()) {
+        std::pop_heap(scratch.open.begin(), scratch.open.end(), greater);
+        const auto [priority, current] = scratch.open.back();
+        scratch.open.pop_back();
+
+        if (current == to) {
+            for (auto node = to; node != invalidIndex; node = scratch.parent[node]) {
+                route.push_back(node);
+            }
+            std::reverse(route.begin(), route.end());
+            return true;
+        }
+
+        const auto& pos = graph.positions[current];
+        const auto cost = scratch.cost[current];
+        if (priority > cost + glm::distance(pos, goalPos) + 1e-3f) {
+            continue;
+        }
+
+        for (auto e = graph.begins[current]; e < graph.ends[current]; e++) {
+            const auto next = graph.edges[e];
+            if (!filter.accepts(next)) {
+                continue;
             }
+
+            const auto nextCost = cost + glm::distance(pos, graph.positions[next]);
+            if (scratch.visited[next] == scratch.generation && nextCost >= scratch.cost[next]) {
+                continue;
+            }
+
+            scratch.visited[next] = scratch.generation;
+            scratch.cost[next] = nextCost;
+            scratch.parent[next] = current;
+            scratch.open.emplace_back(nextCost + glm::distance(graph.positions[next], goalPos), next);
+            std::push_heap(scratch.open.begin(), scratch.open.end(), greater);
         }
     }
 
-    return std::nullopt;
+    return false;
 }
 
-Pathfinding::NodeInfo Pathfinding::findNearest(const Index index, const Vector3i& origin, const int level,
-                                               const HashCode previous, const Vector3& pos, int maxLevel) {
-    const auto nodeWidth = scale * static_cast<int>(std::pow(2.0f, static_cast<float>(depth - level)));
+bool Pathfinding::findCachedRoute(const uint64_t key, std::vector<Index>& route) const {
+    std::lock_guard<std::mutex> lock{cacheMutex};
 
-    const auto childWidth = nodeWidth / 2;
+    const auto it = cache.find(key);
+    if (it == cache.end()) {
+        return false;
+    }
 
-    auto& node = nodes[index];
+    cacheLru.splice(cacheLru.begin(), cacheLru, it->second.lru);
+    route.assign(it->second.route.begin(), it->second.route.end());
+    return true;
+}
 
-    for (int idx = 0; idx < 8; idx++) {
-        const auto nextCode = previous | HashCode{(idx & 0x0FULL) << (level * 4ULL)};
-        const auto childOrigin = idxToOffset(idx, origin, nodeWidth);
-
-        if (isInsideBox(childOrigin, childWidth, pos)) {
-            if (level + 1 != depth && node.children & (1 << idx) && level + 1 < maxLevel) {
-                return findNearest(node.offset + idx, childOrigin, level + 1, nextCode, pos, maxLevel);
-            } else {
-                return NodeInfo{
-                    childOrigin,
-                    static_cast<Index>(node.offset + idx),
-                    nextCode,
-                    level + 1,
-                };
-            }
-        }
+void Pathfinding::storeCachedRoute(const uint64_t key, const std::vector<Index>& route) const {
+    if (cacheSize == 0) {
+        return;
     }
 
-    return {
-        {0, 0, 0},
-        0,
-        0,
-        0,
-    };
+    std::lock_guard<std::mutex> lock{cacheMutex};
+
+    if (cache.find(key) != cache.end()) {
+        return;
+    }
+
+    if (cache.size() >= cacheSize) {
+        cache.erase(cacheLru.back());
+        cacheLru.pop_back();
+    }
+
+    cacheLru.push_front(key);
+    cache.emplace(key, CacheEntry{route, cacheLru.begin()});
+}
+
+void Pathfinding::evictCachedRoutes(const std::vector<uint8_t>& dirty) {
+    std::lock_guard<std::mutex> lock{cacheMutex};
+
+    for (auto it = cache.begin(); it != cache.end();) {
+        const auto& route = it->second.route;
+        const auto through =
+            std::any_of(route.begin(), route.end(), [&](const Index cell) { return dirty[cellClusters[cell]]; });
+        if (through) {
+            cacheLru.erase(it->second.lru);
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
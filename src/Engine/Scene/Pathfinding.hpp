@@ -2,13 +2,20 @@
 
 #include "../Library.hpp"
 #include "../Math/Vector.hpp"
-#include <array>
-#include <functional>
+#include <atomic>
+#include <limits>
+#include <list>
+#include <mutex>
 #include <optional>
-#include <queue>
+#include <unordered_map>
 #include <vector>
 
 namespace Engine {
+// Navigation volume, a cube of 2^depth leaf cells of the scale size per side centered at the origin.
+// The volume is split into a grid of clusters, each one holds a sparse octree of the occupied space, so the free
+// space is covered by as few cells as possible. A path is searched on the graph of the clusters first, then on the
+// free cells within the corridor of the clusters found. Only the dirty clusters are tested again on a rebuild, and only
+// their cells and the cells of their neighbours along the shared faces are linked again.
 class ENGINE_API Pathfinding {
 public:
     class Tester {
@@ -19,106 +26,171 @@ public:
     };
 
     using Index = uint32_t;
-    using ChildrenMask = uint8_t;
-    using HashCode = uint64_t;
-
-    struct Node {
-        Index offset;
-        ChildrenMask children;
+    using Path = std::vector<Vector3>;
+
+    static constexpr Index invalidIndex = std::numeric_limits<Index>::max();
+
+    // Scratch memory of a single search, one per thread. Sized for the volume once, searches do not allocate.
+    class SearchState {
+    private:
+        friend class Pathfinding;
+
+        struct Scratch {
+            std::vector<float> cost;
+            std::vector<Index> parent;
+            std::vector<uint32_t> visited;
+            std::vector<std::pair<float, Index>> open;
+            uint32_t generation{0};
+
+            void reset(size_t size);
+        };
+
+        Scratch clusters;
+        Scratch cells;
+        std::vector<uint32_t> corridor;
+        uint32_t corridorGeneration{0};
+        std::vector<Index> route;
     };
 
-    struct NodeInfo {
-        Vector3i pos;
-        Index offset;
-        HashCode code;
-        int level;
+    explicit Pathfinding(Tester& tester, int depth, int scale, size_t cacheSize = 256);
 
-        operator bool() const {
-            return offset != 0;
-        }
-    };
+    // Tests the whole volume
+    void build();
+    // Marks the clusters overlapping the box, they are tested again by the next rebuild
+    void invalidate(const Vector3& min, const Vector3& max);
+    // Returns false if nothing was dirty
+    bool rebuild();
 
-    using NodeInfoCallback = std::function<void(const NodeInfo&)>;
+    // The free cell at the position, none if it is occupied or outside of the volume
+    [[nodiscard]] std::optional<Index> find(const Vector3& pos) const;
+    // Starts and ends at the exact positions, the waypoints in between are the centers of the cells.
+    // Safe to call from multiple threads with their own states, but not while the volume is being rebuilt.
+    std::optional<Path> findPath(const Vector3& from, const Vector3& to, SearchState& state) const;
 
-    struct NodeInfoDistance {
-        NodeInfo info;
-        uint64_t distance;
+    [[nodiscard]] int getDepth() const {
+        return depth;
+    }
 
-        bool operator<(const NodeInfoDistance& other) const {
-            return distance < other.distance;
-        }
-    };
+    [[nodiscard]] int getScale() const {
+        return scale;
+    }
+
+    [[nodiscard]] bool isBuilt() const {
+        return built;
+    }
+
+    [[nodiscard]] size_t getCellCount() const {
+        return cells.size() - freeCells.size();
+    }
+
+    [[nodiscard]] size_t getClusterCount() const {
+        return clusters.size();
+    }
+
+    [[nodiscard]] uint64_t getCacheHits() const {
+        return cacheHits;
+    }
+
+    [[nodiscard]] uint64_t getCacheMisses() const {
+        return cacheMisses;
+    }
 
-    struct Info {
-        HashCode from;
-        uint64_t cost;
+private:
+    enum class NodeState : uint8_t {
+        Free,
+        Blocked,
+        Split,
     };
 
-    struct QueryData {
-        NodeInfo start;
-        NodeInfo goal;
-        std::priority_queue<NodeInfoDistance> frontier;
-        std::unordered_map<HashCode, Info> costSoFar;
-        NodeInfoDistance current;
+    struct TreeNode {
+        // The first of the eight children
+        Index children{0};
+        // Only valid for the free nodes
+        Index cell{invalidIndex};
+        NodeState state{NodeState::Free};
     };
 
-    explicit Pathfinding(Tester& tester, int depth, int scale);
+    struct Cluster {
+        std::vector<TreeNode> nodes;
+        // The cells keep their indices until the cluster is rebuilt
+        std::vector<Index> cells;
+        bool dirty{true};
+    };
 
-    // using Node = uint64_t;
+    // In the leaf coordinates, a released cell has the size of zero
+    struct Cell {
+        Vector3i min;
+        int size;
+        Index cluster;
+    };
 
-    // size_t addNode();
+    // Adjacency of the nodes, each node owns a range of a single edge list. A node linked again appends a new
+    // range, the old ones are dropped once they take up half of the list.
+    struct Graph {
+        std::vector<Vector3> positions;
+        std::vector<Index> begins;
+        std::vector<Index> ends;
+        std::vector<Index> edges;
+        size_t garbage{0};
+
+        void resize(size_t size);
+        void link(Index node, const std::vector<Index>& targets);
+        void compact();
+    };
 
-    void build();
-    std::optional<HashCode> find(const Vector3& pos);
-    NodeInfo findNearest(const Vector3& pos, int maxLevel = std::numeric_limits<int>::max());
-    bool findPath(const Vector3& from, const Vector3& to);
-    // void iterate(const std::function<void(const Vector3i&, int)>& fn);
+    // Restricts the search to the nodes whose group is stamped with the current generation
+    struct Filter {
+        const std::vector<Index>* groups{nullptr};
+        const std::vector<uint32_t>* stamps{nullptr};
+        uint32_t generation{0};
 
-    [[nodiscard]] int getDepth() const {
-        return depth;
-    }
+        bool accepts(const Index node) const {
+            return !groups || (*stamps)[(*groups)[node]] == generation;
+        }
+    };
 
-    [[nodiscard]] int getScale() const {
-        return scale;
-    }
+    struct CacheEntry {
+        std::vector<Index> route;
+        std::list<uint64_t>::iterator lru;
+    };
 
-private:
-    using Nodes = std::vector<Node>;
-    using Layers = std::vector<Nodes>;
-
-    static constexpr size_t nodeCapacityMultipler{1024};
-
-    /*struct Bucket {
-        size_t used{0};
-        size_t next{0};
-    };*/
-
-    Index allocateTempNodes(int level);
-    Index allocateNodes(size_t num);
-    void optimize();
-    void build(Index index, const Vector3i& origin, int level);
-    void getNeighbours(const NodeInfo& info, QueryData& data);
-    void getNeighboursSide(const Index index, const Vector3i& origin, int level, HashCode previous, uint8_t side,
-                           QueryData& data);
-    void processNeighbour(const NodeInfo& next, QueryData& data);
-    std::optional<HashCode> find(Index index, const Vector3i& origin, int level, HashCode previous, const Vector3& pos);
-    NodeInfo findNearest(Index index, const Vector3i& origin, int level, HashCode previous, const Vector3& pos,
-                         int maxLevel);
-
-    // void iterate(size_t node, const Vector3i& origin, int level, const std::function<void(const Vector3i&, int)>&
-    // fn);
-
-    // inline void setNodeValue(size_t node, uint64_t offset, uint64_t mask, uint64_t value);
-    // inline uint64_t getNodeValue(size_t node, uint64_t offset, uint64_t mask);
+    void buildCluster(Index index);
+    void buildNode(Cluster& cluster, Index index, const Vector3i& min, int size);
+    void collectCells(Index cluster, Index index, const Vector3i& min, int size);
+    void releaseCells(Index cluster);
+    void linkCell(Index index, std::vector<Index>& neighbours);
+    void linkCluster(Index index, std::vector<Index>& neighbours);
+    Vector3i toLeaf(const Vector3& pos) const;
+    Vector3i getClusterMin(Index index) const;
+    Vector3 getCenter(const Vector3i& min, int size) const;
+    Index findCell(const Vector3i& leaf) const;
+    bool search(const Graph& graph, Index from, Index to, SearchState::Scratch& scratch, const Filter& filter,
+                std::vector<Index>& route) const;
+    bool findCachedRoute(uint64_t key, std::vector<Index>& route) const;
+    void storeCachedRoute(uint64_t key, const std::vector<Index>& route) const;
+    void evictCachedRoutes(const std::vector<uint8_t>& dirty);
 
     Tester& tester;
     const int depth;
     const int scale;
-    // std::vector<Bucket> buckets;
-
-    std::vector<Node> nodes;
-    // std::vector<Info> infos;
-    Layers temp;
-    std::array<size_t, 16> levels;
+    // Levels of the octree replaced by the grid of the clusters
+    const int clusterLevels;
+    const int clusterSize;
+    const size_t cacheSize;
+    bool built{false};
+
+    std::vector<Cluster> clusters;
+    std::vector<Cell> cells;
+    std::vector<Index> freeCells;
+    std::vector<Index> cellClusters;
+    Graph cellGraph;
+    Graph clusterGraph;
+
+    // Keyed by the start and the goal cell, the routes through the rebuilt clusters are dropped
+    mutable std::mutex cacheMutex;
+    mutable std::unordered_map<uint64_t, CacheEntry> cache;
+    mutable std::list<uint64_t> cacheLru;
+    mutable std::atomic<uint64_t> cacheHits{0};
+    mutable std::atomic<uint64_t> cacheMisses{0};
 };
 } // namespace Engine
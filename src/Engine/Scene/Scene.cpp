@@ -1,5 +1,6 @@
 #include "Scene.hpp"
 #include "../Assets/AssetsManager.hpp"
+#include "../Utils/Profiler.hpp"
 #include "Controllers/ControllerAgent.hpp"
 #include "Controllers/ControllerBullets.hpp"
 #include "Controllers/ControllerCamera.hpp"
@@ -20,6 +21,7 @@
 #include "Controllers/ControllerShipControl.hpp"
 #include "Controllers/ControllerStaticModel.hpp"
 #include "Controllers/ControllerText.hpp"
+#include "Controllers/ControllerTransform.hpp"
 #include "Controllers/ControllerTurret.hpp"
 #include "Controllers/ControllerWorldText.hpp"
 #include <sol/sol.hpp>
@@ -31,13 +33,14 @@ static auto logger = createLogger(LOG_FILENAME);
 Scene::Scene(const Config& config, VoxelShapeCache* voxelShapeCache, Lua* lua) :
     lua{lua}, dynamicsWorld{*this, reg, config} /*, counterTp{std::chrono::steady_clock::now()}*/ {
 
+    transforms = &addController<ControllerTransform>();
     addController<ControllerGrid>(dynamicsWorld, voxelShapeCache);
     addController<ControllerRigidBody>(dynamicsWorld);
     network = &addController<ControllerNetwork>();
-    auto& bullets = addController<ControllerBullets>(dynamicsWorld);
+    // Without the shape cache this is the server scene, which decides the bullet hits
+    auto& bullets = addController<ControllerBullets>(dynamicsWorld, config, voxelShapeCache == nullptr);
     addController<ControllerTurret>(dynamicsWorld, bullets);
     addController<ControllerModel>();
-    // addController<ControllerPathfinding>(dynamicsWorld);
 
     if (voxelShapeCache) {
         addController<ControllerCamera>();
@@ -55,7 +58,8 @@ Scene::Scene(const Config& config, VoxelShapeCache* voxelShapeCache, Lua* lua) :
         addController<ControllerLines>();
     } else {
         addController<ControllerShipControl>();
-        addController<ControllerAgent>();
+        addController<ControllerAgent>(config.server.agentThreads);
+        addController<ControllerPathfinding>(dynamicsWorld, config);
     }
 }
 
@@ -111,6 +115,8 @@ Entity Scene::fromHandle(EntityId handle) {
 }
 
 void Scene::update(const float delta) {
+    PROFILE_SCOPE("Scene::update");
+
     /*const auto now = std::chrono::steady_clock::now();
     if (counterTp + std::chrono::seconds{60} < now) {
         counterTp = now;
@@ -130,7 +136,19 @@ void Scene::update(const float delta) {
         renderTicks = 0;
     }*/
 
-    dynamicsWorld.update(delta);
+    if (simulationMode == SimulationMode::Full) {
+        PROFILE_SCOPE("DynamicsWorld::update");
+        dynamicsWorld.update(delta);
+    } else {
+        // Without the step the broadphase is not refreshed, the ray casts of the bullets would miss moved bodies
+        PROFILE_SCOPE("DynamicsWorld::updateAabbs");
+        dynamicsWorld.updateAabbs();
+    }
+
+    {
+        PROFILE_SCOPE("ControllerTransform::updateWorld");
+        transforms->updateWorld();
+    }
 
     //++updateTicks;
 
@@ -142,6 +160,7 @@ void Scene::update(const float delta) {
         /*auto& counter = updateCounters.at(type);
         const auto t0 = std::chrono::steady_clock::now();*/
 
+        PROFILE_SCOPE(controllerNames.at(type));
         controller->update(delta);
 
         /*const auto t1 = std::chrono::steady_clock::now();
@@ -155,10 +174,15 @@ void Scene::update(const float delta) {
 }
 
 void Scene::interpolate(const float delta) {
-    const auto& entities = reg.view<ComponentTransform, ComponentShipControl>(entt::exclude<TagDisabled>).each();
-    for (const auto&& [handle, transform, component] : entities) {
-        transform.interpolate();
+    network->interpolate(delta);
+}
+
+void Scene::setSimulationMode(const SimulationMode value) {
+    // The bodies were moved by their transforms only, the broadphase has to catch up before the next step
+    if (simulationMode == SimulationMode::Strategic && value == SimulationMode::Full) {
+        dynamicsWorld.updateAabbs();
     }
+    simulationMode = value;
 }
 
 void Scene::updateSelection() {
@@ -202,6 +226,7 @@ void Scene::updateSelection() {
 
 void Scene::recalculate(VulkanRenderer& vulkan) {
     dynamicsWorld.recalculate(vulkan);
+    transforms->updateWorld();
 
     // renderTicks++;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Utils/Exceptions.hpp"
+#include "../Utils/Profiler.hpp"
 #include "../Vulkan/VulkanPipeline.hpp"
 #include "Controller.hpp"
 #include "DynamicsWorld.hpp"
@@ -13,11 +14,19 @@ namespace Engine {
 class ENGINE_API Skybox;
 class ENGINE_API Lua;
 class ENGINE_API ControllerNetwork;
+class ENGINE_API ControllerTransform;
 
 class ENGINE_API Scene : public UserInput {
 public:
     using SelectedEntityCallback = std::function<void(std::optional<Entity>)>;
 
+    // The strategic mode skips the physics step, the controllers still move the entities along their paths.
+    // Used by the server for the sectors nobody is looking at.
+    enum class SimulationMode {
+        Full,
+        Strategic,
+    };
+
     explicit Scene(const Config& config, VoxelShapeCache* voxelShapeCache = nullptr, Lua* lua = nullptr);
     virtual ~Scene();
 
@@ -93,6 +102,9 @@ public:
         auto ptr = dynamic_cast<T*>(controller.get());
 
         controllers.emplace(type, std::move(controller));
+#ifdef TEMPORARY_ESCAPE_PROFILER
+        controllerNames.emplace(type, Profiler::getInstance().internTypeName(typeid(T)));
+#endif
         // updateCounters.emplace(type, 0);
         // renderCounters.emplace(type, 0);
 
@@ -147,11 +159,19 @@ public:
         return dynamicsWorld;
     }
 
+    void setSimulationMode(SimulationMode value);
+
+    SimulationMode getSimulationMode() const {
+        return simulationMode;
+    }
+
 private:
     void updateSelection();
 
     EntityRegistry reg;
     std::unordered_map<std::type_index, std::unique_ptr<Controller>> controllers;
+    // Readable names of the controllers for the profiler zones
+    std::unordered_map<std::type_index, const char*> controllerNames;
     /*std::unordered_map<std::type_index, uint64_t> updateCounters;
     std::unordered_map<std::type_index, uint64_t> renderCounters;
     std::chrono::steady_clock::time_point counterTp;
@@ -168,6 +188,8 @@ private:
     Lua* lua{nullptr};
     std::unordered_map<std::string, std::unique_ptr<sol::table>> entityTemplates;
     bool selectionEnabled{true};
+    SimulationMode simulationMode{SimulationMode::Full};
     ControllerNetwork* network{nullptr};
+    ControllerTransform* transforms{nullptr};
 };
 } // namespace Engine
@@ -0,0 +1,123 @@
+#include "SnapshotBuffer.hpp"
+#include <algorithm>
+
+using namespace Engine;
+
+// Smoothing of the running estimates, the clock drift is followed much slower than the jitter
+static constexpr float intervalSmoothing = 0.1f;
+static constexpr float jitterSmoothing = 0.1f;
+static constexpr float delaySmoothing = 0.05f;
+static constexpr double driftSmoothing = 0.01;
+
+SnapshotBuffer::SnapshotBuffer(const Options& options) : options{options}, delay{options.minDelay} {
+}
+
+void SnapshotBuffer::receive(const double serverTime, const double localTime) {
+    // The same tick may be split across several messages
+    if (clockOffset && serverTime <= lastServerTime) {
+        return;
+    }
+
+    // The earliest arrival defines the offset between the clocks, anything later than that is jitter
+    const auto offset = serverTime - localTime;
+    if (!clockOffset) {
+        clockOffset = offset;
+    } else {
+        const auto elapsed = static_cast<float>(serverTime - lastServerTime);
+        interval = interval > 0.0f ? interval + (elapsed - interval) * intervalSmoothing : elapsed;
+
+        if (offset > *clockOffset) {
+            clockOffset = offset;
+        } else {
+            clockOffset = *clockOffset + (offset - *clockOffset) * driftSmoothing;
+        }
+        jitter += (static_cast<float>(*clockOffset - offset) - jitter) * jitterSmoothing;
+    }
+    lastServerTime = serverTime;
+
+    // Changed gradually, a sudden change of the delay would make everything jump in time
+    const auto target = std::clamp(interval + jitter * options.jitterFactor, options.minDelay, options.maxDelay);
+    delay += (target - delay) * delaySmoothing;
+}
+
+void SnapshotBuffer::push(const EntityId entity, const double serverTime, const Matrix4& transform) {
+    auto& samples = entities[entity];
+
+    // Out of order or repeated within the same tick, the newest value of the tick wins
+    while (!samples.empty() && samples.back().time >= serverTime) {
+        samples.pop_back();
+    }
+
+    samples.push_back(decompose(serverTime, transform));
+    while (samples.size() > options.capacity) {
+        samples.pop_front();
+    }
+}
+
+void SnapshotBuffer::remove(const EntityId entity) {
+    entities.erase(entity);
+}
+
+void SnapshotBuffer::clear() {
+    entities.clear();
+    clockOffset.reset();
+    lastServerTime = 0.0;
+    interval = 0.0f;
+    jitter = 0.0f;
+    delay = options.minDelay;
+}
+
+double SnapshotBuffer::getPlayoutTime(const double localTime) const {
+    return localTime + clockOffset.value_or(0.0) - delay;
+}
+
+std::optional<Matrix4> SnapshotBuffer::sample(const EntityId entity, const double playoutTime) const {
+    const auto it = entities.find(entity);
+    if (it == entities.end() || it->second.empty()) {
+        return std::nullopt;
+    }
+
+    const auto& samples = it->second;
+    if (samples.size() == 1 || playoutTime <= samples.front().time) {
+        return blend(samples.front(), samples.front(), 0.0f);
+    }
+
+    const auto next = std::find_if(
+        samples.begin(), samples.end(), [&](const Sample& sample) { return sample.time > playoutTime; });
+
+    // Ran out of samples, continue along the last known motion for a while
+    auto time = playoutTime;
+    auto b = next;
+    if (next == samples.end()) {
+        b = std::prev(samples.end());
+        time = std::min(time, b->time + options.maxExtrapolation);
+    }
+    const auto a = std::prev(b);
+
+    const auto factor = static_cast<float>((time - a->time) / (b->time - a->time));
+    return blend(*a, *b, factor);
+}
+
+SnapshotBuffer::Sample SnapshotBuffer::decompose(const double time, const Matrix4& transform) {
+    Sample sample{};
+    sample.time = time;
+    sample.position = Vector3{transform[3]};
+    sample.scale = Vector3{glm::length(Vector3{transform[0]}),
+                           glm::length(Vector3{transform[1]}),
+                           glm::length(Vector3{transform[2]})};
+    sample.rotation = glm::quat_cast(withoutScale(transform));
+    return sample;
+}
+
+Matrix4 SnapshotBuffer::blend(const Sample& a, const Sample& b, const float factor) const {
+    if (glm::distance2(a.position, b.position) > options.snapDistance * options.snapDistance) {
+        const auto& s = factor < 1.0f ? a : b;
+        return glm::translate(s.position) * glm::toMat4(s.rotation) * glm::scale(s.scale);
+    }
+
+    // The factor goes past 1.0 when extrapolating
+    const auto position = a.position + (b.position - a.position) * factor;
+    const auto rotation = glm::normalize(glm::slerp(a.rotation, b.rotation, factor));
+    const auto scale = a.scale + (b.scale - a.scale) * factor;
+    return glm::translate(position) * glm::toMat4(rotation) * glm::scale(scale);
+}
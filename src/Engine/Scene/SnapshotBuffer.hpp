@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../Math/Matrix.hpp"
+#include "Component.hpp"
+#include <deque>
+#include <optional>
+#include <unordered_map>
+
+namespace Engine {
+// Keeps the last few transforms received from the server for every replicated entity, stamped with the server
+// time of the tick that produced them. The transforms are rendered a little behind the estimated server clock
+// (the playout delay), so there are two samples to interpolate between even when the updates arrive late or
+// unevenly. The delay adapts to the measured send interval and the arrival jitter. Once the samples run out
+// the motion is extrapolated for a limited time and then held.
+class ENGINE_API SnapshotBuffer {
+public:
+    struct Options {
+        float minDelay{0.05f};
+        float maxDelay{0.5f};
+        float maxExtrapolation{0.25f};
+        // Number of jitter deviations added on top of the send interval
+        float jitterFactor{3.0f};
+        // Samples further apart are treated as a teleport and are not interpolated
+        float snapDistance{1000.0f};
+        size_t capacity{8};
+    };
+
+    SnapshotBuffer() = default;
+    explicit SnapshotBuffer(const Options& options);
+
+    // Called once for every received update message, before the samples of that message are pushed
+    void receive(double serverTime, double localTime);
+    void push(EntityId entity, double serverTime, const Matrix4& transform);
+    void remove(EntityId entity);
+    void clear();
+
+    [[nodiscard]] std::optional<Matrix4> sample(EntityId entity, double playoutTime) const;
+    [[nodiscard]] double getPlayoutTime(double localTime) const;
+
+    template <typename Fn> void forEach(Fn&& fn) const {
+        for (const auto& [entity, samples] : entities) {
+            fn(entity);
+        }
+    }
+
+    [[nodiscard]] float getDelay() const {
+        return delay;
+    }
+    [[nodiscard]] float getInterval() const {
+        return interval;
+    }
+    [[nodiscard]] float getJitter() const {
+        return jitter;
+    }
+    [[nodiscard]] size_t size() const {
+        return entities.size();
+    }
+
+private:
+    struct Sample {
+        double time;
+        Vector3 position;
+        Quaternion rotation;
+        Vector3 scale;
+    };
+
+    static Sample decompose(double time, const Matrix4& transform);
+    [[nodiscard]] Matrix4 blend(const Sample& a, const Sample& b, float factor) const;
+
+    Options options;
+    std::unordered_map<EntityId, std::deque<Sample>> entities;
+    std::optional<double> clockOffset;
+    double lastServerTime{0.0};
+    float interval{0.0f};
+    float jitter{0.0f};
+    float delay{0.1f};
+};
+} // namespace Engine
@@ -88,7 +88,16 @@ static void bindComponentTurret(sol::table& m) {
 LUA_BINDINGS(bindComponentTurret);
 
 static void bindComponentAgent(sol::table& m) {
+    m.new_enum("AgentPriority",
+               "LOW",
+               AgentPriority::Low,
+               "NORMAL",
+               AgentPriority::Normal,
+               "HIGH",
+               AgentPriority::High);
+
     auto cls = m.new_usertype<ComponentAgent>("ComponentAgent");
+    cls["priority"] = sol::property(&ComponentAgent::getPriority, &ComponentAgent::setPriority);
 }
 
 LUA_BINDINGS(bindComponentAgent);
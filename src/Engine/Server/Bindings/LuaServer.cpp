@@ -43,6 +43,37 @@ static void bindSystemHeuristics(sol::table& m) {
 
 LUA_BINDINGS(bindSystemHeuristics);
 
+// The functions of a sector type module loaded into a state of its own, released before the state
+struct LuaSectorType {
+    std::unique_ptr<Lua> lua;
+    sol::function heuristics;
+    sol::function onCreate;
+};
+
+static Generator::SectorTypeCallbacks loadSectorModule(const std::string& module) {
+    auto type = std::make_shared<LuaSectorType>();
+    type->lua = Server::instance->getLuaPool().acquire();
+    type->lua->require(module, [&](sol::table& table) {
+        type->heuristics = table["heuristics_callback"];
+        type->onCreate = table["on_create_sector"];
+    });
+
+    if (!type->heuristics.valid() || !type->onCreate.valid()) {
+        EXCEPTION("Sector module: '{}' must return heuristics_callback and on_create_sector", module);
+    }
+
+    return Generator::SectorTypeCallbacks{
+        [type](SystemHeuristics& h) {
+            LUA_CALL_FN(type->heuristics, h)
+            return result.get<float>();
+        },
+        [type](SystemHeuristics& h, uint64_t seed) {
+            LUA_CALL_FN(type->onCreate, h, seed)
+            return result.get<SectorData>();
+        },
+    };
+}
+
 static void bindGenerator(sol::table& m) {
     auto cls = m.new_usertype<Generator>("Generator");
     cls["add_on_start"] = [](Generator& self, sol::function fn) {
@@ -89,6 +120,10 @@ static void bindGenerator(sol::table& m) {
                 return result.get<SectorData>();
             });
     };
+    // Every generator thread requires the module in a pooled state, so the type runs in parallel
+    cls["add_sector_module"] = [](Generator& self, const std::string& name, const std::string& module) {
+        self.addSectorTypeFactory(name, [module]() { return loadSectorModule(module); });
+    };
 }
 
 LUA_BINDINGS(bindGenerator);
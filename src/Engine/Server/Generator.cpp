@@ -7,8 +7,10 @@
 #include "../Server/Lua.hpp"
 #include "../Utils/NameGenerator.hpp"
 #include "../Utils/Random.hpp"
+#include <atomic>
 #include <queue>
 #include <sol/sol.hpp>
+#include <thread>
 
 using namespace Engine;
 
@@ -97,6 +99,58 @@ static const SystemData& getNearestSystem(const std::vector<SystemData>& systems
     return *ptr;
 }
 
+static std::optional<FactionData> findFaction(const std::vector<FactionData>& factions,
+                                              const std::optional<std::string>& factionId) {
+    if (!factionId) {
+        return std::nullopt;
+    }
+    const auto found =
+        std::find_if(factions.begin(), factions.end(), [&](const FactionData& f) { return f.id == *factionId; });
+    return found != factions.end() ? std::optional<FactionData>{*found} : std::nullopt;
+}
+
+// Calls fn(i, thread) for every index from a fixed number of threads, the first exception is rethrown
+template <typename Fn> static void parallelFor(const size_t count, const size_t threads, const Fn& fn) {
+    if (threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    std::exception_ptr error;
+
+    const auto work = [&](const size_t thread) {
+        try {
+            for (auto i = next++; i < count; i = next++) {
+                fn(i, thread);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (!error) {
+                error = std::current_exception();
+            }
+            next = count;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(std::min(threads, count) - 1);
+    for (size_t t = 1; t < std::min(threads, count); t++) {
+        pool.emplace_back(work, t);
+    }
+    work(0);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
 template <typename T, typename... Args> static void callback(const std::vector<T>& fns, Args&&... args) {
     for (const auto& fn : fns) {
         fn(std::forward<Args>(args)...);
@@ -149,13 +203,31 @@ float SystemHeuristics::getSystemRadius() const {
 }
 
 void Generator::addSectorType(const std::string& name, SystemHeuristicsCallback heuristics,
-                              OnCreateSystemCallback onCreate) {
+                              OnCreateSystemCallback onCreate, const bool concurrent) {
     systemTypes[name] = SystemType{
         std::move(heuristics),
         std::move(onCreate),
+        concurrent,
+        nullptr,
     };
 }
 
+void Generator::addSectorTypeFactory(const std::string& name, SectorTypeFactory factory) {
+    systemTypes[name] = SystemType{
+        nullptr,
+        nullptr,
+        true,
+        std::move(factory),
+    };
+}
+
+size_t Generator::getThreadCount() const {
+    if (options.threads > 0) {
+        return options.threads;
+    }
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
 void Generator::generate(const uint64_t seed) {
     logger.info("Generating world with seed: {}", seed);
 
@@ -172,12 +244,25 @@ void Generator::generate(const uint64_t seed) {
 
         Rng rng{seed};
 
-        const auto galaxy = createMainGalaxy(galaxyId, randomSeed(rng));
-        db.put<MetaData>("main_galaxy_id", *mainGalaxyId);
+        auto factions = db.seekAll<FactionData>("");
+        if (factions.empty()) {
+            EXCEPTION("Can not generate galaxy, no factions in the database");
+        }
+
+        // Every phase passes its results to the next one in memory, the whole galaxy
+        // is written into the database as a single table file once it is complete
+        auto batch = db.startBulkLoad();
+        std::vector<std::vector<PlanetData>> planets;
 
-        createGalaxyRegions(galaxyId);
-        createGalaxySystems(galaxyId);
-        createGalaxySectors(galaxyId);
+        const auto galaxy = createMainGalaxy(*batch, galaxyId, randomSeed(rng));
+        const auto regions = createGalaxyRegions(*batch, galaxy);
+        const auto systems = createGalaxySystems(*batch, galaxy, regions, factions, planets);
+        createGalaxySectors(*batch, galaxy, systems, planets, factions);
+
+        batch->commit();
+
+        // Written last, an interrupted generation starts over on the next boot
+        db.put<MetaData>("main_galaxy_id", *mainGalaxyId);
 
         callback(callbacks.onEnd, galaxy);
     } else {
@@ -207,14 +292,14 @@ void Generator::generate(const uint64_t seed) {
     }
 }*/
 
-GalaxyData Generator::createMainGalaxy(const std::string& galaxyId, const uint64_t seed) {
+GalaxyData Generator::createMainGalaxy(Database& batch, const std::string& galaxyId, const uint64_t seed) {
     auto galaxy = GalaxyData{};
     galaxy.id = galaxyId;
     galaxy.name = "Main Galaxy";
     galaxy.pos = Vector2{0.0f, 0.0f};
     galaxy.seed = seed;
 
-    db.put<GalaxyData>(galaxyId, galaxy);
+    batch.put<GalaxyData>(galaxyId, galaxy);
 
     logger.info("Galaxy was generated with id: {}", galaxyId);
 
@@ -223,30 +308,36 @@ GalaxyData Generator::createMainGalaxy(const std::string& galaxyId, const uint64
     return galaxy;
 }
 
-void Generator::createGalaxyRegions(const std::string& galaxyId) {
-    const auto galaxy = db.get<GalaxyData>(galaxyId);
-
+std::vector<RegionData> Generator::createGalaxyRegions(Database& batch, const GalaxyData& galaxy) {
     Rng rng{galaxy.seed + 10};
 
     const auto positions = randomCirclePositions(
         rng, options.galaxyWidthMax * 0.8f, options.galaxyRegionsMax, options.galaxyRegionDistanceMin);
 
+    std::vector<RegionData> regions;
+    regions.reserve(positions.size());
+
     for (const auto& pos : positions) {
-        auto region = RegionData{};
+        auto& region = regions.emplace_back();
         region.id = uuid();
         region.pos = pos;
         region.name = randomRegionName(rng);
 
-        db.put<RegionData>(fmt::format("{}/{}", galaxyId, region.id), region);
+        batch.put<RegionData>(fmt::format("{}/{}", galaxy.id, region.id), region);
 
         callback(callbacks.onRegionCreated, galaxy, region);
     }
 
-    logger.info("Created {} regions in galaxy {}", positions.size(), galaxyId);
+    logger.info("Created {} regions in galaxy {}", regions.size(), galaxy.id);
+
+    return regions;
 }
 
-void Generator::createGalaxySystems(const std::string& galaxyId) {
-    const auto galaxy = db.get<GalaxyData>(galaxyId);
+std::vector<SystemData> Generator::createGalaxySystems(Database& batch, const GalaxyData& galaxy,
+                                                       const std::vector<RegionData>& regions,
+                                                       std::vector<FactionData>& factions,
+                                                       std::vector<std::vector<PlanetData>>& planets) {
+    const auto& galaxyId = galaxy.id;
 
     // Random generator specific to generating systems
     Rng rng{galaxy.seed + 20};
@@ -402,48 +493,106 @@ void Generator::createGalaxySystems(const std::string& galaxyId) {
         }
     }
 
-    fillGalaxyRegions(galaxyId, positions, connections, systems);
-    findFactionHomes(galaxyId, systems);
-    fillGalaxyFactions(galaxyId, positions, connections, systems);
+    fillGalaxyRegions(regions, positions, connections, systems);
+    findFactionHomes(batch, galaxy, factions, systems);
+    fillGalaxyFactions(factions, positions, connections, systems);
 
-    auto factions = db.seekAll<FactionData>("");
+    const auto planetTypes = assetsManager.getPlanetTypes().findAll();
+    if (planetTypes.empty()) {
+        EXCEPTION("Can not generate galaxy, no planet types in the assets");
+    }
 
-    for (auto& system : systems) {
-        fillSystemPlanets(galaxyId, system);
+    // Every system has its own random stream, so the result does not depend on the order the threads run in
+    planets.clear();
+    planets.resize(systems.size());
+    parallelFor(systems.size(), getThreadCount(), [&](const size_t i, const size_t thread) {
+        (void)thread;
+        planets[i] = fillSystemPlanets(galaxy, systems[i], planetTypes);
+    });
 
-        const auto key = fmt::format("{}/{}", galaxyId, system.id);
-        db.put<SystemData>(key, system);
+    for (size_t i = 0; i < systems.size(); i++) {
+        const auto& system = systems[i];
+
+        for (const auto& planet : planets[i]) {
+            batch.put<PlanetData>(fmt::format("{}/{}/{}", galaxyId, system.id, planet.id), planet);
+        }
 
-        const auto found = system.factionId
-                               ? std::find_if(factions.begin(),
-                                              factions.end(),
-                                              [&](const FactionData& f) { return f.id == system.factionId; })
-                               : factions.end();
+        const auto key = fmt::format("{}/{}", galaxyId, system.id);
+        batch.put<SystemData>(key, system);
 
-        const auto faction = found != factions.end() ? std::optional<FactionData>{*found} : std::nullopt;
+        const auto faction = findFaction(factions, system.factionId);
         callback(callbacks.onSystemCreated, galaxy, system, faction);
     }
 
     logger.info("Created {} systems in galaxy {}", systems.size(), galaxyId);
+
+    return systems;
 }
 
-void Generator::createGalaxySectors(const std::string& galaxyId) {
-    const auto galaxy = db.get<GalaxyData>(galaxyId);
+void Generator::createGalaxySectors(Database& batch, const GalaxyData& galaxy, const std::vector<SystemData>& systems,
+                                    const std::vector<std::vector<PlanetData>>& planets,
+                                    const std::vector<FactionData>& factions) {
+    std::vector<std::optional<FactionData>> systemFactions;
+    systemFactions.reserve(systems.size());
+    for (const auto& system : systems) {
+        systemFactions.push_back(findFaction(factions, system.factionId));
+    }
+
+    // Sector types added with a callback from the main Lua state can not be called from multiple threads
+    const auto concurrent = std::all_of(
+        systemTypes.begin(), systemTypes.end(), [](const auto& pair) { return pair.second.concurrent; });
+    const auto threads = concurrent ? std::min(getThreadCount(), std::max<size_t>(systems.size(), 1)) : 1;
+
+    // Every thread evaluates the types in the order of their names, not in the order of the hash map
+    std::vector<std::string> names;
+    names.reserve(systemTypes.size());
+    for (const auto& [name, type] : systemTypes) {
+        names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+
+    // Created by the thread that uses them, a factory may load its callbacks into a new Lua state
+    std::vector<std::vector<SectorTypeCallbacks>> instances(threads);
+    const auto getInstances = [&](const size_t thread) -> const std::vector<SectorTypeCallbacks>& {
+        auto& types = instances[thread];
+        if (types.size() != names.size()) {
+            for (const auto& name : names) {
+                const auto& type = systemTypes.at(name);
+                types.push_back(type.factory ? type.factory() : SectorTypeCallbacks{type.heuristics, type.onCreate});
+            }
+        }
+        return types;
+    };
+
+    std::vector<std::vector<SectorData>> sectors(systems.size());
+    parallelFor(systems.size(), threads, [&](const size_t i, const size_t thread) {
+        sectors[i] = createSystemSectors(
+            getInstances(thread), galaxy, systems, systems[i], planets[i], systemFactions[i]);
+    });
 
-    const auto systems = db.seekAll<SystemData>(fmt::format("{}/", galaxyId));
+    // Merged in the order of the systems, the callbacks always run on the calling thread
     size_t total{0};
-    for (const auto& system : systems) {
-        total += createGalaxySectors(galaxy, systems, system);
+    for (size_t i = 0; i < systems.size(); i++) {
+        const auto& system = systems[i];
+        for (const auto& sector : sectors[i]) {
+            batch.put(fmt::format("{}/{}/{}", galaxy.id, system.id, sector.id), sector);
+            callback(callbacks.onSectorCreated, galaxy, system, systemFactions[i], sector);
+        }
+        total += sectors[i].size();
     }
 
-    logger.info("Created {} sectors in galaxy {}", total, galaxyId);
+    logger.info("Created {} sectors in galaxy {} using {} threads", total, galaxy.id, threads);
 }
 
-size_t Generator::createGalaxySectors(const GalaxyData& galaxy, const std::vector<SystemData>& systems,
-                                      const SystemData& system) {
+std::vector<SectorData> Generator::createSystemSectors(const std::vector<SectorTypeCallbacks>& types,
+                                                       const GalaxyData& galaxy,
+                                                       const std::vector<SystemData>& systems,
+                                                       const SystemData& system,
+                                                       const std::vector<PlanetData>& planets,
+                                                       const std::optional<FactionData>& faction) const {
     struct Probability {
         float value;
-        std::string key;
+        size_t index;
 
         bool operator<(const Probability& other) const {
             return value < other.value;
@@ -452,22 +601,17 @@ size_t Generator::createGalaxySectors(const GalaxyData& galaxy, const std::vecto
 
     Rng rng{system.seed};
 
-    size_t total{0};
-
-    const auto planets = db.seekAll<PlanetData>(fmt::format("{}/{}/", galaxy.id, system.id), 0);
     std::vector<SectorData> sectors;
 
-    const auto faction = system.factionId ? db.find<FactionData>(*system.factionId) : std::nullopt;
-
     SystemHeuristics heuristics{galaxy, system, systems, sectors, planets, faction};
 
     while (true) {
         std::priority_queue<Probability> queue;
 
-        for (const auto& [key, type] : systemTypes) {
-            const auto probability = type.heuristics(heuristics);
+        for (size_t i = 0; i < types.size(); i++) {
+            const auto probability = types[i].heuristics(heuristics);
             if (probability > 0.0f) {
-                queue.push(Probability{probability, key});
+                queue.push(Probability{probability, i});
             }
         }
 
@@ -478,15 +622,11 @@ size_t Generator::createGalaxySectors(const GalaxyData& galaxy, const std::vecto
         const auto& top = queue.top();
         const auto seed = randomSeed(rng);
 
-        auto sector = systemTypes[top.key].onCreate(heuristics, seed);
+        auto sector = types[top.index].onCreate(heuristics, seed);
         if (sector.id.empty()) {
             EXCEPTION("Sector id is empty");
         }
 
-        db.put(fmt::format("{}/{}/{}", galaxy.id, system.id, sector.id), sector);
-
-        callback(callbacks.onSectorCreated, galaxy, system, faction, sector);
-
         sectors.push_back(std::move(sector));
     }
 
@@ -559,15 +699,12 @@ size_t Generator::createGalaxySectors(const GalaxyData& galaxy, const std::vecto
         total += count;
     }*/
 
-    return total;
+    return sectors;
 }
 
-void Generator::fillGalaxyRegions(const std::string& galaxyId, const std::vector<Vector2>& positions,
+void Generator::fillGalaxyRegions(const std::vector<RegionData>& regions, const std::vector<Vector2>& positions,
                                   const std::unordered_map<size_t, std::vector<size_t>>& connections,
                                   std::vector<SystemData>& systems) {
-
-    auto regions = db.seekAll<RegionData>(fmt::format("{}/", galaxyId));
-
     auto floodFill = FloodFillPoints{};
 
     for (size_t i = 0; i < regions.size(); i++) {
@@ -596,14 +733,8 @@ void Generator::fillGalaxyRegions(const std::string& galaxyId, const std::vector
     logger.info("Associated regions with {} systems", systems.size());
 }
 
-void Generator::findFactionHomes(const std::string& galaxyId, std::vector<SystemData>& systems) {
-    auto factions = db.seekAll<FactionData>("");
-    if (factions.empty()) {
-        EXCEPTION("Can not generate galaxy, no factions in the database");
-    }
-
-    const auto galaxy = db.get<GalaxyData>(galaxyId);
-
+void Generator::findFactionHomes(Database& batch, const GalaxyData& galaxy, std::vector<FactionData>& factions,
+                                 std::vector<SystemData>& systems) {
     // Random generator specific to generating faction homes
     Rng rng{galaxy.seed + 30};
 
@@ -615,15 +746,15 @@ void Generator::findFactionHomes(const std::string& galaxyId, std::vector<System
         const auto& pos = positions.at(i);
         const auto& system = getNearestSystem(systems, pos);
 
-        factions.at(i).homeGalaxyId = galaxyId;
+        factions.at(i).homeGalaxyId = galaxy.id;
         factions.at(i).homeSystemId = system.id;
-        db.put<FactionData>(factions.at(i).id, factions.at(i));
+        batch.put<FactionData>(factions.at(i).id, factions.at(i));
     }
 
     logger.info("Updated faction homes");
 }
 
-void Generator::fillGalaxyFactions(const std::string& galaxyId, const std::vector<Vector2>& positions,
+void Generator::fillGalaxyFactions(const std::vector<FactionData>& factions, const std::vector<Vector2>& positions,
                                    const std::unordered_map<size_t, std::vector<size_t>>& connections,
                                    std::vector<SystemData>& systems) {
     // Index map converts a system id into an index
@@ -633,11 +764,6 @@ void Generator::fillGalaxyFactions(const std::string& galaxyId, const std::vecto
         indexes.emplace(systems.at(i).id, i);
     }
 
-    auto factions = db.seekAll<FactionData>("");
-    if (factions.empty()) {
-        EXCEPTION("Can not generate galaxy, no factions in the database");
-    }
-
     auto floodFill = FloodFillPoints{};
 
     for (size_t i = 0; i < factions.size(); i++) {
@@ -674,19 +800,18 @@ void Generator::fillGalaxyFactions(const std::string& galaxyId, const std::vecto
     logger.info("Associated factions with {} systems", total);
 }
 
-void Generator::fillSystemPlanets(const std::string& galaxyId, const SystemData& system) {
-    const auto galaxy = db.get<GalaxyData>(galaxyId);
-    const auto planetTypes = assetsManager.getPlanetTypes().findAll();
-    if (planetTypes.empty()) {
-        EXCEPTION("Can not generate galaxy, no planet types in the assets");
-    }
+std::vector<PlanetData> Generator::fillSystemPlanets(const GalaxyData& galaxy, const SystemData& system,
+                                                    const std::vector<PlanetTypePtr>& planetTypes) const {
+    const auto& galaxyId = galaxy.id;
 
-    // Random generator specific to generating faction homes
-    Rng rng{galaxy.seed + 40};
+    // Random generator specific to generating planets of this system
+    Rng rng{system.seed + 40};
 
     float orbitDistance = 0.0f;
     const auto totalPlanets = randomInt<size_t>(rng, options.systemPlanetsMin, options.systemPlanetsMax);
 
+    std::vector<PlanetData> planets;
+
     for (size_t p = 0; p < totalPlanets; p++) {
         PlanetData planet{};
         planet.id = uuid();
@@ -727,13 +852,15 @@ void Generator::fillSystemPlanets(const std::string& galaxyId, const SystemData&
 
         for (auto& moon : moons) {
             moon.pos += planet.pos;
-
-            db.put<PlanetData>(fmt::format("{}/{}/{}", galaxyId, system.id, moon.id), moon);
         }
 
         orbitDistance += moonOrbitDistance;
-        db.put<PlanetData>(fmt::format("{}/{}/{}", galaxyId, system.id, planet.id), planet);
+
+        planets.push_back(std::move(planet));
+        std::move(moons.begin(), moons.end(), std::back_inserter(planets));
     }
+
+    return planets;
 }
 
 std::string Generator::getRandomName(Rng& rng) const {
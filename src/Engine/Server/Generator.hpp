@@ -67,6 +67,8 @@ public:
         float planetDistanceMax{12.0f};
         float moonDistanceMin{1.0f};
         float moonDistanceMax{2.5f};
+        // Threads used for the per system phases, zero picks the number of cores
+        size_t threads{0};
     };
 
     using OnGeneratorStartCallback = std::function<void(uint64_t)>;
@@ -82,13 +84,25 @@ public:
     using SystemHeuristicsCallback = std::function<float(SystemHeuristics&)>;
     using OnCreateSystemCallback = std::function<SectorData(SystemHeuristics&, uint64_t)>;
 
+    struct SectorTypeCallbacks {
+        SystemHeuristicsCallback heuristics;
+        OnCreateSystemCallback onCreate;
+    };
+    using SectorTypeFactory = std::function<SectorTypeCallbacks()>;
+
     explicit Generator(const Options& options, AssetsManager& assetsManager, Database& db);
     virtual ~Generator() = default;
 
     void generate(uint64_t seed);
     // void populate(const SectorData& sector, Scene& scene);
 
-    void addSectorType(const std::string& name, SystemHeuristicsCallback heuristics, OnCreateSystemCallback onCreate);
+    // Concurrent sector types may be called from multiple threads at once, the per system phase
+    // only runs in parallel when all of the registered types are concurrent
+    void addSectorType(const std::string& name, SystemHeuristicsCallback heuristics, OnCreateSystemCallback onCreate,
+                       bool concurrent = false);
+    // The factory is called once by every thread of the per system phase, which then only calls the callbacks
+    // it got, so the type always runs in parallel (e.g. with the callbacks loaded into a Lua state of its own)
+    void addSectorTypeFactory(const std::string& name, SectorTypeFactory factory);
 
     void addOnStart(OnGeneratorStartCallback fn) {
         callbacks.onStart.push_back(std::move(fn));
@@ -125,22 +139,34 @@ private:
     struct SystemType {
         SystemHeuristicsCallback heuristics;
         OnCreateSystemCallback onCreate;
+        bool concurrent{false};
+        SectorTypeFactory factory;
     };
 
-    GalaxyData createMainGalaxy(const std::string& galaxyId, uint64_t seed);
-    void createGalaxyRegions(const std::string& galaxyId);
-    void createGalaxySystems(const std::string& galaxyId);
-    void createGalaxySectors(const std::string& galaxyId);
-    size_t createGalaxySectors(const GalaxyData& galaxy, const std::vector<SystemData>& systems,
-                               const SystemData& system);
-    void fillGalaxyRegions(const std::string& galaxyId, const std::vector<Vector2>& positions,
+    GalaxyData createMainGalaxy(Database& batch, const std::string& galaxyId, uint64_t seed);
+    std::vector<RegionData> createGalaxyRegions(Database& batch, const GalaxyData& galaxy);
+    std::vector<SystemData> createGalaxySystems(Database& batch, const GalaxyData& galaxy,
+                                                const std::vector<RegionData>& regions,
+                                                std::vector<FactionData>& factions,
+                                                std::vector<std::vector<PlanetData>>& planets);
+    void createGalaxySectors(Database& batch, const GalaxyData& galaxy, const std::vector<SystemData>& systems,
+                             const std::vector<std::vector<PlanetData>>& planets,
+                             const std::vector<FactionData>& factions);
+    std::vector<SectorData> createSystemSectors(const std::vector<SectorTypeCallbacks>& types,
+                                                const GalaxyData& galaxy, const std::vector<SystemData>& systems,
+                                                const SystemData& system, const std::vector<PlanetData>& planets,
+                                                const std::optional<FactionData>& faction) const;
+    void fillGalaxyRegions(const std::vector<RegionData>& regions, const std::vector<Vector2>& positions,
                            const std::unordered_map<size_t, std::vector<size_t>>& connections,
                            std::vector<SystemData>& systems);
-    void findFactionHomes(const std::string& galaxyId, std::vector<SystemData>& systems);
-    void fillGalaxyFactions(const std::string& galaxyId, const std::vector<Vector2>& positions,
+    void findFactionHomes(Database& batch, const GalaxyData& galaxy, std::vector<FactionData>& factions,
+                          std::vector<SystemData>& systems);
+    void fillGalaxyFactions(const std::vector<FactionData>& factions, const std::vector<Vector2>& positions,
                             const std::unordered_map<size_t, std::vector<size_t>>& connections,
                             std::vector<SystemData>& systems);
-    void fillSystemPlanets(const std::string& galaxyId, const SystemData& system);
+    std::vector<PlanetData> fillSystemPlanets(const GalaxyData& galaxy, const SystemData& system,
+                                              const std::vector<PlanetTypePtr>& planetTypes) const;
+    size_t getThreadCount() const;
 
     const Options options;
     AssetsManager& assetsManager;
@@ -7,6 +7,7 @@
 #include "../Math/VolumeOccupancyTester.hpp"
 #include "../Utils/Exceptions.hpp"
 #include "../Utils/Log.hpp"
+#include "../Utils/Md5.hpp"
 #include "../Utils/NameGenerator.hpp"
 #include "../Utils/Path.hpp"
 #include "../Utils/Random.hpp"
@@ -16,8 +17,16 @@
 
 using namespace Engine;
 
+// Sectors create their states on the load thread while the server uses its own
+static std::mutex instancesMutex;
 static std::unordered_map<lua_State*, Lua::Data*> instances;
 
+// Compiled chunks shared by all Lua instances, keyed by the file path and the hash of its source
+static std::mutex chunksMutex;
+static std::unordered_map<std::string, std::shared_ptr<const std::string>> chunks;
+static std::atomic<uint64_t> chunksHits{0};
+static std::atomic<uint64_t> chunksMisses{0};
+
 static auto logger = createLogger(LOG_FILENAME);
 
 static void backtrace(std::stringstream& out, const std::exception& e) {
@@ -74,10 +83,93 @@ struct Lua::Data {
 static sol::table requireEngine(sol::this_state state) {
     logger.info("Require engine lua state: {}", reinterpret_cast<uint64_t>(state.lua_state()));
 
+    std::lock_guard<std::mutex> lock{instancesMutex};
     auto& self = instances.at(state.lua_state());
     return self->engine;
 }
 
+static int writeChunk(lua_State* L, const void* p, const size_t size, void* ud) {
+    (void)L;
+    static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+    return 0;
+}
+
+// Pushes the compiled chunk of the file onto the stack, the source is parsed only the first time
+// any instance loads it, or after it has changed. Returns the status of the load, the error message
+// is left on the stack, so the caller raises it once no C++ objects are alive.
+static int loadCachedChunk(lua_State* L, const std::string& filename) {
+    const auto source = readFileStr(filename);
+    const auto key = fmt::format("{}:{}", filename, md5sum(source.data(), source.size()));
+    const auto chunkName = fmt::format("@{}", filename);
+
+    std::shared_ptr<const std::string> bytecode;
+    {
+        std::lock_guard<std::mutex> lock{chunksMutex};
+        if (const auto it = chunks.find(key); it != chunks.end()) {
+            bytecode = it->second;
+        }
+    }
+
+    if (bytecode) {
+        ++chunksHits;
+        return luaL_loadbufferx(L, bytecode->data(), bytecode->size(), chunkName.c_str(), "b");
+    }
+
+    ++chunksMisses;
+    const auto status = luaL_loadbufferx(L, source.data(), source.size(), chunkName.c_str(), "t");
+    if (status != LUA_OK) {
+        return status;
+    }
+
+    // Debug info is kept, so the tracebacks still point to the source lines
+    auto dumped = std::make_shared<std::string>();
+    lua_dump(L, &writeChunk, dumped.get(), 0);
+
+    std::lock_guard<std::mutex> lock{chunksMutex};
+    chunks.insert_or_assign(key, std::move(dumped));
+    return LUA_OK;
+}
+
+// Replaces the default Lua file searcher of the require() function
+static int searchCachedChunk(lua_State* L) {
+    const auto* name = luaL_checkstring(L, 1);
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchpath");
+    lua_pushstring(L, name);
+    lua_getfield(L, -3, "path");
+    lua_call(L, 2, 2);
+
+    if (lua_isnil(L, -2)) {
+        // Not found, the error message goes back to require()
+        return 1;
+    }
+
+    // Only the file name stays on the stack, it is passed to the loader as the second argument
+    lua_pop(L, 1);
+    lua_remove(L, -2);
+    const auto filenameIndex = lua_gettop(L);
+
+    int status;
+    try {
+        status = loadCachedChunk(L, lua_tostring(L, filenameIndex));
+    } catch (std::exception& e) {
+        lua_pushstring(L, e.what());
+        status = LUA_ERRFILE;
+    }
+
+    if (status != LUA_OK) {
+        return luaL_error(L,
+                          "error loading module '%s' from file '%s':\n\t%s",
+                          name,
+                          lua_tostring(L, filenameIndex),
+                          lua_tostring(L, -1));
+    }
+
+    lua_pushvalue(L, filenameIndex);
+    return 2;
+}
+
 class Lua::EventHandler : EventBus::Listener {
 public:
     explicit EventHandler(EventBus& eventBus) : EventBus::Listener{eventBus} {
@@ -132,7 +224,14 @@ Lua::Lua(const Config& config, EventBus& eventBus) : config{config}, data{std::m
     data->engine = data->state.create_table();
 
     // Remember out instance
-    instances.insert(std::make_pair(data->state.lua_state(), data.get()));
+    {
+        std::lock_guard<std::mutex> lock{instancesMutex};
+        instances.insert(std::make_pair(data->state.lua_state(), data.get()));
+    }
+
+    // Lua files are loaded through the shared chunk cache, the default file searcher is the second one
+    auto searchers = data->state["package"]["searchers"].get<sol::table>();
+    searchers[2] = &searchCachedChunk;
 
     // The "engine" module will be exposed via the require() function
     data->state.require("engine", sol::c_call<decltype(&requireEngine), &requireEngine>, false);
@@ -150,9 +249,24 @@ Lua::Lua(const Config& config, EventBus& eventBus) : config{config}, data{std::m
 }
 
 Lua::~Lua() {
+    std::lock_guard<std::mutex> lock{instancesMutex};
     instances.erase(data->state.lua_state());
 }
 
+Lua::ChunkCacheStats Lua::getChunkCacheStats() {
+    ChunkCacheStats stats{};
+    stats.hits = chunksHits.load();
+    stats.misses = chunksMisses.load();
+    std::lock_guard<std::mutex> lock{chunksMutex};
+    stats.size = chunks.size();
+    return stats;
+}
+
+void Lua::clearChunkCache() {
+    std::lock_guard<std::mutex> lock{chunksMutex};
+    chunks.clear();
+}
+
 void Lua::importModule(const std::string_view& name, const std::string_view& file) {
     const auto path = config.assetsPath / name / file;
     if (Fs::exists(path) && Fs::is_regular_file(path)) {
@@ -162,6 +276,33 @@ void Lua::importModule(const std::string_view& name, const std::string_view& fil
     }
 }
 
+void Lua::precompile(const std::string_view& name) {
+    auto res = data->state["package"]["searchpath"](name, data->state["package"]["path"]);
+    if (!res.valid() || res.get_type() != sol::type::string) {
+        logger.warn("Lua precompile: '{}' not found", name);
+        return;
+    }
+
+    const auto filename = res.get<std::string>();
+    auto* L = data->state.lua_state();
+    const auto top = lua_gettop(L);
+
+    int status;
+    try {
+        status = loadCachedChunk(L, filename);
+    } catch (...) {
+        lua_settop(L, top);
+        EXCEPTION_NESTED("Lua precompile: '{}' failed", name);
+    }
+
+    if (status != LUA_OK) {
+        std::string error{lua_tostring(L, -1)};
+        lua_settop(L, top);
+        EXCEPTION("Lua precompile: '{}' error: {}", name, error);
+    }
+    lua_settop(L, top);
+}
+
 void Lua::require(const std::string_view& name) {
     logger.info("Lua require: '{}'", name);
 
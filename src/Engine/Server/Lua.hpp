@@ -32,13 +32,23 @@ public:
 
     struct Data;
 
+    struct ChunkCacheStats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t size{0};
+    };
+
     static void registerBinder(Binder& binder);
+    static ChunkCacheStats getChunkCacheStats();
+    static void clearChunkCache();
 
     explicit Lua(const Config& config, EventBus& eventBus);
     virtual ~Lua();
 
     void importModule(const std::string_view& name, const std::string_view& file);
     void setScene(Scene& value);
+    // Compiles the module into the shared chunk cache without running it
+    void precompile(const std::string_view& name);
     void require(const std::string_view& name);
     void require(const std::string_view& name, const std::function<void(sol::table&)>& callback);
     sol::table& root();
@@ -0,0 +1,89 @@
+#include "LuaPool.hpp"
+#include "../Utils/Metrics.hpp"
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+static auto& metricReady =
+    Metrics::getInstance().gauge("server_lua_pool_ready", "Number of initialized Lua states waiting for a sector");
+static auto& metricMisses = Metrics::getInstance().counter(
+    "server_lua_pool_misses_total", "Number of Lua states created in place because the pool was empty");
+
+LuaPool::LuaPool(const Config& config, EventBus& eventBus, const size_t size, std::vector<std::string> precompiled) :
+    config{config}, eventBus{eventBus}, size{size}, precompiled{std::move(precompiled)} {
+
+    refill();
+}
+
+LuaPool::~LuaPool() {
+    worker.stop();
+
+    std::lock_guard<std::mutex> lock{mutex};
+    metricReady.add(-static_cast<int64_t>(ready.size()));
+    ready.clear();
+}
+
+std::unique_ptr<Lua> LuaPool::create() {
+    auto lua = std::make_unique<Lua>(config, eventBus);
+
+    // Only compiled into the shared cache, the modules run once the state belongs to a sector
+    for (const auto& name : precompiled) {
+        try {
+            lua->precompile(name);
+        } catch (std::exception& e) {
+            BACKTRACE(e, "Failed to precompile lua module: '{}'", name);
+        }
+    }
+
+    return lua;
+}
+
+std::unique_ptr<Lua> LuaPool::acquire() {
+    std::unique_ptr<Lua> lua;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (!ready.empty()) {
+            lua = std::move(ready.back());
+            ready.pop_back();
+            metricReady.add(-1);
+        }
+    }
+
+    refill();
+
+    if (!lua) {
+        metricMisses.add();
+        lua = create();
+    }
+
+    return lua;
+}
+
+size_t LuaPool::getReadyCount() {
+    std::lock_guard<std::mutex> lock{mutex};
+    return ready.size();
+}
+
+void LuaPool::refill() {
+    std::lock_guard<std::mutex> lock{mutex};
+
+    while (ready.size() + pending < size) {
+        ++pending;
+        worker.post([this]() {
+            std::unique_ptr<Lua> lua;
+            try {
+                lua = create();
+            } catch (std::exception& e) {
+                BACKTRACE(e, "Failed to create pooled lua state");
+            }
+
+            std::lock_guard<std::mutex> lock{mutex};
+            --pending;
+            if (lua) {
+                ready.push_back(std::move(lua));
+                metricReady.add(1);
+            }
+        });
+    }
+}
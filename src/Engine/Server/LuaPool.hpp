@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../Utils/Worker.hpp"
+#include "Lua.hpp"
+#include <mutex>
+
+namespace Engine {
+// Keeps a few fully initialized Lua states ready for the sectors, so a starting sector does not pay for
+// opening the libraries and running all of the binders. The states are not returned to the pool,
+// a state used by a sector holds its globals and is destroyed together with the sector.
+class ENGINE_API LuaPool {
+public:
+    explicit LuaPool(const Config& config, EventBus& eventBus, size_t size, std::vector<std::string> precompiled = {});
+    ~LuaPool();
+    NON_COPYABLE(LuaPool);
+    NON_MOVEABLE(LuaPool);
+
+    // Returns a ready state, or creates one in place when the pool is empty
+    std::unique_ptr<Lua> acquire();
+
+    size_t getReadyCount();
+
+private:
+    std::unique_ptr<Lua> create();
+    void refill();
+
+    const Config& config;
+    EventBus& eventBus;
+    size_t size;
+    std::vector<std::string> precompiled;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Lua>> ready;
+    size_t pending{0};
+    BackgroundWorker worker;
+};
+} // namespace Engine
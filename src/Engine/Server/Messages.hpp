@@ -191,8 +191,33 @@ struct MessageShipStatusEvent {
 MESSAGE_DEFINE(MessageShipStatusEvent);
 
 // --------------------------------------------------------------------------------------------------------------------
+// Bullets fired and hits detected by the server during a single tick. The clients simulate the trajectories
+// themselves, so the size depends only on the number of shots and not on the number of bullets in flight.
 struct MessageSceneBulletsEvent {
-    // void
+    struct Fire {
+        uint32_t id{0};
+        EntityId turret{NullEntity};
+        Vector3 origin;
+        Vector3 direction;
+        float speed{0.0f};
+        float lifetime{0.0f};
+        float size{0.0f};
+
+        MSGPACK_DEFINE_ARRAY(id, turret, origin, direction, speed, lifetime, size);
+    };
+
+    struct Hit {
+        uint32_t id{0};
+        Vector3 position;
+
+        MSGPACK_DEFINE_ARRAY(id, position);
+    };
+
+    uint64_t tick{0};
+    std::vector<Fire> fired;
+    std::vector<Hit> hits;
+
+    MSGPACK_DEFINE_ARRAY(tick, fired, hits);
 };
 
 MESSAGE_DEFINE(MessageSceneBulletsEvent);
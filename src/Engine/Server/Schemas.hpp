@@ -27,6 +27,8 @@ struct PlayerData {
 
 SCHEMA_DEFINE(PlayerData);
 SCHEMA_INDEXES(PlayerData, secret);
+SCHEMA_COVERING_INDEXES(PlayerData, secret);
+SCHEMA_COVERING_FIELDS(PlayerData, secret, id);
 
 struct PlayerLocationData {
     std::string galaxyId;
@@ -131,4 +133,27 @@ struct PlanetData {
 };
 
 SCHEMA_DEFINE(PlanetData);
+
+// The latest state of a single sector entity, the components are stored as LZ4 compressed msgpack
+struct SectorEntityData {
+    uint32_t entity{0};
+    uint64_t checkpoint{0};
+    bool removed{false};
+    uint32_t size{0};
+    std::vector<char> data;
+
+    MSGPACK_DEFINE_MAP(entity, checkpoint, removed, size, data);
+};
+
+SCHEMA_DEFINE(SectorEntityData);
+
+struct SectorCheckpointData {
+    uint64_t checkpoint{0};
+    uint64_t timestamp{0};
+    uint64_t entities{0};
+
+    MSGPACK_DEFINE_MAP(checkpoint, timestamp, entities);
+};
+
+SCHEMA_DEFINE(SectorCheckpointData);
 } // namespace Engine
@@ -1,25 +1,62 @@
 #include "Sector.hpp"
+#include "../Scene/Controllers/ControllerAgent.hpp"
+#include "../Scene/Controllers/ControllerBullets.hpp"
 #include "../Scene/Controllers/ControllerNetwork.hpp"
 #include "../Scene/Controllers/ControllerPathfinding.hpp"
+#include "../Utils/Profiler.hpp"
 #include "../Utils/StringUtils.hpp"
 #include "Server.hpp"
+#include <btBulletDynamicsCommon.h>
 #include <sol/sol.hpp>
 
 using namespace Engine;
 
 static auto logger = createLogger(LOG_FILENAME);
 
+// The movement actions replace each other, only the last one sent matters. The warp looks up the database.
+static constexpr Sector::InboxAction actionMovement{1, 1};
+static constexpr Sector::InboxAction actionWarp{2, 4};
+static constexpr Sector::InboxAction actionTarget{3, 1};
+
+// A collision object is a rigid body with a proxy and a leaf in the dynamic tree of the broadphase,
+// the shapes are not counted as their size depends on the type
+static constexpr size_t collisionObjectBytes = sizeof(btRigidBody) + sizeof(btDbvtProxy) + sizeof(btDbvtNode);
+
+// The entt storage keeps every component in the packed array, with its entity in the packed and the sparse array.
+// The memory owned by the components themselves (grids, scripts) is not counted.
+template <typename> struct ComponentStorageBytes;
+template <typename... Ts> struct ComponentStorageBytes<entt::ident<Ts...>> {
+    static size_t get(Scene& scene) {
+        return (... + (scene.getView<Ts>().size() * (sizeof(Ts) + 2 * sizeof(EntityId))));
+    }
+};
+
 Sector::Sector(const Config& config, Database& db, AssetsManager& assetsManager, EventBus& eventBus,
-               std::string galaxyId, std::string systemId, std::string sectorId) :
+               LuaPool& luaPool, std::string galaxyId, std::string systemId, std::string sectorId) :
     config{config},
     db{db},
     assetsManager{assetsManager},
     eventBus{eventBus},
+    luaPool{luaPool},
     galaxyId{std::move(galaxyId)},
     systemId{std::move(systemId)},
     sectorId{std::move(sectorId)},
-    loaded{false},
-    rng{std::random_device()()} {
+    inbox{{config.server.sectorInboxCapacity, config.server.sectorInboxBudget}},
+    rng{std::random_device()()},
+    metricUpdate{Metrics::getInstance().histogram("server_sector_update_duration_seconds",
+                                                  "Duration of a single sector update",
+                                                  {{"sector", this->sectorId}},
+                                                  1e-9)},
+    metricInboxDepth{Metrics::getInstance().gauge(
+        "server_sector_inbox_depth", "Player actions waiting for the sector", {{"sector", this->sectorId}})},
+    metricInboxDropped{Metrics::getInstance().counter("server_sector_inbox_dropped_total",
+                                                      "Player actions dropped by a full sector inbox",
+                                                      {{"sector", this->sectorId}})},
+    metricInboxCoalesced{Metrics::getInstance().counter("server_sector_inbox_coalesced_total",
+                                                        "Player actions replaced by a newer one while waiting",
+                                                        {{"sector", this->sectorId}})},
+    metricMemory{Metrics::getInstance().gauge(
+        "server_sector_memory_bytes", "Estimated memory held by a loaded sector", {{"sector", this->sectorId}})} {
 
     logger.info("Started sector: '{}'", this->sectorId);
 }
@@ -28,20 +65,34 @@ Sector::~Sector() {
     logger.info("Stopping sector: '{}'", sectorId);
 
     players.clear();
+    // A hibernation posted to the load queue may never run when the server stops, the scene is still here
+    const auto current = state.load();
+    if ((current == State::Loaded || current == State::Hibernating) && checkpoint) {
+        checkpoint->wait();
+        saveCheckpoint();
+        checkpoint->wait();
+    }
+    checkpoint.reset();
     scene.reset();
     lua.reset();
 
+    Metrics::getInstance().remove("server_sector_update_duration_seconds", {{"sector", sectorId}});
+    Metrics::getInstance().remove("server_sector_inbox_depth", {{"sector", sectorId}});
+    Metrics::getInstance().remove("server_sector_inbox_dropped_total", {{"sector", sectorId}});
+    Metrics::getInstance().remove("server_sector_inbox_coalesced_total", {{"sector", sectorId}});
+    Metrics::getInstance().remove("server_sector_memory_bytes", {{"sector", sectorId}});
+
     logger.info("Stopped sector: '{}'", sectorId);
 }
 
 void Sector::load() {
     logger.info("Sector is loading: '{}'", sectorId);
 
-    if (loaded) {
+    if (state == State::Loaded) {
         EXCEPTION("Sector was already loaded id: '{}'", sectorId);
     }
 
-    lua = std::make_unique<Lua>(config, eventBus);
+    lua = luaPool.acquire();
     scene = std::make_unique<Scene>(config, nullptr, lua.get());
     lua->setScene(*scene);
 
@@ -63,34 +114,138 @@ void Sector::load() {
         }
     });*/
 
+    scene->createEntityFrom(sectorData.entity);
+
+    // The template is deterministic, the latest checkpoint is applied on top of it
+    auto& checkpointController = scene->addController<ControllerCheckpoint>();
+    if (config.server.sectorCheckpointIntervalSec > 0) {
+        checkpoint = std::make_unique<SectorCheckpoint>(db, fmt::format("{}/{}/{}", galaxyId, systemId, sectorId));
+        checkpoint->restore(checkpointController);
+
+        const auto intervalUs = static_cast<uint64_t>(config.server.sectorCheckpointIntervalSec) * 1000000ULL;
+        checkpointTicks = std::max<uint64_t>(intervalUs / config.tickLengthUs.count(), 1);
+    }
+    checkpointController.reset();
+
     // Build pathfinding
     scene->getDynamicsWorld().updateAabbs();
-    // scene->getController<ControllerPathfinding>().buildTree();
-    scene->createEntityFrom(sectorData.entity);
+    scene->getController<ControllerPathfinding>().buildTree();
 
-    loaded = true;
+    memoryUsage = estimateMemoryUsage();
+    metricMemory.set(static_cast<int64_t>(memoryUsage.load()));
+    lastActive = std::chrono::steady_clock::now();
+    state = State::Loaded;
     logger.info("Sector is loaded: '{}'", sectorId);
 }
 
+bool Sector::beginHibernate() {
+    // Without the checkpoints the sector would come back as a fresh copy of its template
+    if (!checkpoint || !players.empty()) {
+        return false;
+    }
+
+    auto expected = State::Loaded;
+    if (!state.compare_exchange_strong(expected, State::Hibernating)) {
+        return false;
+    }
+
+    // A player that started joining in the meantime has seen the sector loaded and will not wake it
+    if (pendingPlayers != 0) {
+        state = State::Loaded;
+        return false;
+    }
+
+    return true;
+}
+
+void Sector::hibernate() {
+    logger.info("Sector is hibernating: '{}'", sectorId);
+
+    if (state != State::Hibernating) {
+        EXCEPTION("Sector was not stopped for hibernation id: '{}'", sectorId);
+    }
+
+    // The periodic checkpoint may still be writing, the last one must not be postponed
+    checkpoint->wait();
+    saveCheckpoint();
+    checkpoint->wait();
+
+    checkpoint.reset();
+    playerControl.clear();
+    scene.reset();
+    lua.reset();
+    tickCount = 0;
+    skippedTicks = 0;
+    background = false;
+
+    memoryUsage = 0;
+    metricMemory.set(0);
+    state = State::Hibernated;
+    logger.info("Sector is hibernated: '{}'", sectorId);
+}
+
+bool Sector::wake() {
+    auto expected = State::Hibernated;
+    if (!state.compare_exchange_strong(expected, State::Loading)) {
+        return false;
+    }
+
+    try {
+        load();
+    } catch (...) {
+        // The checkpoint is still in the database, the next player tries again
+        state = State::Hibernated;
+        EXCEPTION_NESTED("Failed to wake sector: '{}'", sectorId);
+    }
+    return true;
+}
+
 void Sector::update() {
+    PROFILE_SCOPE("Sector::update");
+    const MetricHistogram::Timer timer{metricUpdate};
+
     try {
         worker.poll();
 
-        const auto tickF = static_cast<float>(config.tickLengthUs.count()) / 1000000.0f;
-        scene->update(tickF);
+        {
+            PROFILE_SCOPE("Sector::drainInbox");
+            inbox.drain();
+            metricInboxDepth.set(static_cast<int64_t>(inbox.size()));
+        }
+
+        updateScene();
 
         // if (tickCount % 2 == 0 && tickCount != 0) {
         // const auto t0 = std::chrono::steady_clock::now();
 
-        auto& networkController = scene->getController<ControllerNetwork>();
-        for (const auto& player : players) {
-            if (const auto stream = player->getStream(); stream) {
-                networkController.sendUpdate(*stream);
+        {
+            PROFILE_SCOPE("Sector::sendUpdates");
+
+            auto& networkController = scene->getController<ControllerNetwork>();
+            auto& bulletsController = scene->getController<ControllerBullets>();
+            for (const auto& player : players) {
+                if (const auto stream = player->getStream(); stream) {
+                    networkController.sendUpdate(*stream);
+                    if (bulletsController.hasEvents()) {
+                        stream->send(bulletsController.getEvents());
+                    }
+                }
             }
+            networkController.resetUpdates();
+            bulletsController.resetEvents();
         }
-        networkController.resetUpdates();
         //}
 
+        if (checkpoint && tickCount % checkpointTicks == 0 && tickCount != 0) {
+            saveCheckpoint();
+        }
+
+        if (!isEmpty()) {
+            lastActive = std::chrono::steady_clock::now();
+        }
+        memoryUsage = estimateMemoryUsage();
+        metricMemory.set(static_cast<int64_t>(memoryUsage.load()));
+
         // const auto t1 = std::chrono::steady_clock::now();
         // const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
         // logger.info("Network update took: {} ms", ms);
@@ -102,7 +257,10 @@ void Sector::update() {
 }
 
 void Sector::addPlayer(const SessionPtr& session) {
+    ++pendingPlayers;
     worker.postSafe([this, session]() {
+        --pendingPlayers;
+
         const auto it = std::find_if(players.begin(), players.end(), [&](const SessionPtr& p) { return p == session; });
         if (it != players.end()) {
             EXCEPTION("Player: {} is already in sector: {}", session->getPlayerId(), sectorId);
@@ -157,6 +315,7 @@ void Sector::removePlayer(const SessionPtr& session) {
         if (it != players.end()) {
             players.erase(it);
         }
+        inbox.remove(session);
     });
 }
 
@@ -165,6 +324,10 @@ EntityId Sector::spawnPlayerEntity(const SessionPtr& session) {
     table["player_id"] = session->getPlayerId();
 
     auto entity = scene->createEntityFrom("player", table);
+    // Player ships travel with the player, they are not a part of the sector state
+    scene->getController<ControllerCheckpoint>().setTransient(entity);
+    // The NPCs around the players are simulated at the full rate
+    scene->getController<ControllerAgent>().addObserver(entity);
     auto* transform = scene->tryGetComponent<ComponentTransform>(entity);
     if (transform) {
         transform->move(Vector3{100.0f, 0.0f, 0.0f});
@@ -173,8 +336,70 @@ EntityId Sector::spawnPlayerEntity(const SessionPtr& session) {
     return entity;
 }
 
-void Sector::handleShipAction(const SessionPtr& session, std::function<void(Entity&, ComponentShipControl&)> callback) {
-    worker.postSafe([this, session, c = std::move(callback)]() {
+void Sector::saveCheckpoint() {
+    PROFILE_SCOPE("Sector::saveCheckpoint");
+    if (!checkpoint->save(scene->getController<ControllerCheckpoint>())) {
+        logger.warn("Sector: '{}' checkpoint postponed, the previous one is still being written", sectorId);
+    }
+}
+
+void Sector::updateScene() {
+    ++skippedTicks;
+
+    // Switching back to the full rate simulates the skipped ticks right away, before the player gets the snapshot
+    const auto observed = !isEmpty();
+    const auto reduced = !observed && config.server.sectorBackgroundTicks > 1;
+    if (reduced != background) {
+        background = reduced;
+        scene->setSimulationMode(reduced ? Scene::SimulationMode::Strategic : Scene::SimulationMode::Full);
+    }
+
+    if (reduced && skippedTicks < config.server.sectorBackgroundTicks) {
+        return;
+    }
+
+    const auto tickF = static_cast<float>(config.tickLengthUs.count()) / 1000000.0f;
+
+    // Without the physics step the controllers take the skipped ticks at once, Bullet makes a single sub step
+    // per update and would drop most of a longer delta, so the full rate catches up tick by tick
+    if (reduced) {
+        scene->update(tickF * static_cast<float>(skippedTicks));
+    } else {
+        for (uint64_t i = 0; i < skippedTicks; i++) {
+            scene->update(tickF);
+        }
+    }
+    skippedTicks = 0;
+}
+
+// The Lua heap is exact, the components and the physics are counted by the size of their types
+size_t Sector::estimateMemoryUsage() {
+    auto bytes = lua->getState().memory_used();
+    bytes += ComponentStorageBytes<EntityComponentIds>::get(*scene);
+    bytes += static_cast<size_t>(scene->getDynamicsWorld().get().getNumCollisionObjects()) * collisionObjectBytes;
+    return bytes;
+}
+
+void Sector::enqueueAction(const SessionPtr& session, const InboxAction& kind, std::function<void()> action) {
+    const auto result = inbox.push(session, kind.coalesce, kind.cost, [this, a = std::move(action)]() {
+        try {
+            a();
+        } catch (std::exception& e) {
+            BACKTRACE(e, "Failed to handle player action in sector: '{}'", sectorId);
+        }
+    });
+
+    if (result == FairQueue<SessionPtr>::Result::Dropped) {
+        metricInboxDropped.add();
+        logger.debug("Player: '{}' action dropped, sector: '{}' inbox is full", session->getPlayerId(), sectorId);
+    } else if (result == FairQueue<SessionPtr>::Result::Coalesced) {
+        metricInboxCoalesced.add();
+    }
+}
+
+void Sector::handleShipAction(const SessionPtr& session, const InboxAction& kind,
+                              std::function<void(Entity&, ComponentShipControl&)> callback) {
+    enqueueAction(session, kind, [this, session, c = std::move(callback)]() {
         // Find the entity that the player controls
         const auto found = playerControl.find(session);
         if (found == playerControl.end()) {
@@ -193,42 +418,42 @@ void Sector::handleShipAction(const SessionPtr& session, std::function<void(Enti
 }
 
 void Sector::handle(const SessionPtr& session, MessageActionApproach req) {
-    handleShipAction(session, [req](Entity& entity, ComponentShipControl& shipControl) {
+    handleShipAction(session, actionMovement, [req](Entity& entity, ComponentShipControl& shipControl) {
         logger.debug("Entity: {} approaching: {}", entity.getHandle(), req.entityId);
         shipControl.actionApproach(req.entityId);
     });
 }
 
 void Sector::handle(const SessionPtr& session, MessageActionOrbit req) {
-    handleShipAction(session, [req](Entity& entity, ComponentShipControl& shipControl) {
+    handleShipAction(session, actionMovement, [req](Entity& entity, ComponentShipControl& shipControl) {
         logger.debug("Entity: {} orbiting: {}", entity.getHandle(), req.entityId);
         shipControl.actionOrbit(req.entityId, req.radius);
     });
 }
 
 void Sector::handle(const SessionPtr& session, MessageActionKeepDistance req) {
-    handleShipAction(session, [req](Entity& entity, ComponentShipControl& shipControl) {
+    handleShipAction(session, actionMovement, [req](Entity& entity, ComponentShipControl& shipControl) {
         logger.debug("Entity: {} keeping distance: {} target: {}", entity.getHandle(), req.distance, req.entityId);
         shipControl.actionKeepDistance(req.entityId, req.distance);
     });
 }
 
 void Sector::handle(const SessionPtr& session, MessageActionStopMovement req) {
-    handleShipAction(session, [req](Entity& entity, ComponentShipControl& shipControl) {
+    handleShipAction(session, actionMovement, [req](Entity& entity, ComponentShipControl& shipControl) {
         logger.debug("Entity: {} stopping", entity.getHandle());
         shipControl.actionCancelMovement();
     });
 }
 
 void Sector::handle(const SessionPtr& session, MessageActionGoDirection req) {
-    handleShipAction(session, [req](Entity& entity, ComponentShipControl& shipControl) {
+    handleShipAction(session, actionMovement, [req](Entity& entity, ComponentShipControl& shipControl) {
         logger.debug("Entity: {} going direction: {}", entity.getHandle(), req.direction);
         // shipControl.actionGoDirection(req.direction);
     });
 }
 
 void Sector::handle(const SessionPtr& session, MessageActionWarpTo req) {
-    handleShipAction(session, [this, req](Entity& entity, ComponentShipControl& shipControl) {
+    handleShipAction(session, actionWarp, [this, req](Entity& entity, ComponentShipControl& shipControl) {
         if (req.sectorId != sectorId) {
             const auto thisSector = db.find<SectorData>(fmt::format("{}/{}/{}", galaxyId, systemId, sectorId));
             const auto targetSector = db.find<SectorData>(fmt::format("{}/{}/{}", galaxyId, systemId, req.sectorId));
@@ -244,7 +469,7 @@ void Sector::handle(const SessionPtr& session, MessageActionWarpTo req) {
 }
 
 void Sector::handle(const SessionPtr& session, MessageControlTargetEvent req) {
-    worker.postSafe([this, session, req]() {
+    enqueueAction(session, actionTarget, [this, session, req]() {
         // Find the entity that the player controls
         const auto found = playerControl.find(session);
         if (found != playerControl.end()) {
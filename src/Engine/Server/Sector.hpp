@@ -1,10 +1,13 @@
 #pragma once
 
 #include "../Scene/Scene.hpp"
+#include "../Utils/FairQueue.hpp"
+#include "../Utils/Metrics.hpp"
 #include "../Utils/Worker.hpp"
 #include "Generator.hpp"
-#include "Lua.hpp"
+#include "LuaPool.hpp"
 #include "Messages.hpp"
+#include "SectorCheckpoint.hpp"
 #include "Session.hpp"
 
 namespace Engine {
@@ -12,18 +15,69 @@ class ENGINE_API Server;
 
 class ENGINE_API Sector {
 public:
+    // How the player action is queued in the inbox, see FairQueue
+    struct InboxAction {
+        uint64_t coalesce;
+        size_t cost;
+    };
+
     explicit Sector(const Config& config, Database& db, AssetsManager& assetsManager, EventBus& eventBus,
-                    std::string galaxyId, std::string systemId, std::string sectorId);
+                    LuaPool& luaPool, std::string galaxyId, std::string systemId, std::string sectorId);
     virtual ~Sector();
 
+    enum class State : uint8_t {
+        Loading,
+        Loaded,
+        Hibernating,
+        Hibernated,
+    };
+
     void load();
     void update();
 
+    // Called from the tick, stops the updates if nobody is in the sector or joining it.
+    // The hibernate() must follow on the load queue when this returns true.
+    bool beginHibernate();
+    // Saves the checkpoint and releases the scene and the Lua state, the sector stays in the server as a stub
+    void hibernate();
+    // Loads the sector again from its checkpoint, returns false if it was not hibernated
+    bool wake();
+
     void addPlayer(const SessionPtr& session);
     void removePlayer(const SessionPtr& session);
 
     bool isLoaded() const {
-        return loaded;
+        return state == State::Loaded;
+    }
+
+    bool isHibernated() const {
+        const auto current = state.load();
+        return current == State::Hibernating || current == State::Hibernated;
+    }
+
+    // Only valid on the tick thread
+    bool isEmpty() const {
+        return players.empty() && pendingPlayers == 0;
+    }
+
+    // Only valid on the tick thread
+    std::chrono::steady_clock::time_point getLastActive() const {
+        return lastActive;
+    }
+
+    // Nobody observes the sector, it runs at the reduced rate in the strategic mode
+    bool isBackground() const {
+        return background;
+    }
+
+    // Only valid on the tick thread, null when hibernated
+    Scene* getScene() const {
+        return scene.get();
+    }
+
+    // Estimated bytes held by the loaded sector, zero when hibernated
+    size_t getMemoryUsage() const {
+        return memoryUsage;
     }
 
     const std::string& getGalaxyId() const {
@@ -50,23 +104,45 @@ public:
 
 private:
     EntityId spawnPlayerEntity(const SessionPtr& session);
-    void handleShipAction(const SessionPtr& session, std::function<void(Entity&, ComponentShipControl&)> callback);
+    void saveCheckpoint();
+    size_t estimateMemoryUsage();
+    void updateScene();
+    void enqueueAction(const SessionPtr& session, const InboxAction& kind, std::function<void()> action);
+    void handleShipAction(const SessionPtr& session, const InboxAction& kind,
+                          std::function<void(Entity&, ComponentShipControl&)> callback);
 
     const Config& config;
     Database& db;
     AssetsManager& assetsManager;
     EventBus& eventBus;
+    LuaPool& luaPool;
     uint64_t tickCount{0};
     std::string galaxyId;
     std::string systemId;
     std::string sectorId;
-    bool loaded;
+    std::atomic<State> state{State::Loading};
+    // Players posted to the worker but not yet in the sector, they keep the sector awake
+    std::atomic<int> pendingPlayers{0};
+    std::chrono::steady_clock::time_point lastActive;
+    std::atomic<size_t> memoryUsage{0};
     std::unique_ptr<Scene> scene;
     std::unique_ptr<Lua> lua;
+    std::unique_ptr<SectorCheckpoint> checkpoint;
+    uint64_t checkpointTicks{0};
+    // Ticks not yet simulated by the scene, more than one only in the background
+    uint64_t skippedTicks{0};
+    std::atomic<bool> background{false};
     std::vector<SessionPtr> players;
     std::unordered_map<SessionPtr, EntityId> playerControl;
     SynchronizedWorker worker;
+    // The player actions, bounded and drained fairly once per tick
+    FairQueue<SessionPtr> inbox;
     std::mt19937_64 rng;
+    MetricHistogram& metricUpdate;
+    MetricGauge& metricInboxDepth;
+    MetricCounter& metricInboxDropped;
+    MetricCounter& metricInboxCoalesced;
+    MetricGauge& metricMemory;
 };
 
 using SectorPtr = std::shared_ptr<Sector>;
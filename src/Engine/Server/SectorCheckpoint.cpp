@@ -0,0 +1,181 @@
+#include "SectorCheckpoint.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Profiler.hpp"
+#include <lz4.h>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+static auto& metricDuration =
+    Metrics::getInstance().histogram("server_sector_checkpoint_duration_seconds",
+                                     "Duration of compressing and writing a sector checkpoint", {}, 1e-9);
+static auto& metricEntities = Metrics::getInstance().counter("server_sector_checkpoint_entities_total",
+                                                             "Number of entity records written by sector checkpoints");
+static auto& metricBytes = Metrics::getInstance().counter("server_sector_checkpoint_bytes_total",
+                                                          "Number of compressed bytes written by sector checkpoints");
+static auto& metricCompacted = Metrics::getInstance().counter(
+    "server_sector_checkpoint_tombstones_removed_total", "Number of tombstones removed when restoring sectors");
+static auto& metricSkipped = Metrics::getInstance().counter(
+    "server_sector_checkpoint_skipped_total", "Number of checkpoints postponed because the previous one was in flight");
+
+SectorCheckpoint::SectorCheckpoint(Database& db, std::string key) : db{db}, key{std::move(key)} {
+}
+
+SectorCheckpoint::~SectorCheckpoint() {
+    wait();
+    worker.stop();
+}
+
+std::string SectorCheckpoint::getEntityKey(const EntityId handle) const {
+    // Zero padded so the entities are iterated in the order of their ids
+    return fmt::format("{}/{:010}", key, static_cast<uint32_t>(handle));
+}
+
+bool SectorCheckpoint::restore(ControllerCheckpoint& controller) {
+    PROFILE_SCOPE("SectorCheckpoint::restore");
+
+    const auto info = db.find<SectorCheckpointData>(key);
+    if (!info) {
+        return false;
+    }
+    checkpoint = info->checkpoint;
+
+    const auto entities = db.seekAll<SectorEntityData>(fmt::format("{}/", key));
+
+    // Destroy the template entities that no longer exist first, so their ids can be reused by the restored ones.
+    // A tombstone of an entity the template did not create is left from a removed entity created at runtime.
+    std::vector<std::string> stale;
+    for (const auto& entity : entities) {
+        if (entity.removed && !controller.restoreRemoved(static_cast<EntityId>(entity.entity))) {
+            stale.push_back(getEntityKey(static_cast<EntityId>(entity.entity)));
+        }
+    }
+    compact(stale);
+
+    std::string raw;
+    for (const auto& entity : entities) {
+        if (entity.removed) {
+            continue;
+        }
+
+        raw.resize(entity.size);
+        const auto res = LZ4_decompress_safe(entity.data.data(),
+                                             raw.data(),
+                                             static_cast<int>(entity.data.size()),
+                                             static_cast<int>(raw.size()));
+        if (res < 0 || static_cast<size_t>(res) != raw.size()) {
+            EXCEPTION("Failed to decompress checkpoint of entity: {} sector: '{}'", entity.entity, key);
+        }
+
+        const auto oh = msgpack::unpack(raw.data(), raw.size());
+        controller.restore(static_cast<EntityId>(entity.entity), oh.get());
+    }
+
+    controller.restoreFinish();
+
+    logger.info("Restored checkpoint: {} of sector: '{}' entities: {}", checkpoint, key, entities.size());
+    return true;
+}
+
+bool SectorCheckpoint::save(ControllerCheckpoint& controller) {
+    if (busy.load()) {
+        metricSkipped.add();
+        return false;
+    }
+
+    if (controller.getChangedCount() == 0) {
+        return true;
+    }
+
+    // The snapshot owns a copy of the components, the scene can keep changing while it is packed and written
+    auto snapshot = std::make_shared<ControllerCheckpoint::Snapshot>(controller.takeSnapshot());
+    const auto id = ++checkpoint;
+
+    busy.store(true);
+    worker.post([this, id, snapshot]() {
+        try {
+            write(id, *snapshot);
+        } catch (std::exception& e) {
+            BACKTRACE(e, "Failed to write checkpoint: {} of sector: '{}'", id, key);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            busy.store(false);
+        }
+        cv.notify_all();
+    });
+
+    return true;
+}
+
+void SectorCheckpoint::write(const uint64_t id, const ControllerCheckpoint::Snapshot& snapshot) {
+    const MetricHistogram::Timer timer{metricDuration};
+
+    auto batch = db.startBatch();
+
+    SectorEntityData data{};
+    data.checkpoint = id;
+
+    for (const auto& entity : snapshot.entities) {
+        const auto sbuf = entity.pack();
+
+        data.entity = static_cast<uint32_t>(entity.handle);
+        data.size = static_cast<uint32_t>(sbuf.size());
+        data.data.resize(LZ4_compressBound(static_cast<int>(sbuf.size())));
+
+        const auto written = LZ4_compress_default(
+            sbuf.data(), data.data.data(), static_cast<int>(sbuf.size()), static_cast<int>(data.data.size()));
+        if (written <= 0) {
+            EXCEPTION("Failed to compress checkpoint of entity: {}", data.entity);
+        }
+        data.data.resize(written);
+
+        batch->put(getEntityKey(entity.handle), data);
+        metricBytes.add(static_cast<uint64_t>(written));
+    }
+
+    // Tombstones are kept so the entities populated by the sector template are not recreated on load,
+    // the ones of the entities created at runtime are removed by the next restore
+    data.removed = true;
+    data.size = 0;
+    data.data.clear();
+    for (const auto handle : snapshot.removed) {
+        data.entity = static_cast<uint32_t>(handle);
+        batch->put(getEntityKey(handle), data);
+    }
+
+    SectorCheckpointData info{};
+    info.checkpoint = id;
+    info.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                               std::chrono::system_clock::now().time_since_epoch())
+                                               .count());
+    info.entities = snapshot.entities.size() + snapshot.removed.size();
+    batch->put(key, info);
+
+    batch->commit();
+
+    metricEntities.add(info.entities);
+    logger.debug("Written checkpoint: {} of sector: '{}' entities: {}", id, key, info.entities);
+}
+
+void SectorCheckpoint::compact(const std::vector<std::string>& keys) {
+    if (keys.empty()) {
+        return;
+    }
+
+    auto batch = db.startBatch();
+    for (const auto& entityKey : keys) {
+        batch->remove<SectorEntityData>(entityKey);
+    }
+    batch->commit();
+
+    metricCompacted.add(keys.size());
+    logger.info("Removed stale tombstones of sector: '{}' count: {}", key, keys.size());
+}
+
+void SectorCheckpoint::wait() {
+    std::unique_lock<std::mutex> lock{mutex};
+    cv.wait(lock, [this]() { return !busy.load(); });
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../Scene/Controllers/ControllerCheckpoint.hpp"
+#include "../Utils/Worker.hpp"
+#include "Schemas.hpp"
+#include <atomic>
+
+namespace Engine {
+// Persists the entities of a single sector. The changed entities are packed on the tick thread,
+// the compression and the database writes happen on a background thread so the tick is never blocked.
+class ENGINE_API SectorCheckpoint {
+public:
+    explicit SectorCheckpoint(Database& db, std::string key);
+    ~SectorCheckpoint();
+    NON_COPYABLE(SectorCheckpoint);
+    NON_MOVEABLE(SectorCheckpoint);
+
+    // Applies the latest checkpoint on top of the freshly populated scene, returns false if there is none
+    bool restore(ControllerCheckpoint& controller);
+    // Returns false if the previous checkpoint is still being written, the changes are kept for the next call
+    bool save(ControllerCheckpoint& controller);
+    // Blocks until the pending checkpoint is written
+    void wait();
+
+    [[nodiscard]] uint64_t getCheckpoint() const {
+        return checkpoint;
+    }
+
+private:
+    void write(uint64_t id, const ControllerCheckpoint::Snapshot& snapshot);
+    void compact(const std::vector<std::string>& keys);
+    std::string getEntityKey(EntityId handle) const;
+
+    Database& db;
+    std::string key;
+    uint64_t checkpoint{0};
+    std::atomic<bool> busy{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    BackgroundWorker worker{1};
+};
+} // namespace Engine
@@ -1,6 +1,9 @@
 #include "Server.hpp"
 #include "../Database/SaveInfo.hpp"
+#include "../Network/NetworkMetricsServer.hpp"
 #include "../Network/NetworkUdpServer.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Profiler.hpp"
 #include "../Utils/Random.hpp"
 #include "Lua.hpp"
 #include "MatchmakerSession.hpp"
@@ -19,11 +22,31 @@ static auto logger = createLogger(LOG_FILENAME);
 
 Server* Server::instance;
 
+static auto& metricTickDuration = Metrics::getInstance().histogram(
+    "server_tick_duration_seconds", "Duration of a server tick without the sleep", {}, 1e-9);
+static auto& metricTicks = Metrics::getInstance().counter("server_ticks_total", "Number of server ticks");
+static auto& metricSectors = Metrics::getInstance().gauge("server_sectors", "Number of started sectors");
+static auto& metricSessions = Metrics::getInstance().gauge("server_sessions", "Number of logged in players");
+static auto& metricLoadQueue =
+    Metrics::getInstance().gauge("server_sector_load_queue_depth", "Sectors waiting to be loaded");
+static auto& metricSectorsHibernated =
+    Metrics::getInstance().gauge("server_sectors_hibernated", "Number of started sectors that are hibernated");
+static auto& metricSectorsMemory =
+    Metrics::getInstance().gauge("server_sectors_memory_bytes", "Estimated memory held by the loaded sectors");
+static auto& metricSectorsBackground =
+    Metrics::getInstance().gauge("server_sectors_background", "Number of sectors simulated at the reduced rate");
+static auto& metricHibernations =
+    Metrics::getInstance().counter("server_sector_hibernations_total", "Number of hibernated sectors");
+static auto& metricWakes =
+    Metrics::getInstance().counter("server_sector_wakes_total", "Number of sectors loaded back from hibernation");
+
 static DatabaseRocksDB::Options getDatabaseOptions(const Config& config) {
     DatabaseRocksDB::Options options{};
     options.cacheSizeMb = config.server.dbCacheSize;
     options.debugLogging = config.server.dbDebug;
     options.compression = config.server.dbCompression;
+    options.statistics = config.server.dbStatistics;
+    options.objectCacheSize = config.server.dbObjectCacheSize;
     return options;
 }
 
@@ -102,6 +125,10 @@ void Server::load() {
         EXCEPTION_NESTED("Failed to import base assets module");
     }
 
+    // The sector script is compiled while the pool fills, before the first sector starts
+    luaPool = std::make_unique<LuaPool>(
+        config, *eventBus, config.server.luaPoolSize, std::vector<std::string>{"base.sector"});
+
     try {
         const auto t0 = std::chrono::high_resolution_clock::now();
         generator->generate(std::get<int64_t>(seed->value));
@@ -134,6 +161,85 @@ void Server::load() {
     if (matchmakerClient) {
         matchmakerSession = std::make_unique<MatchmakerSession>(*matchmakerClient, *this, options.name);
     }
+
+    startMetrics();
+}
+
+void Server::startMetrics() {
+    // Per peer values are read from the streams on every scrape instead of being tracked in the registry
+    const auto addPeerCollector = [this](const std::string& name, const Metrics::Type type, const std::string& help,
+                                         std::function<uint64_t(const NetworkUdpStream&)> getter) {
+        metricsCollectors.push_back(Metrics::getInstance().addCollector(
+            name, type, help, [this, getter = std::move(getter)](std::vector<Metrics::Sample>& samples) {
+                for (const auto& session : playerSessions.getAllSessions()) {
+                    const auto stream = std::dynamic_pointer_cast<NetworkUdpStream>(session->getStream());
+                    if (stream) {
+                        samples.push_back({{{"player", session->getPlayerId()}},
+                                           static_cast<double>(getter(*stream))});
+                    }
+                }
+            }));
+    };
+
+    addPeerCollector("network_peer_bytes_sent_total",
+                     Metrics::Type::Counter,
+                     "Data bytes queued for the player",
+                     [](const NetworkUdpStream& stream) { return stream.getTotalBytesSent(); });
+    addPeerCollector("network_peer_bytes_received_total",
+                     Metrics::Type::Counter,
+                     "Bytes received from the player",
+                     [](const NetworkUdpStream& stream) { return stream.getTotalBytesReceived(); });
+    addPeerCollector("network_peer_packets_resent_total",
+                     Metrics::Type::Counter,
+                     "Reliable packets resent to the player",
+                     [](const NetworkUdpStream& stream) { return stream.getTotalResent(); });
+    addPeerCollector("network_peer_send_queue_depth",
+                     Metrics::Type::Gauge,
+                     "Packets waiting to be sent to the player",
+                     [](const NetworkUdpStream& stream) { return stream.getSendQueueSize(); });
+
+    metricsLogTime = std::chrono::steady_clock::now();
+
+    if (config.server.metricsPort == 0) {
+        return;
+    }
+
+    // The game can run without the metrics, so a port already in use is not fatal
+    try {
+        metricsServer = std::make_shared<NetworkMetricsServer>(
+            worker.getService(), config.server.metricsBindAddress, config.server.metricsPort);
+        metricsServer->start();
+    } catch (std::exception& e) {
+        BACKTRACE(e, "Failed to start metrics server on port: {}", config.server.metricsPort);
+        metricsServer.reset();
+    }
+}
+
+void Server::stopMetrics() {
+    if (metricsServer) {
+        logger.info("Stopping metrics server");
+        metricsServer->stop();
+    }
+
+    for (const auto id : metricsCollectors) {
+        Metrics::getInstance().removeCollector(id);
+    }
+    metricsCollectors.clear();
+}
+
+void Server::updateMetrics() {
+    metricSessions.set(static_cast<int64_t>(playerSessions.getAllSessions().size()));
+    {
+        std::shared_lock<std::shared_mutex> lock{sectors.mutex};
+        metricSectors.set(static_cast<int64_t>(sectors.map.size()));
+    }
+
+    const auto interval = std::chrono::seconds{config.server.metricsLogIntervalSec};
+    const auto now = std::chrono::steady_clock::now();
+    if (interval.count() > 0 && now - metricsLogTime > interval) {
+        metricsLogTime = now;
+        Metrics::getInstance().logSummary();
+    }
 }
 
 void Server::updateSaveInfo() {
@@ -152,6 +258,8 @@ void Server::cleanup() {
 
     logger.info("Cleanup started");
 
+    stopMetrics();
+
     if (matchmakerSession) {
         logger.info("Stopping matchmaker session");
         matchmakerSession.reset();
@@ -168,12 +276,14 @@ void Server::cleanup() {
         network->stop();
     }
 
-    logger.info("Waiting for load queue to stop");
-    loadQueue.stop();
-
+    // The request handlers post the sector loads and wakes to the load queue, they must stop first
     logger.info("Waiting for workers to stop");
     worker.stop();
+
+    logger.info("Waiting for load queue to stop");
+    loadQueue.stop();
     network.reset();
+    metricsServer.reset();
 
     logger.info("Clearing sectors");
     {
@@ -181,6 +291,9 @@ void Server::cleanup() {
         sectors.map.clear();
     }
 
+    logger.info("Stopping lua pool");
+    luaPool.reset();
+
     logger.info("Stopping event bus");
     eventBus.reset();
 
@@ -204,6 +317,7 @@ Server::~Server() {
 
 void Server::startTick() {
     tickThread = std::thread([this]() {
+        PROFILE_THREAD("Server tick");
         try {
             tick();
         } catch (std::exception& e) {
@@ -214,6 +328,7 @@ void Server::startTick() {
 }
 
 void Server::pollEvents() {
+    PROFILE_SCOPE("Server::pollEvents");
     try {
         eventBus->poll();
     } catch (std::exception& e) {
@@ -222,10 +337,20 @@ void Server::pollEvents() {
 }
 
 void Server::updateSectors() {
+    PROFILE_SCOPE("Server::updateSectors");
     std::shared_lock<std::shared_mutex> lock{sectors.mutex};
+
+    std::vector<SectorPtr> idle;
+    size_t memory = 0;
+    int64_t hibernated = 0;
+    int64_t background = 0;
+
     for (auto& [compoundId, sector] : sectors.map) {
         // Skip sectors that are not yet ready
         if (!sector->isLoaded()) {
+            if (sector->isHibernated()) {
+                ++hibernated;
+            }
             continue;
         }
 
@@ -234,7 +359,85 @@ void Server::updateSectors() {
         } catch (std::exception& e) {
             EXCEPTION_NESTED("Failed to update sector: '{}'", compoundId);
         }
+
+        memory += sector->getMemoryUsage();
+        if (sector->isBackground()) {
+            ++background;
+        }
+        if (sector->isEmpty()) {
+            idle.push_back(sector);
+        }
     }
+
+    metricSectorsHibernated.set(hibernated);
+    metricSectorsBackground.set(background);
+    hibernateSectors(std::move(idle), memory);
+}
+
+std::vector<SectorPtr> Server::beginHibernations(std::vector<SectorPtr> idle, size_t& memory, const size_t budget,
+                                                 const std::chrono::seconds grace,
+                                                 const std::chrono::steady_clock::time_point now) {
+    // Least recently used first, those are evicted when over the memory budget
+    std::sort(idle.begin(), idle.end(), [](const SectorPtr& a, const SectorPtr& b) {
+        return a->getLastActive() < b->getLastActive();
+    });
+
+    std::vector<SectorPtr> stopped;
+    for (const auto& sector : idle) {
+        const auto expired = grace.count() > 0 && now - sector->getLastActive() > grace;
+        const auto overBudget = budget > 0 && memory > budget;
+        if (!expired && !overBudget) {
+            continue;
+        }
+
+        if (!sector->beginHibernate()) {
+            continue;
+        }
+
+        memory -= std::min(memory, sector->getMemoryUsage());
+        stopped.push_back(sector);
+    }
+
+    return stopped;
+}
+
+void Server::hibernateSectors(std::vector<SectorPtr> idle, size_t memory) {
+    const auto grace = std::chrono::seconds{config.server.sectorHibernateAfterSec};
+    const auto budget = config.server.sectorMemoryBudgetMb * 1024ULL * 1024ULL;
+    const auto now = std::chrono::steady_clock::now();
+
+    for (const auto& sector : beginHibernations(std::move(idle), memory, budget, grace, now)) {
+        metricHibernations.add();
+
+        metricLoadQueue.add(1);
+        loadQueue.post([sector]() {
+            metricLoadQueue.add(-1);
+            try {
+                sector->hibernate();
+            } catch (std::exception& e) {
+                BACKTRACE(e, "Failed to hibernate sector: '{}'", sector->getSectorId());
+            }
+        });
+    }
+
+    metricSectorsMemory.set(static_cast<int64_t>(memory));
+}
+
+void Server::wakeSector(const SectorPtr& sector) {
+    logger.info("Waking sector: '{}'", sector->getSectorId());
+
+    // Queued behind the hibernation if it is still running
+    metricLoadQueue.add(1);
+    loadQueue.post([sector]() {
+        metricLoadQueue.add(-1);
+        try {
+            if (sector->wake()) {
+                metricWakes.add();
+            }
+        } catch (std::exception& e) {
+            BACKTRACE(e, "Failed to wake sector: '{}'", sector->getSectorId());
+        }
+    });
 }
 
 void Server::tick() {
@@ -243,11 +446,19 @@ void Server::tick() {
     while (tickFlag.load()) {
         const auto start = std::chrono::high_resolution_clock::now();
 
-        // playerSessions.updateSessionsPing();
-        pollEvents();
-        updateSectors();
+        {
+            PROFILE_SCOPE("Server::tick");
+
+            // playerSessions.updateSessionsPing();
+            pollEvents();
+            updateSectors();
+        }
 
         const auto now = std::chrono::high_resolution_clock::now();
+        metricTickDuration.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start));
+        metricTicks.add();
+        updateMetrics();
+
         const auto test = std::chrono::duration_cast<std::chrono::microseconds>(now - start);
         if (test < config.tickLengthUs) {
             std::this_thread::sleep_for(config.tickLengthUs - test);
@@ -303,12 +514,14 @@ SectorPtr Server::startSector(const std::string& sectorId) {
 
     try {
         logger.info("Creating sector: '{}'", sectorId);
-        auto sectorPtr =
-            std::make_shared<Sector>(config, db, assetsManager, *eventBus, sector.galaxyId, sector.systemId, sector.id);
+        auto sectorPtr = std::make_shared<Sector>(
+            config, db, assetsManager, *eventBus, *luaPool, sector.galaxyId, sector.systemId, sector.id);
         sectors.map.insert(std::make_pair(sector.id, sectorPtr));
 
         // Load the sector in a separate thread
+        metricLoadQueue.add(1);
         loadQueue.post([sectorPtr]() {
+            metricLoadQueue.add(-1);
             try {
                 sectorPtr->load();
             } catch (std::exception& e) {
@@ -331,7 +544,11 @@ void Server::addPlayerToSector(const SessionPtr& session, const std::string& sec
         EXCEPTION("Can not add player to invalid sector id: {} player id: {}", sectorId, session->getPlayerId());
     }
 
+    // The player waits in the sector worker until the sector is loaded back
     it->second->addPlayer(session);
+    if (it->second->isHibernated()) {
+        wakeSector(it->second);
+    }
 }
 
 void Server::disconnectPlayer(const std::string& playerId) {
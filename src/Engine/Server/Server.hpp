@@ -20,6 +20,7 @@
 namespace Engine {
 class ENGINE_API Lua;
 class ENGINE_API NetworkUdpServer;
+class ENGINE_API NetworkMetricsServer;
 
 class ENGINE_API Server : public NetworkDispatcher2, public MatchmakerSession::Receiver {
 public:
@@ -84,6 +85,10 @@ public:
         return *generator;
     }
 
+    LuaPool& getLuaPool() {
+        return *luaPool;
+    }
+
     // Sector functions
     void movePlayerToSector(const std::string& playerId, const std::string& sectorId);
     SessionPtr getPlayerSession(const std::string& playerId);
@@ -92,6 +97,12 @@ public:
     SectorPtr getSectorForSession(const SessionPtr& session);
     template <typename T> void forwardMessageToSector(const Request2<T>& req);
 
+    // Stops the updates of the idle sectors past the grace period, and of the least recently used ones while
+    // the memory is over the budget (zero disables either). The hibernate() of the returned sectors must follow.
+    static std::vector<SectorPtr> beginHibernations(std::vector<SectorPtr> idle, size_t& memory, size_t budget,
+                                                    std::chrono::seconds grace,
+                                                    std::chrono::steady_clock::time_point now);
+
     static Server* instance;
 
 private:
@@ -102,7 +113,12 @@ private:
     void cleanup();
     void pollEvents();
     void updateSectors();
+    void hibernateSectors(std::vector<SectorPtr> idle, size_t memory);
+    void wakeSector(const SectorPtr& sector);
     void updateSaveInfo();
+    void startMetrics();
+    void stopMetrics();
+    void updateMetrics();
     template <typename T, typename... Args> void addService(Args&&... args) {
         services.emplace(typeid(T).hash_code(),
                          std::make_unique<T>(*this, db, playerSessions, std::forward<Args>(args)...));
@@ -123,11 +139,15 @@ private:
 
     std::unique_ptr<Generator> generator;
     std::unique_ptr<Lua> lua;
+    std::unique_ptr<LuaPool> luaPool;
     BackgroundWorker worker;
     BackgroundWorker loadQueue;
     Worker::Strand strand;
     std::shared_ptr<NetworkUdpServer> network;
     std::unique_ptr<MatchmakerSession> matchmakerSession;
+    std::shared_ptr<NetworkMetricsServer> metricsServer;
+    std::vector<uint64_t> metricsCollectors;
+    std::chrono::steady_clock::time_point metricsLogTime;
     uint16_t port{0};
 
     struct {
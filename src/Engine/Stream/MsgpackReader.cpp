@@ -0,0 +1,284 @@
+#include "MsgpackReader.hpp"
+#include "../Utils/Exceptions.hpp"
+#include <cstring>
+#include <limits>
+
+using namespace Engine;
+
+namespace {
+struct Header {
+    size_t length;   // Type byte and the length fields
+    size_t payload;  // Bytes that follow the header
+    size_t children; // Nested values that follow the payload
+};
+
+template <typename T> T loadBigEndian(const uint8_t* src) {
+    T value{0};
+    for (size_t i = 0; i < sizeof(T); i++) {
+        value = static_cast<T>((value << 8) | src[i]);
+    }
+    return value;
+}
+
+// Returns false when the buffer ends before the whole header does
+bool parseHeader(const uint8_t* src, const size_t available, Header& header) {
+    const auto type = src[0];
+
+    const auto sized = [&](const size_t bytes, const size_t extra, const bool isChildren, const size_t multiplier) {
+        if (available < 1 + bytes) {
+            return false;
+        }
+        size_t count;
+        switch (bytes) {
+        case 1:
+            count = src[1];
+            break;
+        case 2:
+            count = loadBigEndian<uint16_t>(src + 1);
+            break;
+        default:
+            count = loadBigEndian<uint32_t>(src + 1);
+            break;
+        }
+        header.length = 1 + bytes + extra;
+        header.payload = isChildren ? 0 : count;
+        header.children = isChildren ? count * multiplier : 0;
+        return true;
+    };
+
+    header = {1, 0, 0};
+    if (type <= 0x7f || type >= 0xe0 || type == 0xc0 || type == 0xc2 || type == 0xc3) {
+        return true;
+    }
+    if (type <= 0x8f) {
+        header.children = (type & 0x0f) * 2;
+        return true;
+    }
+    if (type <= 0x9f) {
+        header.children = type & 0x0f;
+        return true;
+    }
+    if (type <= 0xbf) {
+        header.payload = type & 0x1f;
+        return true;
+    }
+
+    switch (type) {
+    case 0xc4:
+    case 0xd9:
+        return sized(1, 0, false, 1);
+    case 0xc5:
+    case 0xda:
+        return sized(2, 0, false, 1);
+    case 0xc6:
+    case 0xdb:
+        return sized(4, 0, false, 1);
+    case 0xc7:
+        return sized(1, 1, false, 1);
+    case 0xc8:
+        return sized(2, 1, false, 1);
+    case 0xc9:
+        return sized(4, 1, false, 1);
+    case 0xca:
+    case 0xce:
+    case 0xd2:
+        header.payload = 4;
+        return true;
+    case 0xcb:
+    case 0xcf:
+    case 0xd3:
+        header.payload = 8;
+        return true;
+    case 0xcc:
+    case 0xd0:
+        header.payload = 1;
+        return true;
+    case 0xcd:
+    case 0xd1:
+        header.payload = 2;
+        return true;
+    case 0xd4:
+        header.payload = 2;
+        return true;
+    case 0xd5:
+        header.payload = 3;
+        return true;
+    case 0xd6:
+        header.payload = 5;
+        return true;
+    case 0xd7:
+        header.payload = 9;
+        return true;
+    case 0xd8:
+        header.payload = 17;
+        return true;
+    case 0xdc:
+        return sized(2, 0, true, 1);
+    case 0xdd:
+        return sized(4, 0, true, 1);
+    case 0xde:
+        return sized(2, 0, true, 2);
+    case 0xdf:
+        return sized(4, 0, true, 2);
+    default:
+        EXCEPTION("Invalid msgpack type: 0x{:02x}", type);
+    }
+}
+} // namespace
+
+MsgpackReader::MsgpackReader(const char* data, const size_t size) : data{data}, size{size} {
+}
+
+size_t MsgpackReader::getObjectSize(const char* data, const size_t size) {
+    MsgpackSizeParser parser{};
+    return parser.parse(data, size);
+}
+
+uint8_t MsgpackReader::peek() const {
+    if (offset >= size) {
+        EXCEPTION("Unexpected end of msgpack data at offset: {}", offset);
+    }
+    return static_cast<uint8_t>(data[offset]);
+}
+
+template <typename T> T MsgpackReader::readBigEndian() {
+    if (offset + sizeof(T) > size) {
+        EXCEPTION("Unexpected end of msgpack data at offset: {}", offset);
+    }
+    const auto value = loadBigEndian<T>(reinterpret_cast<const uint8_t*>(data + offset));
+    offset += sizeof(T);
+    return value;
+}
+
+uint32_t MsgpackReader::readArray() {
+    const auto type = peek();
+    ++offset;
+    if (type >= 0x90 && type <= 0x9f) {
+        return type & 0x0f;
+    }
+    if (type == 0xdc) {
+        return readBigEndian<uint16_t>();
+    }
+    if (type == 0xdd) {
+        return readBigEndian<uint32_t>();
+    }
+    EXCEPTION("Expected msgpack array at offset: {} got type: 0x{:02x}", offset - 1, type);
+}
+
+uint64_t MsgpackReader::readUint() {
+    // Does not fit the signed value, the message hashes use the whole range
+    if (peek() == 0xcf) {
+        ++offset;
+        return readBigEndian<uint64_t>();
+    }
+
+    const auto value = readInt();
+    if (value < 0) {
+        EXCEPTION("Expected msgpack unsigned integer at offset: {}", offset);
+    }
+    return static_cast<uint64_t>(value);
+}
+
+int64_t MsgpackReader::readInt() {
+    const auto type = peek();
+    ++offset;
+    if (type <= 0x7f) {
+        return type;
+    }
+    if (type >= 0xe0) {
+        return static_cast<int8_t>(type);
+    }
+
+    switch (type) {
+    case 0xcc:
+        return readBigEndian<uint8_t>();
+    case 0xcd:
+        return readBigEndian<uint16_t>();
+    case 0xce:
+        return readBigEndian<uint32_t>();
+    case 0xcf: {
+        const auto value = readBigEndian<uint64_t>();
+        if (value > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+            EXCEPTION("Msgpack unsigned integer out of range at offset: {}", offset);
+        }
+        return static_cast<int64_t>(value);
+    }
+    case 0xd0:
+        return static_cast<int8_t>(readBigEndian<uint8_t>());
+    case 0xd1:
+        return static_cast<int16_t>(readBigEndian<uint16_t>());
+    case 0xd2:
+        return static_cast<int32_t>(readBigEndian<uint32_t>());
+    case 0xd3:
+        return static_cast<int64_t>(readBigEndian<uint64_t>());
+    default:
+        EXCEPTION("Expected msgpack integer at offset: {} got type: 0x{:02x}", offset - 1, type);
+    }
+}
+
+double MsgpackReader::readDouble() {
+    const auto type = peek();
+    if (type == 0xca) {
+        ++offset;
+        const auto bits = readBigEndian<uint32_t>();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    if (type == 0xcb) {
+        ++offset;
+        const auto bits = readBigEndian<uint64_t>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    // Whole numbers may have been packed as integers
+    return static_cast<double>(readInt());
+}
+
+std::string_view MsgpackReader::readRaw() {
+    const auto length = getObjectSize(data + offset, size - offset);
+    if (length == 0) {
+        EXCEPTION("Unexpected end of msgpack data at offset: {}", offset);
+    }
+    const std::string_view raw{data + offset, length};
+    offset += length;
+    return raw;
+}
+
+void MsgpackReader::skip() {
+    (void)readRaw();
+}
+
+size_t MsgpackSizeParser::parse(const char* data, const size_t size) {
+    const auto* src = reinterpret_cast<const uint8_t*>(data);
+
+    // Walked without recursion, only the number of values still to be read is tracked.
+    // A header cut by the end of the data is parsed again on the next call, the payloads are skipped.
+    while (pending > 0) {
+        if (offset >= size) {
+            return 0;
+        }
+
+        Header header{};
+        if (!parseHeader(src + offset, size - offset, header)) {
+            return 0;
+        }
+
+        offset += header.length + header.payload;
+        pending += header.children - 1;
+    }
+
+    if (offset > size) {
+        return 0;
+    }
+
+    const auto result = offset;
+    reset();
+    return result;
+}
+
+void MsgpackSizeParser::reset() {
+    offset = 0;
+    pending = 1;
+}
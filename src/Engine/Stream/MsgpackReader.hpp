@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../Library.hpp"
+#include <cstdint>
+#include <string_view>
+
+namespace Engine {
+// Reads msgpack values one by one straight from a buffer, without unpacking the data into an object tree.
+// Meant for the hot messages that are decoded by hand, the values must be read in the order they were packed.
+// Throws when the data is malformed or ends too early.
+class ENGINE_API MsgpackReader {
+public:
+    MsgpackReader(const char* data, size_t size);
+    explicit MsgpackReader(std::string_view data) : MsgpackReader{data.data(), data.size()} {
+    }
+
+    uint32_t readArray();
+    uint64_t readUint();
+    int64_t readInt();
+    double readDouble();
+    // The packed bytes of the next value, whatever its type is
+    std::string_view readRaw();
+    void skip();
+
+    [[nodiscard]] size_t getOffset() const {
+        return offset;
+    }
+    [[nodiscard]] bool isEnd() const {
+        return offset == size;
+    }
+
+    // Size in bytes of the first value in the buffer, or zero when the buffer ends before the value does
+    static size_t getObjectSize(const char* data, size_t size);
+
+private:
+    uint8_t peek() const;
+    template <typename T> T readBigEndian();
+
+    const char* data;
+    size_t size;
+    size_t offset{0};
+};
+
+// Finds the size of a value that arrives in parts, every call continues where the previous one stopped,
+// so every header is parsed only once however many parts the value is split into.
+// The nested arrays and maps only add to the number of values still to be read, no stack is needed.
+class ENGINE_API MsgpackSizeParser {
+public:
+    // The data always starts at the value and holds all of the bytes received so far.
+    // Returns the size of the value once it is complete and starts over, otherwise zero.
+    size_t parse(const char* data, size_t size);
+    void reset();
+
+    // Bytes the value needs at least, known from the headers parsed so far
+    [[nodiscard]] size_t getRequired() const {
+        return offset;
+    }
+
+private:
+    size_t offset{0};
+    size_t pending{1};
+};
+} // namespace Engine
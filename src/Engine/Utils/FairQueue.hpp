@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine {
+// Bounded per key (ie. per player session) queue of tasks that is drained in round robin order,
+// so a single key flooding the queue can only spend its own budget and never delays the others.
+// Tasks with the same non-zero coalesce id replace each other while they are waiting, which is
+// how repeated idempotent requests (the latest one wins) are collapsed into one.
+template <typename Key> class FairQueue {
+public:
+    using Task = std::function<void()>;
+
+    struct Options {
+        // Tasks waiting per key, anything above is dropped
+        size_t capacity{64};
+        // Total cost of the tasks a single key can run during one drain
+        size_t budget{16};
+    };
+
+    enum class Result {
+        Queued,
+        Coalesced,
+        Dropped,
+    };
+
+    explicit FairQueue(const Options& options) : options{options} {
+    }
+
+    Result push(const Key& key, const uint64_t coalesce, const size_t cost, Task task) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto& queue = queues[key];
+
+        if (coalesce != 0) {
+            for (auto& entry : queue) {
+                if (entry.coalesce == coalesce) {
+                    entry.cost = cost;
+                    entry.task = std::move(task);
+                    ++coalesced;
+                    return Result::Coalesced;
+                }
+            }
+        }
+
+        if (queue.size() >= options.capacity) {
+            ++dropped;
+            return Result::Dropped;
+        }
+
+        if (queue.empty()) {
+            order.push_back(key);
+        }
+        queue.push_back({coalesce, cost, std::move(task)});
+        ++pending;
+        return Result::Queued;
+    }
+
+    // Runs one task of every key in turn until their budgets are spent, the rest waits for the next drain.
+    // The tasks run outside of the lock, so they can push more tasks. Returns the number of tasks run.
+    size_t drain() {
+        std::vector<Task> tasks;
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+
+            std::vector<size_t> spent(order.size(), 0);
+            bool progress = true;
+            while (progress) {
+                progress = false;
+                for (size_t i = 0; i < order.size(); i++) {
+                    auto& queue = queues[order[i]];
+                    if (queue.empty()) {
+                        continue;
+                    }
+
+                    // The first task always runs, even if it costs more than the whole budget
+                    auto& entry = queue.front();
+                    if (spent[i] != 0 && spent[i] + entry.cost > options.budget) {
+                        continue;
+                    }
+
+                    spent[i] += entry.cost;
+                    tasks.push_back(std::move(entry.task));
+                    queue.pop_front();
+                    --pending;
+                    progress = true;
+                }
+            }
+
+            std::deque<Key> next;
+            for (const auto& key : order) {
+                const auto it = queues.find(key);
+                if (it->second.empty()) {
+                    queues.erase(it);
+                } else {
+                    next.push_back(key);
+                }
+            }
+
+            // Rotated, so the same key does not always run first
+            if (!next.empty()) {
+                next.push_back(std::move(next.front()));
+                next.pop_front();
+            }
+            order = std::move(next);
+        }
+
+        for (auto& task : tasks) {
+            task();
+        }
+
+        return tasks.size();
+    }
+
+    void remove(const Key& key) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        const auto it = queues.find(key);
+        if (it == queues.end()) {
+            return;
+        }
+
+        pending -= it->second.size();
+        queues.erase(it);
+        order.erase(std::remove(order.begin(), order.end(), key), order.end());
+    }
+
+    [[nodiscard]] size_t size() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return pending;
+    }
+
+    [[nodiscard]] uint64_t getDropped() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return dropped;
+    }
+
+    [[nodiscard]] uint64_t getCoalesced() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return coalesced;
+    }
+
+private:
+    struct Entry {
+        uint64_t coalesce;
+        size_t cost;
+        Task task;
+    };
+
+    const Options options;
+    mutable std::mutex mutex;
+    std::unordered_map<Key, std::deque<Entry>> queues;
+    std::deque<Key> order;
+    size_t pending{0};
+    uint64_t dropped{0};
+    uint64_t coalesced{0};
+};
+} // namespace Engine
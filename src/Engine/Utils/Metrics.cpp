@@ -0,0 +1,285 @@
+#include "Metrics.hpp"
+#include "Exceptions.hpp"
+#include <cmath>
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+static const char* toTypeString(const Metrics::Type type) {
+    switch (type) {
+    case Metrics::Type::Counter: {
+        return "counter";
+    }
+    case Metrics::Type::Gauge: {
+        return "gauge";
+    }
+    default: {
+        return "summary";
+    }
+    }
+}
+
+static std::string formatLabels(const Metrics::Labels& labels, const std::string_view& extra = "") {
+    if (labels.empty() && extra.empty()) {
+        return "";
+    }
+
+    std::string res{"{"};
+    for (const auto& [key, value] : labels) {
+        if (res.size() > 1) {
+            res += ",";
+        }
+        res += key;
+        res += "=\"";
+        for (const auto c : value) {
+            if (c == '\\' || c == '"') {
+                res += '\\';
+                res += c;
+            } else if (c == '\n') {
+                res += "\\n";
+            } else {
+                res += c;
+            }
+        }
+        res += "\"";
+    }
+    if (!extra.empty()) {
+        if (res.size() > 1) {
+            res += ",";
+        }
+        res += extra;
+    }
+    res += "}";
+    return res;
+}
+
+static size_t findLastBitSet(uint64_t value) {
+    size_t res{0};
+    for (size_t shift = 32; shift > 0; shift /= 2) {
+        if (value >> shift) {
+            value >>= shift;
+            res += shift;
+        }
+    }
+    return res;
+}
+
+MetricHistogram::MetricHistogram(const double scale) : scale{scale} {
+}
+
+size_t MetricHistogram::getBucketIndex(const uint64_t value) {
+    if (value < subBucketCount) {
+        return value;
+    }
+
+    // The top bit is implicit, the next subBucketBits bits select the linear sub-bucket
+    const auto shift = findLastBitSet(value) - subBucketBits;
+    const auto sub = (value >> shift) - subBucketCount;
+    return (shift + 1) * subBucketCount + sub;
+}
+
+uint64_t MetricHistogram::getBucketValue(const size_t index) {
+    if (index < subBucketCount) {
+        return index;
+    }
+
+    // Middle of the bucket
+    const auto shift = index / subBucketCount - 1;
+    const auto sub = index % subBucketCount;
+    const auto lower = static_cast<uint64_t>(subBucketCount + sub) << shift;
+    return lower + ((uint64_t{1} << shift) >> 1);
+}
+
+void MetricHistogram::record(const uint64_t value) {
+    buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+double MetricHistogram::getSum() const {
+    return static_cast<double>(sum.load(std::memory_order_relaxed)) * scale;
+}
+
+double MetricHistogram::getMax() const {
+    return static_cast<double>(max.load(std::memory_order_relaxed)) * scale;
+}
+
+double MetricHistogram::getPercentile(const double quantile) const {
+    // The buckets are read one by one while they may be still written to, the result is only approximate
+    uint64_t total{0};
+    for (const auto& bucket : buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total))));
+    uint64_t seen{0};
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return std::min(static_cast<double>(getBucketValue(i)) * scale, getMax());
+        }
+    }
+    return getMax();
+}
+
+Metrics& Metrics::getInstance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Family& Metrics::getFamily(const std::string& name, const Type type, const std::string& help) {
+    auto it = families.find(name);
+    if (it == families.end()) {
+        it = families.emplace(name, Family{type, help, {}}).first;
+    } else if (it->second.type != type) {
+        EXCEPTION("Metric: '{}' is already registered with type: {}", name, toTypeString(it->second.type));
+    }
+    return it->second;
+}
+
+MetricCounter& Metrics::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& series = getFamily(name, Type::Counter, help).series[formatLabels(labels)];
+    if (!series) {
+        series = std::make_unique<Series>(std::in_place_type<MetricCounter>);
+    }
+    return std::get<MetricCounter>(*series);
+}
+
+MetricGauge& Metrics::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& series = getFamily(name, Type::Gauge, help).series[formatLabels(labels)];
+    if (!series) {
+        series = std::make_unique<Series>(std::in_place_type<MetricGauge>);
+    }
+    return std::get<MetricGauge>(*series);
+}
+
+MetricHistogram& Metrics::histogram(const std::string& name, const std::string& help, const Labels& labels,
+                                    const double scale) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto& series = getFamily(name, Type::Histogram, help).series[formatLabels(labels)];
+    if (!series) {
+        series = std::make_unique<Series>(std::in_place_type<MetricHistogram>, scale);
+    }
+    return std::get<MetricHistogram>(*series);
+}
+
+void Metrics::remove(const std::string& name, const Labels& labels) {
+    std::lock_guard<std::mutex> lock{mutex};
+    const auto it = families.find(name);
+    if (it != families.end()) {
+        it->second.series.erase(formatLabels(labels));
+    }
+}
+
+uint64_t Metrics::addCollector(const std::string& name, const Type type, const std::string& help,
+                               Collector collector) {
+    if (type == Type::Histogram) {
+        EXCEPTION("Metric collector: '{}' can not produce a histogram", name);
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    const auto id = nextCollectorId++;
+    collectors.emplace(id, CollectorEntry{name, type, help, std::move(collector)});
+    return id;
+}
+
+void Metrics::removeCollector(const uint64_t id) {
+    std::lock_guard<std::mutex> lock{mutex};
+    collectors.erase(id);
+}
+
+std::vector<Metrics::CollectorEntry> Metrics::getCollectors() const {
+    // Copied so that the collectors do not run while holding the registry lock
+    std::lock_guard<std::mutex> lock{mutex};
+    std::vector<CollectorEntry> res;
+    res.reserve(collectors.size());
+    for (const auto& [_, entry] : collectors) {
+        res.push_back(entry);
+    }
+    return res;
+}
+
+std::string Metrics::toPrometheus() const {
+    static const std::array<std::pair<double, const char*>, 4> quantiles = {{
+        {0.5, "quantile=\"0.5\""},
+        {0.9, "quantile=\"0.9\""},
+        {0.99, "quantile=\"0.99\""},
+        {0.999, "quantile=\"0.999\""},
+    }};
+
+    std::string out;
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (const auto& [name, family] : families) {
+            if (family.series.empty()) {
+                continue;
+            }
+
+            out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help, name, toTypeString(family.type));
+
+            for (const auto& [labels, series] : family.series) {
+                if (const auto* counter = std::get_if<MetricCounter>(series.get())) {
+                    out += fmt::format("{}{} {}\n", name, labels, counter->get());
+                } else if (const auto* gauge = std::get_if<MetricGauge>(series.get())) {
+                    out += fmt::format("{}{} {}\n", name, labels, gauge->get());
+                } else if (const auto* histogram = std::get_if<MetricHistogram>(series.get())) {
+                    // Labels are stored already formatted, the quantile goes inside the braces
+                    const auto prefix = labels.empty() ? std::string{"{"} : labels.substr(0, labels.size() - 1) + ",";
+                    for (const auto& [quantile, label] : quantiles) {
+                        out += fmt::format("{}{}{}}} {}\n", name, prefix, label, histogram->getPercentile(quantile));
+                    }
+                    out += fmt::format("{}_sum{} {}\n", name, labels, histogram->getSum());
+                    out += fmt::format("{}_count{} {}\n", name, labels, histogram->getCount());
+                }
+            }
+        }
+    }
+
+    for (const auto& entry : getCollectors()) {
+        std::vector<Sample> samples;
+        entry.collector(samples);
+        if (samples.empty()) {
+            continue;
+        }
+
+        out += fmt::format(
+            "# HELP {} {}\n# TYPE {} {}\n", entry.name, entry.help, entry.name, toTypeString(entry.type));
+        for (const auto& sample : samples) {
+            out += fmt::format("{}{} {}\n", entry.name, formatLabels(sample.labels), sample.value);
+        }
+    }
+
+    return out;
+}
+
+void Metrics::logSummary() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    for (const auto& [name, family] : families) {
+        for (const auto& [labels, series] : family.series) {
+            if (const auto* counter = std::get_if<MetricCounter>(series.get())) {
+                logger.info("Metric {}{} = {}", name, labels, counter->get());
+            } else if (const auto* gauge = std::get_if<MetricGauge>(series.get())) {
+                logger.info("Metric {}{} = {}", name, labels, gauge->get());
+            } else if (const auto* histogram = std::get_if<MetricHistogram>(series.get())) {
+                logger.info("Metric {}{} count: {} p50: {:.6f} p99: {:.6f} max: {:.6f}",
+                            name,
+                            labels,
+                            histogram->getCount(),
+                            histogram->getPercentile(0.5),
+                            histogram->getPercentile(0.99),
+                            histogram->getMax());
+            }
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "../Library.hpp"
+#include "MoveableCopyable.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace Engine {
+class ENGINE_API MetricCounter {
+public:
+    MetricCounter() = default;
+    NON_COPYABLE(MetricCounter);
+    NON_MOVEABLE(MetricCounter);
+
+    void add(const uint64_t value = 1) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+    [[nodiscard]] uint64_t get() const {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> counter{0};
+};
+
+class ENGINE_API MetricGauge {
+public:
+    MetricGauge() = default;
+    NON_COPYABLE(MetricGauge);
+    NON_MOVEABLE(MetricGauge);
+
+    void set(const int64_t value) {
+        gauge.store(value, std::memory_order_relaxed);
+    }
+    void add(const int64_t value) {
+        gauge.fetch_add(value, std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t get() const {
+        return gauge.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> gauge{0};
+};
+
+// Lock-free HDR-like histogram, every power of two is split into 16 linear sub-buckets,
+// so any recorded value is reported with a relative error of at most 1/32
+class ENGINE_API MetricHistogram {
+public:
+    static constexpr size_t subBucketBits = 4;
+    static constexpr size_t subBucketCount = 1 << subBucketBits;
+    static constexpr size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+    class ENGINE_API Timer {
+    public:
+        explicit Timer(MetricHistogram& histogram) :
+            histogram{histogram}, start{std::chrono::steady_clock::now()} {
+        }
+        ~Timer() {
+            histogram.record(std::chrono::steady_clock::now() - start);
+        }
+        NON_COPYABLE(Timer);
+        NON_MOVEABLE(Timer);
+
+    private:
+        MetricHistogram& histogram;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // The scale is applied when the values are exported, ie. 1e-9 for nanoseconds exported as seconds
+    explicit MetricHistogram(double scale = 1.0);
+    NON_COPYABLE(MetricHistogram);
+    NON_MOVEABLE(MetricHistogram);
+
+    void record(uint64_t value);
+    void record(const std::chrono::nanoseconds value) {
+        record(static_cast<uint64_t>(std::max<int64_t>(value.count(), 0)));
+    }
+
+    [[nodiscard]] uint64_t getCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] double getSum() const;
+    [[nodiscard]] double getMax() const;
+    [[nodiscard]] double getPercentile(double quantile) const;
+
+    static size_t getBucketIndex(uint64_t value);
+    static uint64_t getBucketValue(size_t index);
+
+private:
+    const double scale;
+    std::array<std::atomic<uint64_t>, bucketCount> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+};
+
+// Process wide registry of named metrics, the returned references stay valid until the series is removed,
+// so the hot paths only touch the atomics
+class ENGINE_API Metrics {
+public:
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    struct Sample {
+        Labels labels;
+        double value{0.0};
+    };
+
+    // Produces samples on demand for values that already live somewhere else, ie. per peer totals
+    using Collector = std::function<void(std::vector<Sample>&)>;
+
+    static Metrics& getInstance();
+
+    MetricCounter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    MetricGauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    MetricHistogram& histogram(const std::string& name, const std::string& help, const Labels& labels = {},
+                               double scale = 1.0);
+    void remove(const std::string& name, const Labels& labels);
+
+    uint64_t addCollector(const std::string& name, Type type, const std::string& help, Collector collector);
+    void removeCollector(uint64_t id);
+
+    // Prometheus text exposition format (version 0.0.4)
+    [[nodiscard]] std::string toPrometheus() const;
+    void logSummary() const;
+
+private:
+    using Series = std::variant<MetricCounter, MetricGauge, MetricHistogram>;
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<std::string, std::unique_ptr<Series>> series;
+    };
+
+    struct CollectorEntry {
+        std::string name;
+        Type type;
+        std::string help;
+        Collector collector;
+    };
+
+    Metrics() = default;
+    Family& getFamily(const std::string& name, Type type, const std::string& help);
+    std::vector<CollectorEntry> getCollectors() const;
+
+    mutable std::mutex mutex;
+    std::map<std::string, Family> families;
+    std::map<uint64_t, CollectorEntry> collectors;
+    uint64_t nextCollectorId{1};
+};
+} // namespace Engine
@@ -0,0 +1,214 @@
+#include "Profiler.hpp"
+#include "Exceptions.hpp"
+#include "Json.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+using namespace Engine;
+
+static auto logger = createLogger(LOG_FILENAME);
+
+// Chrome trace has no notion of a GPU, the GPU zones are shown as a separate thread instead
+static constexpr uint32_t gpuThreadId = 0;
+
+template <typename Fn> void Profiler::ThreadBuffer::forEach(Fn&& fn) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    for (const auto& zone : zones) {
+        fn(zone);
+    }
+}
+
+void Profiler::ThreadBuffer::push(const Zone& zone) {
+    // Only contended while the zones are being collected
+    std::lock_guard<std::mutex> lock{mutex};
+    if (zones.size() < ringSize) {
+        zones.push_back(zone);
+    } else {
+        zones[next] = zone;
+    }
+    next = (next + 1) % ringSize;
+}
+
+Profiler::Scope::Scope(const char* name) : name{nullptr} {
+    auto& profiler = Profiler::getInstance();
+    if (profiler.isEnabled()) {
+        this->name = name;
+        ++profiler.getThreadBuffer().depth;
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+Profiler::Scope::~Scope() {
+    if (name) {
+        const auto end = std::chrono::steady_clock::now();
+        auto& profiler = Profiler::getInstance();
+        --profiler.getThreadBuffer().depth;
+        profiler.addZone(name, start, end);
+    }
+}
+
+Profiler::Profiler() : epoch{std::chrono::steady_clock::now()}, gpu{std::make_shared<ThreadBuffer>()} {
+    gpu->id = gpuThreadId;
+    gpu->name = "GPU";
+    gpu->zones.reserve(ringSize);
+}
+
+Profiler& Profiler::getInstance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadBuffer& Profiler::getThreadBuffer() {
+    // The buffer is shared with the profiler so the zones outlive the thread that recorded them
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->zones.reserve(ringSize);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        buffer->id = static_cast<uint32_t>(threads.size() + 1);
+        buffer->name = fmt::format("Thread {}", buffer->id);
+        threads.push_back(buffer);
+    }
+    return *buffer;
+}
+
+const char* Profiler::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock{mutex};
+    return names.insert(name).first->c_str();
+}
+
+const char* Profiler::internTypeName(const std::type_info& type) {
+#if defined(__GNUC__) || defined(__clang__)
+    int status{0};
+    const std::unique_ptr<char, decltype(&std::free)> demangled{
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free};
+    std::string name{status == 0 && demangled ? demangled.get() : type.name()};
+#else
+    // MSVC names are already readable, prefixed with "class "
+    std::string name{type.name()};
+    if (const auto pos = name.find(' '); pos != std::string::npos) {
+        name.erase(0, pos + 1);
+    }
+#endif
+
+    if (const auto pos = name.rfind("::"); pos != std::string::npos) {
+        name.erase(0, pos + 2);
+    }
+    return intern(name);
+}
+
+void Profiler::setThreadName(std::string name) {
+    auto& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock{buffer.mutex};
+    buffer.name = std::move(name);
+}
+
+void Profiler::addZone(const char* name, const std::chrono::steady_clock::time_point start,
+                       const std::chrono::steady_clock::time_point end) {
+    auto& buffer = getThreadBuffer();
+    buffer.push(Zone{name, buffer.depth, sinceEpoch(start), sinceEpoch(end) - sinceEpoch(start)});
+}
+
+void Profiler::addGpuZone(const char* name, const std::chrono::steady_clock::time_point start,
+                          const std::chrono::nanoseconds duration) {
+    if (isEnabled()) {
+        gpu->push(Zone{name, 0, sinceEpoch(start), duration});
+    }
+}
+
+std::vector<Profiler::Stat> Profiler::getStats(const std::chrono::nanoseconds window) const {
+    const auto from = sinceEpoch(std::chrono::steady_clock::now()) - window;
+
+    std::unordered_map<std::string_view, Stat> map;
+    const auto collect = [&](const Zone& zone) {
+        if (zone.start < from) {
+            return;
+        }
+        auto& stat = map[zone.name];
+        stat.total += zone.duration;
+        stat.max = std::max(stat.max, zone.duration);
+        ++stat.count;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (const auto& thread : threads) {
+            thread->forEach(collect);
+        }
+    }
+    gpu->forEach(collect);
+
+    std::vector<Stat> stats;
+    stats.reserve(map.size());
+    for (auto& [name, stat] : map) {
+        stat.name = name;
+        stats.push_back(std::move(stat));
+    }
+
+    std::sort(stats.begin(), stats.end(), [](const Stat& a, const Stat& b) { return a.total > b.total; });
+    return stats;
+}
+
+void Profiler::exportChromeTrace(const Path& path) const {
+    logger.info("Exporting profiler trace to: '{}'", path);
+
+    auto events = Json::array();
+
+    const auto exportThread = [&](const ThreadBuffer& thread) {
+        events.push_back({
+            {"name", "thread_name"},
+            {"ph", "M"},
+            {"pid", 1},
+            {"tid", thread.id},
+            {"args", {{"name", thread.name}}},
+        });
+
+        thread.forEach([&](const Zone& zone) {
+            // Chrome trace timestamps are in microseconds
+            events.push_back({
+                {"name", zone.name},
+                {"ph", "X"},
+                {"pid", 1},
+                {"tid", thread.id},
+                {"ts", static_cast<double>(zone.start.count()) / 1000.0},
+                {"dur", static_cast<double>(zone.duration.count()) / 1000.0},
+            });
+        });
+    };
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (const auto& thread : threads) {
+            exportThread(*thread);
+        }
+    }
+    exportThread(*gpu);
+
+    Json json;
+    json["traceEvents"] = std::move(events);
+    json["displayTimeUnit"] = "ms";
+
+    const auto str = json.dump();
+    writeFileBinary(path, str.data(), str.size());
+}
+
+void Profiler::clear() {
+    const auto clearThread = [](ThreadBuffer& thread) {
+        std::lock_guard<std::mutex> lock{thread.mutex};
+        thread.zones.clear();
+        thread.next = 0;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (auto& thread : threads) {
+            clearThread(*thread);
+        }
+    }
+    clearThread(*gpu);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../Library.hpp"
+#include "MoveableCopyable.hpp"
+#include "Path.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_set>
+#include <vector>
+
+namespace Engine {
+// Collects named CPU/GPU time zones into per-thread ring buffers, the zones can be summarized for an
+// on-screen overlay or exported as a Chrome trace (chrome://tracing or ui.perfetto.dev)
+class ENGINE_API Profiler {
+public:
+    static constexpr size_t ringSize = 1024 * 16;
+
+    struct Zone {
+        const char* name{nullptr};
+        uint32_t depth{0};
+        std::chrono::nanoseconds start{0};
+        std::chrono::nanoseconds duration{0};
+    };
+
+    struct Stat {
+        std::string name;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+        size_t count{0};
+    };
+
+    class ENGINE_API Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        NON_COPYABLE(Scope);
+        NON_MOVEABLE(Scope);
+
+    private:
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static Profiler& getInstance();
+
+    void setEnabled(const bool value) {
+        enabled.store(value, std::memory_order_relaxed);
+    }
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Returns a pointer to a copy of the name that stays valid for the lifetime of the profiler
+    const char* intern(const std::string& name);
+    // Same as intern, with the demangled name of the type without its namespace
+    const char* internTypeName(const std::type_info& type);
+    void setThreadName(std::string name);
+    void addZone(const char* name, std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end);
+    void addGpuZone(const char* name, std::chrono::steady_clock::time_point start, std::chrono::nanoseconds duration);
+
+    // Aggregated zones (by name) which started within the last window of time, sorted by total time
+    std::vector<Stat> getStats(std::chrono::nanoseconds window) const;
+    void exportChromeTrace(const Path& path) const;
+    void clear();
+
+private:
+    struct ThreadBuffer {
+        uint32_t id{0};
+        std::string name;
+        mutable std::mutex mutex;
+        std::vector<Zone> zones;
+        size_t next{0};
+        uint32_t depth{0};
+
+        void push(const Zone& zone);
+        template <typename Fn> void forEach(Fn&& fn) const;
+    };
+
+    Profiler();
+    ThreadBuffer& getThreadBuffer();
+    std::chrono::nanoseconds sinceEpoch(std::chrono::steady_clock::time_point time) const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch);
+    }
+
+    const std::chrono::steady_clock::time_point epoch;
+    std::atomic_bool enabled{true};
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    std::shared_ptr<ThreadBuffer> gpu;
+    std::unordered_set<std::string> names;
+};
+} // namespace Engine
+
+#ifdef TEMPORARY_ESCAPE_PROFILER
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) const Engine::Profiler::Scope PROFILE_CONCAT(profilerScope, __LINE__){name}
+#define PROFILE_THREAD(name) Engine::Profiler::getInstance().setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) (void)0
+#define PROFILE_THREAD(name) (void)0
+#endif
@@ -1,6 +1,7 @@
 #include "Random.hpp"
 #include "NameGenerator.hpp"
 #include <array>
+#include <mutex>
 
 #if defined(_WIN32)
 #include <rpc.h>
@@ -64,7 +65,12 @@ static char hexLow(const uint8_t b) {
 }
 #endif
 
+// The platform generators are not documented as thread safe, the generator calls this from its worker threads
+static std::mutex uuidMutex;
+
 std::string Engine::uuid() {
+    std::lock_guard<std::mutex> lock{uuidMutex};
+
 #if defined(_WIN32)
     UUID uuid;
     UuidCreate(&uuid);
@@ -483,6 +483,13 @@ void VulkanRenderer::transitionImageLayout(VulkanTexture& texture, const VkImage
 
         sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
         destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL &&
+               newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
     } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED &&
                newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
         barrier.srcAccessMask = 0;
@@ -623,6 +630,94 @@ void VulkanRenderer::copyBufferToImage(const VulkanBuffer& buffer, VulkanTexture
     }
 }
 
+std::vector<char> VulkanRenderer::copyImageToData(const VulkanTexture& texture, const VkImageLayout layout,
+                                                  const int level, const Vector2i& offset, const int layer,
+                                                  const Vector2i& size) {
+
+    const auto region = VkExtent3D{static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y), 1};
+
+    VulkanBuffer::CreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = getFormatDataSize(texture.getFormat(), region);
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferInfo.memoryUsage = VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_ONLY;
+
+    auto stagingBuffer = createBuffer(bufferInfo);
+
+    auto commandBuffer = createCommandBuffer();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBuffer.start(beginInfo);
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = texture.getHandle();
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = level;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = layer;
+    barrier.subresourceRange.layerCount = 1;
+
+    const auto transition = layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    if (transition) {
+        barrier.oldLayout = layout;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        commandBuffer.pipelineBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, barrier);
+    }
+
+    std::array<VkBufferImageCopy, 1> regions{};
+    regions[0].bufferOffset = 0;
+    regions[0].bufferRowLength = 0;
+    regions[0].bufferImageHeight = 0;
+    regions[0].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    regions[0].imageSubresource.mipLevel = level;
+    regions[0].imageSubresource.baseArrayLayer = layer;
+    regions[0].imageSubresource.layerCount = 1;
+    regions[0].imageOffset = {offset.x, offset.y, 0};
+    regions[0].imageExtent = region;
+
+    commandBuffer.copyImageToBuffer(texture, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, regions);
+
+    if (transition) {
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = layout;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        commandBuffer.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, barrier);
+    }
+
+    commandBuffer.end();
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer.getHandle();
+
+    if (vkQueueSubmit(getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        EXCEPTION("Failed to download image data, submit error");
+    }
+
+    if (vkQueueWaitIdle(getGraphicsQueue()) != VK_SUCCESS) {
+        EXCEPTION("Failed to download image data, wait queue error");
+    }
+
+    std::vector<char> data;
+    data.resize(bufferInfo.size);
+
+    const auto* stagingBufferSrc = stagingBuffer.mapMemory();
+    std::memcpy(data.data(), stagingBufferSrc, data.size());
+    stagingBuffer.unmapMemory();
+
+    return data;
+}
+
 bool VulkanRenderer::canBeMipMapped(const VkFormat format) const {
     const auto formatProperties = getPhysicalDeviceFormatProperties(format);
 
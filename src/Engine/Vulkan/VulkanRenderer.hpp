@@ -77,6 +77,9 @@ public:
                           const VulkanTexture& source);
     void copyBufferToImage(const VulkanBuffer& buffer, VulkanTexture& texture, int level, int layer,
                            const VkOffset3D& offset, const VkExtent3D& extent);
+    // Reads a region of one level and layer back to the host, the image is returned to its layout afterwards
+    std::vector<char> copyImageToData(const VulkanTexture& texture, VkImageLayout layout, int level,
+                                      const Vector2i& offset, int layer, const Vector2i& size);
     // void getGpuMemoryStats();
     void transitionImageLayout(VulkanTexture& texture, VkImageLayout oldLayout, VkImageLayout newLayout);
     void generateMipMaps(VulkanTexture& texture);
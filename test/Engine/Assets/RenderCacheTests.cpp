@@ -0,0 +1,53 @@
+#include "../../Common.hpp"
+#include <Engine/Assets/RenderCache.hpp>
+
+using namespace Engine;
+
+TEST_CASE("Store and load render cache entry", "[render_cache]") {
+    TmpDir dir{};
+
+    const auto texture = dir.value() / "texture.png";
+    writeFileBinary(texture, "Hello", 5);
+
+    RenderCache::Image image{};
+    image.size = {2, 2};
+    image.pixels = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+    std::string key;
+    {
+        RenderCache cache{dir.value() / "cache"};
+        key = cache.createKey().add("block").add(256).addFile(texture).get();
+
+        REQUIRE_FALSE(cache.load("block_image", key).has_value());
+        cache.store("block_image", key, {image});
+        REQUIRE(cache.getMisses() == 1);
+    }
+
+    SECTION("Same inputs hit the cache") {
+        RenderCache cache{dir.value() / "cache"};
+        REQUIRE(cache.createKey().add("block").add(256).addFile(texture).get() == key);
+
+        const auto images = cache.load("block_image", key);
+        REQUIRE(images.has_value());
+        REQUIRE(images->size() == 1);
+        REQUIRE(images->front().size == image.size);
+        REQUIRE(images->front().pixels == image.pixels);
+        REQUIRE(cache.getHits() == 1);
+    }
+
+    SECTION("Changed settings miss the cache") {
+        RenderCache cache{dir.value() / "cache"};
+        const auto changed = cache.createKey().add("block").add(512).addFile(texture).get();
+        REQUIRE(changed != key);
+        REQUIRE_FALSE(cache.load("block_image", changed).has_value());
+    }
+
+    SECTION("Changed file contents miss the cache") {
+        writeFileBinary(texture, "World", 5);
+
+        RenderCache cache{dir.value() / "cache"};
+        const auto changed = cache.createKey().add("block").add(256).addFile(texture).get();
+        REQUIRE(changed != key);
+        REQUIRE_FALSE(cache.load("block_image", changed).has_value());
+    }
+}
@@ -1,7 +1,11 @@
 #include "../../Common.hpp"
 #include <Engine/Database/DatabaseRocksdb.hpp>
 #include <Engine/Future.hpp>
+#include <Engine/Utils/Metrics.hpp>
 #include <Engine/Utils/Random.hpp>
+#include <iostream>
+#include <sstream>
+#include <rocksdb/db.h>
 
 #define TAG "[DatabaseRocksDB]"
 
@@ -71,6 +75,154 @@ TEST_CASE("Database use multiGet to get multiple keys at once", TAG) {
     REQUIRE(players.at(1).name == "Some Name 1");
 }
 
+TEST_CASE("Database object cache is invalidated by writes", TAG) {
+    auto tmpDir = std::make_shared<TmpDir>();
+    DatabaseRocksDB::Options options{};
+    options.objectCacheSize = 100;
+    DatabaseRocksDB db{tmpDir->value(), options};
+    REQUIRE(db.getCache() != nullptr);
+
+    SchemaFoo foo{};
+    foo.bar = "Hello World";
+    foo.baz = 1;
+    db.put<SchemaFoo>("a", foo);
+    db.put<SchemaFoo>("b", foo);
+
+    // Populated by the first read
+    REQUIRE(db.get<SchemaFoo>("a").baz == 1);
+    REQUIRE(db.getCache()->size() == 1);
+    REQUIRE(db.getCache()->find<SchemaFoo>("SchemaFoo:data:a") != nullptr);
+
+    // Cached and uncached keys mixed in a single multiGet keep their order
+    auto items = db.multiGet<SchemaFoo>({"b", "missing", "a"});
+    REQUIRE(items.size() == 2);
+    REQUIRE(db.getCache()->size() == 2);
+
+    foo.baz = 2;
+    db.put<SchemaFoo>("a", foo);
+    REQUIRE(db.getCache()->find<SchemaFoo>("SchemaFoo:data:a") == nullptr);
+    REQUIRE(db.get<SchemaFoo>("a").baz == 2);
+
+    db.update<SchemaFoo>("a", [](std::optional<SchemaFoo> value) {
+        value->baz = 3;
+        return value.value();
+    });
+    REQUIRE(db.get<SchemaFoo>("a").baz == 3);
+
+    db.remove<SchemaFoo>("a");
+    REQUIRE(db.find<SchemaFoo>("a").has_value() == false);
+
+    items = db.multiGet<SchemaFoo>({"a", "b"});
+    REQUIRE(items.size() == 1);
+    REQUIRE(items.at(0).baz == 1);
+}
+
+TEST_CASE("Database write batch and bulk load", TAG) {
+    auto tmpDir = std::make_shared<TmpDir>();
+    DatabaseRocksDB::Options options{};
+    options.objectCacheSize = 100;
+    DatabaseRocksDB db{tmpDir->value(), options};
+
+    SchemaFoo foo{};
+    foo.bar = "Hello World";
+    foo.baz = 1;
+    db.put<SchemaFoo>("cached", foo);
+    REQUIRE(db.get<SchemaFoo>("cached").baz == 1);
+
+    auto batch = db.startBatch();
+    for (auto i = 0; i < 10; i++) {
+        foo.baz = i;
+        batch->put<SchemaFoo>(fmt::format("batch/{}", i), foo);
+    }
+    REQUIRE(batch->size() == 10);
+    REQUIRE(db.find<SchemaFoo>("batch/5").has_value() == false);
+    batch->commit();
+    REQUIRE(db.get<SchemaFoo>("batch/5").baz == 5);
+
+    auto bulk = db.startBulkLoad();
+    // Inserted out of order, the table file is written sorted
+    for (auto i = 9; i >= 0; i--) {
+        foo.baz = i * 10;
+        bulk->put<SchemaFoo>(fmt::format("bulk/{}", i), foo);
+    }
+    foo.baz = 2;
+    bulk->put<SchemaFoo>("cached", foo);
+    bulk->remove<SchemaFoo>("batch/0");
+    REQUIRE(bulk->size() == 12);
+    bulk->commit();
+
+    REQUIRE(db.get<SchemaFoo>("bulk/3").baz == 30);
+    REQUIRE(db.get<SchemaFoo>("cached").baz == 2);
+    REQUIRE(db.find<SchemaFoo>("batch/0").has_value() == false);
+    REQUIRE(db.seekAll<SchemaFoo>("bulk/").size() == 10);
+}
+
+TEST_CASE("Database schemas are stored in their own column families", TAG) {
+    REQUIRE(DatabaseRocksDB::getFamilyName("SchemaFoo:data:123") == "SchemaFoo");
+    REQUIRE(DatabaseRocksDB::getFamilyName("SchemaFoo:index:bar:1:123") == "SchemaFoo");
+    REQUIRE(DatabaseRocksDB::getFamilyName("no schema") == "default");
+
+    auto tmpDir = std::make_shared<TmpDir>();
+
+    // A database written before the column families existed, everything is in the default family
+    {
+        rocksdb::Options opts{};
+        opts.create_if_missing = true;
+        rocksdb::DB* raw{nullptr};
+        REQUIRE(rocksdb::DB::Open(opts, tmpDir->value().string(), &raw).ok());
+
+        SchemaFoo foo{};
+        foo.bar = "legacy";
+        foo.baz = 7;
+        const auto sbuf = Details::packSchema<SchemaFoo>(foo);
+        REQUIRE(raw->Put(rocksdb::WriteOptions{}, "SchemaFoo:data:legacy", {sbuf.data(), sbuf.size()}).ok());
+        REQUIRE(raw->Close().ok());
+        delete raw;
+    }
+
+    {
+        DatabaseRocksDB::Options options{};
+        DatabaseRocksDB db{tmpDir->value(), options};
+        REQUIRE(db.get<SchemaFoo>("legacy").baz == 7);
+
+        SchemaFoo foo{};
+        foo.baz = 42;
+        db.put<SchemaFoo>("new", foo);
+    }
+
+    // The families created at runtime are opened again
+    DatabaseRocksDB::Options options{};
+    DatabaseRocksDB db{tmpDir->value(), options};
+    REQUIRE(db.get<SchemaFoo>("legacy").baz == 7);
+    REQUIRE(db.get<SchemaFoo>("new").baz == 42);
+    REQUIRE(db.seekAll<SchemaFoo>("").size() == 2);
+}
+
+TEST_CASE("Database seeks across and within the extracted prefixes", TAG) {
+    REQUIRE(DatabaseRocksDB::getSeekPrefix("SchemaFoo:data:galaxy/system/sector") == "SchemaFoo:data:galaxy/");
+    REQUIRE(DatabaseRocksDB::getSeekPrefix("SchemaFoo:data:galaxy").empty());
+    REQUIRE(DatabaseRocksDB::getSeekPrefix("SchemaFoo:index:bar:1:123") == "SchemaFoo:index:bar:1:");
+    REQUIRE(DatabaseRocksDB::getSeekPrefix("SchemaFoo:index:bar").empty());
+    REQUIRE(DatabaseRocksDB::getSeekPrefix("no schema").empty());
+
+    auto tmpDir = std::make_shared<TmpDir>();
+    DatabaseRocksDB::Options options{};
+    DatabaseRocksDB db{tmpDir->value(), options};
+
+    for (const auto* key : {"a", "a/1", "a/2", "a/2/x", "ab", "ab/1", "b/1"}) {
+        SchemaFoo foo{};
+        foo.bar = key;
+        db.put<SchemaFoo>(key, foo);
+    }
+
+    REQUIRE(db.seekAll<SchemaFoo>("").size() == 7);
+    REQUIRE(db.seekAll<SchemaFoo>("a").size() == 6);
+    REQUIRE(db.seekAll<SchemaFoo>("a/").size() == 3);
+    REQUIRE(db.seekAll<SchemaFoo>("a/2").size() == 2);
+    REQUIRE(db.seekAll<SchemaFoo>("ab/").size() == 1);
+    REQUIRE(db.seekAll<SchemaFoo>("c/").empty());
+}
+
 TEST_CASE("Database seek many values", TAG) {
     auto tmpDir = std::make_shared<TmpDir>();
     DatabaseRocksDB::Options options{};
@@ -367,6 +519,188 @@ TEST_CASE("Database schema indexes", TAG) {
     REQUIRE(found.empty() == true);
 }
 
+struct SchemaCoveredPlayer {
+    uint64_t uid{0};
+    std::string name;
+    uint64_t secret{0};
+
+    MSGPACK_DEFINE(uid, name, secret);
+};
+
+SCHEMA_DEFINE(SchemaCoveredPlayer);
+SCHEMA_INDEXES(SchemaCoveredPlayer, name, secret);
+SCHEMA_COVERING_INDEXES(SchemaCoveredPlayer, secret);
+SCHEMA_COVERING_FIELDS(SchemaCoveredPlayer, secret, uid);
+
+TEST_CASE("Database covering schema indexes", TAG) {
+    auto tmpDir = std::make_shared<TmpDir>();
+    DatabaseRocksDB::Options options{};
+    DatabaseRocksDB db{tmpDir->value(), options};
+
+    SchemaCoveredPlayer player;
+    player.uid = 123;
+    player.name = "Hello World";
+    player.secret = 42;
+    db.put("1234", player);
+
+    // The covering index entry holds only the covering fields
+    const auto entryKey = Details::keyToSchemaIndexKey<&SchemaCoveredPlayer::secret>(uint64_t{42}, "1234");
+    auto entry = db.seekRaw(entryKey, std::nullopt);
+    REQUIRE(entry->next() == true);
+    const auto entryValue = entry->valueString();
+    REQUIRE(entryValue.front() == static_cast<char>(Details::SchemaIndexTag::Projection));
+    REQUIRE(entryValue.find("Hello World") == std::string::npos);
+    entry.reset();
+
+    auto found = db.getByIndex<&SchemaCoveredPlayer::secret>(uint64_t{42});
+    REQUIRE(found.size() == 1);
+    REQUIRE(found.back().uid == 123);
+    REQUIRE(found.back().name.empty());
+
+    found = db.getByIndex<&SchemaCoveredPlayer::name>(std::string("Hello World"));
+    REQUIRE(found.size() == 1);
+    REQUIRE(found.back().secret == 42);
+
+    // The previous value known to the writer removes the entry of the old name
+    auto previous = player;
+    player.name = "Hello World 2";
+    db.put("1234", player, previous);
+    found = db.getByIndex<&SchemaCoveredPlayer::name>(std::string("Hello World"));
+    REQUIRE(found.empty() == true);
+    REQUIRE(db.getRaw(Details::keyToSchemaIndexKey<&SchemaCoveredPlayer::name>(std::string("Hello World"), "1234"))
+                .has_value() == false);
+
+    // Including the covering one, which would otherwise return the stale fields
+    db.update<SchemaCoveredPlayer>("1234", [](std::optional<SchemaCoveredPlayer> item) {
+        item->secret = 43;
+        item->uid = 124;
+        return item.value();
+    });
+    found = db.getByIndex<&SchemaCoveredPlayer::secret>(uint64_t{42});
+    REQUIRE(found.empty() == true);
+    found = db.getByIndex<&SchemaCoveredPlayer::secret>(uint64_t{43});
+    REQUIRE(found.size() == 1);
+    REQUIRE(found.back().uid == 124);
+
+    // A plain put does not read the previous value, the old plain entry is filtered out on lookup
+    previous = db.get<SchemaCoveredPlayer>("1234");
+    player = previous;
+    player.name = "Hello World 3";
+    db.put("1234", player);
+    found = db.getByIndex<&SchemaCoveredPlayer::name>(std::string("Hello World 2"));
+    REQUIRE(found.empty() == true);
+    found = db.getByIndex<&SchemaCoveredPlayer::name>(std::string("Hello World 3"));
+    REQUIRE(found.size() == 1);
+
+    // Plain entries written before the tags were added hold the bare data key
+    const auto legacyKey = Details::keyToSchemaIndexKey<&SchemaCoveredPlayer::name>(std::string("Legacy"), "1234");
+    const auto dataKey = Details::keyToSchemaDataKey<SchemaCoveredPlayer>("1234");
+    db.putRaw(legacyKey, dataKey.data(), dataKey.size());
+    REQUIRE(db.getByIndexName<SchemaCoveredPlayer>("name", std::string("Legacy")).size() == 1);
+    db.removeRaw(legacyKey);
+
+    db.remove<SchemaCoveredPlayer>("1234");
+    found = db.getByIndex<&SchemaCoveredPlayer::secret>(uint64_t{43});
+    REQUIRE(found.empty() == true);
+}
+
+TEST_CASE("Benchmark database index lookups", "[.benchmark]" TAG) {
+    static constexpr size_t count = 100000;
+
+    auto tmpDir = std::make_shared<TmpDir>();
+    DatabaseRocksDB::Options options{};
+    DatabaseRocksDB db{tmpDir->value(), options};
+
+    // Every name is shared by 10 rows, every secret is unique
+    for (size_t i = 0; i < count; i++) {
+        SchemaCoveredPlayer player;
+        player.uid = i;
+        player.name = fmt::format("player-{}", i / 10);
+        player.secret = i;
+        db.put(fmt::format("{}", i), player);
+    }
+
+    const auto measure = [&](const char* name, const std::function<size_t(size_t)>& fn) {
+        size_t total{0};
+        const auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            total += fn(i);
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        std::cout << name << ": " << us / 1000 << "ms (" << static_cast<double>(us) / count << "us per lookup, "
+                  << total << " rows)" << std::endl;
+    };
+
+    measure("plain index, 10 rows per lookup", [&](const size_t i) {
+        return db.getByIndex<&SchemaCoveredPlayer::name>(fmt::format("player-{}", i / 10)).size();
+    });
+    measure("covering index, 1 row per lookup",
+            [&](const size_t i) { return db.getByIndex<&SchemaCoveredPlayer::secret>(uint64_t{i}).size(); });
+    measure("point lookup, 1 row per lookup",
+            [&](const size_t i) { return db.find<SchemaCoveredPlayer>(fmt::format("{}", i)) ? 1 : 0; });
+}
+
+TEST_CASE("Benchmark database mixed scans and point lookups", "[.benchmark]" TAG) {
+    static constexpr size_t parents = 1000;
+    static constexpr size_t children = 100;
+
+    auto tmpDir = std::make_shared<TmpDir>();
+    DatabaseRocksDB::Options options{};
+    DatabaseRocksDB db{tmpDir->value(), options};
+
+    // Same layout as the galaxy, hierarchical keys scanned by the parent and looked up one by one
+    {
+        auto batch = db.startBulkLoad();
+        for (size_t p = 0; p < parents; p++) {
+            SchemaComplexKey parent;
+            parent.id = fmt::format("{:06}", p);
+            batch->put(parent.id, parent);
+
+            for (size_t c = 0; c < children; c++) {
+                SchemaComplexKey child;
+                child.id = fmt::format("{:06}/{:06}", p, c);
+                batch->put(child.id, child);
+            }
+        }
+        batch->commit();
+    }
+
+    Rng rng{1234};
+    std::uniform_int_distribution<size_t> distParent{0, parents - 1};
+    std::uniform_int_distribution<size_t> distChild{0, children - 1};
+    std::uniform_int_distribution<int> distOp{0, 9};
+
+    static constexpr size_t count = 100000;
+    size_t scanned{0};
+    size_t found{0};
+
+    const auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        const auto p = distParent(rng);
+        // One in ten operations scans all children of a parent
+        if (distOp(rng) == 0) {
+            scanned += db.seekAll<SchemaComplexKey>(fmt::format("{:06}/", p)).size();
+        } else {
+            found += db.find<SchemaComplexKey>(fmt::format("{:06}/{:06}", p, distChild(rng))) ? 1 : 0;
+        }
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    std::cout << "mixed 10% scan 90% point: " << us / 1000 << "ms (" << static_cast<double>(us) / count
+              << "us per op, " << scanned << " scanned, " << found << " found)" << std::endl;
+
+    // Only the cache and the filter counters are of interest here
+    std::istringstream dump{Metrics::getInstance().toPrometheus()};
+    for (std::string line; std::getline(dump, line);) {
+        if (line.rfind("database_rocksdb_block_cache_bytes", 0) == 0 ||
+            (line.rfind("database_rocksdb_tickers_total", 0) == 0 &&
+             (line.find("block_cache") != std::string::npos || line.find("bloom") != std::string::npos))) {
+            std::cout << line << std::endl;
+        }
+    }
+}
+
 /*struct BenchmarkData {
     std::string msg;
     MSGPACK_DEFINE_ARRAY(msg);
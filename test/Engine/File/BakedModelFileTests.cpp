@@ -0,0 +1,88 @@
+#include "../../Common.hpp"
+#include <Engine/File/BakedModelFile.hpp>
+#include <cstring>
+#include <limits>
+
+using namespace Engine;
+
+TEST_CASE("Write and read baked model file", "[baked_model_file]") {
+    TmpDir dir{};
+    const auto path = dir.value() / "model.mdl";
+
+    BakedModel model{};
+    model.collision.bbMin = {-1.0f, -2.0f, -3.0f};
+    model.collision.bbMax = {1.0f, 2.0f, 3.0f};
+    model.collision.radius = 3.75f;
+    model.collision.hull = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+
+    auto& node = model.nodes.emplace_back();
+    node.name = "Hull";
+    auto& primitive = node.primitives.emplace_back();
+    primitive.material.baseColorTexture = "hull_baseColor.png";
+    primitive.material.baseColorFactor = {0.5f, 0.5f, 0.5f, 1.0f};
+    primitive.vertices = {1, 2, 3, 4, 5, 6, 7, 8};
+    primitive.indices = {0, 0, 1, 0, 2, 0};
+    primitive.lods = {{0, 3, 0.0f}};
+    primitive.radius = 1.5f;
+
+    BakedModelFile::write(path, model, 0x1234u);
+
+    SECTION("Read the whole file") {
+        const auto read = BakedModelFile::read(path);
+        REQUIRE(read.collision.bbMin == model.collision.bbMin);
+        REQUIRE(read.collision.bbMax == model.collision.bbMax);
+        REQUIRE(read.collision.hull == model.collision.hull);
+        REQUIRE(read.nodes.size() == 1);
+        REQUIRE(read.nodes.front().name == "Hull");
+        REQUIRE(read.nodes.front().primitives.size() == 1);
+
+        const auto& readPrimitive = read.nodes.front().primitives.front();
+        REQUIRE(readPrimitive.material.baseColorTexture == "hull_baseColor.png");
+        REQUIRE(readPrimitive.material.baseColorFactor == primitive.material.baseColorFactor);
+        REQUIRE(readPrimitive.vertices == primitive.vertices);
+        REQUIRE(readPrimitive.indices == primitive.indices);
+        REQUIRE(readPrimitive.lods.size() == 1);
+        REQUIRE(readPrimitive.lods.front().count == 3);
+    }
+
+    SECTION("Read only the collision") {
+        const auto collision = BakedModelFile::readCollision(path);
+        REQUIRE(collision.radius == model.collision.radius);
+        REQUIRE(collision.hull == model.collision.hull);
+    }
+
+    SECTION("Reject a truncated file") {
+        writeFileBinary(path, "TEMD", 4);
+        REQUIRE_THROWS(BakedModelFile::read(path));
+        REQUIRE_THROWS(BakedModelFile::readCollision(path));
+        REQUIRE(BakedModelFile::isUpToDate(path, 0x1234u) == false);
+    }
+
+    SECTION("Reject a section that overflows past the end of the file") {
+        // The collision offset follows the magic and the version, the size after it wraps around when added
+        auto data = readFileBinary(path);
+        const auto offset = std::numeric_limits<uint64_t>::max() - 8;
+        std::memcpy(data.data() + 8, &offset, sizeof(offset));
+        writeFileBinary(path, data);
+
+        REQUIRE_THROWS(BakedModelFile::read(path));
+        REQUIRE_THROWS(BakedModelFile::readCollision(path));
+        REQUIRE(BakedModelFile::isUpToDate(path, 0x1234u) == false);
+    }
+
+    SECTION("Compare the source stamp") {
+        REQUIRE(BakedModelFile::isUpToDate(path, 0x1234u) == true);
+        REQUIRE(BakedModelFile::isUpToDate(path, 0x4321u) == false);
+        REQUIRE(BakedModelFile::isUpToDate(dir.value() / "missing.mdl", 0x1234u) == false);
+    }
+
+    SECTION("Reject a file of another version") {
+        auto data = readFileBinary(path);
+        const uint32_t version = BakedModelFile::version - 1;
+        std::memcpy(data.data() + 4, &version, sizeof(version));
+        writeFileBinary(path, data);
+
+        REQUIRE(BakedModelFile::isUpToDate(path, 0x1234u) == false);
+        REQUIRE_THROWS(BakedModelFile::read(path));
+    }
+}
@@ -0,0 +1,127 @@
+#include "../../Common.hpp"
+#include <Engine/Font/GlyphAtlas.hpp>
+
+#define TAG "[GlyphAtlas]"
+
+using namespace Engine;
+
+// Square glyphs for every code point but the missing ones, counting the calls
+class FakeSource : public GlyphAtlas::Source {
+public:
+    bool hasGlyph(const uint32_t code) override {
+        ++tested;
+        return code != missing;
+    }
+
+    FontLoader::Glyph loadGlyph(const uint32_t code) override {
+        ++loaded;
+        const auto width = code == large ? 300 : 60;
+
+        FontLoader::Glyph glyph{};
+        glyph.bitmap.reset(new char[width * width]);
+        std::memset(glyph.bitmap.get(), 0xff, width * width);
+        glyph.bitmapSize = {width, width};
+        glyph.bitmapPitch = width;
+        glyph.advance = static_cast<int>(code) << 6;
+        return glyph;
+    }
+
+    static constexpr uint32_t missing = 0x1000;
+    static constexpr uint32_t large = 0x1001;
+    int tested{0};
+    int loaded{0};
+};
+
+// Two pages of 256x256, each one holds 16 glyphs with the padding
+static const Vector2i regionSize{512, 256};
+
+TEST_CASE("Missing glyph is resolved only once", TAG) {
+    FakeSource source{};
+    GlyphAtlas atlas{source, regionSize, regionSize, {0, 0}, 16};
+    REQUIRE(atlas.getPageSize() == 256);
+    REQUIRE(atlas.getPages().size() == 2);
+
+    const auto glyph = atlas.getGlyph(FakeSource::missing);
+    REQUIRE(glyph.page == 0);
+    REQUIRE(glyph.advance == 0.0f);
+
+    const auto tested = source.tested;
+    const auto loaded = source.loaded;
+    for (auto i = 0; i < 10; i++) {
+        REQUIRE(atlas.getGlyph(FakeSource::missing).page == 0);
+    }
+    REQUIRE(source.tested == tested);
+    REQUIRE(source.loaded == loaded);
+}
+
+TEST_CASE("Glyph too large for a page is cached as unknown", TAG) {
+    FakeSource source{};
+    GlyphAtlas atlas{source, regionSize, regionSize, {0, 0}, 16};
+
+    REQUIRE(atlas.getGlyph(FakeSource::large).page == 0);
+    const auto loaded = source.loaded;
+
+    for (auto i = 0; i < 5; i++) {
+        atlas.nextFrame();
+        REQUIRE(atlas.getGlyph(FakeSource::large).page == 0);
+    }
+    REQUIRE(source.loaded == loaded);
+}
+
+TEST_CASE("Full atlas evicts the least recently used page", TAG) {
+    FakeSource source{};
+    GlyphAtlas atlas{source, regionSize, regionSize, {0, 0}, 16};
+
+    // The first page holds the unknown glyph next to 15 others
+    std::vector<GlyphAtlas::Glyph> glyphs;
+    for (uint32_t code = 0x100; code < 0x100 + 31; code++) {
+        glyphs.push_back(atlas.getGlyph(code));
+        REQUIRE(glyphs.back().page == (code < 0x100 + 15 ? 0 : 1));
+        REQUIRE(glyphs.back().advance == static_cast<float>(code));
+    }
+    REQUIRE(atlas.getGeneration() == 0);
+
+    // Both pages are in use by the current frame, the glyph is unknown until the next frame
+    auto loaded = source.loaded;
+    REQUIRE(atlas.getGlyph(0x200).page == 0);
+    REQUIRE(atlas.getGlyph(0x200).page == 0);
+    REQUIRE(source.loaded == loaded + 1);
+
+    for (auto i = 0; i < 3; i++) {
+        atlas.nextFrame();
+    }
+
+    const auto glyph = atlas.getGlyph(0x200);
+    REQUIRE(glyph.page == 1);
+    REQUIRE(glyph.advance == static_cast<float>(0x200));
+    REQUIRE(atlas.getGeneration() == 1);
+
+    // The copies held by the caller outlive the eviction, the glyphs of the page are rasterized again
+    REQUIRE(glyphs.back().advance == static_cast<float>(0x100 + 30));
+    loaded = source.loaded;
+    REQUIRE(atlas.getGlyph(0x100 + 30).page == 1);
+    REQUIRE(source.loaded == loaded + 1);
+
+    // The first page is never evicted
+    REQUIRE(atlas.getGlyph(0x100).page == 0);
+    REQUIRE(source.loaded == loaded + 1);
+}
+
+TEST_CASE("Touched page is not evicted", TAG) {
+    FakeSource source{};
+    GlyphAtlas atlas{source, {768, 256}, {768, 256}, {0, 0}, 16};
+    REQUIRE(atlas.getPages().size() == 3);
+
+    for (uint32_t code = 0x100; code < 0x100 + 47; code++) {
+        REQUIRE(atlas.getGlyph(code).page == static_cast<int>((code - 0x100 + 1) / 16));
+    }
+
+    // Retained geometry draws from the second page without looking up its glyphs again
+    for (auto i = 0; i < 3; i++) {
+        atlas.nextFrame();
+        atlas.touch(1);
+    }
+
+    REQUIRE(atlas.getGlyph(0x200).page == 2);
+    REQUIRE(atlas.getGeneration() == 1);
+}
@@ -0,0 +1,61 @@
+#include "../../Common.hpp"
+#include <Engine/Graphics/MeshOptimizer.hpp>
+
+using namespace Engine;
+
+struct TestVertex {
+    Vector3 position;
+    Vector2 texCoords;
+};
+
+TEST_CASE("Optimize mesh and generate levels of detail", "[mesh_optimizer]") {
+    static constexpr uint32_t width = 32;
+
+    // A gently curved sheet, so the simplification has something to lose
+    std::vector<TestVertex> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y <= width; y++) {
+        for (uint32_t x = 0; x <= width; x++) {
+            const auto u = static_cast<float>(x) / width;
+            const auto v = static_cast<float>(y) / width;
+            vertices.push_back({{u, v, 0.1f * std::sin(u * 3.0f)}, {u, v}});
+        }
+    }
+    for (uint32_t y = 0; y < width; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            const auto i = y * (width + 1) + x;
+            indices.insert(indices.end(), {i, i + 1, i + width + 1, i + 1, i + width + 2, i + width + 1});
+        }
+    }
+    const auto triangles = indices.size();
+
+    const auto result = optimizeMesh(vertices, indices, MeshOptimizeOptions{});
+
+    REQUIRE(result.vertexCount == vertices.size());
+    REQUIRE(result.vertexCount <= (width + 1) * (width + 1));
+    REQUIRE(result.lods.size() > 1);
+    REQUIRE(result.lods.front().offset == 0);
+    REQUIRE(result.lods.front().count == triangles);
+    REQUIRE(result.lods.front().error == 0.0f);
+    REQUIRE(result.radius == Approx(glm::length(Vector3{1.0f, 1.0f, 0.1f * std::sin(3.0f)})).epsilon(0.1f));
+
+    for (size_t i = 1; i < result.lods.size(); i++) {
+        const auto& lod = result.lods[i];
+        REQUIRE(lod.offset == result.lods[i - 1].offset + result.lods[i - 1].count);
+        REQUIRE(lod.count < result.lods[i - 1].count);
+        REQUIRE(lod.count % 3 == 0);
+    }
+
+    const auto& last = result.lods.back();
+    REQUIRE(indices.size() == last.offset + last.count);
+    for (const auto index : indices) {
+        REQUIRE(index < result.vertexCount);
+    }
+
+    SECTION("Pack the indices as 16-bit") {
+        VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+        const auto packed = packIndices(indices, result.vertexCount, indexType);
+        REQUIRE(indexType == VK_INDEX_TYPE_UINT16);
+        REQUIRE(packed.size() == indices.size() * sizeof(uint16_t));
+    }
+}
@@ -314,6 +314,35 @@ TEST_CASE("Connect to UDP server and disconnect from server", "[Network]") {
     REQUIRE_EVENTUALLY_S(!client->isEstablished(), 5);
 }
 
+TEST_CASE("Connect to UDP server and send a message over the size limit", "[Network]") {
+    Config config{};
+    config.network.clientBindAddress = "::1";
+    config.network.serverBindAddress = "::1";
+
+    TestUdpServer server{config};
+    TestUdpClient client{config};
+    client->connect(server->getEndpoint().address().to_string(), server->getEndpoint().port());
+
+    REQUIRE_EVENTUALLY_S(server.getPeers().size() == 1, 1);
+    REQUIRE_EVENTUALLY_S(client->isEstablished(), 1);
+
+    {
+        // A string declaring 4 GB, only a bit more than the limit is ever sent
+        NetworkStream::Writer writer{*client.operator->(), PacketType::DataReliable};
+        const std::array<char, 5> header{'\xdb', '\xff', '\xff', '\xff', '\xff'};
+        writer.write(header.data(), header.size());
+
+        const std::vector<char> chunk(64 * 1024, 'x');
+        for (size_t total = 0; total <= maxMessageSize; total += chunk.size()) {
+            writer.write(chunk.data(), chunk.size());
+        }
+        writer.flush();
+    }
+
+    REQUIRE_EVENTUALLY_S(server.getPeers().empty(), 30);
+    REQUIRE_EVENTUALLY_S(!client->isEstablished(), 5);
+}
+
 /*TEST_CASE("Start UDP server and wait", "[NetworkUdpServer]") {
     Config config{};
     config.network.serverBindAddress = "192.168.163.1";
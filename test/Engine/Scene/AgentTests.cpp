@@ -0,0 +1,139 @@
+#include "../../Common.hpp"
+#include <Engine/Scene/Controllers/ControllerAgent.hpp>
+#include <Engine/Scene/Scene.hpp>
+
+using namespace Engine;
+
+TEST_CASE("Agent spatial index finds entities within radius", "[Scene]") {
+    AgentSpatialIndex spatial{100.0f};
+    for (auto i = 0; i < 100; i++) {
+        spatial.add(static_cast<EntityId>(i), Vector3{static_cast<float>(i) * 10.0f, 0.0f, -50.0f});
+    }
+    spatial.build();
+
+    std::vector<EntityId> found;
+    spatial.forEachInRadius(Vector3{500.0f, 0.0f, -50.0f}, 25.0f, [&](const AgentObservable& o) {
+        found.push_back(o.entity);
+    });
+    std::sort(found.begin(), found.end());
+
+    REQUIRE(found == std::vector<EntityId>{
+                         static_cast<EntityId>(48),
+                         static_cast<EntityId>(49),
+                         static_cast<EntityId>(50),
+                         static_cast<EntityId>(51),
+                         static_cast<EntityId>(52),
+                     });
+
+    // A radius covering more cells than there are falls back to a linear pass
+    size_t count{0};
+    spatial.forEachInRadius(Vector3{0.0f}, 1e6f, [&](const AgentObservable& o) { ++count; });
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("Agents far from observers are time sliced across ticks", "[Scene]") {
+    Config config{};
+    config.assetsPath = Path{ROOT_DIR} / "assets";
+    config.server.agentThreads = 4;
+    Scene scene{config};
+
+    static constexpr size_t count = 1000;
+    for (size_t i = 0; i < count; i++) {
+        auto entity = scene.createEntity();
+        auto& transform = entity.addComponent<ComponentTransform>();
+        transform.move({static_cast<float>(i) * 100.0f, 0.0f, 0.0f});
+        entity.addComponent<ComponentAgent>();
+    }
+
+    auto& controller = scene.getController<ControllerAgent>();
+
+    // Nobody is watching, every agent runs exactly once per idle interval
+    size_t total{0};
+    for (size_t t = 0; t < ControllerAgent::idleInterval; t++) {
+        controller.update(0.05f);
+        REQUIRE(controller.getScheduledCount() < count);
+        total += controller.getScheduledCount();
+    }
+    REQUIRE(total == count);
+
+    // An observer at the origin puts the closest agents on every tick
+    auto observer = scene.createEntity();
+    observer.addComponent<ComponentTransform>();
+    controller.addObserver(observer.getHandle());
+    controller.update(0.05f);
+    REQUIRE(controller.getScheduledCount() >= 51);
+}
+
+TEST_CASE("Agent priority shifts the update interval of its tier", "[Scene]") {
+    Config config{};
+    config.assetsPath = Path{ROOT_DIR} / "assets";
+    Scene scene{config};
+
+    auto entity = scene.createEntity();
+    entity.addComponent<ComponentTransform>();
+    auto& agent = entity.addComponent<ComponentAgent>();
+    auto& controller = scene.getController<ControllerAgent>();
+
+    const auto countUpdates = [&](const size_t ticks) {
+        size_t total{0};
+        for (size_t t = 0; t < ticks; t++) {
+            controller.update(0.05f);
+            total += controller.getScheduledCount();
+        }
+        return total;
+    };
+
+    REQUIRE(countUpdates(ControllerAgent::idleInterval * 2) == 2);
+
+    agent.setPriority(AgentPriority::High);
+    REQUIRE(countUpdates(ControllerAgent::idleInterval * 2) == 8);
+
+    agent.setPriority(AgentPriority::Low);
+    REQUIRE(countUpdates(ControllerAgent::idleInterval * 2) == 1);
+}
+
+TEST_CASE("Agents make the same decisions regardless of the number of threads", "[Scene]") {
+    static constexpr size_t count = 500;
+
+    const auto simulate = [](const uint64_t threads) {
+        Config config{};
+        config.assetsPath = Path{ROOT_DIR} / "assets";
+        config.server.agentThreads = threads;
+        Scene scene{config};
+
+        std::vector<EntityId> entities;
+        for (size_t i = 0; i < count; i++) {
+            auto entity = scene.createEntity();
+            auto& transform = entity.addComponent<ComponentTransform>();
+            transform.move({static_cast<float>(i % 25) * 400.0f, static_cast<float>(i / 25) * 400.0f, 0.0f});
+            entity.addComponent<ComponentShipControl>();
+            auto& agent = entity.addComponent<ComponentAgent>();
+            if (i % 7 == 0) {
+                agent.setPriority(AgentPriority::High);
+            }
+            entities.push_back(entity.getHandle());
+        }
+
+        auto observer = scene.createEntity();
+        observer.addComponent<ComponentTransform>();
+        auto& controller = scene.getController<ControllerAgent>();
+        controller.addObserver(observer.getHandle());
+
+        // Long enough for every agent to finish its idle time and pick a destination
+        for (size_t t = 0; t < ControllerAgent::idleInterval * 4; t++) {
+            controller.update(1.0f);
+        }
+
+        std::vector<Vector3> targets;
+        for (const auto entity : entities) {
+            const auto& shipControl = scene.getComponent<ComponentShipControl>(entity);
+            REQUIRE(shipControl.getAction() == ShipAutopilotAction::MoveTo);
+            targets.push_back(shipControl.getTargetPos());
+        }
+        return targets;
+    };
+
+    const auto single = simulate(1);
+    const auto parallel = simulate(4);
+    REQUIRE(single == parallel);
+}
@@ -1,4 +1,5 @@
 #include "../../Common.hpp"
+#include <Engine/Scene/EntityIdMap.hpp>
 #include <Engine/Scene/Scene.hpp>
 
 #define TEST_TAG "[entity_tests]"
@@ -88,3 +89,26 @@ TEST_CASE("Adding entity with component to the scene", TEST_TAG) {
     REQUIRE(cameraSystem.size_hint() == true);
     REQUIRE(counter == 0);
 }*/
+
+TEST_CASE("Entity id map finds the inserted ids after growing and erasing", TEST_TAG) {
+    EntityIdMap map{};
+    for (uint32_t i = 0; i < 1000; i++) {
+        map.insert(static_cast<EntityId>(i), static_cast<EntityId>(i + 5000));
+    }
+    REQUIRE(map.size() == 1000);
+
+    for (uint32_t i = 0; i < 1000; i += 2) {
+        map.erase(static_cast<EntityId>(i));
+    }
+    REQUIRE(map.size() == 500);
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        const auto value = map.find(static_cast<EntityId>(i));
+        if (i % 2 == 0) {
+            REQUIRE(value == static_cast<EntityId>(NullEntity));
+        } else {
+            REQUIRE(value == static_cast<EntityId>(i + 5000));
+        }
+    }
+    REQUIRE(map.find(static_cast<EntityId>(123456)) == static_cast<EntityId>(NullEntity));
+}
@@ -0,0 +1,194 @@
+#include "../../Common.hpp"
+#include <Engine/Scene/Controllers/ControllerPathfinding.hpp>
+#include <Engine/Scene/Pathfinding.hpp>
+#include <Engine/Scene/Scene.hpp>
+#include <Engine/Utils/Random.hpp>
+#include <thread>
+
+using namespace Engine;
+
+// A wall across the x axis with a hole around the y and z axes
+class WallTester : public Pathfinding::Tester {
+public:
+    bool contactTestBox(const Vector3i& pos, const int width) override {
+        const auto half = width / 2;
+        if (pos.x - half >= 32 || pos.x + half <= -32) {
+            return false;
+        }
+        const auto inHole = [&](const int c) { return c - half >= -64 && c + half <= 64; };
+        return !(open && inHole(pos.y) && inHole(pos.z));
+    }
+
+    bool open{true};
+};
+
+TEST_CASE("Find path through the hole in a wall", "[Scene]") {
+    WallTester tester{};
+    Pathfinding pathfinding{tester, 6, 32};
+    pathfinding.build();
+
+    REQUIRE(pathfinding.find({0.0f, 500.0f, 0.0f}).has_value() == false);
+    REQUIRE(pathfinding.find({0.0f, 0.0f, 0.0f}).has_value() == true);
+
+    Pathfinding::SearchState state{};
+    const auto path = pathfinding.findPath({-500.0f, 600.0f, 300.0f}, {500.0f, 600.0f, 300.0f}, state);
+    REQUIRE(path.has_value());
+    REQUIRE(path->front() == Vector3{-500.0f, 600.0f, 300.0f});
+    REQUIRE(path->back() == Vector3{500.0f, 600.0f, 300.0f});
+
+    bool throughHole{false};
+    for (const auto& waypoint : *path) {
+        REQUIRE(pathfinding.find(waypoint).has_value());
+        throughHole |= waypoint.x > -32.0f && waypoint.x < 32.0f;
+    }
+    REQUIRE(throughHole);
+
+    // Within the same cells, the route is reused
+    REQUIRE(pathfinding.findPath({-510.0f, 600.0f, 300.0f}, {505.0f, 600.0f, 300.0f}, state).has_value());
+    REQUIRE(pathfinding.getCacheMisses() == 1);
+    REQUIRE(pathfinding.getCacheHits() == 1);
+
+    // Stays on a single side of the wall
+    REQUIRE(pathfinding.findPath({-500.0f, 600.0f, 300.0f}, {-400.0f, -600.0f, -300.0f}, state).has_value());
+    REQUIRE(pathfinding.getCacheMisses() == 2);
+
+    // Only the clusters around the hole are tested again, the route through them is dropped from the cache
+    tester.open = false;
+    pathfinding.invalidate({-10.0f, -10.0f, -10.0f}, {10.0f, 10.0f, 10.0f});
+    REQUIRE(pathfinding.rebuild() == true);
+    REQUIRE(pathfinding.rebuild() == false);
+    REQUIRE(pathfinding.findPath({-500.0f, 600.0f, 300.0f}, {-400.0f, -600.0f, -300.0f}, state).has_value());
+    REQUIRE(pathfinding.getCacheHits() == 2);
+    REQUIRE(pathfinding.getCacheMisses() == 2);
+    REQUIRE(pathfinding.findPath({-500.0f, 600.0f, 300.0f}, {500.0f, 600.0f, 300.0f}, state).has_value() == false);
+
+    // The cells linked again match the ones of the whole volume tested from scratch
+    Pathfinding fresh{tester, 6, 32};
+    fresh.build();
+    REQUIRE(pathfinding.getCellCount() == fresh.getCellCount());
+
+    tester.open = true;
+    pathfinding.invalidate({-10.0f, -10.0f, -10.0f}, {10.0f, 10.0f, 10.0f});
+    REQUIRE(pathfinding.rebuild() == true);
+    REQUIRE(pathfinding.findPath({-500.0f, 600.0f, 300.0f}, {500.0f, 600.0f, 300.0f}, state).has_value());
+}
+
+TEST_CASE("Path requests are searched in the background until the next update", "[Scene]") {
+    Config config{};
+    config.assetsPath = Path{ROOT_DIR} / "assets";
+    Scene scene{config};
+
+    auto entity = scene.createEntity();
+    auto& transform = entity.addComponent<ComponentTransform>();
+    transform.setStatic(true);
+    auto& rigidBody = entity.addComponent<ComponentRigidBody>();
+    rigidBody.setMass(0.0f);
+    rigidBody.setShape(transform, CollisionShape::createSphere(50.0f));
+    scene.getDynamicsWorld().updateAabbs();
+
+    auto& controller = scene.getController<ControllerPathfinding>();
+    controller.buildTree();
+    REQUIRE(controller.getOctree().find({0.0f, 0.0f, 0.0f}).has_value() == false);
+
+    const auto ticket = controller.requestPath({-500.0f, 0.0f, 0.0f}, {500.0f, 0.0f, 0.0f});
+    REQUIRE(controller.getResult(ticket) == nullptr);
+    REQUIRE(controller.isPending(ticket));
+
+    // Started by the first update and collected by the second one, however long the search takes
+    controller.update(0.05f);
+    REQUIRE(controller.isPending(ticket));
+    controller.update(0.05f);
+    REQUIRE(!controller.isPending(ticket));
+    const auto* result = controller.getResult(ticket);
+    REQUIRE(result != nullptr);
+    REQUIRE(result->path.has_value());
+
+    // Kept for a while, so the agents updated only on every few ticks see it
+    for (uint64_t i = 1; i < ControllerPathfinding::resultTicks; i++) {
+        controller.update(0.05f);
+    }
+    REQUIRE(controller.getResult(ticket) != nullptr);
+    controller.update(0.05f);
+    REQUIRE(controller.getResult(ticket) == nullptr);
+    REQUIRE(!controller.isPending(ticket));
+
+    // The space the obstacle left is rebuilt on the next update
+    transform.move({300.0f, 0.0f, 0.0f});
+    scene.setDirty(transform);
+    controller.update(0.05f);
+    REQUIRE(controller.getOctree().find({0.0f, 0.0f, 0.0f}).has_value() == true);
+    REQUIRE(controller.getOctree().find({300.0f, 0.0f, 0.0f}).has_value() == false);
+}
+
+// The obstacles and the patrol routes of the agents both come from the seed
+static std::vector<std::optional<Pathfinding::Path>> findPatrolPaths(const uint64_t seed) {
+    Config config{};
+    config.assetsPath = Path{ROOT_DIR} / "assets";
+    Scene scene{config};
+    Rng rng{seed};
+
+    const auto randomPosition = [&]() {
+        const auto x = randomReal(rng, -800.0f, 800.0f);
+        const auto y = randomReal(rng, -800.0f, 800.0f);
+        const auto z = randomReal(rng, -800.0f, 800.0f);
+        return Vector3{x, y, z};
+    };
+
+    for (auto i = 0; i < 8; i++) {
+        auto entity = scene.createEntity();
+        auto& transform = entity.addComponent<ComponentTransform>();
+        transform.move(randomPosition());
+        transform.setStatic(true);
+        auto& rigidBody = entity.addComponent<ComponentRigidBody>();
+        rigidBody.setMass(0.0f);
+        rigidBody.setShape(transform, CollisionShape::createSphere(randomReal(rng, 20.0f, 100.0f)));
+    }
+    scene.getDynamicsWorld().updateAabbs();
+
+    auto& controller = scene.getController<ControllerPathfinding>();
+    controller.buildTree();
+
+    std::vector<std::pair<Vector3, Vector3>> routes;
+    for (auto i = 0; i < 64; i++) {
+        routes.emplace_back(randomPosition(), randomPosition());
+    }
+
+    // Requested from several threads like the agents do, the order of the tickets differs between the runs
+    std::vector<ControllerPathfinding::Ticket> tickets;
+    tickets.resize(routes.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (auto i = t; i < routes.size(); i += 4) {
+                tickets[i] = controller.requestPath(routes[i].first, routes[i].second);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    controller.update(0.05f);
+    controller.update(0.05f);
+
+    std::vector<std::optional<Pathfinding::Path>> paths;
+    for (const auto ticket : tickets) {
+        const auto* result = controller.getResult(ticket);
+        REQUIRE(result != nullptr);
+        paths.push_back(result->path);
+    }
+    return paths;
+}
+
+TEST_CASE("Path requests give the same paths on the same ticks for the same seed", "[Scene]") {
+    const auto first = findPatrolPaths(123456789ULL);
+    const auto second = findPatrolPaths(123456789ULL);
+
+    REQUIRE(first.size() == second.size());
+    for (size_t i = 0; i < first.size(); i++) {
+        REQUIRE(first[i].has_value() == second[i].has_value());
+        if (first[i]) {
+            REQUIRE(*first[i] == *second[i]);
+        }
+    }
+}
@@ -1,6 +1,11 @@
 #include "../../Common.hpp"
+#include <Engine/Assets/VoxelShapeCache.hpp>
+#include <Engine/Scene/Controllers/ControllerBullets.hpp>
+#include <Engine/Scene/Controllers/ControllerCheckpoint.hpp>
 #include <Engine/Scene/Controllers/ControllerPathfinding.hpp>
+#include <Engine/Scene/Controllers/ControllerTransform.hpp>
 #include <Engine/Scene/Scene.hpp>
+#include <iostream>
 
 using namespace Engine;
 
@@ -51,29 +56,224 @@ TEST_CASE_METHOD(SceneFixture, "Check if box overlaps with dynamics world", "[Sc
     }
 }
 
-/*TEST_CASE_METHOD(SceneFixture, "Build pathfinding tree and find node", "[Scene]") {
-    auto sphere = CollisionShape::createSphere(1.0f);
+TEST_CASE_METHOD(SceneFixture, "Checkpoint restores changed and removed entities", "[Scene]") {
+    const auto populate = [](Scene& s) {
+        for (auto i = 0; i < 3; i++) {
+            auto entity = s.createEntity();
+            auto& transform = entity.addComponent<ComponentTransform>();
+            transform.move({static_cast<float>(i), 0.0f, 0.0f});
+        }
+    };
 
-    for (auto z = -128; z <= 128; z += 32) {
-        auto entity = scene->createEntity();
-        auto& transform = entity.addComponent<ComponentTransform>();
-        transform.move({5.0f, 5.0f, static_cast<float>(z) + 16.0f});
-        transform.setStatic(true);
+    populate(*scene);
+    auto& controller = scene->addController<ControllerCheckpoint>();
+    controller.reset();
 
-        auto& rigidBody = entity.addComponent<ComponentRigidBody>();
-        rigidBody.setMass(0.0f);
-        rigidBody.setScale(1.0f);
-        rigidBody.setShape(sphere);
+    auto moved = scene->fromHandle(static_cast<EntityId>(1));
+    auto& transform = moved.getComponent<ComponentTransform>();
+    transform.move({10.0f, 20.0f, 30.0f});
+    scene->setDirty(transform);
+    const auto expected = transform.getPosition();
+
+    auto removed = scene->fromHandle(static_cast<EntityId>(2));
+    scene->removeEntity(removed);
+
+    REQUIRE(controller.getChangedCount() == 2);
+    const auto snapshot = controller.takeSnapshot();
+    REQUIRE(controller.getChangedCount() == 0);
+    REQUIRE(snapshot.entities.size() == 1);
+    REQUIRE(snapshot.removed.size() == 1);
+
+    // Restore into a freshly populated scene, the same way a sector is loaded
+    Scene other{config};
+    populate(other);
+    auto& otherController = other.addController<ControllerCheckpoint>();
+    for (const auto handle : snapshot.removed) {
+        otherController.restoreRemoved(handle);
+    }
+    for (const auto& entity : snapshot.entities) {
+        const auto sbuf = entity.pack();
+        const auto oh = msgpack::unpack(sbuf.data(), sbuf.size());
+        otherController.restore(entity.handle, oh.get());
     }
+    otherController.restoreFinish();
 
-    auto& dynamicsWorld = scene->getController<ControllerDynamicsWorld>();
-    dynamicsWorld.updateAabbs();
+    REQUIRE(other.isValid(static_cast<EntityId>(0)));
+    REQUIRE(other.isValid(static_cast<EntityId>(2)) == false);
+    const auto restored = other.fromHandle(static_cast<EntityId>(1));
+    REQUIRE(restored.getComponent<ComponentTransform>().getPosition() == expected);
+}
+
+TEST_CASE_METHOD(SceneFixture, "Cached absolute transforms follow the parent", "[Scene]") {
+    auto ship = scene->createEntity();
+    auto& shipTransform = ship.addComponent<ComponentTransform>();
+    shipTransform.move({10.0f, 0.0f, 0.0f});
+
+    auto turret = scene->createEntity();
+    auto& turretTransform = turret.addComponent<ComponentTransform>();
+    turretTransform.setParent(&shipTransform);
+    turretTransform.move({0.0f, 2.0f, 0.0f});
+
+    auto& controller = scene->getController<ControllerTransform>();
+    controller.updateWorld();
+    REQUIRE(controller.getUpdatedCount() == 2);
+    REQUIRE(turretTransform.getAbsolutePosition() == Vector3{10.0f, 2.0f, 0.0f});
+
+    // Nothing changed, nothing is recomputed
+    controller.updateWorld();
+    REQUIRE(controller.getUpdatedCount() == 0);
+
+    // Moving the parent is visible before the next update, and the update recomputes the whole subtree
+    shipTransform.move({20.0f, 0.0f, 0.0f});
+    REQUIRE(turretTransform.getAbsolutePosition() == Vector3{20.0f, 2.0f, 0.0f});
+    controller.updateWorld();
+    REQUIRE(controller.getUpdatedCount() == 2);
+    REQUIRE(turretTransform.getAbsolutePosition() == Vector3{20.0f, 2.0f, 0.0f});
+}
+
+TEST_CASE_METHOD(SceneFixture, "Bullets are replayed from the fire and hit events", "[Scene]") {
+    auto target = scene->createEntity();
+    auto& transform = target.addComponent<ComponentTransform>();
+    transform.move({0.0f, 0.0f, -100.0f});
+    transform.setStatic(true);
+    auto& rigidBody = target.addComponent<ComponentRigidBody>();
+    rigidBody.setMass(0.0f);
+    rigidBody.setShape(transform, CollisionShape::createSphere(10.0f));
+    scene->getDynamicsWorld().updateAabbs();
+
+    // The client scene has the shape cache, nothing to hit there, the bullets only disappear with the hit events
+    VoxelShapeCache voxelShapeCache{config};
+    Scene other{config, &voxelShapeCache};
+
+    auto& server = scene->getController<ControllerBullets>();
+    auto& client = other.getController<ControllerBullets>();
+    REQUIRE(server.isAuthoritative());
+    REQUIRE(!client.isAuthoritative());
+
+    const auto replay = [&]() {
+        if (server.hasEvents()) {
+            msgpack::sbuffer sbuf;
+            msgpack::pack(sbuf, server.getEvents());
+            const auto oh = msgpack::unpack(sbuf.data(), sbuf.size());
+            client.receiveEvents(oh.get().as<MessageSceneBulletsEvent>());
+        }
+        server.resetEvents();
+    };
+
+    const auto hit = server.fire(NullEntity, Vector3{0.0f}, Vector3{0.0f, 0.0f, -1.0f}, 500.0f, 10.0f, 1.0f);
+    const auto miss = server.fire(NullEntity, Vector3{0.0f}, Vector3{0.0f, 0.0f, 1.0f}, 500.0f, 10.0f, 1.0f);
+    REQUIRE(server.getEvents().fired.size() == 2);
+    replay();
+
+    for (auto tick = 0; tick < 3; tick++) {
+        server.update(0.05f);
+        client.update(0.05f);
+        replay();
+
+        // Both sides integrate the same way
+        REQUIRE(client.findBullet(hit)->origin == server.findBullet(hit)->origin);
+        REQUIRE(client.findBullet(miss)->origin == server.findBullet(miss)->origin);
+    }
+
+    for (auto tick = 0; tick < 10 && server.findBullet(hit); tick++) {
+        server.update(0.05f);
+        client.update(0.05f);
+        replay();
+    }
 
-    auto& pathfinding = scene->getController<ControllerPathfinding>();
-    pathfinding.buildTree();
+    REQUIRE(server.findBullet(hit) == nullptr);
+    REQUIRE(client.findBullet(hit) == nullptr);
+    REQUIRE(client.findBullet(miss) != nullptr);
+}
 
-    REQUIRE(pathfinding.getOctree().find({5.0f, 5.0f, -128.0f + 16.0f}).has_value() == true);
-    REQUIRE(pathfinding.getOctree().find({5.0f, 64.0f, -128.0f + 16.0f}).has_value() == false);
+TEST_CASE_METHOD(SceneFixture, "Strategic simulation catches up with the physics when switched back", "[Scene]") {
+    auto entity = scene->createEntity();
+    auto& transform = entity.addComponent<ComponentTransform>();
+    transform.setStatic(true);
+    auto& rigidBody = entity.addComponent<ComponentRigidBody>();
+    rigidBody.setMass(0.0f);
+    rigidBody.setShape(transform, CollisionShape::createSphere(1.0f));
+    scene->getDynamicsWorld().updateAabbs();
 
-    REQUIRE(pathfinding.getOctree().findPath({-40.0f, 5.0f, 5.0f}, {40.0f, 5.0f, 5.0f}) == true);
-}*/
+    scene->setSimulationMode(Scene::SimulationMode::Strategic);
+    transform.move({50.0f, 0.0f, 0.0f});
+    scene->update(0.5f);
+    REQUIRE(transform.getPosition() == Vector3{50.0f, 0.0f, 0.0f});
+
+    scene->setSimulationMode(Scene::SimulationMode::Full);
+    auto& dynamicsWorld = scene->getDynamicsWorld();
+    REQUIRE(dynamicsWorld.contactTestSphere({50.0f, 0.0f, 0.0f}, 1.0f, CollisionGroup::Static) == true);
+    REQUIRE(dynamicsWorld.contactTestSphere({0.0f, 0.0f, 0.0f}, 1.0f, CollisionGroup::Static) == false);
+}
+
+TEST_CASE_METHOD(SceneFixture, "Strategic mode keeps the broadphase up to date", "[Scene]") {
+    auto entity = scene->createEntity();
+    auto& transform = entity.addComponent<ComponentTransform>();
+    auto& rigidBody = entity.addComponent<ComponentRigidBody>();
+    rigidBody.setMass(1.0f);
+    rigidBody.setShape(transform, CollisionShape::createSphere(10.0f));
+    scene->getDynamicsWorld().updateAabbs();
+    REQUIRE(scene->contactTestSphere(Vector3{0.0f}, 1.0f));
+
+    // Moved without the physics step, only the refreshed bounding box lets the broadphase find it
+    scene->setSimulationMode(Scene::SimulationMode::Strategic);
+    transform.move({500.0f, 0.0f, 0.0f});
+    scene->update(0.05f);
+
+    REQUIRE(scene->contactTestSphere(Vector3{500.0f, 0.0f, 0.0f}, 1.0f));
+    REQUIRE(!scene->contactTestSphere(Vector3{0.0f}, 1.0f));
+}
+
+TEST_CASE_METHOD(SceneFixture, "Benchmark absolute transforms of a 50k entity hierarchy", "[.benchmark][Scene]") {
+    static constexpr size_t ships = 10000;
+    static constexpr size_t turrets = 4;
+    static constexpr size_t frames = 100;
+
+    std::vector<ComponentTransform*> roots;
+    std::vector<ComponentTransform*> all;
+    for (size_t i = 0; i < ships; i++) {
+        auto ship = scene->createEntity();
+        auto& shipTransform = ship.addComponent<ComponentTransform>();
+        shipTransform.move({static_cast<float>(i), 0.0f, 0.0f});
+        roots.push_back(&shipTransform);
+        all.push_back(&shipTransform);
+
+        for (size_t t = 0; t < turrets; t++) {
+            auto turret = scene->createEntity();
+            auto& turretTransform = turret.addComponent<ComponentTransform>();
+            turretTransform.setParent(&shipTransform);
+            turretTransform.move({0.0f, static_cast<float>(t), 0.0f});
+            all.push_back(&turretTransform);
+        }
+    }
+
+    auto& controller = scene->getController<ControllerTransform>();
+    controller.updateWorld();
+
+    const auto measure = [&](const char* name, const bool cached) {
+        float sum{0.0f};
+        const auto t0 = std::chrono::steady_clock::now();
+        for (size_t f = 0; f < frames; f++) {
+            // One in ten ships moves every frame
+            for (size_t i = f % 10; i < roots.size(); i += 10) {
+                roots[i]->translate({0.0f, 0.0f, 1.0f});
+            }
+            if (cached) {
+                controller.updateWorld();
+            }
+            // Every entity is read three times, as the render passes, turrets, and networking do
+            for (auto pass = 0; pass < 3; pass++) {
+                for (const auto* transform : all) {
+                    sum += transform->getAbsolutePosition().z;
+                }
+            }
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        std::cout << name << ": " << us / 1000 << "ms (" << static_cast<double>(us) / frames << "us per frame, "
+                  << sum << ")" << std::endl;
+    };
+
+    measure("without world pass", false);
+    measure("with world pass", true);
+}
@@ -0,0 +1,35 @@
+#include "../../Common.hpp"
+#include <Engine/Scene/SnapshotBuffer.hpp>
+
+using namespace Engine;
+
+TEST_CASE("Snapshot buffer interpolates and extrapolates the received transforms", "[Scene]") {
+    SnapshotBuffer buffer{};
+    const auto entity = static_cast<EntityId>(1);
+
+    // Sent every 100ms, every other update arrives 30ms late
+    for (auto i = 0; i <= 20; i++) {
+        const auto serverTime = i * 0.1;
+        buffer.receive(serverTime, serverTime + (i % 2 == 1 ? 0.03 : 0.0));
+        buffer.push(entity, serverTime, glm::translate(Vector3{i * 10.0f, 0.0f, 0.0f}));
+    }
+
+    REQUIRE(buffer.getInterval() == Approx(0.1f).margin(0.001f));
+    REQUIRE(buffer.getJitter() > 0.0f);
+    REQUIRE(buffer.getDelay() > SnapshotBuffer::Options{}.minDelay);
+    REQUIRE(buffer.getPlayoutTime(2.0) == Approx(2.0 - buffer.getDelay()));
+
+    // Only the last few samples are kept
+    REQUIRE(buffer.sample(entity, 1.55).value()[3].x == Approx(155.0f));
+    REQUIRE(buffer.sample(entity, 2.1).value()[3].x == Approx(210.0f));
+    REQUIRE(buffer.sample(entity, 5.0).value()[3].x == Approx(225.0f));
+    REQUIRE(buffer.sample(entity, 0.0).value()[3].x == Approx(130.0f));
+
+    // Teleported, not swept across the space
+    buffer.push(entity, 2.1, glm::translate(Vector3{1.0e6f, 0.0f, 0.0f}));
+    REQUIRE(buffer.sample(entity, 2.05).value()[3].x == Approx(200.0f));
+    REQUIRE(buffer.sample(entity, 2.1).value()[3].x == Approx(1.0e6f));
+
+    buffer.remove(entity);
+    REQUIRE_FALSE(buffer.sample(entity, 2.1).has_value());
+}
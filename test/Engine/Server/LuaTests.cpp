@@ -0,0 +1,97 @@
+#include "../../Common.hpp"
+#include <Engine/Scene/Scene.hpp>
+#include <Engine/Server/LuaPool.hpp>
+#include <iostream>
+#include <sol/sol.hpp>
+
+#define TAG "[Lua]"
+
+using namespace Engine;
+
+static void writeModule(const Path& path, const std::string& source) {
+    writeFileBinary(path, source.data(), source.size());
+}
+
+TEST_CASE("Lua modules are compiled once and shared across states", TAG) {
+    auto tmpDir = std::make_shared<TmpDir>();
+    Config config{};
+    config.assetsPath = tmpDir->value();
+    EventBus eventBus{};
+
+    Fs::create_directories(tmpDir->value() / "test");
+    writeModule(tmpDir->value() / "test" / "module.lua", "globals.value = 42\nreturn { name = 'first' }\n");
+
+    Lua::clearChunkCache();
+    const auto before = Lua::getChunkCacheStats();
+
+    Lua first{config, eventBus};
+    first.require("test.module", [](sol::table& table) { REQUIRE(table["name"].get<std::string>() == "first"); });
+    REQUIRE(first.getState()["globals"]["value"].get<int>() == 42);
+
+    Lua second{config, eventBus};
+    second.require("test.module");
+    REQUIRE(second.getState()["globals"]["value"].get<int>() == 42);
+
+    auto stats = Lua::getChunkCacheStats();
+    REQUIRE(stats.misses - before.misses == 1);
+    REQUIRE(stats.hits - before.hits == 1);
+
+    // A changed source has a different hash, so it is compiled again
+    writeModule(tmpDir->value() / "test" / "module.lua", "return { name = 'second' }\n");
+    Lua third{config, eventBus};
+    third.require("test.module", [](sol::table& table) { REQUIRE(table["name"].get<std::string>() == "second"); });
+    REQUIRE(Lua::getChunkCacheStats().misses - before.misses == 2);
+
+    // Syntax errors are still reported by require()
+    writeModule(tmpDir->value() / "test" / "broken.lua", "return {\n");
+    REQUIRE_THROWS(third.require("test.broken"));
+}
+
+TEST_CASE("Benchmark sector lua startup", "[.benchmark]") {
+    Config config{};
+    config.assetsPath = Path{ROOT_DIR} / "assets";
+    EventBus eventBus{};
+
+    static constexpr size_t iterations = 20;
+
+    const auto startSector = [&](std::unique_ptr<Lua> lua) {
+        Scene scene{config, nullptr, lua.get()};
+        lua->setScene(scene);
+        lua->require("base.sector");
+    };
+
+    // Fresh state and parsing of all sources, how every sector used to start
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        Lua::clearChunkCache();
+        startSector(std::make_unique<Lua>(config, eventBus));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    const auto cold = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / iterations;
+
+    // Fresh state, the chunks come from the cache
+    t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        startSector(std::make_unique<Lua>(config, eventBus));
+    }
+    t1 = std::chrono::steady_clock::now();
+    const auto cached = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / iterations;
+
+    // State taken from the pool, the pool is given time to refill as it would between sector starts
+    LuaPool pool{config, eventBus, 2, {"base.sector"}};
+    std::chrono::microseconds pooledTotal{0};
+    for (size_t i = 0; i < iterations; i++) {
+        while (pool.getReadyCount() < 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        t0 = std::chrono::steady_clock::now();
+        startSector(pool.acquire());
+        t1 = std::chrono::steady_clock::now();
+        pooledTotal += std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+    }
+    const auto pooled = pooledTotal.count() / iterations;
+
+    std::cout << "Sector lua startup cold: " << cold << "us cached: " << cached << "us pooled: " << pooled << "us"
+              << std::endl;
+}
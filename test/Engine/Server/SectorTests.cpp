@@ -0,0 +1,276 @@
+#include "../../Common.hpp"
+#include "../../Fixtures/ClientServerFixture.hpp"
+#include <Engine/Server/LuaPool.hpp>
+#include <Engine/Server/Sector.hpp>
+#include <Engine/Server/Server.hpp>
+
+#define TAG "[Sector]"
+
+using namespace Engine;
+
+// Records the delta of every scene update
+class ControllerDeltaRecorder : public Controller {
+public:
+    explicit ControllerDeltaRecorder(Scene& scene, entt::registry& reg) {
+        (void)scene;
+        (void)reg;
+    }
+
+    void update(const float delta) override {
+        deltas.push_back(delta);
+    }
+
+    void recalculate(VulkanRenderer& vulkan) override {
+        (void)vulkan;
+    }
+
+    std::vector<float> deltas;
+};
+
+class SectorFixture : public ClientServerFixture {
+public:
+    SectorFixture() {
+        startServer();
+
+        sectors = server->getDatabase().seekAll<SectorData>("", 3);
+        REQUIRE(sectors.size() == 3);
+        sectorData = sectors.front();
+        luaPool = std::make_unique<LuaPool>(config, server->getEventBus(), 1);
+    }
+
+    std::unique_ptr<Sector> createSector() {
+        return createSector(sectorData);
+    }
+
+    std::unique_ptr<Sector> createSector(const SectorData& data) {
+        return std::make_unique<Sector>(config,
+                                        server->getDatabase(),
+                                        *assetsManager,
+                                        server->getEventBus(),
+                                        *luaPool,
+                                        data.galaxyId,
+                                        data.systemId,
+                                        data.id);
+    }
+
+    std::string getEntityKey(const EntityId handle) const {
+        return fmt::format(
+            "{}/{}/{}/{:010}", sectorData.galaxyId, sectorData.systemId, sectorData.id, static_cast<uint32_t>(handle));
+    }
+
+    // The player entity template looks up the player in the database
+    SessionPtr createSession() {
+        PlayerData player{};
+        player.id = "test_player";
+        player.secret = 1;
+        player.name = "Test Player";
+        player.admin = false;
+        server->getDatabase().put<PlayerData>(player.id, player);
+        return std::make_shared<Session>(player.id, nullptr);
+    }
+
+    EntityId createAsteroid(Scene& scene, const Vector3& pos, const Vector3& velocity) {
+        auto entity = scene.createEntity();
+        auto& transform = entity.addComponent<ComponentTransform>();
+        transform.move(pos);
+        auto& rigidBody = entity.addComponent<ComponentRigidBody>();
+        rigidBody.setMass(10.0f);
+        entity.addComponent<ComponentModel>(assetsManager->getModels().find("model_asteroid_01_a"));
+        rigidBody.setLinearVelocity(velocity);
+        return entity.getHandle();
+    }
+
+    std::vector<SectorData> sectors;
+    SectorData sectorData;
+    std::unique_ptr<LuaPool> luaPool;
+};
+
+TEST_CASE_METHOD(SectorFixture, "Sector restores rigid bodies from its checkpoint", TAG) {
+    EntityId moving;
+    EntityId removed;
+
+    // The destructor of a loaded sector writes the last checkpoint
+    {
+        auto sector = createSector();
+        sector->load();
+        auto& scene = *sector->getScene();
+        moving = createAsteroid(scene, {100.0f, 20.0f, -50.0f}, {0.0f, 0.0f, 5.0f});
+        removed = createAsteroid(scene, {-100.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+    }
+
+    {
+        auto sector = createSector();
+        sector->load();
+        auto& scene = *sector->getScene();
+
+        REQUIRE(scene.isValid(moving));
+        const auto& transform = scene.getComponent<ComponentTransform>(moving);
+        REQUIRE(transform.getPosition().x == Approx(100.0f));
+        REQUIRE(transform.getPosition().y == Approx(20.0f));
+        REQUIRE(transform.getPosition().z == Approx(-50.0f));
+
+        const auto& rigidBody = scene.getComponent<ComponentRigidBody>(moving);
+        REQUIRE(rigidBody.getRigidBody() != nullptr);
+        REQUIRE(rigidBody.getLinearVelocity().z == Approx(5.0f));
+        REQUIRE(rigidBody.getBtTransform().getOrigin().x() == Approx(100.0f));
+
+        REQUIRE(scene.isValid(removed));
+        auto entity = scene.fromHandle(removed);
+        scene.removeEntity(entity);
+    }
+
+    // The entity is not in the template, its tombstone is removed by the next restore
+    auto tombstone = server->getDatabase().find<SectorEntityData>(getEntityKey(removed));
+    REQUIRE(tombstone.has_value());
+    REQUIRE(tombstone->removed);
+
+    {
+        auto sector = createSector();
+        sector->load();
+        REQUIRE(sector->getScene()->isValid(moving));
+        REQUIRE(!sector->getScene()->isValid(removed));
+    }
+
+    tombstone = server->getDatabase().find<SectorEntityData>(getEntityKey(removed));
+    REQUIRE(!tombstone.has_value());
+}
+
+TEST_CASE_METHOD(SectorFixture, "Sector hibernates into its checkpoint and wakes up", TAG) {
+    auto sector = createSector();
+    sector->load();
+    const auto asteroid = createAsteroid(*sector->getScene(), {100.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+    sector->update();
+    REQUIRE(sector->getMemoryUsage() > 0);
+
+    // Only a hibernated sector can be woken up
+    REQUIRE(sector->wake() == false);
+
+    REQUIRE(sector->beginHibernate());
+    REQUIRE(!sector->isLoaded());
+    REQUIRE(sector->isHibernated());
+    sector->hibernate();
+    REQUIRE(sector->getScene() == nullptr);
+    REQUIRE(sector->getMemoryUsage() == 0);
+
+    REQUIRE(sector->wake());
+    REQUIRE(sector->isLoaded());
+    REQUIRE(sector->getScene()->isValid(asteroid));
+    REQUIRE(sector->getMemoryUsage() > 0);
+}
+
+TEST_CASE_METHOD(SectorFixture, "Sector stopped for hibernation saves its checkpoint when destroyed", TAG) {
+    EntityId asteroid;
+
+    // The server stopped before the hibernation posted to the load queue has run
+    {
+        auto sector = createSector();
+        sector->load();
+        asteroid = createAsteroid(*sector->getScene(), {100.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+        REQUIRE(sector->beginHibernate());
+    }
+
+    auto sector = createSector();
+    sector->load();
+    REQUIRE(sector->getScene()->isValid(asteroid));
+}
+
+TEST_CASE_METHOD(SectorFixture, "Joining player keeps the sector awake", TAG) {
+    auto sector = createSector();
+    sector->load();
+
+    // Posted to the sector worker, the player is not in the sector until the next update
+    const auto session = createSession();
+    sector->addPlayer(session);
+    REQUIRE(!sector->isEmpty());
+    REQUIRE(sector->beginHibernate() == false);
+    REQUIRE(sector->isLoaded());
+
+    sector->update();
+    REQUIRE(!sector->isEmpty());
+    REQUIRE(sector->beginHibernate() == false);
+
+    sector->removePlayer(session);
+    sector->update();
+    REQUIRE(sector->isEmpty());
+    REQUIRE(sector->beginHibernate());
+    sector->hibernate();
+
+    // A player joining the hibernated sector waits in the worker until it is woken up
+    sector->addPlayer(session);
+    REQUIRE(!sector->isEmpty());
+    REQUIRE(sector->wake());
+    sector->update();
+    REQUIRE(!sector->isEmpty());
+}
+
+TEST_CASE_METHOD(SectorFixture, "Least recently used sectors are hibernated over the memory budget", TAG) {
+    std::vector<SectorPtr> idle;
+    size_t total{0};
+    for (const auto& data : sectors) {
+        SectorPtr sector = createSector(data);
+        sector->load();
+        total += sector->getMemoryUsage();
+        idle.push_back(sector);
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto grace = std::chrono::seconds{60};
+
+    // Within the budget and the grace period, nothing to do
+    auto memory = total;
+    REQUIRE(Server::beginHibernations(idle, memory, total, grace, now).empty());
+    REQUIRE(memory == total);
+
+    // A single byte over the budget evicts the sector loaded first, given in any order
+    std::reverse(idle.begin(), idle.end());
+    const auto stopped = Server::beginHibernations(idle, memory, total - 1, grace, now);
+    REQUIRE(stopped.size() == 1);
+    REQUIRE(stopped.front() == idle.back());
+    REQUIRE(stopped.front()->isHibernated());
+    REQUIRE(memory == total - stopped.front()->getMemoryUsage());
+    stopped.front()->hibernate();
+
+    // Past the grace period all the remaining ones go, regardless of the budget
+    idle.pop_back();
+    const auto expired = Server::beginHibernations(idle, memory, 0, grace, now + grace + std::chrono::seconds{1});
+    REQUIRE(expired.size() == 2);
+    for (const auto& sector : expired) {
+        sector->hibernate();
+    }
+}
+
+TEST_CASE_METHOD(SectorFixture, "Sector without players runs at the reduced rate", TAG) {
+    config.server.sectorBackgroundTicks = 10;
+    const auto tick = static_cast<float>(config.tickLengthUs.count()) / 1000000.0f;
+
+    auto sector = createSector();
+    sector->load();
+    auto& scene = *sector->getScene();
+    auto& recorder = scene.addController<ControllerDeltaRecorder>();
+
+    // The scene gets the time of the skipped ticks at once
+    for (auto i = 0; i < 25; i++) {
+        sector->update();
+    }
+    REQUIRE(sector->isBackground());
+    REQUIRE(scene.getSimulationMode() == Scene::SimulationMode::Strategic);
+    REQUIRE(recorder.deltas.size() == 2);
+    REQUIRE(recorder.deltas[0] == Approx(tick * 10.0f));
+    REQUIRE(recorder.deltas[1] == Approx(tick * 10.0f));
+
+    // A joining player switches to the full rate, the five skipped ticks and the current one are run one by one
+    recorder.deltas.clear();
+    sector->addPlayer(createSession());
+    sector->update();
+    REQUIRE(!sector->isBackground());
+    REQUIRE(scene.getSimulationMode() == Scene::SimulationMode::Full);
+    REQUIRE(recorder.deltas.size() == 6);
+    for (const auto delta : recorder.deltas) {
+        REQUIRE(delta == Approx(tick));
+    }
+
+    recorder.deltas.clear();
+    sector->update();
+    REQUIRE(recorder.deltas.size() == 1);
+}
@@ -0,0 +1,68 @@
+#include "../../Common.hpp"
+#include <Engine/Stream/MsgpackReader.hpp>
+#include <msgpack.hpp>
+
+using namespace Engine;
+
+TEST_CASE("Msgpack reader reads values in the packed order", "[Stream]") {
+    msgpack::sbuffer sbuf;
+    msgpack::packer<msgpack::sbuffer> packer{sbuf};
+    packer.pack_array(5);
+    packer.pack_uint64(std::numeric_limits<uint64_t>::max());
+    packer.pack(-42);
+    packer.pack(1.5);
+    packer.pack(std::map<std::string, std::vector<int>>{{"a", {1, 2, 3}}, {"b", {}}});
+    packer.pack(std::string(300, 'x'));
+
+    MsgpackReader reader{sbuf.data(), sbuf.size()};
+    REQUIRE(reader.readArray() == 5);
+    REQUIRE(reader.readUint() == std::numeric_limits<uint64_t>::max());
+    REQUIRE(reader.readInt() == -42);
+    REQUIRE(reader.readDouble() == Approx(1.5));
+
+    const auto raw = reader.readRaw();
+    const auto map = msgpack::unpack(raw.data(), raw.size())->as<std::map<std::string, std::vector<int>>>();
+    REQUIRE(map.at("a") == std::vector<int>{1, 2, 3});
+
+    reader.skip();
+    REQUIRE(reader.isEnd());
+    REQUIRE_THROWS(reader.readUint());
+}
+
+TEST_CASE("Msgpack reader finds where the split objects end", "[Stream]") {
+    msgpack::sbuffer sbuf;
+    msgpack::packer<msgpack::sbuffer> packer{sbuf};
+    packer.pack(std::vector<std::string>{"first", std::string(1000, 'y')});
+    const auto first = sbuf.size();
+    packer.pack(std::make_tuple(1, 2.0f, msgpack::type::nil_t{}, true));
+
+    REQUIRE(MsgpackReader::getObjectSize(sbuf.data(), sbuf.size()) == first);
+    REQUIRE(MsgpackReader::getObjectSize(sbuf.data() + first, sbuf.size() - first) == sbuf.size() - first);
+
+    // Every cut before the end of the object must report it as incomplete
+    for (size_t i = 0; i < first; i++) {
+        REQUIRE(MsgpackReader::getObjectSize(sbuf.data(), i) == 0);
+    }
+}
+
+TEST_CASE("Msgpack size parser continues the split objects where it stopped", "[Stream]") {
+    msgpack::sbuffer sbuf;
+    msgpack::packer<msgpack::sbuffer> packer{sbuf};
+    packer.pack(std::map<std::string, std::vector<int>>{{"a", {1, 2, 300000}}, {std::string(40, 'k'), {}}});
+    const auto first = sbuf.size();
+    packer.pack(std::vector<std::string>{"first", std::string(1000, 'y')});
+
+    // Fed one byte at a time, the same way a message arrives split across packets
+    MsgpackSizeParser parser{};
+    for (size_t i = 1; i < first; i++) {
+        REQUIRE(parser.parse(sbuf.data(), i) == 0);
+    }
+    REQUIRE(parser.parse(sbuf.data(), first) == first);
+
+    // Starts over once the value is complete, the declared length of the string is known before its bytes
+    REQUIRE(parser.parse(sbuf.data() + first, 20) == 0);
+    REQUIRE(parser.getRequired() == sbuf.size() - first);
+    REQUIRE(parser.parse(sbuf.data() + first, sbuf.size() - first - 1) == 0);
+    REQUIRE(parser.parse(sbuf.data() + first, sbuf.size() - first) == sbuf.size() - first);
+    REQUIRE(parser.getRequired() == 0);
+}
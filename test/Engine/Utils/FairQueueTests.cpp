@@ -0,0 +1,63 @@
+#include "../../Common.hpp"
+#include <Engine/Utils/FairQueue.hpp>
+
+using namespace Engine;
+
+using Queue = FairQueue<int>;
+
+TEST_CASE("Drain fair queue in round robin order within the budget", "[FairQueue]") {
+    Queue queue{{64, 4}};
+    std::vector<int> ran;
+
+    // The first key floods the queue, the second one sends a single task
+    for (auto i = 0; i < 10; i++) {
+        REQUIRE(queue.push(1, 0, 1, [&ran]() { ran.push_back(1); }) == Queue::Result::Queued);
+    }
+    REQUIRE(queue.push(2, 0, 1, [&ran]() { ran.push_back(2); }) == Queue::Result::Queued);
+    REQUIRE(queue.size() == 11);
+
+    REQUIRE(queue.drain() == 5);
+    REQUIRE(ran == std::vector<int>{1, 2, 1, 1, 1});
+    REQUIRE(queue.size() == 6);
+
+    ran.clear();
+    REQUIRE(queue.drain() == 4);
+    REQUIRE(queue.drain() == 2);
+    REQUIRE(queue.drain() == 0);
+    REQUIRE(queue.size() == 0);
+}
+
+TEST_CASE("Expensive task in fair queue runs alone", "[FairQueue]") {
+    Queue queue{{64, 4}};
+    auto count = 0;
+
+    queue.push(1, 0, 10, [&count]() { count++; });
+    queue.push(1, 0, 1, [&count]() { count++; });
+
+    REQUIRE(queue.drain() == 1);
+    REQUIRE(queue.drain() == 1);
+    REQUIRE(count == 2);
+}
+
+TEST_CASE("Coalesce and drop tasks in fair queue", "[FairQueue]") {
+    Queue queue{{2, 16}};
+    std::vector<int> ran;
+
+    REQUIRE(queue.push(1, 7, 1, [&ran]() { ran.push_back(1); }) == Queue::Result::Queued);
+    REQUIRE(queue.push(1, 7, 1, [&ran]() { ran.push_back(2); }) == Queue::Result::Coalesced);
+    REQUIRE(queue.push(1, 0, 1, [&ran]() { ran.push_back(3); }) == Queue::Result::Queued);
+    REQUIRE(queue.push(1, 0, 1, [&ran]() { ran.push_back(4); }) == Queue::Result::Dropped);
+
+    // Still replaced even when the queue is full
+    REQUIRE(queue.push(1, 7, 1, [&ran]() { ran.push_back(5); }) == Queue::Result::Coalesced);
+
+    // The other keys have their own capacity
+    REQUIRE(queue.push(2, 0, 1, [&ran]() { ran.push_back(6); }) == Queue::Result::Queued);
+
+    REQUIRE(queue.getCoalesced() == 2);
+    REQUIRE(queue.getDropped() == 1);
+
+    queue.remove(2);
+    REQUIRE(queue.drain() == 2);
+    REQUIRE(ran == std::vector<int>{5, 3});
+}
@@ -0,0 +1,66 @@
+#include "../../Common.hpp"
+#include <Engine/Utils/Metrics.hpp>
+
+#define TAG "[Metrics]"
+
+using namespace Engine;
+
+TEST_CASE("Histogram bucket index is monotonic and within the relative error", TAG) {
+    size_t last{0};
+    for (uint64_t value = 1; value < 10000000; value = value * 3 / 2 + 1) {
+        const auto index = MetricHistogram::getBucketIndex(value);
+        REQUIRE(index >= last);
+        REQUIRE(index < MetricHistogram::bucketCount);
+        last = index;
+
+        const auto bucket = static_cast<double>(MetricHistogram::getBucketValue(index));
+        REQUIRE(std::abs(bucket - static_cast<double>(value)) <= static_cast<double>(value) / 32.0 + 1.0);
+    }
+
+    REQUIRE(MetricHistogram::getBucketIndex(std::numeric_limits<uint64_t>::max()) < MetricHistogram::bucketCount);
+}
+
+TEST_CASE("Histogram percentiles", TAG) {
+    MetricHistogram histogram{};
+    for (uint64_t i = 1; i <= 1000; i++) {
+        histogram.record(i);
+    }
+
+    REQUIRE(histogram.getCount() == 1000);
+    REQUIRE(histogram.getSum() == Approx(500500.0));
+    REQUIRE(histogram.getMax() == Approx(1000.0));
+    REQUIRE(histogram.getPercentile(0.5) == Approx(500.0).epsilon(0.04));
+    REQUIRE(histogram.getPercentile(0.99) == Approx(990.0).epsilon(0.04));
+    REQUIRE(histogram.getPercentile(1.0) == Approx(1000.0).epsilon(0.04));
+}
+
+TEST_CASE("Prometheus text output", TAG) {
+    auto& metrics = Metrics::getInstance();
+
+    metrics.counter("test_requests_total", "Test requests", {{"peer", "a\"b"}}).add(3);
+    metrics.gauge("test_queue_depth", "Test queue").set(7);
+    metrics.histogram("test_duration_seconds", "Test duration", {{"op", "get"}}, 1e-9).record(1000000);
+
+    const auto id = metrics.addCollector("test_collected", Metrics::Type::Gauge, "Test collector",
+                                         [](std::vector<Metrics::Sample>& samples) {
+                                             samples.push_back({{{"peer", "x"}}, 42.0});
+                                         });
+
+    const auto text = metrics.toPrometheus();
+    REQUIRE(text.find("# TYPE test_requests_total counter") != std::string::npos);
+    REQUIRE(text.find("test_requests_total{peer=\"a\\\"b\"} 3") != std::string::npos);
+    REQUIRE(text.find("test_queue_depth 7") != std::string::npos);
+    REQUIRE(text.find("# TYPE test_duration_seconds summary") != std::string::npos);
+    REQUIRE(text.find("test_duration_seconds{op=\"get\",quantile=\"0.5\"}") != std::string::npos);
+    REQUIRE(text.find("test_duration_seconds_count{op=\"get\"} 1") != std::string::npos);
+    REQUIRE(text.find("test_collected{peer=\"x\"} 42") != std::string::npos);
+
+    metrics.removeCollector(id);
+    metrics.remove("test_requests_total", {{"peer", "a\"b"}});
+    metrics.remove("test_queue_depth", {});
+    metrics.remove("test_duration_seconds", {{"op", "get"}});
+
+    const auto after = metrics.toPrometheus();
+    REQUIRE(after.find("test_requests_total") == std::string::npos);
+    REQUIRE(after.find("test_collected") == std::string::npos);
+}